@@ -0,0 +1,168 @@
+#include "BatchDissector.h"
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+
+// "IPv4 Packet #12" -> "IPv4 Packet": titles carry per-state counters
+QString layerKind(const QString &name) {
+    int hash = name.lastIndexOf(" #");
+    return hash > 0 ? name.left(hash) : name;
+}
+
+}
+
+BatchDissector::BatchDissector(QObject *parent)
+    : QObject(parent)
+    , cancelRequested(false)
+    , keepLayers(false)
+    , runKeepsLayers(false)
+    , running(false)
+    , shardsDone(0)
+    , dissectedPackets(0)
+    , totalPackets(0)
+{
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    dissect_state_init(&totals);
+}
+
+BatchDissector::~BatchDissector() {
+    stop();
+}
+
+void BatchDissector::setMaxThreadCount(int threads) {
+    pool.setMaxThreadCount(qMax(1, threads));
+}
+
+bool BatchDissector::start(const QVector<PacketBytes> &packets) {
+    if (running) {
+        cancel();
+    }
+    if (packets.isEmpty()) {
+        return false;
+    }
+
+    input = packets;
+    totalPackets = input.size();
+    runKeepsLayers = keepLayers;
+    runMatcher = matcher;
+    results.clear();
+    if (runKeepsLayers) {
+        results.resize(input.size());
+    }
+
+    int shardCount = (input.size() + SHARD_PACKETS - 1) / SHARD_PACKETS;
+    shards.clear();
+    shards.resize(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        Shard &shard = shards[i];
+        shard.first = i * SHARD_PACKETS;
+        shard.count = qMin(SHARD_PACKETS, input.size() - shard.first);
+        shard.dissected = 0;
+        dissect_state_init(&shard.state);
+    }
+
+    dissect_state_init(&totals);
+    layerTotals.clear();
+    shardsDone = 0;
+    dissectedPackets = 0;
+    cancelRequested.store(false);
+    running = true;
+
+    // Workers only ever see these arrays through pointers taken here,
+    // never through the containers themselves
+    Shard *shardData = shards.data();
+    QList<ProtocolLayer> *kept = runKeepsLayers ? results.data() : nullptr;
+    for (int i = 0; i < shardCount; ++i) {
+        pool.start(QRunnable::create([this, shardData, kept, i]() {
+            dissectShard(shardData + i, kept);
+            QMetaObject::invokeMethod(this, "onShardDone", Qt::QueuedConnection, Q_ARG(int, i));
+        }));
+    }
+    return true;
+}
+
+void BatchDissector::cancel() {
+    if (!running) {
+        return;
+    }
+    stop();
+    emit finished(true);
+}
+
+void BatchDissector::stop() {
+    cancelRequested.store(true);
+    pool.waitForDone();
+
+    // Drop shard completions the pool already posted
+    QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+    running = false;
+    input.clear();
+}
+
+void BatchDissector::dissectShard(Shard *shard, QList<ProtocolLayer> *kept) {
+    const PacketBytes *packets = input.constData();
+
+    for (int i = shard->first; i < shard->first + shard->count; ++i) {
+        if (cancelRequested.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        QList<ProtocolLayer> layers = ProtocolAnalysisWrapper::dissectLayers(packets[i].bytes(), &shard->state);
+        for (const ProtocolLayer &layer : layers) {
+            shard->layerCounts[layerKind(layer.name)]++;
+        }
+        if (runMatcher && runMatcher(layers)) {
+            shard->matches.append(i);
+        }
+        if (kept) {
+            kept[i] = layers;
+        }
+        shard->dissected++;
+    }
+}
+
+void BatchDissector::onShardDone(int index) {
+    if (!running) {
+        return;
+    }
+
+    Shard &shard = shards[index];
+    dissect_state_merge(&totals, &shard.state);
+    for (auto it = shard.layerCounts.constBegin(); it != shard.layerCounts.constEnd(); ++it) {
+        layerTotals[it.key()] += it.value();
+    }
+    shard.layerCounts.clear();
+    dissectedPackets += shard.dissected;
+    shardsDone++;
+
+    emit progress(dissectedPackets, totalPackets);
+
+    if (shardsDone == shards.size()) {
+        running = false;
+        pool.waitForDone();
+        input.clear();  // Releases the slabs the frames live in
+        emit finished(false);
+    }
+}
+
+void BatchDissector::clearResults() {
+    if (running) {
+        return;
+    }
+    results.clear();
+    results.squeeze();
+    shards.clear();
+    shards.squeeze();
+}
+
+QVector<int> BatchDissector::matchingIndexes() const {
+    // Shards cover the input in order, so this comes out sorted
+    QVector<int> indexes;
+    for (const Shard &shard : shards) {
+        indexes += shard.matches;
+    }
+    return indexes;
+}
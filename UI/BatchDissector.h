@@ -0,0 +1,130 @@
+#ifndef BATCHDISSECTOR_H
+#define BATCHDISSECTOR_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include "Models/PacketModel.h"
+#include "Wrappers/ProtocolAnalysisWrapper.h"
+
+/**
+ * @brief Fully dissects many packets on a thread pool
+ *
+ * The input is cut into shards of SHARD_PACKETS consecutive packets that
+ * pool threads pick up one at a time, so the work balances itself across
+ * cores. Every shard dissects with its own dissect_state_t; the shard
+ * states are merged into statistics() on the main thread as shards finish,
+ * so no dissector state is ever shared between threads.
+ *
+ * Results are only valid after finished(false). Layer trees are kept for
+ * every packet only when asked for; statistics, per-layer packet counts
+ * and matcher hits are always collected and cost little memory.
+ */
+class BatchDissector : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SHARD_PACKETS = 4096;
+
+    // Runs on pool threads; must not touch anything but its argument
+    using Matcher = std::function<bool(const QList<ProtocolLayer> &layers)>;
+
+    explicit BatchDissector(QObject *parent = nullptr);
+    ~BatchDissector();
+
+    /**
+     * @brief Keep every packet's layer tree in layers() (off by default)
+     *
+     * Like the matcher, takes effect at the next start(); a running batch
+     * keeps the settings it was started with.
+     */
+    void setKeepLayers(bool keep) { keepLayers = keep; }
+
+    /**
+     * @brief Record the input indexes whose layers satisfy matcher
+     */
+    void setMatcher(const Matcher &packetMatcher) { matcher = packetMatcher; }
+
+    void setMaxThreadCount(int threads);
+    int maxThreadCount() const { return pool.maxThreadCount(); }
+
+    /**
+     * @brief Start dissecting in the background, cancelling any running batch
+     * @return false if packets is empty; finished() is not emitted then
+     */
+    bool start(const QVector<PacketBytes> &packets);
+
+    /**
+     * @brief Stop the running batch and emit finished(true)
+     */
+    void cancel();
+
+    /**
+     * @brief Free the kept layer trees and matches once they are consumed
+     */
+    void clearResults();
+
+    bool isRunning() const { return running; }
+    int packetCount() const { return totalPackets; }
+
+    // Indexed like the input given to start()
+    const QVector<QList<ProtocolLayer>> &layers() const { return results; }
+    QVector<int> matchingIndexes() const;
+
+    // Merged over every shard
+    const dissect_state_t &statistics() const { return totals; }
+
+    // Packets containing each top-level layer, "#n" packet counters stripped
+    const QHash<QString, quint64> &layerCounts() const { return layerTotals; }
+
+signals:
+    void progress(int dissected, int total);
+    void finished(bool cancelled);
+
+private slots:
+    void onShardDone(int shard);
+
+private:
+    // Written by one pool thread, read on the main thread after onShardDone()
+    struct Shard {
+        int first;
+        int count;
+        int dissected;
+        dissect_state_t state;
+        QHash<QString, quint64> layerCounts;
+        QVector<int> matches;
+    };
+
+    void dissectShard(Shard *shard, QList<ProtocolLayer> *kept);
+    void stop();
+
+    QThreadPool pool;
+    std::atomic<bool> cancelRequested;
+    bool keepLayers;
+    Matcher matcher;
+
+    // The running batch's copies of the settings above; the pool reads
+    // only these, and start() writes them while the pool is idle
+    bool runKeepsLayers;
+    Matcher runMatcher;
+
+    QVector<PacketBytes> input;
+    QVector<QList<ProtocolLayer>> results;
+    QVector<Shard> shards;
+
+    // Main thread only
+    bool running;
+    int shardsDone;
+    int dissectedPackets;
+    int totalPackets;
+    dissect_state_t totals;
+    QHash<QString, quint64> layerTotals;
+};
+
+#endif // BATCHDISSECTOR_H
@@ -1,5 +1,7 @@
 #include "CaptureControlWidget.h"
 #include "PacketCaptureController.h"
+#include "Models/PacketModel.h"
+#include <QHeaderView>
 #include <QMessageBox>
 #include <QDateTime>
 #include <QDebug>
@@ -8,6 +10,7 @@
 CaptureControlWidget::CaptureControlWidget(QWidget *parent)
     : QWidget(parent)
     , m_captureController(nullptr)
+    , m_packetModel(nullptr)
     , m_startButton(nullptr)
     , m_stopButton(nullptr)
     , m_pauseButton(nullptr)
@@ -20,6 +23,7 @@ CaptureControlWidget::CaptureControlWidget(QWidget *parent)
     , m_bytesReceivedLabel(nullptr)
     , m_captureRateLabel(nullptr)
     , m_captureTimeLabel(nullptr)
+    , m_dropTable(nullptr)
     , m_controlGroup(nullptr)
     , m_statusGroup(nullptr)
     , m_statisticsGroup(nullptr)
@@ -63,9 +67,8 @@ void CaptureControlWidget::setCaptureController(PacketCaptureController *control
     if (m_captureController) {
         connect(m_captureController, &PacketCaptureController::captureStatusChanged,
                 this, &CaptureControlWidget::onCaptureStatusChanged);
-        // TODO: Add captureStatistics signal to PacketCaptureController
-        // connect(m_captureController, &PacketCaptureController::captureStatistics,
-        //         this, &CaptureControlWidget::onCaptureStatistics);
+        connect(m_captureController, &PacketCaptureController::captureStatistics,
+                this, &CaptureControlWidget::onCaptureStatistics);
         connect(m_captureController, &PacketCaptureController::captureError,
                 this, &CaptureControlWidget::onCaptureError);
         
@@ -73,11 +76,22 @@ void CaptureControlWidget::setCaptureController(PacketCaptureController *control
         m_interfaceLabel->setText(QString("Interface: %1").arg(m_captureController->getInterface()));
     }
     
-    updateControlStates();
+    onCaptureStatusChanged(m_captureController && m_captureController->isCapturing());
     
     qDebug() << "CaptureControlWidget: Controller set";
 }
 
+void CaptureControlWidget::setPacketModel(PacketModel *model)
+{
+    m_packetModel = model;
+    m_lastStageTotals.clear();
+}
+
+void CaptureControlWidget::setControlsVisible(bool visible)
+{
+    m_controlGroup->setVisible(visible);
+}
+
 CaptureControlWidget::CaptureStats CaptureControlWidget::getCaptureStats() const
 {
     CaptureStats stats;
@@ -107,25 +121,9 @@ void CaptureControlWidget::startCapture()
         return;
     }
     
-    // Reset statistics
-    m_packetsReceived = 0;
-    m_packetsDropped = 0;
-    m_bytesReceived = 0;
-    m_currentRate = 0.0;
-    m_lastPacketCount = 0;
-    m_captureStartTime = QDateTime::currentDateTime();
-    m_lastStatsUpdate = m_captureStartTime;
-    
-    // Start capture
+    // Statistics and timers are reset by onCaptureStatusChanged()
     m_captureController->startCapture();
     
-    // Start timers
-    m_statisticsTimer->start(1000); // Update every second
-    m_timeUpdateTimer->start(1000); // Update time every second
-    
-    // Update activity indicator
-    m_activityIndicator->setRange(0, 0); // Indeterminate progress
-    
     emit captureStarted();
     
     qDebug() << "CaptureControlWidget: Started capture";
@@ -141,14 +139,6 @@ void CaptureControlWidget::stopCapture()
         m_captureController->stopCapture();
     }
     
-    // Stop timers
-    m_statisticsTimer->stop();
-    m_timeUpdateTimer->stop();
-    
-    // Reset activity indicator
-    m_activityIndicator->setRange(0, 1);
-    m_activityIndicator->setValue(0);
-    
     emit captureStopped();
     
     qDebug() << "CaptureControlWidget: Stopped capture";
@@ -189,6 +179,7 @@ void CaptureControlWidget::resetStatistics()
     m_bytesReceived = 0;
     m_currentRate = 0.0;
     m_lastPacketCount = 0;
+    m_lastStageTotals.clear();
     
     if (m_isCapturing) {
         m_captureStartTime = QDateTime::currentDateTime();
@@ -216,6 +207,31 @@ void CaptureControlWidget::updateInterfaceStatus(const QString &interface, bool
 
 void CaptureControlWidget::onCaptureStatusChanged(bool capturing)
 {
+    // Captures may be started from elsewhere (the main window's toolbar),
+    // so the controller's status is what starts and stops the counters
+    if (capturing && !m_isCapturing) {
+        m_packetsReceived = 0;
+        m_packetsDropped = 0;
+        m_bytesReceived = 0;
+        m_currentRate = 0.0;
+        m_lastPacketCount = 0;
+        m_captureStartTime = QDateTime::currentDateTime();
+        m_lastStatsUpdate = m_captureStartTime;
+        m_lastStageTotals.clear();
+        
+        m_statisticsTimer->start(1000); // Update every second
+        m_timeUpdateTimer->start(1000); // Update time every second
+        m_activityIndicator->setRange(0, 0); // Indeterminate progress
+    } else if (!capturing && m_isCapturing) {
+        m_statisticsTimer->stop();
+        m_timeUpdateTimer->stop();
+        m_activityIndicator->setRange(0, 1);
+        m_activityIndicator->setValue(0);
+        
+        // Show the final counters of the capture that just ended
+        updateDropTable();
+    }
+    
     m_isCapturing = capturing;
     
     if (capturing) {
@@ -250,6 +266,7 @@ void CaptureControlWidget::onCaptureStatistics(int packetsReceived, int packetsD
     }
     
     updateStatisticsDisplay();
+    updateDropTable();
     emit statisticsUpdated(packetsReceived, m_bytesReceived, m_currentRate);
     
     qDebug() << "CaptureControlWidget: Statistics updated - packets:" << packetsReceived 
@@ -291,7 +308,7 @@ void CaptureControlWidget::updateCaptureTime()
 
 void CaptureControlWidget::setupUI()
 {
-    setFixedHeight(200);
+    setFixedHeight(500);
     setMinimumWidth(300);
     
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
@@ -364,6 +381,24 @@ void CaptureControlWidget::setupUI()
     m_captureTimeLabel = new QLabel("Time: 00:00:00");
     statsLayout->addWidget(m_captureTimeLabel, 2, 0, 1, 2);
     
+    // Per-stage loss; rows follow the order used by updateDropTable()
+    const QStringList stages = {"Kernel buffer", "Interface/driver", "Batch ring overflow",
+                                "Sampling", "Validation", "Model evictions", "Disk writer",
+                                "Overload: summary only", "Overload: sampled out",
+                                "Overload: spilled to disk", "Overload: dropped"};
+    m_dropTable = new QTableWidget(stages.size(), 3);
+    m_dropTable->setHorizontalHeaderLabels({"Stage", "Total", "Rate"});
+    m_dropTable->verticalHeader()->setVisible(false);
+    m_dropTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    m_dropTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_dropTable->setSelectionMode(QAbstractItemView::NoSelection);
+    for (int row = 0; row < stages.size(); ++row) {
+        m_dropTable->setItem(row, 0, new QTableWidgetItem(stages[row]));
+        m_dropTable->setItem(row, 1, new QTableWidgetItem("0"));
+        m_dropTable->setItem(row, 2, new QTableWidgetItem(formatRate(0.0)));
+    }
+    statsLayout->addWidget(m_dropTable, 3, 0, 1, 2);
+    
     mainLayout->addWidget(m_statisticsGroup);
     
     qDebug() << "CaptureControlWidget: UI setup completed";
@@ -413,6 +448,51 @@ QString CaptureControlWidget::formatRate(double rate) const
     }
 }
 
+void CaptureControlWidget::updateDropTable()
+{
+    if (!m_captureController || !m_dropTable) {
+        return;
+    }
+    
+    CaptureDropStats stats = m_captureController->getDropStatistics();
+    QVector<quint64> totals = {
+        stats.kernelDrops,
+        stats.interfaceDrops,
+        stats.ringOverflows,
+        stats.samplingDiscards,
+        stats.validationRejects,
+        m_packetModel ? m_packetModel->getEvictedPacketCount() : 0,
+        stats.diskWriterDrops,
+        stats.overloadSummaryOnly,
+        stats.overloadSampled,
+        stats.overloadSpilled,
+        stats.overloadDropped
+    };
+    
+    QDateTime now = QDateTime::currentDateTime();
+    qint64 elapsedMs = m_lastDropUpdate.isValid() ? m_lastDropUpdate.msecsTo(now) : 0;
+    bool haveBaseline = m_lastStageTotals.size() == totals.size();
+    
+    for (int row = 0; row < totals.size(); ++row) {
+        // Counters restart with each capture; a smaller value is a new baseline
+        double rate = 0.0;
+        if (haveBaseline && elapsedMs > 0 && totals[row] >= m_lastStageTotals[row]) {
+            rate = (totals[row] - m_lastStageTotals[row]) * 1000.0 / elapsedMs;
+        }
+        
+        m_dropTable->item(row, 1)->setText(QString::number(totals[row]));
+        m_dropTable->item(row, 2)->setText(formatRate(rate));
+    }
+    
+    // Sampled counts are scaled by 1 / ratio to estimate the real traffic
+    double ratio = stats.samplingRatio();
+    m_dropTable->item(3, 0)->setText(ratio < 1.0 ? QString("Sampling (kept %1%)").arg(ratio * 100.0, 0, 'f', 1)
+                                                 : QString("Sampling"));
+    
+    m_lastStageTotals = totals;
+    m_lastDropUpdate = now;
+}
+
 QString CaptureControlWidget::formatDuration(int seconds) const
 {
     int hours = seconds / 3600;
@@ -11,8 +11,11 @@
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QDateTime>
+#include <QTableWidget>
+#include <QVector>
 
 class PacketCaptureController;
+class PacketModel;
 
 /**
  * @brief Widget providing comprehensive capture control functionality
@@ -33,6 +36,18 @@ public:
      */
     void setCaptureController(PacketCaptureController *controller);
 
+    /**
+     * @brief Set the packet model whose retention evictions are reported
+     */
+    void setPacketModel(PacketModel *model);
+
+    /**
+     * @brief Show or hide the Start/Stop/Pause/Reset buttons
+     *
+     * Hidden when the widget only reports on a capture someone else runs.
+     */
+    void setControlsVisible(bool visible);
+
     /**
      * @brief Get current capture status
      */
@@ -160,8 +175,14 @@ private:
      */
     QString formatDuration(int seconds) const;
 
+    /**
+     * @brief Refresh the per-stage drop table from the controller and model
+     */
+    void updateDropTable();
+
     // Controller reference
     PacketCaptureController *m_captureController;
+    PacketModel *m_packetModel;
 
     // UI Components - Control buttons
     QPushButton *m_startButton;
@@ -180,6 +201,7 @@ private:
     QLabel *m_bytesReceivedLabel;
     QLabel *m_captureRateLabel;
     QLabel *m_captureTimeLabel;
+    QTableWidget *m_dropTable;
 
     // UI Components - Layout
     QGroupBox *m_controlGroup;
@@ -202,6 +224,10 @@ private:
     int m_lastPacketCount;
     QDateTime m_lastStatsUpdate;
     double m_currentRate;
+
+    // Per-stage drop totals at the previous table refresh
+    QVector<quint64> m_lastStageTotals;
+    QDateTime m_lastDropUpdate;
 };
 
 #endif // CAPTURECONTROLWIDGET_H
\ No newline at end of file
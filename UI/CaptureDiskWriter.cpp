@@ -0,0 +1,238 @@
+#include "CaptureDiskWriter.h"
+#include "Utils/ErrorHandler.h"
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+// How long finish() waits for capture workers to close their feeds
+const qint64 FEED_CLOSE_TIMEOUT_MS = 2000;
+
+// Partial buffers are pushed to the kernel at least this often
+const qint64 FLUSH_INTERVAL_MS = 1000;
+}
+
+// DiskWriterFeed implementation
+DiskWriterFeed::DiskWriterFeed(const QSharedPointer<QSemaphore> &wake)
+    : ring(SLOT_COUNT, SLOT_BYTES, SLOT_PACKETS)
+    , writeSlot(nullptr)
+    , wake(wake)
+    , closed(false)
+{
+}
+
+void DiskWriterFeed::appendPacket(const char *packet, int length, int wireLength, qint64 timestampNs) {
+    if (!writeSlot) {
+        writeSlot = ring.beginWrite();
+        if (!writeSlot) {
+            ring.noteOverflow(1);
+            return;
+        }
+    }
+
+    writeSlot->appendPacket(packet, length, timestampNs, wireLength);
+    if (writeSlot->data.size() >= SLOT_BYTES || writeSlot->records.size() >= SLOT_PACKETS) {
+        flush();
+    }
+}
+
+void DiskWriterFeed::flush() {
+    if (!writeSlot || writeSlot->isEmpty()) {
+        return;
+    }
+
+    writeSlot = nullptr;
+    if (ring.commitWrite()) {
+        wake->release();
+    }
+}
+
+void DiskWriterFeed::close() {
+    flush();
+    closed.store(true, std::memory_order_release);
+    wake->release();
+}
+
+// CaptureDiskWriter implementation
+CaptureDiskWriter::CaptureDiskWriter(QObject *parent)
+    : QObject(parent)
+    , writer()
+    , writerThread(nullptr)
+    , wake(new QSemaphore(0))
+    , finishRequested(false)
+    , writtenPackets(0)
+    , writtenBytes(0)
+{
+    writer.fd = -1;
+}
+
+CaptureDiskWriter::~CaptureDiskWriter() {
+    if (writerThread) {
+        finish();
+        writerThread->wait();
+        delete writerThread;
+    }
+}
+
+bool CaptureDiskWriter::start(const DiskCaptureSettings &settings) {
+    if (writerThread) {
+        return false;
+    }
+
+    QByteArray path = QFile::encodeName(settings.path);
+
+    pcapng_writer_config_t config;
+    pcapng_writer_default_config(&config);
+    config.path = path.constData();
+    config.direct_io = settings.directIo ? 1 : 0;
+    config.max_file_bytes = static_cast<uint64_t>(qMax<qint64>(0, settings.maxFileBytes));
+    config.max_file_seconds = static_cast<uint32_t>(qMax(0, settings.maxFileSeconds));
+    config.ring_files = static_cast<unsigned int>(qMax(0, settings.ringFiles));
+
+    if (pcapng_writer_open(&writer, &config) < 0) {
+        QMutexLocker locker(&stateMutex);
+        errorText = QString::fromLocal8Bit(writer.error);
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&stateMutex);
+        openFile = QFile::decodeName(writer.current_path);
+    }
+    LOG_INFO(QString("Writing capture to %1%2").arg(currentFile(), writer.direct ? " (O_DIRECT)" : ""));
+    emit fileOpened(currentFile());
+
+    finishRequested.store(false);
+    writerThread = QThread::create([this]() { runWriter(); });
+    writerThread->start();
+    return true;
+}
+
+void CaptureDiskWriter::finish() {
+    finishRequested.store(true);
+    wake->release();
+}
+
+QSharedPointer<DiskWriterFeed> CaptureDiskWriter::createFeed() {
+    QSharedPointer<DiskWriterFeed> feed(new DiskWriterFeed(wake));
+    QMutexLocker locker(&stateMutex);
+    feeds.append(feed);
+    return feed;
+}
+
+quint64 CaptureDiskWriter::droppedPackets() const {
+    QMutexLocker locker(&stateMutex);
+    quint64 dropped = 0;
+    for (const QSharedPointer<DiskWriterFeed> &feed : feeds) {
+        dropped += feed->droppedPackets();
+    }
+    return dropped;
+}
+
+QString CaptureDiskWriter::currentFile() const {
+    QMutexLocker locker(&stateMutex);
+    return openFile;
+}
+
+QString CaptureDiskWriter::lastError() const {
+    QMutexLocker locker(&stateMutex);
+    return errorText;
+}
+
+bool CaptureDiskWriter::drainFeeds(const QList<QSharedPointer<DiskWriterFeed>> &activeFeeds) {
+    for (const QSharedPointer<DiskWriterFeed> &feed : activeFeeds) {
+        PacketBatchRing &ring = feed->batchRing();
+        do {
+            while (PacketBatchSlot *slot = ring.beginRead()) {
+                const uint8_t *base = reinterpret_cast<const uint8_t*>(slot->data.constData());
+                for (const PacketRecord &record : slot->records) {
+                    if (pcapng_writer_write(&writer, base + record.offset, static_cast<uint32_t>(record.length),
+                                            static_cast<uint32_t>(record.wireLength), record.timestampNs) < 0) {
+                        return false;
+                    }
+                }
+                writtenPackets.fetch_add(static_cast<quint64>(slot->records.size()), std::memory_order_relaxed);
+                slot->reset();
+                ring.endRead();
+            }
+        } while (ring.finishDrain());
+    }
+    return true;
+}
+
+void CaptureDiskWriter::runWriter() {
+    bool failed = false;
+    qint64 lastFlush = QDateTime::currentMSecsSinceEpoch();
+    qint64 finishDeadline = 0;
+
+    while (true) {
+        wake->tryAcquire(1, 100);
+
+        QList<QSharedPointer<DiskWriterFeed>> activeFeeds;
+        {
+            QMutexLocker locker(&stateMutex);
+            activeFeeds = feeds;
+        }
+
+        // Closed is read before draining so the final batch of a feed is
+        // always written before the writer gives up on it
+        bool allClosed = true;
+        for (const QSharedPointer<DiskWriterFeed> &feed : activeFeeds) {
+            allClosed = allClosed && feed->isClosed();
+        }
+
+        // After a failure the feeds are left alone; their overflow counters
+        // account for everything that no longer reaches the disk
+        if (!failed) {
+            QString previousFile = QFile::decodeName(writer.current_path);
+            bool ok = drainFeeds(activeFeeds);
+
+            qint64 now = QDateTime::currentMSecsSinceEpoch();
+            if (ok && now - lastFlush >= FLUSH_INTERVAL_MS) {
+                ok = pcapng_writer_flush(&writer) == 0;
+                lastFlush = now;
+            }
+            writtenBytes.store(writer.bytes_written + writer.buffer_used, std::memory_order_relaxed);
+
+            QString currentPath = QFile::decodeName(writer.current_path);
+            if (currentPath != previousFile) {
+                {
+                    QMutexLocker locker(&stateMutex);
+                    openFile = currentPath;
+                }
+                emit fileOpened(currentPath);
+            }
+
+            if (!ok) {
+                failed = true;
+                QString error = QString("Capture file write failed: %1").arg(QString::fromLocal8Bit(writer.error));
+                {
+                    QMutexLocker locker(&stateMutex);
+                    errorText = error;
+                }
+                emit writeError(error);
+            }
+        }
+
+        if (finishRequested.load()) {
+            qint64 now = QDateTime::currentMSecsSinceEpoch();
+            if (finishDeadline == 0) {
+                finishDeadline = now + FEED_CLOSE_TIMEOUT_MS;
+            }
+            if (allClosed || failed || now >= finishDeadline) {
+                break;
+            }
+        }
+    }
+
+    if (pcapng_writer_close(&writer) < 0 && !failed) {
+        QString error = QString("Capture file close failed: %1").arg(QString::fromLocal8Bit(writer.error));
+        emit writeError(error);
+    }
+    writtenBytes.store(writer.bytes_written, std::memory_order_relaxed);
+
+    qDebug() << "CaptureDiskWriter: wrote" << packetsWritten() << "packets," << bytesWritten()
+             << "bytes in" << writer.files_opened << "file(s)";
+    emit finished();
+}
@@ -0,0 +1,129 @@
+#ifndef CAPTUREDISKWRITER_H
+#define CAPTUREDISKWRITER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include "Utils/PacketBatchRing.h"
+
+extern "C" {
+    #include "../src/packetcapture/pcapng_writer.h"
+}
+
+/**
+ * @brief Continuous capture-to-disk settings
+ *
+ * With maxFileBytes and maxFileSeconds both 0 everything goes to @c path.
+ * Otherwise files rotate and ringFiles > 0 keeps only the newest N.
+ */
+struct DiskCaptureSettings {
+    bool enabled = false;
+    QString path;
+    qint64 maxFileBytes = 0;
+    int maxFileSeconds = 0;
+    int ringFiles = 0;
+    bool directIo = true;
+};
+
+/**
+ * @brief Producer end of the disk writer, owned by one capture worker
+ *
+ * Packets are copied into batch slots of a dedicated single-producer ring,
+ * independent of the ring feeding the controller, so sampling, validation
+ * and model retention never affect what reaches the file. When the writer
+ * falls behind the packets are counted as dropped rather than blocking the
+ * capture thread.
+ */
+class DiskWriterFeed
+{
+public:
+    static constexpr int SLOT_COUNT = 64;
+    static constexpr int SLOT_BYTES = 1024 * 1024;
+    static constexpr int SLOT_PACKETS = 4096;
+
+    explicit DiskWriterFeed(const QSharedPointer<QSemaphore> &wake);
+
+    // Producer side (capture worker thread)
+    void appendPacket(const char *packet, int length, int wireLength, qint64 timestampNs);
+    void flush();
+    void close();  // Final flush; the writer stops waiting for this feed
+
+    // Consumer side (writer thread)
+    PacketBatchRing &batchRing() { return ring; }
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    quint64 droppedPackets() const { return ring.droppedPackets(); }
+
+private:
+    PacketBatchRing ring;
+    PacketBatchSlot *writeSlot;
+    QSharedPointer<QSemaphore> wake;
+    std::atomic<bool> closed;
+};
+
+/**
+ * @brief Writes every captured packet to pcapng files on its own thread
+ *
+ * Each capture worker gets a DiskWriterFeed; the writer thread drains all
+ * feeds and appends Enhanced Packet Blocks with nanosecond timestamps
+ * through large (optionally O_DIRECT) writes. Packets of different fanout
+ * workers are interleaved per batch, not merged by timestamp.
+ */
+class CaptureDiskWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureDiskWriter(QObject *parent = nullptr);
+    ~CaptureDiskWriter();
+
+    /**
+     * @brief Open the first file and start the writer thread
+     * @return false if the file could not be created; see lastError()
+     */
+    bool start(const DiskCaptureSettings &settings);
+
+    /**
+     * @brief Let the thread drain until every feed is closed, then close the file
+     *
+     * Returns immediately; finished() is emitted once the file is closed.
+     */
+    void finish();
+
+    QSharedPointer<DiskWriterFeed> createFeed();
+
+    // Thread-safe counters
+    quint64 packetsWritten() const { return writtenPackets.load(std::memory_order_relaxed); }
+    quint64 bytesWritten() const { return writtenBytes.load(std::memory_order_relaxed); }
+    quint64 droppedPackets() const;
+    QString currentFile() const;
+    QString lastError() const;
+
+signals:
+    void fileOpened(const QString &path);
+    void writeError(const QString &error);
+    void finished();
+
+private:
+    void runWriter();
+    bool drainFeeds(const QList<QSharedPointer<DiskWriterFeed>> &feeds);
+
+    pcapng_writer_t writer;
+    QThread *writerThread;
+    QSharedPointer<QSemaphore> wake;
+    std::atomic<bool> finishRequested;
+    std::atomic<quint64> writtenPackets;
+    std::atomic<quint64> writtenBytes;
+
+    mutable QMutex stateMutex;
+    QList<QSharedPointer<DiskWriterFeed>> feeds;
+    QString openFile;
+    QString errorText;
+};
+
+#endif // CAPTUREDISKWRITER_H
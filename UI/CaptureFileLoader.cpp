@@ -0,0 +1,290 @@
+#include "CaptureFileLoader.h"
+#include "PacketCaptureController.h"
+#include "Utils/ErrorHandler.h"
+#include "Utils/PacketSlab.h"
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+
+// Summarizes one chunk of indexed packets on a pool thread
+class SummarizeChunkTask : public QRunnable
+{
+public:
+    SummarizeChunkTask(CaptureFileLoader *loader,
+                       const QSharedPointer<capture_file_t> &file,
+                       const QVector<capture_index_entry_t> &entries,
+                       quint64 sequence,
+                       qint64 endOffset,
+                       const std::atomic<bool> *cancelled)
+        : loader(loader)
+        , file(file)
+        , entries(entries)
+        , sequence(sequence)
+        , endOffset(endOffset)
+        , cancelled(cancelled)
+    {
+    }
+
+    void run() override {
+        // One slab sized to the chunk, so its frames end up contiguous
+        qint64 chunkBytes = 0;
+        for (const capture_index_entry_t &entry : entries) {
+            chunkBytes += capture_index_caplen(&entry);
+        }
+        PacketSlabStore slabStore(static_cast<int>(qBound<qint64>(1, chunkBytes, PacketSlabStore::DEFAULT_SLAB_BYTES * 16)));
+
+        QList<PacketInfo> packets;
+        packets.reserve(entries.size());
+
+        for (const capture_index_entry_t &entry : entries) {
+            if (cancelled->load(std::memory_order_relaxed)) {
+                return;
+            }
+            const char *data = reinterpret_cast<const char*>(capture_index_data(file.data(), &entry));
+            PacketSlice slice = slabStore.append(data, static_cast<int>(capture_index_caplen(&entry)));
+            // Offline files skip DataValidator: their timestamps are legitimately old
+            packets.append(PacketCaptureController::summarizePacket(slice, entry.ts_ns));
+        }
+
+        QMetaObject::invokeMethod(loader, "onChunkSummarized", Qt::QueuedConnection,
+                                  Q_ARG(quint64, sequence),
+                                  Q_ARG(qint64, endOffset),
+                                  Q_ARG(QList<PacketInfo>, packets));
+    }
+
+private:
+    CaptureFileLoader *loader;
+    QSharedPointer<capture_file_t> file;
+    QVector<capture_index_entry_t> entries;
+    quint64 sequence;
+    qint64 endOffset;
+    const std::atomic<bool> *cancelled;
+};
+
+void closeCaptureFile(capture_file_t *file) {
+    capture_file_close(file);
+    delete file;
+}
+
+}
+
+CaptureFileLoader::CaptureFileLoader(QObject *parent)
+    : QObject(parent)
+    , indexThread(nullptr)
+    , maxChunkCredits(0)
+    , cancelRequested(false)
+    , mapped(false)
+    , nextSequence(0)
+    , totalChunks(0)
+    , indexingDone(false)
+    , loading(false)
+    , deliveredPackets(0)
+{
+    summarizePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
+    // Chunks that are indexed but not yet in the model; bounds memory when
+    // the UI falls behind the summarizers
+    maxChunkCredits = summarizePool.maxThreadCount() * 4;
+    chunkCredits.release(maxChunkCredits);
+}
+
+CaptureFileLoader::~CaptureFileLoader() {
+    cancel();
+}
+
+bool CaptureFileLoader::load(const QString &fileName) {
+    cancel();
+
+    QSharedPointer<capture_file_t> opened(new capture_file_t, closeCaptureFile);
+    if (capture_file_open(opened.data(), QFile::encodeName(fileName).constData()) < 0) {
+        QString error = QString("Cannot open %1: %2").arg(fileName, QString::fromLocal8Bit(opened->error));
+        LOG_WARNING(error);
+        emit loadError(error);
+        return false;
+    }
+
+    file = opened;
+    currentFileName = fileName;
+    mapped = static_cast<qint64>(file->size) >= MAPPED_BACKEND_MIN_BYTES;
+    pendingChunks.clear();
+    nextSequence = 0;
+    totalChunks = 0;
+    indexingDone = false;
+    deliveredPackets = 0;
+    indexError.clear();
+    cancelRequested.store(false);
+
+    // A cancelled load can leave credits with undelivered chunks
+    int missingCredits = maxChunkCredits - chunkCredits.available();
+    if (missingCredits > 0) {
+        chunkCredits.release(missingCredits);
+    }
+
+    loading = true;
+    indexThread = QThread::create([this]() { runIndexer(); });
+    indexThread->start();
+
+    LOG_INFO(QString("Loading capture file %1 (%2 bytes, %3%4)")
+             .arg(fileName)
+             .arg(file->size)
+             .arg(file->format == CAPTURE_FORMAT_PCAPNG ? "pcapng" : "pcap")
+             .arg(mapped ? ", mapped" : ""));
+    return true;
+}
+
+void CaptureFileLoader::cancel() {
+    cancelRequested.store(true);
+    stopThreads();
+
+    // Drop results the pool already posted for this load
+    QCoreApplication::removePostedEvents(this, QEvent::MetaCall);
+    pendingChunks.clear();
+    loading = false;
+}
+
+void CaptureFileLoader::stopThreads() {
+    if (indexThread) {
+        indexThread->wait();
+        delete indexThread;
+        indexThread = nullptr;
+    }
+    summarizePool.waitForDone();
+}
+
+void CaptureFileLoader::runIndexer() {
+    QSharedPointer<capture_file_t> sharedFile = file;
+    capture_file_t *capture = sharedFile.data();
+    QVector<capture_index_entry_t> entries(INDEX_CHUNK_PACKETS);
+    quint64 sequence = 0;
+    QString error;
+
+    while (!cancelRequested.load(std::memory_order_relaxed)) {
+        int count = capture_file_index(capture, entries.data(), INDEX_CHUNK_PACKETS);
+        if (count < 0) {
+            error = QString::fromLocal8Bit(capture->error);
+            break;
+        }
+
+        // Summaries assume Ethernet framing; pcapng only knows after its first IDB
+        if (capture->linktype >= 0 && capture->linktype != CAPTURE_LINKTYPE_ETHERNET) {
+            error = QString("Unsupported link type %1 (only Ethernet captures can be opened)").arg(capture->linktype);
+            break;
+        }
+
+        if (count == 0) {
+            break;
+        }
+
+        bool haveCredit = false;
+        while (!(haveCredit = chunkCredits.tryAcquire(1, 50))) {
+            if (cancelRequested.load(std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        if (!haveCredit) {
+            break;
+        }
+
+        QVector<capture_index_entry_t> chunk(entries.constBegin(), entries.constBegin() + count);
+
+        // Mapped files go to the model as bare index entries
+        if (mapped) {
+            QMetaObject::invokeMethod(this, "onChunkIndexed", Qt::QueuedConnection,
+                                      Q_ARG(quint64, sequence++),
+                                      Q_ARG(qint64, static_cast<qint64>(capture->next_offset)),
+                                      Q_ARG(QVector<capture_index_entry_t>, chunk));
+            continue;
+        }
+
+        summarizePool.start(new SummarizeChunkTask(this, sharedFile, chunk, sequence++,
+                                                   static_cast<qint64>(capture->next_offset),
+                                                   &cancelRequested));
+    }
+
+    if (error.isEmpty() && capture->truncated) {
+        qWarning() << "CaptureFileLoader: file ends in a partial record, ignoring it";
+    }
+    if (capture->mixed_linktypes) {
+        qWarning() << "CaptureFileLoader: file mixes link types, non-Ethernet interfaces will not decode";
+    }
+
+    QMetaObject::invokeMethod(this, "onIndexingDone", Qt::QueuedConnection,
+                              Q_ARG(quint64, sequence),
+                              Q_ARG(QString, error));
+}
+
+void CaptureFileLoader::onChunkSummarized(quint64 sequence, qint64 endOffset, const QList<PacketInfo> &packets) {
+    if (!loading) {
+        return;
+    }
+
+    pendingChunks.insert(sequence, qMakePair(endOffset, packets));
+    deliverReadyChunks();
+}
+
+void CaptureFileLoader::onChunkIndexed(quint64 sequence, qint64 endOffset, const QVector<capture_index_entry_t> &entries) {
+    if (!loading) {
+        return;
+    }
+
+    // Posted by the single index thread, so already in file order
+    Q_ASSERT(sequence == nextSequence);
+    nextSequence++;
+    chunkCredits.release();
+
+    deliveredPackets += entries.size();
+    emit packetsIndexed(entries);
+    emit progress(endOffset, static_cast<qint64>(file->size));
+
+    deliverReadyChunks();
+}
+
+void CaptureFileLoader::onIndexingDone(quint64 chunkCount, const QString &error) {
+    if (!loading) {
+        return;
+    }
+
+    indexingDone = true;
+    totalChunks = chunkCount;
+    indexError = error;
+    deliverReadyChunks();
+}
+
+void CaptureFileLoader::deliverReadyChunks() {
+    // Release chunks strictly in file order
+    while (!pendingChunks.isEmpty() && pendingChunks.firstKey() == nextSequence) {
+        QPair<qint64, QList<PacketInfo>> chunk = pendingChunks.take(nextSequence);
+        nextSequence++;
+        chunkCredits.release();
+
+        deliveredPackets += chunk.second.size();
+        emit packetsLoaded(chunk.second);
+        emit progress(chunk.first, static_cast<qint64>(file->size));
+    }
+
+    if (indexingDone && nextSequence == totalChunks) {
+        finishLoad();
+    }
+}
+
+void CaptureFileLoader::finishLoad() {
+    loading = false;
+    stopThreads();
+
+    // From here on the model reads rows at random
+    if (mapped) {
+        capture_file_end_sequential(file.data());
+    }
+
+    if (!indexError.isEmpty()) {
+        QString error = QString("%1: %2").arg(currentFileName, indexError);
+        LOG_WARNING(error);
+        emit loadError(error);
+    }
+
+    LOG_INFO(QString("Loaded %1 packets from %2").arg(deliveredPackets).arg(currentFileName));
+    emit finished(deliveredPackets);
+}
@@ -0,0 +1,102 @@
+#ifndef CAPTUREFILELOADER_H
+#define CAPTUREFILELOADER_H
+
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QVector>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <atomic>
+#include "Models/PacketModel.h"
+
+extern "C" {
+    #include "../src/packetcapture/capture_file.h"
+}
+
+/**
+ * @brief Loads a pcap or pcapng file through the capture summarization path
+ *
+ * The file is memory mapped once. An index thread walks the records front to
+ * back, appending a 16-byte entry per packet to a compact offset index, and
+ * hands every chunk of entries to a thread pool that summarizes them exactly
+ * like live captured packets. Chunks finish out of order; they are released
+ * to the model in file order so rows appear progressively while the rest of
+ * the file is still being read.
+ *
+ * Files of MAPPED_BACKEND_MIN_BYTES and more are not summarized up front:
+ * only the index is delivered (packetsIndexed()) and the model reads rows
+ * straight out of the mapping on demand, leaving residency to the page cache.
+ */
+class CaptureFileLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int INDEX_CHUNK_PACKETS = 4096;
+    static constexpr qint64 MAPPED_BACKEND_MIN_BYTES = 256LL * 1024 * 1024;
+
+    explicit CaptureFileLoader(QObject *parent = nullptr);
+    ~CaptureFileLoader();
+
+    /**
+     * @brief Open a capture file and start loading it in the background
+     * @return false if the file could not be opened; loadError() is emitted
+     */
+    bool load(const QString &fileName);
+
+    /**
+     * @brief Stop indexing and drop chunks that have not been delivered yet
+     */
+    void cancel();
+
+    bool isLoading() const { return loading; }
+    QString fileName() const { return currentFileName; }
+
+    /**
+     * @brief Whether the current file is delivered as an index for PacketModel's mapped backend
+     */
+    bool isMapped() const { return mapped; }
+    QSharedPointer<capture_file_t> captureFile() const { return file; }
+
+signals:
+    void packetsLoaded(const QList<PacketInfo> &packets);
+    void packetsIndexed(const QVector<capture_index_entry_t> &entries);
+    void progress(qint64 bytesLoaded, qint64 totalBytes);
+    void finished(int packetCount);
+    void loadError(const QString &error);
+
+private slots:
+    void onChunkSummarized(quint64 sequence, qint64 endOffset, const QList<PacketInfo> &packets);
+    void onChunkIndexed(quint64 sequence, qint64 endOffset, const QVector<capture_index_entry_t> &entries);
+    void onIndexingDone(quint64 chunkCount, const QString &error);
+
+private:
+    void runIndexer();
+    void stopThreads();
+    void deliverReadyChunks();
+    void finishLoad();
+
+    QSharedPointer<capture_file_t> file;
+    QString currentFileName;
+    QThread *indexThread;
+    QThreadPool summarizePool;
+    QSemaphore chunkCredits;
+    int maxChunkCredits;
+    std::atomic<bool> cancelRequested;
+    bool mapped;
+
+    // Main thread only
+    QMap<quint64, QPair<qint64, QList<PacketInfo>>> pendingChunks;
+    quint64 nextSequence;
+    quint64 totalChunks;
+    bool indexingDone;
+    bool loading;
+    int deliveredPackets;
+    QString indexError;
+};
+
+#endif // CAPTUREFILELOADER_H
@@ -5,6 +5,11 @@
 #include <QMessageBox>
 #include <QStandardPaths>
 #include <QApplication>
+#include <QHeaderView>
+
+extern "C" {
+    #include "../../src/protocols/port_registry.h"
+}
 
 SettingsDialog::SettingsDialog(QWidget *parent)
     : QDialog(parent)
@@ -303,6 +308,77 @@ void SettingsDialog::setupCaptureTab()
     advancedLayout->addRow("Capture buffer size:", m_bufferSizeSpinBox);
     
     layout->addWidget(advancedGroup);
+    
+    // Continuous capture to disk
+    QGroupBox *diskGroup = new QGroupBox("Capture to Disk");
+    QFormLayout *diskLayout = new QFormLayout(diskGroup);
+    
+    m_diskCaptureCheckBox = new QCheckBox("Write every captured packet to pcapng files");
+    connect(m_diskCaptureCheckBox, &QCheckBox::toggled, this, &SettingsDialog::onSettingChanged);
+    diskLayout->addRow(m_diskCaptureCheckBox);
+    
+    m_diskCapturePathEdit = new QLineEdit;
+    m_diskCapturePathEdit->setPlaceholderText(QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/capture.pcapng");
+    connect(m_diskCapturePathEdit, &QLineEdit::textChanged, this, &SettingsDialog::onSettingChanged);
+    diskLayout->addRow("Output file:", m_diskCapturePathEdit);
+    
+    m_diskMaxFileSizeSpinBox = new QSpinBox;
+    m_diskMaxFileSizeSpinBox->setRange(0, 1024 * 1024);
+    m_diskMaxFileSizeSpinBox->setSuffix(" MB (0 = no limit)");
+    connect(m_diskMaxFileSizeSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsDialog::onSettingChanged);
+    diskLayout->addRow("Rotate after size:", m_diskMaxFileSizeSpinBox);
+    
+    m_diskMaxFileSecondsSpinBox = new QSpinBox;
+    m_diskMaxFileSecondsSpinBox->setRange(0, 7 * 24 * 3600);
+    m_diskMaxFileSecondsSpinBox->setSuffix(" seconds (0 = no limit)");
+    connect(m_diskMaxFileSecondsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsDialog::onSettingChanged);
+    diskLayout->addRow("Rotate after duration:", m_diskMaxFileSecondsSpinBox);
+    
+    m_diskRingFilesSpinBox = new QSpinBox;
+    m_diskRingFilesSpinBox->setRange(0, 100000);
+    m_diskRingFilesSpinBox->setSuffix(" files (0 = keep all)");
+    connect(m_diskRingFilesSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsDialog::onSettingChanged);
+    diskLayout->addRow("Ring buffer:", m_diskRingFilesSpinBox);
+    
+    m_diskDirectIoCheckBox = new QCheckBox("Use O_DIRECT (bypass the page cache)");
+    connect(m_diskDirectIoCheckBox, &QCheckBox::toggled, this, &SettingsDialog::onSettingChanged);
+    diskLayout->addRow(m_diskDirectIoCheckBox);
+    
+    layout->addWidget(diskGroup);
+    
+    // Decode As: dissect a port as another protocol than the registry's
+    QGroupBox *decodeAsGroup = new QGroupBox("Decode As");
+    QVBoxLayout *decodeAsLayout = new QVBoxLayout(decodeAsGroup);
+    
+    m_decodeAsTable = new QTableWidget(0, 3);
+    m_decodeAsTable->setHorizontalHeaderLabels({"Transport", "Port", "Decode as"});
+    m_decodeAsTable->verticalHeader()->setVisible(false);
+    m_decodeAsTable->horizontalHeader()->setSectionResizeMode(2, QHeaderView::Stretch);
+    m_decodeAsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_decodeAsTable->setMinimumHeight(120);
+    decodeAsLayout->addWidget(m_decodeAsTable);
+    
+    QHBoxLayout *decodeAsButtons = new QHBoxLayout;
+    m_decodeAsAddButton = new QPushButton("Add");
+    connect(m_decodeAsAddButton, &QPushButton::clicked, [this]() {
+        addDecodeAsRow("tcp", 8080, "none");
+        m_decodeAsTable->selectRow(m_decodeAsTable->rowCount() - 1);
+        onSettingChanged();
+    });
+    decodeAsButtons->addWidget(m_decodeAsAddButton);
+    
+    m_decodeAsRemoveButton = new QPushButton("Remove");
+    connect(m_decodeAsRemoveButton, &QPushButton::clicked, [this]() {
+        if (m_decodeAsTable->currentRow() >= 0) {
+            m_decodeAsTable->removeRow(m_decodeAsTable->currentRow());
+            onSettingChanged();
+        }
+    });
+    decodeAsButtons->addWidget(m_decodeAsRemoveButton);
+    decodeAsButtons->addStretch();
+    decodeAsLayout->addLayout(decodeAsButtons);
+    
+    layout->addWidget(decodeAsGroup);
     layout->addStretch();
     
     m_tabWidget->addTab(m_captureTab, "Capture");
@@ -494,6 +570,13 @@ void SettingsDialog::loadCurrentSettings()
     m_captureTimeoutSpinBox->setValue(settings->getCaptureTimeout());
     m_promiscuousModeCheckBox->setChecked(settings->getCustomSetting("promiscuous_mode", false).toBool());
     m_bufferSizeSpinBox->setValue(settings->getCustomSetting("buffer_size", 10).toInt());
+    m_diskCaptureCheckBox->setChecked(settings->getCustomSetting("disk_capture_enabled", false).toBool());
+    m_diskCapturePathEdit->setText(settings->getCustomSetting("disk_capture_path", "").toString());
+    m_diskMaxFileSizeSpinBox->setValue(settings->getCustomSetting("disk_capture_max_file_mb", 0).toInt());
+    m_diskMaxFileSecondsSpinBox->setValue(settings->getCustomSetting("disk_capture_max_file_seconds", 0).toInt());
+    m_diskRingFilesSpinBox->setValue(settings->getCustomSetting("disk_capture_ring_files", 0).toInt());
+    m_diskDirectIoCheckBox->setChecked(settings->getCustomSetting("disk_capture_direct_io", true).toBool());
+    loadDecodeAsRules(settings->getDecodeAsRules());
     
     // Display settings
     m_hexFontCombo->setCurrentFont(QFont(settings->getHexViewFontFamily()));
@@ -547,6 +630,18 @@ void SettingsDialog::saveCurrentSettings()
     settings->setCaptureTimeout(m_captureTimeoutSpinBox->value());
     settings->setCustomSetting("promiscuous_mode", m_promiscuousModeCheckBox->isChecked());
     settings->setCustomSetting("buffer_size", m_bufferSizeSpinBox->value());
+    settings->setCustomSetting("disk_capture_enabled", m_diskCaptureCheckBox->isChecked());
+    settings->setCustomSetting("disk_capture_path", m_diskCapturePathEdit->text());
+    settings->setCustomSetting("disk_capture_max_file_mb", m_diskMaxFileSizeSpinBox->value());
+    settings->setCustomSetting("disk_capture_max_file_seconds", m_diskMaxFileSecondsSpinBox->value());
+    settings->setCustomSetting("disk_capture_ring_files", m_diskRingFilesSpinBox->value());
+    settings->setCustomSetting("disk_capture_direct_io", m_diskDirectIoCheckBox->isChecked());
+    
+    // Re-applied to the port registry by MainWindow on settingChanged
+    QStringList rules = decodeAsRules();
+    if (rules != settings->getDecodeAsRules()) {
+        settings->setDecodeAsRules(rules);
+    }
     
     // Display settings
     settings->setHexViewFont(m_hexFontCombo->currentFont().family(), m_hexFontSizeSpinBox->value());
@@ -569,6 +664,71 @@ void SettingsDialog::saveCurrentSettings()
     settings->saveSettings();
 }
 
+void SettingsDialog::addDecodeAsRow(const QString &transport, int port, const QString &protocol)
+{
+    int row = m_decodeAsTable->rowCount();
+    m_decodeAsTable->insertRow(row);
+    
+    QComboBox *transportCombo = new QComboBox;
+    transportCombo->addItem("TCP", "tcp");
+    transportCombo->addItem("UDP", "udp");
+    transportCombo->setCurrentIndex(qMax(0, transportCombo->findData(transport.toLower())));
+    connect(transportCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SettingsDialog::onSettingChanged);
+    m_decodeAsTable->setCellWidget(row, 0, transportCombo);
+    
+    QSpinBox *portSpinBox = new QSpinBox;
+    portSpinBox->setRange(1, 65535);
+    portSpinBox->setValue(port);
+    connect(portSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &SettingsDialog::onSettingChanged);
+    m_decodeAsTable->setCellWidget(row, 1, portSpinBox);
+    
+    // Every protocol the registry can dispatch to, plus "none" to turn
+    // dissection off for the port
+    QComboBox *protocolCombo = new QComboBox;
+    protocolCombo->addItem("None (raw data)", "none");
+    for (int app = PORT_APP_NONE + 1; app < PORT_APP_COUNT; ++app) {
+        QString name = QLatin1String(port_registry_app_name(static_cast<uint8_t>(app)));
+        protocolCombo->addItem(name, name.toLower());
+    }
+    protocolCombo->setCurrentIndex(qMax(0, protocolCombo->findData(protocol.toLower())));
+    connect(protocolCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SettingsDialog::onSettingChanged);
+    m_decodeAsTable->setCellWidget(row, 2, protocolCombo);
+}
+
+void SettingsDialog::loadDecodeAsRules(const QStringList &rules)
+{
+    m_decodeAsTable->setRowCount(0);
+    
+    for (const QString &rule : rules) {
+        // Same "tcp/8080=http" form ProtocolAnalysisWrapper::applyDecodeAs() reads
+        QStringList sides = rule.trimmed().split('=');
+        QStringList target = sides.value(0).split('/');
+        bool portOk = false;
+        int port = target.value(1).trimmed().toInt(&portOk);
+        if (sides.size() != 2 || target.size() != 2 || !portOk || port < 1 || port > 65535) {
+            continue;
+        }
+        addDecodeAsRow(target[0].trimmed(), port, sides[1].trimmed());
+    }
+}
+
+QStringList SettingsDialog::decodeAsRules() const
+{
+    QStringList rules;
+    for (int row = 0; row < m_decodeAsTable->rowCount(); ++row) {
+        QComboBox *transportCombo = qobject_cast<QComboBox*>(m_decodeAsTable->cellWidget(row, 0));
+        QSpinBox *portSpinBox = qobject_cast<QSpinBox*>(m_decodeAsTable->cellWidget(row, 1));
+        QComboBox *protocolCombo = qobject_cast<QComboBox*>(m_decodeAsTable->cellWidget(row, 2));
+        if (!transportCombo || !portSpinBox || !protocolCombo) {
+            continue;
+        }
+        rules.append(QString("%1/%2=%3").arg(transportCombo->currentData().toString())
+                                        .arg(portSpinBox->value())
+                                        .arg(protocolCombo->currentData().toString()));
+    }
+    return rules;
+}
+
 void SettingsDialog::updatePreview()
 {
     // Update any preview elements based on current settings
@@ -16,6 +16,7 @@
 #include <QFontComboBox>
 #include <QSlider>
 #include <QTextEdit>
+#include <QTableWidget>
 
 /**
  * @brief Settings configuration dialog
@@ -53,6 +54,11 @@ private:
     
     void loadCurrentSettings();
     void saveCurrentSettings();
+    
+    // Decode As rows: transport, port and protocol, as "tcp/8080=http"
+    void addDecodeAsRow(const QString &transport, int port, const QString &protocol);
+    void loadDecodeAsRules(const QStringList &rules);
+    QStringList decodeAsRules() const;
     void updatePreview();
 
     // UI components
@@ -81,6 +87,15 @@ private:
     QSpinBox *m_captureTimeoutSpinBox;
     QCheckBox *m_promiscuousModeCheckBox;
     QSpinBox *m_bufferSizeSpinBox;
+    QCheckBox *m_diskCaptureCheckBox;
+    QLineEdit *m_diskCapturePathEdit;
+    QSpinBox *m_diskMaxFileSizeSpinBox;
+    QSpinBox *m_diskMaxFileSecondsSpinBox;
+    QSpinBox *m_diskRingFilesSpinBox;
+    QCheckBox *m_diskDirectIoCheckBox;
+    QTableWidget *m_decodeAsTable;
+    QPushButton *m_decodeAsAddButton;
+    QPushButton *m_decodeAsRemoveButton;
     
     // Display tab
     QWidget *m_displayTab;
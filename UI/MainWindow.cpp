@@ -9,11 +9,15 @@
 #include "ARPSpoofingController.h"
 #include "SpeedTestWidget.h"
 #include "TimeSettingsDialog.h"
+#include "Dialogs/SettingsDialog.h"
 #include "LatencyTestWidget.h"
 #include "PortScanWidget.h"
 #include "MacLookupWidget.h"
 #include "DnsLookupWidget.h"
 #include "TracerouteWidget.h"
+#include "CaptureFileLoader.h"
+#include "BatchDissector.h"
+#include "CaptureControlWidget.h"
 #include "Models/PacketModel.h"
 #include "Models/ProtocolTreeModel.h"
 #include "Models/PacketFilterProxyModel.h"
@@ -21,6 +25,7 @@
 #include "Utils/MemoryManager.h"
 #include "Utils/ErrorRecoveryDialog.h"
 #include "Utils/SettingsManager.h"
+#include "Wrappers/ProtocolAnalysisWrapper.h"
 #include <QApplication>
 #include <QCloseEvent>
 #include <QMessageBox>
@@ -34,7 +39,9 @@
 #include <QTimer>
 #include <QAction>
 #include <QFileDialog>
+#include <QProgressDialog>
 #include <QDialog>
+#include <QDockWidget>
 #include <QPushButton>
 #include <QStandardPaths>
 #include <QStyle>
@@ -56,11 +63,14 @@ MainWindow::MainWindow(const QString &interface, QWidget *parent)
     , hexView(nullptr)
     , protocolView(nullptr)
     , filterWidget(nullptr)
+    , captureStatsDock(nullptr)
+    , captureControlWidget(nullptr)
     , mainToolBar(nullptr)
     , startCaptureAction(nullptr)
     , stopCaptureAction(nullptr)
     , clearPacketsAction(nullptr)
     , savePacketsAction(nullptr)
+    , openCaptureFileAction(nullptr)
     , deviceSelectionAction(nullptr)
     , exitAction(nullptr)
     , interfaceLabel(nullptr)
@@ -83,6 +93,9 @@ MainWindow::MainWindow(const QString &interface, QWidget *parent)
     , totalBytes(0)
     , spoofingActive(false)
     , arpSpoofingController(nullptr)
+    , captureFileLoader(nullptr)
+    , exportDissector(nullptr)
+    , exportProgress(nullptr)
     , currentTimeZoneMode(UTC_TIME)
     , customTimeZone(QTimeZone::utc())
 
@@ -96,6 +109,7 @@ MainWindow::MainWindow(const QString &interface, QWidget *parent)
             ErrorHandler::instance()->initialize(this);
             MemoryManager::instance()->initialize();
             SettingsManager::instance()->initialize();
+            ProtocolAnalysisWrapper::applyDecodeAs(SettingsManager::instance()->getDecodeAsRules());
         });
         
         // Defer signal connections for faster startup
@@ -191,6 +205,18 @@ MainWindow::~MainWindow()
         }
     }
     
+    // Stop loading a capture file; the loader joins its threads on destruction
+    if (captureFileLoader) {
+        disconnect(captureFileLoader, nullptr, this, nullptr);
+        captureFileLoader->cancel();
+    }
+    
+    // Abandon a JSON export that is still decoding
+    if (exportDissector) {
+        disconnect(exportDissector, nullptr, this, nullptr);
+        exportDissector->cancel();
+    }
+    
     // Disconnect all error handler signals to prevent callbacks
     if (ErrorHandler::instance()) {
         disconnect(ErrorHandler::instance(), nullptr, this, nullptr);
@@ -207,6 +233,11 @@ MainWindow::~MainWindow()
         disconnect(displayController, nullptr, this, nullptr);
     }
     
+    // The statistics widget must not stop the controller a second time
+    if (captureControlWidget) {
+        captureControlWidget->setCaptureController(nullptr);
+    }
+    
     // Disconnect model signals
     if (packetModel) {
         disconnect(packetModel, nullptr, this, nullptr);
@@ -260,6 +291,16 @@ void MainWindow::setupUI()
         displayController->setModels(packetModel, protocolModel);
     });
     
+    // Capture statistics dock; the toolbar owns starting and stopping, so
+    // the widget's own buttons are hidden
+    captureControlWidget = new CaptureControlWidget;
+    captureControlWidget->setControlsVisible(false);
+    captureControlWidget->setPacketModel(packetModel);
+    captureStatsDock = new QDockWidget("Capture Statistics", this);
+    captureStatsDock->setObjectName("captureStatsDock");
+    captureStatsDock->setWidget(captureControlWidget);
+    addDockWidget(Qt::RightDockWidgetArea, captureStatsDock);
+    
     // Connect memory limit exceeded signal
     connect(packetModel, &PacketModel::memoryLimitExceeded, this, &MainWindow::onMemoryLimitExceeded);
     
@@ -271,6 +312,13 @@ void MainWindow::setupMenuBar()
     // File menu
     QMenu *fileMenu = menuBar()->addMenu("&File");
     
+    openCaptureFileAction = new QAction("&Open Capture File...", this);
+    openCaptureFileAction->setShortcut(QKeySequence::Open);
+
+    openCaptureFileAction->setIcon(style()->standardIcon(QStyle::SP_DialogOpenButton));
+    connect(openCaptureFileAction, &QAction::triggered, this, &MainWindow::onOpenCaptureFile);
+    fileMenu->addAction(openCaptureFileAction);
+    
     savePacketsAction = new QAction("&Save Packets...", this);
     savePacketsAction->setShortcut(QKeySequence::Save);
 
@@ -377,6 +425,9 @@ void MainWindow::setupMenuBar()
     connect(collapseAllAction, &QAction::triggered, protocolView, &ProtocolTreeView::collapseAll);
     viewMenu->addAction(collapseAllAction);
     
+    viewMenu->addSeparator();
+    viewMenu->addAction(captureStatsDock->toggleViewAction());
+    
     // Settings menu
     QMenu *settingsMenu = menuBar()->addMenu("&Settings");
     
@@ -385,6 +436,11 @@ void MainWindow::setupMenuBar()
     connect(timeSettingsAction, &QAction::triggered, this, &MainWindow::onTimeSettingsRequested);
     settingsMenu->addAction(timeSettingsAction);
     
+    QAction *preferencesAction = new QAction("&Preferences...", this);
+    preferencesAction->setIcon(style()->standardIcon(QStyle::SP_FileDialogDetailedView));
+    connect(preferencesAction, &QAction::triggered, this, &MainWindow::onPreferencesRequested);
+    settingsMenu->addAction(preferencesAction);
+    
     qDebug() << "MainWindow: Menu bar setup completed";
 }
 
@@ -508,13 +564,7 @@ void MainWindow::connectSignals()
     connect(displayController, &PacketDisplayController::displayError,
             this, &MainWindow::onDisplayError);
     
-    // Capture controller signals are connected after creation in constructor
-    if (captureController) {
-        connect(captureController, &PacketCaptureController::backpressureApplied,
-                this, &MainWindow::onBackpressureApplied);
-        connect(captureController, &PacketCaptureController::samplingApplied,
-                this, &MainWindow::onSamplingApplied);
-    }
+    // Capture controller signals are connected in connectCaptureController()
     
     // Connect model signals
     connect(packetModel, &PacketModel::rowsInserted,
@@ -540,6 +590,31 @@ void MainWindow::connectSignals()
     qDebug() << "MainWindow: Signal connections completed";
 }
 
+void MainWindow::connectCaptureController()
+{
+    // Individual packet processing disabled for performance - only use batch processing
+    connect(captureController, &PacketCaptureController::packetsBatchCaptured,
+            this, &MainWindow::onNewPacketsBatchCaptured);
+    connect(captureController, &PacketCaptureController::captureError,
+            this, &MainWindow::onCaptureError);
+    connect(captureController, &PacketCaptureController::captureStatusChanged,
+            this, &MainWindow::onCaptureStatusChanged);
+    connect(captureController, &PacketCaptureController::backpressureApplied,
+            this, &MainWindow::onBackpressureApplied);
+    connect(captureController, &PacketCaptureController::backpressureReleased,
+            this, &MainWindow::onBackpressureReleased);
+    connect(captureController, &PacketCaptureController::samplingApplied,
+            this, &MainWindow::onSamplingApplied);
+    
+    // The model's memory pressure paces the credits given back to the workers
+    connect(packetModel, &PacketModel::memoryLimitExceeded,
+            captureController, &PacketCaptureController::onMemoryLimitExceeded);
+    connect(packetModel, &PacketModel::memoryPressureRelieved,
+            captureController, &PacketCaptureController::onMemoryPressureRelieved);
+    
+    captureControlWidget->setCaptureController(captureController);
+}
+
 void MainWindow::onStartCapture()
 {
     // If spoofing is active, this button should not start normal capture
@@ -548,6 +623,12 @@ void MainWindow::onStartCapture()
         return;
     }
     
+    // A live capture replaces whatever file is still loading
+    if (captureFileLoader && captureFileLoader->isLoading()) {
+        captureFileLoader->cancel();
+        openCaptureFileAction->setEnabled(true);
+    }
+    
     // Lazy initialization of capture controller for better performance
     if (!captureController) {
         try {
@@ -555,12 +636,7 @@ void MainWindow::onStartCapture()
             LOG_INFO(QString("MainWindow initialized capture controller for interface: %1").arg(networkInterface));
             
             // Connect capture controller signals after creation
-            connect(captureController, &PacketCaptureController::packetsBatchCaptured,
-                    this, &MainWindow::onNewPacketsBatchCaptured);
-            connect(captureController, &PacketCaptureController::captureError,
-                    this, &MainWindow::onCaptureError);
-            connect(captureController, &PacketCaptureController::captureStatusChanged,
-                    this, &MainWindow::onCaptureStatusChanged);
+            connectCaptureController();
             
         } catch (const std::exception &e) {
             LOG_CRITICAL(QString("Failed to initialize capture controller: %1").arg(e.what()));
@@ -570,6 +646,20 @@ void MainWindow::onStartCapture()
         }
     }
     
+    // Capture-to-disk settings are read fresh for every capture
+    SettingsManager *settings = SettingsManager::instance();
+    DiskCaptureSettings diskCapture;
+    diskCapture.enabled = settings->getCustomSetting("disk_capture_enabled", false).toBool();
+    diskCapture.path = settings->getCustomSetting("disk_capture_path", "").toString();
+    if (diskCapture.path.isEmpty()) {
+        diskCapture.path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/capture.pcapng";
+    }
+    diskCapture.maxFileBytes = settings->getCustomSetting("disk_capture_max_file_mb", 0).toLongLong() * 1024 * 1024;
+    diskCapture.maxFileSeconds = settings->getCustomSetting("disk_capture_max_file_seconds", 0).toInt();
+    diskCapture.ringFiles = settings->getCustomSetting("disk_capture_ring_files", 0).toInt();
+    diskCapture.directIo = settings->getCustomSetting("disk_capture_direct_io", true).toBool();
+    captureController->setDiskCapture(diskCapture);
+    
     captureController->startCapture();
     
     // Update UI state
@@ -692,6 +782,12 @@ void MainWindow::onNewPacketsBatchCaptured(const QList<PacketInfo> &packets)
     // Add batch of packets to model (much more efficient)
     packetModel->addPacketsBatch(packets);
     
+    // The batch is in the model: the capture workers may send more. Batches
+    // from a capture file being loaded owe the workers nothing
+    if (captureController && sender() == captureController) {
+        captureController->grantBatchCredits();
+    }
+    
     // High-speed capture optimization: disable auto-scrolling for large batches
     static int consecutiveLargeBatches = 0;
     if (packets.size() > 100) {
@@ -790,6 +886,14 @@ void MainWindow::updateStatistics()
     
     packetCountLabel->setText(QString("Packets: %1").arg(packetCount));
     bytesCountLabel->setText(QString("Bytes: %1").arg(totalBytes));
+    
+    // With sampling on, show what the live sample stands for
+    double ratio = captureController && captureController->isCapturing()
+                   ? captureController->getEffectiveSamplingRatio() : 1.0;
+    if (ratio > 0.0 && ratio < 1.0) {
+        packetCountLabel->setText(QString("Packets: %1 (~%2 seen)").arg(packetCount).arg(qRound64(packetCount / ratio)));
+        bytesCountLabel->setText(QString("Bytes: %1 (~%2 seen)").arg(totalBytes).arg(qRound64(totalBytes / ratio)));
+    }
 }
 
 void MainWindow::performThrottledUIUpdate()
@@ -965,6 +1069,7 @@ void MainWindow::resetCaptureController()
         
         // Delete and recreate capture controller
         if (captureController) {
+            captureControlWidget->setCaptureController(nullptr);
             captureController->deleteLater();
             captureController = nullptr;
         }
@@ -976,15 +1081,7 @@ void MainWindow::resetCaptureController()
         captureController = new PacketCaptureController(networkInterface, this);
         
         // Reconnect signals
-        // Individual packet processing disabled for performance - only use batch processing
-        // connect(captureController, &PacketCaptureController::packetCaptured,
-        //         this, &MainWindow::onNewPacketCaptured);
-        connect(captureController, &PacketCaptureController::packetsBatchCaptured,
-                this, &MainWindow::onNewPacketsBatchCaptured);
-        connect(captureController, &PacketCaptureController::captureError,
-                this, &MainWindow::onCaptureError);
-        connect(captureController, &PacketCaptureController::captureStatusChanged,
-                this, &MainWindow::onCaptureStatusChanged);
+        connectCaptureController();
         
         LOG_INFO("Capture controller reset successfully");
         
@@ -1058,6 +1155,10 @@ void MainWindow::onSettingChanged(const QString &key, const QVariant &value)
             }
         }
     }
+    else if (key == "capture/decode_as") {
+        // Only packets decoded from now on pick up the new mapping
+        ProtocolAnalysisWrapper::applyDecodeAs(value.toStringList());
+    }
     else if (key == "performance/update_interval") {
         // Update statistics timer interval
         int interval = value.toInt();
@@ -1257,12 +1358,7 @@ void MainWindow::onSpoofingStarted(const QList<QString> &targetIPs, const QStrin
             qDebug() << "MainWindow initialized capture controller for spoofing on interface:" << networkInterface;
             
             // Connect capture controller signals after creation
-            connect(captureController, &PacketCaptureController::packetsBatchCaptured,
-                    this, &MainWindow::onNewPacketsBatchCaptured);
-            connect(captureController, &PacketCaptureController::captureError,
-                    this, &MainWindow::onCaptureError);
-            connect(captureController, &PacketCaptureController::captureStatusChanged,
-                    this, &MainWindow::onCaptureStatusChanged);
+            connectCaptureController();
             
             printf("[DEBUG] MainWindow: Capture controller created for spoofing mode\n");
             
@@ -1404,31 +1500,144 @@ void MainWindow::onExportPackets()
 
 void MainWindow::exportToJson(const QString &fileName)
 {
+    if (exportDissector && exportDissector->isRunning()) {
+        QMessageBox::information(this, "Export In Progress", "Another export is still decoding packets.");
+        return;
+    }
+    
+    if (!exportDissector) {
+        exportDissector = new BatchDissector(this);
+        exportDissector->setKeepLayers(true);
+        connect(exportDissector, &BatchDissector::finished,
+                this, &MainWindow::onExportDissectionFinished);
+    }
+    
+    // Rows as they are now; capture may go on while the pool decodes them.
+    // The fields come from the model's columns and the frames are shared
+    // with the store, so nothing is copied or inflated here.
+    int packetCount = packetModel->rowCount();
+    pendingExportFile = fileName;
+    pendingExportPackets.clear();
+    pendingExportPackets.reserve(packetCount);
+    for (int i = 0; i < packetCount; ++i) {
+        PacketInfo packet;
+        packet.serialNumber = packetModel->serialAt(i);
+        packet.timestampNs = packetModel->timestampAt(i);
+        packet.sourceIP = packetModel->sourceAt(i);
+        packet.destinationIP = packetModel->destinationAt(i);
+        packet.packetLength = packetModel->lengthAt(i);
+        packet.protocolType = packetModel->protocolAt(i);
+        packet.moreInfo = packetModel->infoAt(i);
+        pendingExportPackets.append(packet);
+    }
+    pendingExportFrames = packetModel->getPacketBytes(0, packetCount);
+    
+    exportProgress = new QProgressDialog("Decoding packets for export...", "Cancel", 0, packetCount, this);
+    exportProgress->setWindowModality(Qt::WindowModal);
+    exportProgress->setMinimumDuration(500);
+    exportProgress->setAutoClose(false);
+    connect(exportDissector, &BatchDissector::progress, exportProgress, &QProgressDialog::setValue);
+    connect(exportProgress, &QProgressDialog::canceled, exportDissector, &BatchDissector::cancel);
+    
+    savePacketsAction->setEnabled(false);
+    if (!exportDissector->start(pendingExportFrames)) {
+        onExportDissectionFinished(false);
+    }
+}
+
+void MainWindow::onExportDissectionFinished(bool cancelled)
+{
+    savePacketsAction->setEnabled(true);
+    if (exportProgress) {
+        exportProgress->deleteLater();
+        exportProgress = nullptr;
+    }
+    
+    if (cancelled) {
+        pendingExportPackets.clear();
+        pendingExportFrames.clear();
+        exportDissector->clearResults();
+        statusBar()->showMessage("Export cancelled", 3000);
+        return;
+    }
+    
+    writeJsonExport();
+}
+
+static QJsonObject layerToJson(const ProtocolLayer &layer)
+{
+    QJsonObject layerJson;
+    layerJson["name"] = layer.name;
+    
+    QJsonArray fieldsArray;
+    for (const ProtocolField &field : layer.fields) {
+        QJsonObject fieldJson;
+        fieldJson["name"] = field.name;
+        if (!field.value.isEmpty()) {
+            fieldJson["value"] = field.value;
+        }
+        if (field.offset >= 0) {
+            fieldJson["offset"] = field.offset;
+            fieldJson["length"] = field.length;
+        }
+        fieldsArray.append(fieldJson);
+    }
+    layerJson["fields"] = fieldsArray;
+    
+    if (!layer.subLayers.isEmpty()) {
+        QJsonArray subLayersArray;
+        for (const ProtocolLayer &subLayer : layer.subLayers) {
+            subLayersArray.append(layerToJson(subLayer));
+        }
+        layerJson["layers"] = subLayersArray;
+    }
+    return layerJson;
+}
+
+void MainWindow::writeJsonExport()
+{
+    QString fileName = pendingExportFile;
+    QList<PacketInfo> exportPackets = pendingExportPackets;
+    QVector<PacketBytes> exportFrames = pendingExportFrames;
+    pendingExportPackets.clear();
+    pendingExportFrames.clear();
+    
     QFile file(fileName);
     if (!file.open(QIODevice::WriteOnly)) {
+        exportDissector->clearResults();
         QMessageBox::warning(this, "Export Failed", 
             QString("Failed to open file for writing:\n%1").arg(fileName));
         return;
     }
     
     QJsonArray packetsArray;
-    int packetCount = packetModel->rowCount();
+    int packetCount = exportPackets.size();
+    const QVector<QList<ProtocolLayer>> &decodedLayers = exportDissector->layers();
     
     for (int i = 0; i < packetCount; ++i) {
-        PacketInfo packet = packetModel->getPacket(i);
+        const PacketInfo &packet = exportPackets.at(i);
         
         QJsonObject packetJson;
         packetJson["serialNumber"] = packet.serialNumber;
-        packetJson["timestamp"] = packet.timestamp.toString(Qt::ISODate);
+        packetJson["timestamp"] = packet.timestampDateTime().toString(Qt::ISODate);
         packetJson["sourceIP"] = packet.sourceIP;
         packetJson["destinationIP"] = packet.destinationIP;
         packetJson["protocolType"] = packet.protocolType;
         packetJson["moreInfo"] = packet.moreInfo;
         packetJson["packetLength"] = packet.packetLength;
-        packetJson["rawData"] = QString(packet.rawData.toHex());
+        packetJson["rawData"] = QString(exportFrames.at(i).bytes().toHex());
+        
+        if (i < decodedLayers.size()) {
+            QJsonArray layersArray;
+            for (const ProtocolLayer &layer : decodedLayers.at(i)) {
+                layersArray.append(layerToJson(layer));
+            }
+            packetJson["layers"] = layersArray;
+        }
         
         packetsArray.append(packetJson);
     }
+    exportDissector->clearResults();
     
     QJsonObject root;
     root["packetCount"] = packetCount;
@@ -1472,10 +1681,13 @@ void MainWindow::exportToPcap(const QString &fileName)
     
     file.write(reinterpret_cast<const char*>(&header), sizeof(header));
     
-    // Write packets
+    // Write packets straight from the store; compressed frames are
+    // inflated into one reused buffer
     int packetCount = packetModel->rowCount();
+    QByteArray scratch;
     for (int i = 0; i < packetCount; ++i) {
-        PacketInfo packet = packetModel->getPacket(i);
+        qint64 timestampNs = packetModel->timestampAt(i);
+        QByteArray frame = packetModel->frameBytes(i, scratch);
         
         // PCAP Packet Header (16 bytes)
         struct pcap_pkthdr {
@@ -1485,13 +1697,13 @@ void MainWindow::exportToPcap(const QString &fileName)
             quint32 orig_len;   // actual length of packet
         } pkt_header;
         
-        pkt_header.ts_sec = packet.timestamp.toSecsSinceEpoch();
-        pkt_header.ts_usec = (packet.timestamp.time().msec() * 1000);
-        pkt_header.incl_len = packet.packetLength;
-        pkt_header.orig_len = packet.packetLength;
+        pkt_header.ts_sec = static_cast<quint32>(timestampNs / NANOSECONDS_PER_SECOND);
+        pkt_header.ts_usec = static_cast<quint32>((timestampNs % NANOSECONDS_PER_SECOND) / 1000);
+        pkt_header.incl_len = frame.size();
+        pkt_header.orig_len = packetModel->lengthAt(i);
         
         file.write(reinterpret_cast<const char*>(&pkt_header), sizeof(pkt_header));
-        file.write(packet.rawData);
+        file.write(frame.constData(), frame.size());
     }
     
     file.close();
@@ -1500,6 +1712,86 @@ void MainWindow::exportToPcap(const QString &fileName)
         QString("Exported %1 packets to:\n%2").arg(packetCount).arg(fileName));
 }
 
+void MainWindow::onOpenCaptureFile()
+{
+    if (isCapturing || spoofingActive) {
+        QMessageBox::warning(this, "Capture Active", "Stop the current capture before opening a capture file.");
+        return;
+    }
+    
+    QString fileName = QFileDialog::getOpenFileName(this,
+        "Open Capture File",
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+        "Capture Files (*.pcap *.pcapng *.cap);;All Files (*)");
+    
+    if (fileName.isEmpty()) {
+        return;
+    }
+    
+    if (!captureFileLoader) {
+        captureFileLoader = new CaptureFileLoader(this);
+        
+        // Loaded chunks take the same path as live capture batches
+        connect(captureFileLoader, &CaptureFileLoader::packetsLoaded,
+                this, &MainWindow::onNewPacketsBatchCaptured);
+        connect(captureFileLoader, &CaptureFileLoader::packetsIndexed,
+                packetModel, &PacketModel::appendMappedPackets);
+        connect(captureFileLoader, &CaptureFileLoader::progress,
+                this, &MainWindow::onCaptureFileProgress);
+        connect(captureFileLoader, &CaptureFileLoader::finished,
+                this, &MainWindow::onCaptureFileLoaded);
+        connect(captureFileLoader, &CaptureFileLoader::loadError,
+                this, &MainWindow::onCaptureFileError);
+    }
+    
+    captureFileLoader->cancel();
+    packetModel->clearPackets();
+    
+    if (!captureFileLoader->load(fileName)) {
+        return;
+    }
+    
+    // Large files stay on disk; the model summarizes rows as they are shown
+    if (captureFileLoader->isMapped()) {
+        packetModel->setMappedCaptureFile(captureFileLoader->captureFile(),
+                                          &PacketCaptureController::summarizePacket);
+    }
+    
+    openCaptureFileAction->setEnabled(false);
+    captureStatusLabel->setText(QString("Status: Loading %1").arg(QFileInfo(fileName).fileName()));
+    captureStatusLabel->setStyleSheet("color: blue; font-weight: bold;");
+    
+    qDebug() << "MainWindow: Opening capture file" << fileName;
+}
+
+void MainWindow::onCaptureFileProgress(qint64 bytesLoaded, qint64 totalBytes)
+{
+    int percent = totalBytes > 0 ? static_cast<int>(bytesLoaded * 100 / totalBytes) : 100;
+    captureStatusLabel->setText(QString("Status: Loading %1 (%2%)")
+                                .arg(QFileInfo(captureFileLoader->fileName()).fileName())
+                                .arg(percent));
+}
+
+void MainWindow::onCaptureFileLoaded(int packetCount)
+{
+    openCaptureFileAction->setEnabled(true);
+    uiUpdateTimer->stop();
+    packetTable->setAutoScroll(true);
+    updateStatistics();
+    
+    captureStatusLabel->setText(QString("Status: File %1").arg(QFileInfo(captureFileLoader->fileName()).fileName()));
+    captureStatusLabel->setStyleSheet("color: black; font-weight: bold;");
+    statusBar()->showMessage(QString("Loaded %1 packets").arg(packetCount), 3000);
+}
+
+void MainWindow::onCaptureFileError(const QString &error)
+{
+    if (!captureFileLoader->isLoading()) {
+        openCaptureFileAction->setEnabled(true);
+    }
+    QMessageBox::warning(this, "Capture File Error", error);
+}
+
 void MainWindow::onSpeedTestRequested()
 {
     // Create speed test dialog
@@ -1717,6 +2009,13 @@ void MainWindow::onTimeSettingsRequested()
     dialog->deleteLater();
 }
 
+void MainWindow::onPreferencesRequested()
+{
+    // Changes reach the window through SettingsManager::settingChanged
+    SettingsDialog dialog(this);
+    dialog.exec();
+}
+
 void MainWindow::onMemoryLimitExceeded()
 {
     LOG_WARNING("Memory limit exceeded, applying retention policy");
@@ -1747,6 +2046,16 @@ void MainWindow::onBackpressureApplied()
     captureStatusLabel->setStyleSheet("color: orange; font-weight: bold;");
 }
 
+void MainWindow::onBackpressureReleased()
+{
+    LOG_INFO("Backpressure on packet capture released");
+    
+    if (isCapturing) {
+        captureStatusLabel->setText("Status: Capturing");
+        captureStatusLabel->setStyleSheet("color: green; font-weight: bold;");
+    }
+}
+
 void MainWindow::onSamplingApplied()
 {
     LOG_INFO("Packet sampling applied to reduce capture load");
@@ -29,6 +29,11 @@ class PacketParserWorker;
 class DeviceSelectionDialog;
 class ARPSpoofingController;
 class SpeedTestWidget;
+class CaptureFileLoader;
+class BatchDissector;
+class QProgressDialog;
+class QDockWidget;
+class CaptureControlWidget;
 
 class MainWindow : public QMainWindow
 {
@@ -61,6 +66,7 @@ private slots:
     // Memory and performance management slots
     void onMemoryLimitExceeded();
     void onBackpressureApplied();
+    void onBackpressureReleased();
     void onSamplingApplied();
     
     // Settings management slots
@@ -80,6 +86,13 @@ private slots:
     
     // Export functionality
     void onExportPackets();
+    void onExportDissectionFinished(bool cancelled);
+    
+    // Offline capture files
+    void onOpenCaptureFile();
+    void onCaptureFileProgress(qint64 bytesLoaded, qint64 totalBytes);
+    void onCaptureFileLoaded(int packetCount);
+    void onCaptureFileError(const QString &error);
     
     // Speed test functionality
     void onSpeedTestRequested();
@@ -101,6 +114,7 @@ private slots:
     
     // Settings functionality
     void onTimeSettingsRequested();
+    void onPreferencesRequested();
 
 
 protected:
@@ -113,11 +127,13 @@ private:
     void setupSplitters();
     void setupMenuBar();
     void connectSignals();
+    void connectCaptureController();
     QList<QString> getTargetMACsFromIPs(const QList<QString> &targetIPs);
     
     // Export helper methods
     void exportToJson(const QString &fileName);
     void exportToPcap(const QString &fileName);
+    void writeJsonExport();
     
     // UI Components
     QWidget *centralWidget;
@@ -129,12 +145,17 @@ private:
     ProtocolTreeView *protocolView;
     PacketFilterWidget *filterWidget;
     
+    // Capture status and per-stage drop counters
+    QDockWidget *captureStatsDock;
+    CaptureControlWidget *captureControlWidget;
+    
     // Toolbar and actions
     QToolBar *mainToolBar;
     QAction *startCaptureAction;
     QAction *stopCaptureAction;
     QAction *clearPacketsAction;
     QAction *savePacketsAction;
+    QAction *openCaptureFileAction;
     QAction *deviceSelectionAction;
 
     QAction *exitAction;
@@ -160,6 +181,16 @@ private:
     DeviceSelectionDialog *deviceSelectionDialog;
     ARPSpoofingController *arpSpoofingController;
     
+    // Offline capture file loading
+    CaptureFileLoader *captureFileLoader;
+    
+    // JSON export decodes every packet on a thread pool first
+    BatchDissector *exportDissector;
+    QProgressDialog *exportProgress;
+    QString pendingExportFile;
+    QList<PacketInfo> pendingExportPackets;     // Row fields only; frames are below
+    QVector<PacketBytes> pendingExportFrames;
+    
     // State
     QString networkInterface;
     bool isCapturing;
@@ -0,0 +1,791 @@
+#include "DisplayFilter.h"
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+extern "C" {
+    #include "../../src/packetcapture/packet_summary.h"
+}
+
+/**
+ * @brief Recursive descent parser that appends DisplayFilter bytecode as it goes
+ *
+ * Boolean operators become jumps over the rest of their group, patched once
+ * the group is parsed, so the output needs no second pass.
+ */
+class DisplayFilterCompiler
+{
+public:
+    DisplayFilterCompiler(const QString &text, DisplayFilter &filter)
+        : text(text), filter(filter), current(0) {}
+
+    bool run(QString *error);
+
+private:
+    struct Token {
+        enum Type {
+            Word,           // Field, protocol or unquoted value
+            Quoted,
+            Relation,
+            And,
+            Or,
+            Not,
+            In,
+            OpenParen,
+            CloseParen,
+            OpenBrace,
+            CloseBrace,
+            Comma,
+            End
+        };
+        Type type;
+        QString text;
+        int column;
+    };
+
+    enum Relation { Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual };
+    enum ValueType { IntegerValue, IPv4Value, IPv6Value, IpProtoValue };
+
+    struct FieldSpec {
+        const char *name;
+        ValueType type;
+        QVector<quint8> fields;   // Two for the "either end" fields
+    };
+
+    // A parsed value: an inclusive range, or an IPv6 prefix
+    struct Value {
+        quint64 low;
+        quint64 high;
+        bool subnet;             // Address with a prefix shorter than the address
+        DisplayFilter::Prefix prefix;
+        int bits;
+    };
+
+    bool tokenize();
+    bool fail(const QString &problem, int column);
+    const Token &peek() const { return tokens.at(current); }
+    const Token &take() { return tokens.at(current++); }
+
+    bool parseOr();
+    bool parseAnd();
+    bool parseUnary();
+    bool parseTest();
+    bool parseComparison(const FieldSpec &spec, const Token &fieldToken);
+    bool parseSet(const FieldSpec &spec);
+    bool parseValue(const Token &token, ValueType type, Value &value);
+    bool parseProtocol(const QString &name);
+
+    int append(DisplayFilter::Op op, quint8 field = 0, qint32 operand = 0, quint64 low = 0, quint64 high = 0);
+    void patch(const QVector<int> &jumps);
+    void appendPrefix(DisplayFilter::Op op, quint8 field, const Value &value);
+
+    static const FieldSpec *findField(const QString &name);
+    static bool parseRelation(const QString &text, Relation &relation);
+
+    const QString &text;
+    DisplayFilter &filter;
+    QVector<Token> tokens;
+    int current;
+    QString message;
+};
+
+const DisplayFilterCompiler::FieldSpec *DisplayFilterCompiler::findField(const QString &name) {
+    static const QVector<FieldSpec> specs = {
+        {"frame.number", IntegerValue, {DisplayFilter::FieldFrameNumber}},
+        {"frame.len", IntegerValue, {DisplayFilter::FieldFrameLength}},
+        {"ip.src", IPv4Value, {DisplayFilter::FieldIpSource}},
+        {"ip.dst", IPv4Value, {DisplayFilter::FieldIpDestination}},
+        {"ip.addr", IPv4Value, {DisplayFilter::FieldIpSource, DisplayFilter::FieldIpDestination}},
+        {"ip.proto", IpProtoValue, {DisplayFilter::FieldIpProto}},
+        {"ipv6.src", IPv6Value, {DisplayFilter::FieldIpv6Source}},
+        {"ipv6.dst", IPv6Value, {DisplayFilter::FieldIpv6Destination}},
+        {"ipv6.addr", IPv6Value, {DisplayFilter::FieldIpv6Source, DisplayFilter::FieldIpv6Destination}},
+        {"tcp.srcport", IntegerValue, {DisplayFilter::FieldTcpSourcePort}},
+        {"tcp.dstport", IntegerValue, {DisplayFilter::FieldTcpDestinationPort}},
+        {"tcp.port", IntegerValue, {DisplayFilter::FieldTcpSourcePort, DisplayFilter::FieldTcpDestinationPort}},
+        {"udp.srcport", IntegerValue, {DisplayFilter::FieldUdpSourcePort}},
+        {"udp.dstport", IntegerValue, {DisplayFilter::FieldUdpDestinationPort}},
+        {"udp.port", IntegerValue, {DisplayFilter::FieldUdpSourcePort, DisplayFilter::FieldUdpDestinationPort}},
+    };
+
+    for (const FieldSpec &spec : specs) {
+        if (name == QLatin1String(spec.name)) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+bool DisplayFilterCompiler::parseRelation(const QString &text, Relation &relation) {
+    static const QVector<QPair<QString, Relation>> names = {
+        {"==", Equal}, {"eq", Equal}, {"!=", NotEqual}, {"ne", NotEqual},
+        {"<", Less}, {"lt", Less}, {"<=", LessOrEqual}, {"le", LessOrEqual},
+        {">", Greater}, {"gt", Greater}, {">=", GreaterOrEqual}, {"ge", GreaterOrEqual},
+    };
+
+    for (const auto &name : names) {
+        if (text == name.first) {
+            relation = name.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DisplayFilterCompiler::run(QString *error) {
+    filter = DisplayFilter();
+    filter.source = text;
+
+    bool ok = tokenize();
+    if (ok && peek().type == Token::End) {
+        ok = fail(QStringLiteral("Empty filter"), 0);
+    }
+    ok = ok && parseOr();
+    if (ok && peek().type != Token::End) {
+        ok = fail(QString("Unexpected \"%1\"").arg(peek().text), peek().column);
+    }
+
+    if (!ok) {
+        if (error) {
+            *error = message;
+        }
+        filter = DisplayFilter();
+        return false;
+    }
+    filter.valid = true;
+    return true;
+}
+
+bool DisplayFilterCompiler::fail(const QString &problem, int column) {
+    message = QString("%1 at column %2").arg(problem).arg(column + 1);
+    return false;
+}
+
+bool DisplayFilterCompiler::tokenize() {
+    int i = 0;
+    while (i < text.size()) {
+        QChar c = text.at(i);
+        if (c.isSpace()) {
+            i++;
+            continue;
+        }
+
+        Token token;
+        token.column = i;
+
+        // Words cover field names, numbers and both address families
+        if (c.isLetterOrNumber() || c == '_' || c == '.' || c == ':' || c == '/') {
+            int start = i;
+            while (i < text.size()) {
+                QChar w = text.at(i);
+                if (!(w.isLetterOrNumber() || w == '_' || w == '.' || w == ':' || w == '/' || w == '-')) {
+                    break;
+                }
+                i++;
+            }
+            token.text = text.mid(start, i - start).toLower();
+            if (token.text == "and") {
+                token.type = Token::And;
+            } else if (token.text == "or") {
+                token.type = Token::Or;
+            } else if (token.text == "not") {
+                token.type = Token::Not;
+            } else if (token.text == "in") {
+                token.type = Token::In;
+            } else {
+                Relation relation;
+                token.type = parseRelation(token.text, relation) ? Token::Relation : Token::Word;
+            }
+            tokens.append(token);
+            continue;
+        }
+
+        if (c == '"') {
+            int end = text.indexOf('"', i + 1);
+            if (end < 0) {
+                return fail(QStringLiteral("Unterminated string"), i);
+            }
+            token.type = Token::Quoted;
+            token.text = text.mid(i + 1, end - i - 1).toLower();
+            tokens.append(token);
+            i = end + 1;
+            continue;
+        }
+
+        QString two = text.mid(i, 2);
+        if (two == "==" || two == "!=" || two == "<=" || two == ">=") {
+            token.type = Token::Relation;
+            token.text = two;
+            i += 2;
+        } else if (two == "&&") {
+            token.type = Token::And;
+            token.text = two;
+            i += 2;
+        } else if (two == "||") {
+            token.type = Token::Or;
+            token.text = two;
+            i += 2;
+        } else {
+            token.text = QString(c);
+            i++;
+            switch (c.unicode()) {
+                case '<':
+                case '>':
+                    token.type = Token::Relation;
+                    break;
+                case '!':
+                    token.type = Token::Not;
+                    break;
+                case '(':
+                    token.type = Token::OpenParen;
+                    break;
+                case ')':
+                    token.type = Token::CloseParen;
+                    break;
+                case '{':
+                    token.type = Token::OpenBrace;
+                    break;
+                case '}':
+                    token.type = Token::CloseBrace;
+                    break;
+                case ',':
+                    token.type = Token::Comma;
+                    break;
+                default:
+                    return fail(QString("Unexpected \"%1\"").arg(c), token.column);
+            }
+        }
+        tokens.append(token);
+    }
+
+    Token end;
+    end.type = Token::End;
+    end.column = text.size();
+    tokens.append(end);
+    return true;
+}
+
+bool DisplayFilterCompiler::parseOr() {
+    if (!parseAnd()) {
+        return false;
+    }
+
+    QVector<int> jumps;
+    while (peek().type == Token::Or) {
+        take();
+        jumps.append(append(DisplayFilter::OpJumpIfTrue));
+        if (!parseAnd()) {
+            return false;
+        }
+    }
+    patch(jumps);
+    return true;
+}
+
+bool DisplayFilterCompiler::parseAnd() {
+    if (!parseUnary()) {
+        return false;
+    }
+
+    QVector<int> jumps;
+    while (peek().type == Token::And) {
+        take();
+        jumps.append(append(DisplayFilter::OpJumpIfFalse));
+        if (!parseUnary()) {
+            return false;
+        }
+    }
+    patch(jumps);
+    return true;
+}
+
+bool DisplayFilterCompiler::parseUnary() {
+    const Token &token = peek();
+
+    if (token.type == Token::Not) {
+        take();
+        if (!parseUnary()) {
+            return false;
+        }
+        append(DisplayFilter::OpNot);
+        return true;
+    }
+
+    if (token.type == Token::OpenParen) {
+        take();
+        if (!parseOr()) {
+            return false;
+        }
+        if (peek().type != Token::CloseParen) {
+            return fail(QStringLiteral("Expected \")\""), peek().column);
+        }
+        take();
+        return true;
+    }
+
+    return parseTest();
+}
+
+bool DisplayFilterCompiler::parseTest() {
+    const Token &token = take();
+    if (token.type != Token::Word) {
+        return fail(token.type == Token::End ? QStringLiteral("Expected a field")
+                                             : QString("Expected a field, not \"%1\"").arg(token.text),
+                    token.column);
+    }
+
+    const FieldSpec *spec = findField(token.text);
+    if (!spec) {
+        if (!parseProtocol(token.text)) {
+            return fail(QString("Unknown field \"%1\"").arg(token.text), token.column);
+        }
+        if (peek().type == Token::Relation || peek().type == Token::In) {
+            return fail(QString("\"%1\" is a protocol and has no value").arg(token.text), peek().column);
+        }
+        return true;
+    }
+
+    if (peek().type == Token::Relation) {
+        return parseComparison(*spec, token);
+    }
+    if (peek().type == Token::In) {
+        take();
+        return parseSet(*spec);
+    }
+
+    // A field on its own: does the packet have it at all
+    QVector<int> jumps;
+    for (int i = 0; i < spec->fields.size(); ++i) {
+        if (i > 0) {
+            jumps.append(append(DisplayFilter::OpJumpIfTrue));
+        }
+        append(DisplayFilter::OpPresent, spec->fields.at(i));
+    }
+    patch(jumps);
+    return true;
+}
+
+bool DisplayFilterCompiler::parseProtocol(const QString &name) {
+    if (name == "frame" || name == "eth") {
+        append(DisplayFilter::OpTrue);
+    } else if (name == "ip") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldL3, 0, PACKET_L3_IPV4, PACKET_L3_IPV4);
+    } else if (name == "ipv6") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldL3, 0, PACKET_L3_IPV6, PACKET_L3_IPV6);
+    } else if (name == "arp") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldL3, 0, PACKET_L3_ARP, PACKET_L3_ARP);
+    } else if (name == "tcp") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldIpProto, 0, IPPROTO_TCP, IPPROTO_TCP);
+    } else if (name == "udp") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldIpProto, 0, IPPROTO_UDP, IPPROTO_UDP);
+    } else if (name == "icmp") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldIpProto, 0, IPPROTO_ICMP, IPPROTO_ICMP);
+    } else if (name == "icmpv6") {
+        append(DisplayFilter::OpRange, DisplayFilter::FieldIpProto, 0, IPPROTO_ICMPV6, IPPROTO_ICMPV6);
+    } else {
+        // Application protocols, as the port registry and heuristics name them
+        int app = name == "tls" ? PORT_APP_HTTPS : port_registry_app_from_name(name.toLatin1().constData());
+        if (app <= PORT_APP_NONE) {
+            return false;
+        }
+        append(DisplayFilter::OpRange, DisplayFilter::FieldAppProto, 0, static_cast<quint64>(app), static_cast<quint64>(app));
+    }
+    return true;
+}
+
+bool DisplayFilterCompiler::parseComparison(const FieldSpec &spec, const Token &fieldToken) {
+    const Token &relationToken = take();
+    Relation relation;
+    parseRelation(relationToken.text, relation);
+
+    const Token &valueToken = take();
+    if (valueToken.type != Token::Word && valueToken.type != Token::Quoted) {
+        return fail(QString("Expected a value after \"%1\"").arg(relationToken.text), valueToken.column);
+    }
+    Value value;
+    if (!parseValue(valueToken, spec.type, value)) {
+        return false;
+    }
+
+    bool ordering = relation != Equal && relation != NotEqual;
+    if (ordering && (spec.type == IPv6Value || value.subnet)) {
+        return fail(QString("\"%1\" cannot be ordered against %2")
+                        .arg(fieldToken.text, spec.type == IPv6Value ? "an IPv6 address" : "a subnet"),
+                    relationToken.column);
+    }
+
+    DisplayFilter::Op op = DisplayFilter::OpRange;
+    quint64 low = value.low;
+    quint64 high = value.high;
+    const quint64 maximum = std::numeric_limits<quint64>::max();
+    switch (relation) {
+        case Equal:
+            break;
+        case NotEqual:
+            op = DisplayFilter::OpOutside;
+            break;
+        case Less:
+            // An empty range when nothing is smaller
+            low = value.low == 0 ? 1 : 0;
+            high = value.low == 0 ? 0 : value.low - 1;
+            break;
+        case LessOrEqual:
+            low = 0;
+            break;
+        case Greater:
+            low = value.low == maximum ? 1 : value.low + 1;
+            high = value.low == maximum ? 0 : maximum;
+            break;
+        case GreaterOrEqual:
+            high = maximum;
+            break;
+    }
+
+    // Either end for ==, <, ..; every end for !=
+    QVector<int> jumps;
+    for (int i = 0; i < spec.fields.size(); ++i) {
+        if (i > 0) {
+            jumps.append(append(relation == NotEqual ? DisplayFilter::OpJumpIfFalse : DisplayFilter::OpJumpIfTrue));
+        }
+        if (spec.type == IPv6Value) {
+            appendPrefix(relation == NotEqual ? DisplayFilter::OpOutsidePrefix : DisplayFilter::OpPrefix,
+                       spec.fields.at(i), value);
+        } else {
+            append(op, spec.fields.at(i), 0, low, high);
+        }
+    }
+    patch(jumps);
+    return true;
+}
+
+bool DisplayFilterCompiler::parseSet(const FieldSpec &spec) {
+    if (peek().type != Token::OpenBrace) {
+        return fail(QStringLiteral("Expected \"{\" after \"in\""), peek().column);
+    }
+    take();
+
+    QVector<QPair<quint64, quint64>> ranges;
+    QVector<Value> prefixes;
+    while (peek().type != Token::CloseBrace) {
+        const Token &token = take();
+        if (token.type != Token::Word && token.type != Token::Quoted) {
+            return fail(token.type == Token::End ? QStringLiteral("Expected \"}\"")
+                                                 : QString("Expected a value, not \"%1\"").arg(token.text),
+                        token.column);
+        }
+
+        // "a..b"; no address or number contains two dots in a row
+        int dots = token.text.indexOf(QLatin1String(".."));
+        Value first;
+        if (dots < 0) {
+            if (!parseValue(token, spec.type, first)) {
+                return false;
+            }
+        } else {
+            if (spec.type == IPv6Value) {
+                return fail(QStringLiteral("IPv6 addresses take prefixes, not ranges"), token.column);
+            }
+            Token from = token;
+            Token to = token;
+            from.text = token.text.left(dots);
+            to.text = token.text.mid(dots + 2);
+            to.column = token.column + dots + 2;
+            Value last;
+            if (!parseValue(from, spec.type, first) || !parseValue(to, spec.type, last)) {
+                return false;
+            }
+            if (last.high < first.low) {
+                return fail(QString("Empty range \"%1\"").arg(token.text), token.column);
+            }
+            first.high = last.high;
+        }
+
+        if (spec.type == IPv6Value) {
+            prefixes.append(first);
+        } else {
+            ranges.append(qMakePair(first.low, first.high));
+        }
+
+        if (peek().type == Token::Comma) {
+            take();
+        }
+    }
+    take();
+
+    if (ranges.isEmpty() && prefixes.isEmpty()) {
+        append(DisplayFilter::OpTrue);
+        append(DisplayFilter::OpNot);
+        return true;
+    }
+
+    QVector<int> jumps;
+    if (spec.type == IPv6Value) {
+        // Few enough in practice to test one after the other
+        int tests = 0;
+        for (quint8 field : spec.fields) {
+            for (const Value &prefix : prefixes) {
+                if (tests++ > 0) {
+                    jumps.append(append(DisplayFilter::OpJumpIfTrue));
+                }
+                appendPrefix(DisplayFilter::OpPrefix, field, prefix);
+            }
+        }
+        patch(jumps);
+        return true;
+    }
+
+    // Sorted and merged, so membership is one binary search
+    std::sort(ranges.begin(), ranges.end());
+    int first = filter.sets.size();
+    for (const auto &range : ranges) {
+        if (filter.sets.size() > first) {
+            QPair<quint64, quint64> &last = filter.sets.last();
+            if (last.second == std::numeric_limits<quint64>::max() || range.first <= last.second + 1) {
+                last.second = qMax(last.second, range.second);
+                continue;
+            }
+        }
+        filter.sets.append(range);
+    }
+    int count = filter.sets.size() - first;
+
+    for (int i = 0; i < spec.fields.size(); ++i) {
+        if (i > 0) {
+            jumps.append(append(DisplayFilter::OpJumpIfTrue));
+        }
+        append(DisplayFilter::OpInSet, spec.fields.at(i), first, static_cast<quint64>(count));
+    }
+    patch(jumps);
+    return true;
+}
+
+bool DisplayFilterCompiler::parseValue(const Token &token, ValueType type, Value &value) {
+    value.subnet = false;
+    value.bits = 0;
+    memset(value.prefix.bytes, 0, sizeof(value.prefix.bytes));
+
+    QString text = token.text;
+    bool ok = false;
+
+    if (type == IntegerValue || type == IpProtoValue) {
+        quint64 number = text.startsWith(QLatin1String("0x")) ? text.mid(2).toULongLong(&ok, 16)
+                                                             : text.toULongLong(&ok, 10);
+        if (!ok && type == IpProtoValue) {
+            static const QVector<QPair<QString, quint64>> names = {
+                {"icmp", IPPROTO_ICMP}, {"tcp", IPPROTO_TCP}, {"udp", IPPROTO_UDP}, {"icmpv6", IPPROTO_ICMPV6},
+            };
+            for (const auto &name : names) {
+                if (text == name.first) {
+                    number = name.second;
+                    ok = true;
+                }
+            }
+        }
+        if (!ok) {
+            return fail(QString("\"%1\" is not a number").arg(token.text), token.column);
+        }
+        value.low = number;
+        value.high = number;
+        return true;
+    }
+
+    // Addresses, with an optional prefix length
+    int slash = text.indexOf('/');
+    int maxBits = type == IPv4Value ? 32 : 128;
+    int bits = maxBits;
+    if (slash >= 0) {
+        bits = text.mid(slash + 1).toInt(&ok);
+        if (!ok || bits < 0 || bits > maxBits) {
+            return fail(QString("Bad prefix length in \"%1\"").arg(token.text), token.column);
+        }
+        text = text.left(slash);
+    }
+
+    QByteArray address = text.toLatin1();
+    if (type == IPv4Value) {
+        quint8 bytes[4];
+        if (inet_pton(AF_INET, address.constData(), bytes) != 1) {
+            return fail(QString("\"%1\" is not an IPv4 address").arg(token.text), token.column);
+        }
+        quint64 mask = bits == 0 ? 0 : (0xffffffffULL << (32 - bits)) & 0xffffffffULL;
+        quint64 network = qFromBigEndian<quint32>(bytes) & mask;
+        value.low = network;
+        value.high = network | (~mask & 0xffffffffULL);
+    } else {
+        if (inet_pton(AF_INET6, address.constData(), value.prefix.bytes) != 1) {
+            return fail(QString("\"%1\" is not an IPv6 address").arg(token.text), token.column);
+        }
+        value.low = 0;
+        value.high = 0;
+    }
+    value.bits = bits;
+    value.subnet = bits < maxBits;
+    return true;
+}
+
+int DisplayFilterCompiler::append(DisplayFilter::Op op, quint8 field, qint32 operand, quint64 low, quint64 high) {
+    DisplayFilter::Instruction instruction;
+    instruction.op = op;
+    instruction.field = field;
+    instruction.operand = operand;
+    instruction.low = low;
+    instruction.high = high;
+    filter.program.append(instruction);
+    return filter.program.size() - 1;
+}
+
+void DisplayFilterCompiler::patch(const QVector<int> &jumps) {
+    for (int jump : jumps) {
+        filter.program[jump].operand = filter.program.size();
+    }
+}
+
+void DisplayFilterCompiler::appendPrefix(DisplayFilter::Op op, quint8 field, const Value &value) {
+    append(op, field, filter.prefixes.size(), static_cast<quint64>(value.bits));
+    filter.prefixes.append(value.prefix);
+}
+
+// DisplayFilter implementation
+DisplayFilter DisplayFilter::compile(const QString &text, QString *error) {
+    DisplayFilter filter;
+    DisplayFilterCompiler(text, filter).run(error);
+    return filter;
+}
+
+bool DisplayFilter::matches(const DisplayFilterRow &row) const {
+    const Instruction *code = program.constData();
+    const int size = program.size();
+    bool result = true;
+
+    for (int pc = 0; pc < size; ++pc) {
+        const Instruction &instruction = code[pc];
+        quint64 value;
+
+        switch (instruction.op) {
+            case OpTrue:
+                result = true;
+                break;
+            case OpPresent:
+                result = address(instruction.field, row) || load(instruction.field, row, value);
+                break;
+            case OpRange:
+                result = load(instruction.field, row, value) &&
+                         value >= instruction.low && value <= instruction.high;
+                break;
+            case OpOutside:
+                result = load(instruction.field, row, value) &&
+                         (value < instruction.low || value > instruction.high);
+                break;
+            case OpInSet:
+                result = load(instruction.field, row, value) &&
+                         inSet(instruction.operand, static_cast<int>(instruction.low), value);
+                break;
+            case OpPrefix:
+            case OpOutsidePrefix: {
+                const quint8 *bytes = address(instruction.field, row);
+                if (!bytes) {
+                    result = false;
+                    break;
+                }
+                const quint8 *prefix = prefixes.at(instruction.operand).bytes;
+                int bits = static_cast<int>(instruction.low);
+                int whole = bits / 8;
+                int rest = bits % 8;
+                bool under = memcmp(bytes, prefix, whole) == 0 &&
+                             (rest == 0 || ((bytes[whole] ^ prefix[whole]) & (0xff << (8 - rest)) & 0xff) == 0);
+                result = instruction.op == OpPrefix ? under : !under;
+                break;
+            }
+            case OpNot:
+                result = !result;
+                break;
+            case OpJumpIfTrue:
+                if (result) {
+                    pc = instruction.operand - 1;
+                }
+                break;
+            case OpJumpIfFalse:
+                if (!result) {
+                    pc = instruction.operand - 1;
+                }
+                break;
+        }
+    }
+    return result;
+}
+
+bool DisplayFilter::load(quint8 field, const DisplayFilterRow &row, quint64 &value) {
+    bool ip = row.l3 == PACKET_L3_IPV4 || row.l3 == PACKET_L3_IPV6;
+    bool ports = row.sourcePort != 0 || row.destinationPort != 0;
+
+    switch (field) {
+        case FieldFrameNumber:
+            value = static_cast<quint64>(row.serialNumber);
+            return true;
+        case FieldFrameLength:
+            value = static_cast<quint64>(row.length);
+            return true;
+        case FieldL3:
+            value = row.l3;
+            return true;
+        case FieldIpProto:
+            value = row.l4;
+            return ip;
+        case FieldAppProto:
+            value = row.appProto;
+            return true;
+        case FieldIpSource:
+            value = qFromBigEndian<quint32>(row.source);
+            return row.l3 == PACKET_L3_IPV4;
+        case FieldIpDestination:
+            value = qFromBigEndian<quint32>(row.destination);
+            return row.l3 == PACKET_L3_IPV4;
+        case FieldTcpSourcePort:
+            value = row.sourcePort;
+            return ip && ports && row.l4 == IPPROTO_TCP;
+        case FieldTcpDestinationPort:
+            value = row.destinationPort;
+            return ip && ports && row.l4 == IPPROTO_TCP;
+        case FieldUdpSourcePort:
+            value = row.sourcePort;
+            return ip && ports && row.l4 == IPPROTO_UDP;
+        case FieldUdpDestinationPort:
+            value = row.destinationPort;
+            return ip && ports && row.l4 == IPPROTO_UDP;
+        default:
+            return false;
+    }
+}
+
+const quint8 *DisplayFilter::address(quint8 field, const DisplayFilterRow &row) {
+    if (row.l3 != PACKET_L3_IPV6) {
+        return nullptr;
+    }
+    switch (field) {
+        case FieldIpv6Source:
+            return row.source;
+        case FieldIpv6Destination:
+            return row.destination;
+        default:
+            return nullptr;
+    }
+}
+
+bool DisplayFilter::inSet(int first, int count, quint64 value) const {
+    // Last range starting at or below value
+    const QPair<quint64, quint64> *ranges = sets.constData() + first;
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (ranges[middle].first <= value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low > 0 && value <= ranges[low - 1].second;
+}
@@ -0,0 +1,182 @@
+/**
+ * @brief Compile and match checks for DisplayFilter, plus an evaluator benchmark
+ *
+ * Run without arguments by ctest; "--bench" also times matches() alone over
+ * a million prepared rows and prints ns/packet.
+ */
+#include "DisplayFilter.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+    #include "../../src/packetcapture/packet_summary.h"
+}
+
+namespace {
+
+#define BENCH_ROWS 1000000
+
+struct TestPacket {
+    quint8 source[16];
+    quint8 destination[16];
+    DisplayFilterRow row;
+};
+
+TestPacket makePacket(const char *source, const char *destination, quint8 l4,
+                      quint16 sourcePort, quint16 destinationPort, quint8 appProto,
+                      qint64 length, qint64 serialNumber)
+{
+    TestPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    bool ipv6 = strchr(source, ':') != nullptr;
+    inet_pton(ipv6 ? AF_INET6 : AF_INET, source, packet.source);
+    inet_pton(ipv6 ? AF_INET6 : AF_INET, destination, packet.destination);
+    packet.row.serialNumber = serialNumber;
+    packet.row.length = length;
+    packet.row.sourcePort = sourcePort;
+    packet.row.destinationPort = destinationPort;
+    packet.row.l3 = ipv6 ? PACKET_L3_IPV6 : PACKET_L3_IPV4;
+    packet.row.l4 = l4;
+    packet.row.appProto = appProto;
+    return packet;
+}
+
+// The row points into its packet, so point it again after every copy
+const DisplayFilterRow &rowOf(TestPacket &packet)
+{
+    packet.row.source = packet.source;
+    packet.row.destination = packet.destination;
+    return packet.row;
+}
+
+int failures = 0;
+
+void expectMatch(const char *text, TestPacket packet, bool expected)
+{
+    QString error;
+    DisplayFilter filter = DisplayFilter::compile(text, &error);
+    if (!filter.isValid()) {
+        printf("FAIL compile \"%s\": %s\n", text, error.toUtf8().constData());
+        failures++;
+    } else if (filter.matches(rowOf(packet)) != expected) {
+        printf("FAIL \"%s\" should %smatch packet %lld\n", text, expected ? "" : "not ",
+               (long long)packet.row.serialNumber);
+        failures++;
+    }
+}
+
+void expectError(const char *text)
+{
+    if (DisplayFilter::compile(text).isValid()) {
+        printf("FAIL \"%s\" should not compile\n", text);
+        failures++;
+    }
+}
+
+void benchmark(const TestPacket *packets, int count)
+{
+    const char *text = "ip.addr == 10.0.0.0/8 and tcp.port in {80 443 8000..8080} and not frame.len < 60";
+    DisplayFilter filter = DisplayFilter::compile(text);
+
+    std::vector<TestPacket> rows(BENCH_ROWS);
+    for (int i = 0; i < BENCH_ROWS; ++i) {
+        rows[i] = packets[i % count];
+        rowOf(rows[i]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int matched = 0;
+    for (const TestPacket &packet : rows) {
+        matched += filter.matches(packet.row);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("%d instructions, %d of %d rows matched, %.1f ns/packet\n", filter.size(), matched, BENCH_ROWS,
+           std::chrono::duration<double, std::nano>(elapsed).count() / BENCH_ROWS);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    TestPacket packets[] = {
+        makePacket("10.0.0.1", "192.168.1.5", IPPROTO_TCP, 51000, 443, PORT_APP_HTTPS, 1500, 7),
+        makePacket("10.0.0.10", "8.8.8.8", IPPROTO_UDP, 5353, 53, PORT_APP_DNS, 80, 8),
+        makePacket("fe80::1", "2001:db8::5", IPPROTO_TCP, 22, 40000, PORT_APP_SSH, 60, 9)
+    };
+    const TestPacket &https = packets[0];
+    const TestPacket &dns = packets[1];
+    const TestPacket &ssh = packets[2];
+
+    // Addresses, with prefixes, ranges and either-end fields
+    expectMatch("ip.src == 10.0.0.1", https, true);
+    expectMatch("ip.src == 10.0.0.1", dns, false);
+    expectMatch("ip.src == 10.0.0.0/8", dns, true);
+    expectMatch("ip.src == \"10.0.0.1\"", https, true);
+    expectMatch("ip.src in {10.0.0.2..10.0.0.20}", dns, true);
+    expectMatch("ip.addr == 8.8.8.8", dns, true);
+    expectMatch("ip.addr != 8.8.8.8", dns, false);
+    expectMatch("ip.addr != 1.1.1.1", dns, true);
+    expectMatch("ip.src == 10.0.0.1", ssh, false);
+    expectMatch("ipv6.src == fe80::/10", ssh, true);
+    expectMatch("ipv6.addr == 2001:db8::/32", ssh, true);
+    expectMatch("ipv6.addr in {::1 2001:db8::5}", ssh, true);
+
+    // Ports and sets
+    expectMatch("tcp.port == 443", https, true);
+    expectMatch("tcp.port == 443", dns, false);
+    expectMatch("udp.port == 53", dns, true);
+    expectMatch("tcp.port in {80 443 8000..8080}", https, true);
+    expectMatch("tcp.port in {80, 8000..8080}", https, false);
+    expectMatch("tcp.port in {}", https, false);
+    expectMatch("tcp.dstport >= 400 && tcp.dstport < 500", https, true);
+    expectMatch("tcp.port", dns, false);
+    expectMatch("udp.port", dns, true);
+
+    // Frame fields and protocols
+    expectMatch("frame.len > 1000", https, true);
+    expectMatch("frame.len > 1000", dns, false);
+    expectMatch("frame.len lt 0", https, false);
+    expectMatch("frame.number in {1..7}", https, true);
+    expectMatch("ip.proto == udp", dns, true);
+    expectMatch("ip", https, true);
+    expectMatch("ipv6", https, false);
+    expectMatch("tls", https, true);
+    expectMatch("dns or http", dns, true);
+    expectMatch("ssh && tcp.port == 22", ssh, true);
+
+    // Operators and precedence
+    expectMatch("not (tcp or udp)", https, false);
+    expectMatch("!tcp", dns, true);
+    expectMatch("not not tcp", https, true);
+    expectMatch("udp or tcp and frame.len < 10", https, false);
+    expectMatch("https and ip.dst == 192.168.0.0/16", https, true);
+    expectMatch("(ip.src == 10.0.0.1 or ip.src == 10.0.0.10) and not udp", dns, false);
+    expectMatch("(ip.src == 10.0.0.1 or ip.src == 10.0.0.10) and not udp", https, true);
+    expectMatch("TCP.PORT eq 443 AND ip.dst ne 1.2.3.4", https, true);
+
+    // Text that must stay a plain search
+    expectError("");
+    expectError("192.168.1.1");
+    expectError("HTTP GET");
+    expectError("ip.src == 10.0.0.300");
+    expectError("ip.src < 10.0.0.0/8");
+    expectError("ipv6.src > ::1");
+    expectError("tcp.port ==");
+    expectError("tcp.port == abc");
+    expectError("tcp.port in {1");
+    expectError("tcp == 1");
+    expectError("foo.bar == 1");
+    expectError("(tcp");
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        benchmark(packets, sizeof(packets) / sizeof(packets[0]));
+    }
+
+    printf("%s: %d failure(s)\n", argv[0], failures);
+    return failures == 0 ? 0 : 1;
+}
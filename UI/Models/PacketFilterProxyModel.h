@@ -1,43 +1,117 @@
 #ifndef PACKETFILTERPROXYMODEL_H
 #define PACKETFILTERPROXYMODEL_H
 
-#include <QSortFilterProxyModel>
-#include <QRegularExpression>
+#include <QAbstractProxyModel>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include "DisplayFilter.h"
 #include "../PacketFilterWidget.h"
 
 class PacketModel;
 
-class PacketFilterProxyModel : public QSortFilterProxyModel
+/**
+ * @brief Filtering and sorting view of a PacketModel
+ *
+ * Keeps the serial numbers of the accepted rows in proxy order. Serials
+ * survive eviction, so nothing has to be renumbered when the model drops
+ * its oldest rows; unsorted, those are always a prefix of the list and
+ * are skipped by moving its head. With no filter and no sort the proxy
+ * passes rows straight through and keeps no list at all.
+ *
+ * Appended rows are checked against the active filter as they arrive and
+ * only the accepted ones are inserted. A new filter is applied by
+ * re-scanning a snapshot of the model on a thread pool, SHARD_ROWS rows
+ * per task; the view keeps showing the old result until the scan is done
+ * and then switches in one reset. Setting another filter meanwhile
+ * cancels the scan.
+ *
+ * A custom filter that compiles as a DisplayFilter is evaluated as one,
+ * over each row's binary fields; anything else is a plain text search
+ * of the address, protocol, length and number columns.
+ */
+class PacketFilterProxyModel : public QAbstractProxyModel
 {
     Q_OBJECT
 
 public:
+    static constexpr int SHARD_ROWS = 16384;
+
     explicit PacketFilterProxyModel(QObject *parent = nullptr);
     ~PacketFilterProxyModel();
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
     void setFilter(const PacketFilterWidget::FilterCriteria &criteria);
     void clearFilter();
     bool isFilterActive() const;
 
-protected:
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    // True while a new filter is being applied in the background
+    bool isRescanning() const { return !rescan.isNull(); }
+
+    // Model interface
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private slots:
+    void onSourceRowsAboutToBeInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceAboutToBeReset();
+    void onSourceReset();
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles);
 
 private:
-    bool matchesQuickFilter(const PacketInfo &packet) const;
-    bool matchesCustomFilter(const PacketInfo &packet) const;
-    bool evaluateCustomFilterExpression(const QString &expression, const PacketInfo &packet) const;
-    bool evaluateSimpleCondition(const QString &condition, const PacketInfo &packet) const;
-    QString extractValue(const QString &field, const PacketInfo &packet) const;
-    
+    // One background re-scan. The shards are written by pool threads;
+    // everything else is main thread only.
+    struct Rescan {
+        PacketFilterWidget::FilterCriteria criteria;
+        DisplayFilter displayFilter;
+        std::atomic<bool> cancelled{false};
+        std::atomic<int> shardsLeft{0};
+        QVector<QVector<int>> shards;    // Accepted serials, in capture order
+        QVector<int> appended;           // Accepted rows added after the snapshot
+        QElapsedTimer timer;
+        int scannedRows = 0;
+    };
+
+    bool isPassthrough() const { return !filterEnabled && sortColumn < 0; }
+    bool acceptsRow(int sourceRow) const;
+    QVector<int> allSerials() const;
+
+    void startRescan(const PacketFilterWidget::FilterCriteria &criteria, const DisplayFilter &compiled);
+    void cancelRescan();
+    void finishRescan(const QSharedPointer<Rescan> &job);
+
+    void sortSerials(QVector<int> &serials) const;
+    bool sortsBefore(int leftSerial, int rightSerial) const;
+    int proxyRowOfSerial(int serialNumber) const;
+    void removeSerials(int firstSerial, int lastSerial);
+
+    PacketModel *packetModel;
+    QVector<QMetaObject::Connection> sourceConnections;
+
     PacketFilterWidget::FilterCriteria filterCriteria;
+    DisplayFilter displayFilter;         // Invalid when the custom filter is a text search
     bool filterEnabled;
-    
-    // Cached regex patterns for performance
-    mutable QRegularExpression ipSrcRegex;
-    mutable QRegularExpression ipDstRegex;
-    mutable QRegularExpression tcpPortRegex;
-    mutable QRegularExpression udpPortRegex;
-    mutable QRegularExpression protocolRegex;
+    int sortColumn;                      // -1 for capture order
+    Qt::SortOrder sortOrder;
+
+    // Serials of the accepted rows from acceptedHead on, in proxy order.
+    // Empty while passing through.
+    QVector<int> accepted;
+    int acceptedHead;
+
+    QThreadPool pool;
+    QSharedPointer<Rescan> rescan;
 };
 
-#endif // PACKETFILTERPROXYMODEL_H
\ No newline at end of file
+#endif // PACKETFILTERPROXYMODEL_H
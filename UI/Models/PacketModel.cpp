@@ -1,11 +1,48 @@
 #include "PacketModel.h"
 #include "ProtocolTreeModel.h"
 #include "../Utils/SettingsManager.h"
+#include "../Utils/PacketInfoGenerator.h"
 #include <QDateTime>
 #include <QColor>
 #include <QFont>
 #include <QTimer>
 #include <QDebug>
+#include <limits>
+
+// Summaries kept for a mapped capture file: a few screens plus the
+// neighbourhood the selection and filter are working on
+static const int MAPPED_ROW_CACHE_SIZE = 8192;
+
+// More Info texts kept for rows that were painted recently
+static const int INFO_CACHE_SIZE = 4096;
+
+// protocolStyles entries: a background in the low bits, bold on top
+enum ProtocolStyle : quint8 {
+    StylePlain = 0,
+    StyleHttp,
+    StyleTls,
+    StyleSsh,
+    StyleDns,
+    StyleArp,
+    StyleBackgroundMask = 0x0f,
+    StyleBold = 0x10,
+    StyleKnown = 0x80      // Entry has been worked out
+};
+
+// Mapped rows keep no columns, so their filter fields come from the summary
+static void fillFilterRow(const PacketInfo &packet, DisplayFilterRow &out) {
+    const packet_summary_t &summary = packet.summary;
+    bool ports = summary.flags & PACKET_SUMMARY_HAS_PORTS;
+    out.source = summary.src_addr;
+    out.destination = summary.dst_addr;
+    out.serialNumber = packet.serialNumber;
+    out.length = packet.packetLength;
+    out.sourcePort = ports ? summary.src_port : 0;
+    out.destinationPort = ports ? summary.dst_port : 0;
+    out.l3 = summary.l3;
+    out.l4 = summary.l4_proto;
+    out.appProto = summary.app_proto;
+}
 
 // PacketInfo now uses value semantics - no custom destructor/copy needed
 
@@ -14,19 +51,25 @@ PacketModel::PacketModel(QObject *parent)
     : QAbstractTableModel(parent)
     , totalBytes(0)
     , nextSerialNumber(1)
+    , evictedPackets(0)
     , retentionMode(UnlimitedRetention)
     , maxPackets(MAX_PACKETS_IN_MEMORY)
     , maxAgeMinutes(60)
     , ringBufferEnabled(false)
     , ringBufferSize(MAX_PACKETS_IN_MEMORY)
     , memoryCheckTimer(new QTimer(this))
+    , memoryPressure(false)
     , compressionEnabled(false)
     , compressionThreshold(1024)  // Compress packets larger than 1KB
     , currentTimeZoneMode(UTC_TIME)
     , currentCustomTimeZone(QTimeZone::utc())
+    , formattedSecond(std::numeric_limits<qint64>::min())
+    , infoCache(INFO_CACHE_SIZE)
+    , mappedSummarizer(nullptr)
+    , mappedRowCache(MAPPED_ROW_CACHE_SIZE)
 {
     // Reserve memory for expected packet count to prevent frequent reallocations
-    packets.reserve(MAX_PACKETS_IN_MEMORY);
+    store.reserve(MAX_PACKETS_IN_MEMORY);
     
     // Setup memory check timer
     connect(memoryCheckTimer, &QTimer::timeout, this, &PacketModel::checkMemoryLimits);
@@ -39,7 +82,7 @@ PacketModel::~PacketModel() {
 
 int PacketModel::rowCount(const QModelIndex &parent) const {
     Q_UNUSED(parent)
-    return packets.size();
+    return mappedFile ? mappedIndex.size() : store.size();
 }
 
 int PacketModel::columnCount(const QModelIndex &parent) const {
@@ -48,28 +91,29 @@ int PacketModel::columnCount(const QModelIndex &parent) const {
 }
 
 QVariant PacketModel::data(const QModelIndex &index, int role) const {
-    if (!index.isValid() || index.row() >= packets.size()) {
+    if (!index.isValid() || index.row() >= rowCount()) {
         return QVariant();
     }
 
-    const PacketInfo &packet = packets.at(index.row());
+    // Strings are only built here, for the cells a view asks about
+    int row = index.row();
 
     if (role == Qt::DisplayRole) {
         switch (index.column()) {
         case SerialNumber:
-            return packet.serialNumber;
+            return serialAt(row);
         case Timestamp:
-            return formatTimestamp(packet.timestamp);
+            return formatTimestamp(timestampAt(row));
         case SourceIP:
-            return packet.sourceIP;
+            return sourceAt(row);
         case DestinationIP:
-            return packet.destinationIP;
+            return destinationAt(row);
         case PacketLength:
-            return packet.packetLength;
+            return lengthAt(row);
         case ProtocolType:
-            return packet.protocolType;
+            return protocolAt(row);
         case MoreInfo:
-            return packet.moreInfo;
+            return infoAt(row);
         default:
             return QVariant();
         }
@@ -80,31 +124,33 @@ QVariant PacketModel::data(const QModelIndex &index, int role) const {
     }
     else if (role == Qt::BackgroundRole) {
         // Color coding based on protocol type
-        if (packet.protocolType.contains("HTTP", Qt::CaseInsensitive)) {
+        switch (protocolStyleAt(row) & StyleBackgroundMask) {
+        case StyleHttp:
             return QColor(230, 255, 230); // Light green
-        } else if (packet.protocolType.contains("HTTPS", Qt::CaseInsensitive) || 
-                   packet.protocolType.contains("TLS", Qt::CaseInsensitive)) {
+        case StyleTls:
             return QColor(230, 230, 255); // Light blue
-        } else if (packet.protocolType.contains("SSH", Qt::CaseInsensitive)) {
+        case StyleSsh:
             return QColor(255, 230, 230); // Light red
-        } else if (packet.protocolType.contains("DNS", Qt::CaseInsensitive)) {
+        case StyleDns:
             return QColor(255, 255, 230); // Light yellow
-        } else if (packet.protocolType.contains("ARP", Qt::CaseInsensitive)) {
+        case StyleArp:
             return QColor(255, 230, 255); // Light magenta
+        default:
+            return QVariant();
         }
-        return QVariant();
     }
     else if (role == Qt::ForegroundRole) {
         // Special text color for security indicators in More Info column
         if (index.column() == MoreInfo) {
-            if (packet.moreInfo.contains("Encrypted", Qt::CaseInsensitive) || 
-                packet.moreInfo.contains("TLS", Qt::CaseInsensitive) ||
-                packet.moreInfo.contains("SSH", Qt::CaseInsensitive) ||
-                packet.moreInfo.contains("HTTPS", Qt::CaseInsensitive)) {
+            QString moreInfo = infoAt(row);
+            if (moreInfo.contains("Encrypted", Qt::CaseInsensitive) || 
+                moreInfo.contains("TLS", Qt::CaseInsensitive) ||
+                moreInfo.contains("SSH", Qt::CaseInsensitive) ||
+                moreInfo.contains("HTTPS", Qt::CaseInsensitive)) {
                 return QColor(0, 150, 0); // Green for encrypted
-            } else if (packet.moreInfo.contains("Unencrypted", Qt::CaseInsensitive) ||
-                      packet.moreInfo.contains("Plain Text", Qt::CaseInsensitive) ||
-                      packet.moreInfo.contains("Password", Qt::CaseInsensitive)) {
+            } else if (moreInfo.contains("Unencrypted", Qt::CaseInsensitive) ||
+                      moreInfo.contains("Plain Text", Qt::CaseInsensitive) ||
+                      moreInfo.contains("Password", Qt::CaseInsensitive)) {
                 return QColor(200, 0, 0); // Red for unencrypted/insecure
             }
         }
@@ -112,7 +158,7 @@ QVariant PacketModel::data(const QModelIndex &index, int role) const {
     }
     else if (role == Qt::FontRole) {
         QFont font;
-        if (packet.protocolType.contains("Error", Qt::CaseInsensitive)) {
+        if (protocolStyleAt(row) & StyleBold) {
             font.setBold(true);
         }
         return font;
@@ -125,13 +171,13 @@ QVariant PacketModel::data(const QModelIndex &index, int role) const {
                                 "Length: %5 bytes\n"
                                 "Protocol: %6\n"
                                 "Info: %7")
-                         .arg(packet.serialNumber)
-                         .arg(packet.timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz"))
-                         .arg(packet.sourceIP)
-                         .arg(packet.destinationIP)
-                         .arg(packet.packetLength)
-                         .arg(packet.protocolType)
-                         .arg(packet.moreInfo);
+                         .arg(serialAt(row))
+                         .arg(formatFullTimestamp(timestampAt(row)))
+                         .arg(sourceAt(row))
+                         .arg(destinationAt(row))
+                         .arg(lengthAt(row))
+                         .arg(protocolAt(row))
+                         .arg(infoAt(row));
         return tooltip;
     }
 
@@ -164,38 +210,38 @@ QVariant PacketModel::headerData(int section, Qt::Orientation orientation, int r
 }
 
 void PacketModel::addPacket(const PacketInfo &packet) {
+    if (mappedFile) {
+        clearPackets();
+    }
+    
     try {
-        // Apply compression if enabled and packet is large enough
-        PacketInfo packetToAdd = packet;
+        // Apply compression if enabled and packet is large enough; the
+        // store then keeps this instead of the slab reference
+        QByteArray compressed;
         if (compressionEnabled && packet.rawData.size() > compressionThreshold) {
-            packetToAdd.compressedData = qCompress(packet.rawData, 6);  // Level 6 compression
-            packetToAdd.isCompressed = true;
-            packetToAdd.rawData.clear();  // Clear uncompressed data to save memory
+            compressed = qCompress(packet.rawData.bytes(), 6);  // Level 6 compression
         }
         
         // For ring buffer mode, we might need to remove the oldest packet
-        if (ringBufferEnabled && packets.size() >= ringBufferSize) {
-            beginRemoveRows(QModelIndex(), 0, 0);
-            PacketInfo removedPacket = packets.takeFirst();
-            totalBytes -= removedPacket.packetLength;
-            nextSerialNumber--; // Adjust serial number
-            endRemoveRows();
+        if (ringBufferEnabled && store.size() >= ringBufferSize) {
+            evictFirst(store.size() - ringBufferSize + 1);
         }
         
-        beginInsertRows(QModelIndex(), packets.size(), packets.size());
+        int row = store.size();
+        beginInsertRows(QModelIndex(), row, row);
         
-        PacketInfo newPacket = packetToAdd;
+        PacketInfo newPacket = packet;
         newPacket.serialNumber = nextSerialNumber++;
         
-        packets.append(newPacket);
-        totalBytes += packet.packetLength;
+        store.append(newPacket, newPacket.serialNumber, compressed);
+        totalBytes += store.length(row);
         
         endInsertRows();
         
-        emit packetAdded(packets.size() - 1);
+        emit packetAdded(row);
         emit packetAdded(newPacket);
         // Emit statistics less frequently for performance
-        if (packets.size() % 100 == 0) {
+        if (store.size() % 100 == 0) {
             emit statisticsChanged();
         }
         
@@ -215,53 +261,53 @@ void PacketModel::addPacketsBatch(const QList<PacketInfo> &newPackets) {
         return;
     }
     
+    if (mappedFile) {
+        clearPackets();
+    }
+    
     try {
         // Apply compression to packets if enabled
-        QList<PacketInfo> processedPackets;
-        for (const PacketInfo &packet : newPackets) {
-            PacketInfo packetToAdd = packet;
-            if (compressionEnabled && packet.rawData.size() > compressionThreshold) {
-                packetToAdd.compressedData = qCompress(packet.rawData, 6);  // Level 6 compression
-                packetToAdd.isCompressed = true;
-                packetToAdd.rawData.clear();  // Clear uncompressed data to save memory
+        QVector<QByteArray> compressed(newPackets.size());
+        if (compressionEnabled) {
+            for (int i = 0; i < newPackets.size(); ++i) {
+                const PacketSlice &rawData = newPackets.at(i).rawData;
+                if (rawData.size() > compressionThreshold) {
+                    compressed[i] = qCompress(rawData.bytes(), 6);  // Level 6 compression
+                }
             }
-            processedPackets.append(packetToAdd);
         }
         
-        // For ring buffer mode, we might need to remove old packets
-        if (ringBufferEnabled) {
-            int totalWillBe = packets.size() + processedPackets.size();
+        // For ring buffer mode, we might need to remove old packets. A batch
+        // larger than the whole ring only contributes its newest packets;
+        // the others still use up their serial numbers.
+        int first = 0;
+        if (ringBufferEnabled && ringBufferSize > 0) {
+            int totalWillBe = store.size() + newPackets.size();
             if (totalWillBe > ringBufferSize) {
-                int toRemove = totalWillBe - ringBufferSize;
-                if (toRemove > 0 && toRemove <= packets.size()) {
-                    beginRemoveRows(QModelIndex(), 0, toRemove - 1);
-                    for (int i = 0; i < toRemove; i++) {
-                        PacketInfo removedPacket = packets.takeFirst();
-                        totalBytes -= removedPacket.packetLength;
-                        nextSerialNumber--; // Adjust serial number
-                    }
-                    endRemoveRows();
-                }
+                evictFirst(qMin(totalWillBe - ringBufferSize, store.size()));
+            }
+            if (newPackets.size() > ringBufferSize) {
+                first = newPackets.size() - ringBufferSize;
+                nextSerialNumber += first;
+                evictedPackets += first;
             }
         }
         
         // Add new packets in batch
-        int startRow = packets.size();
-        int endRow = startRow + processedPackets.size() - 1;
+        int startRow = store.size();
+        int endRow = startRow + newPackets.size() - first - 1;
         
         beginInsertRows(QModelIndex(), startRow, endRow);
         
-        for (const PacketInfo &packet : processedPackets) {
-            PacketInfo newPacket = packet;
-            newPacket.serialNumber = nextSerialNumber++;
-            packets.append(newPacket);
-            totalBytes += packet.packetLength;
+        for (int i = first; i < newPackets.size(); ++i) {
+            store.append(newPackets.at(i), nextSerialNumber++, compressed.at(i));
+            totalBytes += store.length(store.size() - 1);
         }
         
         endInsertRows();
         
         // Emit batch completion signal
-        emit packetsBatchAdded(startRow, processedPackets.size());
+        emit packetsBatchAdded(startRow, newPackets.size() - first);
         // Only emit statistics for batch operations to reduce signal overhead
         emit statisticsChanged();
         
@@ -276,28 +322,57 @@ void PacketModel::addPacketsBatch(const QList<PacketInfo> &newPackets) {
 }
 
 PacketInfo PacketModel::getPacket(int index) const {
-    if (index >= 0 && index < packets.size()) {
-        PacketInfo packet = packets.at(index);
-        
-        // Decompress packet data if it's compressed
-        if (packet.isCompressed && !packet.compressedData.isEmpty()) {
-            packet.rawData = qUncompress(packet.compressedData);
-            packet.isCompressed = false;
-            packet.compressedData.clear();
-        }
-        
-        return packet;
+    if (mappedFile) {
+        return index >= 0 && index < mappedIndex.size() ? *mappedPacket(index) : PacketInfo();
+    }
+    
+    if (index >= 0 && index < store.size()) {
+        // Rebuilt from the columns, with the frame inflated if compressed
+        return store.packet(index);
     }
     return PacketInfo();
 }
 
+QVector<PacketBytes> PacketModel::getPacketBytes(int first, int count) const {
+    QVector<PacketBytes> frames;
+    int last = qMin(first + count, rowCount());
+    first = qMax(first, 0);
+    if (last <= first) {
+        return frames;
+    }
+    frames.reserve(last - first);
+    
+    for (int row = first; row < last; ++row) {
+        PacketBytes frame;
+        if (mappedFile) {
+            const capture_index_entry_t &entry = mappedIndex.at(row);
+            int length = static_cast<int>(capture_index_caplen(&entry));
+            const char *data = reinterpret_cast<const char*>(capture_index_data(mappedFile.data(), &entry));
+            frame.data = PacketSlice(PacketSlab::wrap(data, length, mappedFile), 0, length);
+            frame.serialNumber = row + 1;
+        } else {
+            frame.data = store.frame(row);
+            frame.compressedData = store.compressedFrame(row);
+            frame.serialNumber = store.serialNumber(row);
+        }
+        frames.append(frame);
+    }
+    return frames;
+}
+
 void PacketModel::clearPackets() {
-    if (packets.isEmpty()) {
+    if (store.isEmpty() && !mappedFile) {
         return;
     }
     
     beginResetModel();
-    packets.clear();
+    store.clear();
+    infoCache.clear();
+    protocolStyles.clear();
+    mappedRowCache.clear();
+    mappedIndex = QVector<capture_index_entry_t>();
+    mappedFile.reset();
+    mappedSummarizer = nullptr;
     totalBytes = 0;
     nextSerialNumber = 1;
     endResetModel();
@@ -306,13 +381,17 @@ void PacketModel::clearPackets() {
 }
 
 int PacketModel::getPacketCount() const {
-    return packets.size();
+    return rowCount();
 }
 
 qint64 PacketModel::getTotalBytes() const {
     return totalBytes;
 }
 
+quint64 PacketModel::getEvictedPacketCount() const {
+    return evictedPackets;
+}
+
 // Memory management methods
 void PacketModel::setRetentionMode(PacketRetentionMode mode) {
     retentionMode = mode;
@@ -353,6 +432,11 @@ bool PacketModel::isRingBufferEnabled() const {
 }
 
 void PacketModel::enforceRetentionPolicy() {
+    // A mapped file is read-only; nothing of it is held in memory to evict
+    if (mappedFile) {
+        return;
+    }
+    
     switch (retentionMode) {
     case SizeBasedRetention:
         removeExcessPackets();
@@ -361,7 +445,10 @@ void PacketModel::enforceRetentionPolicy() {
         removeOldPackets();
         break;
     case RingBufferRetention:
-        // Ring buffer is handled during packet insertion
+        // Insertion keeps the ring at size; this only trims after a resize
+        if (ringBufferEnabled && store.size() > ringBufferSize) {
+            evictFirst(store.size() - ringBufferSize);
+        }
         break;
     case UnlimitedRetention:
     default:
@@ -371,55 +458,54 @@ void PacketModel::enforceRetentionPolicy() {
 }
 
 void PacketModel::removeOldPackets() {
-    if (packets.isEmpty() || maxAgeMinutes <= 0) {
+    if (store.isEmpty() || maxAgeMinutes <= 0) {
         return;
     }
     
-    QDateTime cutoffTime = QDateTime::currentDateTime().addSecs(-maxAgeMinutes * 60);
-    
-    int removeCount = 0;
-    while (!packets.isEmpty() && packets.first().timestamp < cutoffTime) {
-        packets.removeFirst();
-        removeCount++;
-        nextSerialNumber--; // Adjust serial number
-    }
+    qint64 cutoffNs = (QDateTime::currentMSecsSinceEpoch() - qint64(maxAgeMinutes) * 60 * 1000) * 1000000;
     
+    // Rows are in capture order, so everything too old is one prefix
+    int removeCount = store.lowerBound(cutoffNs);
     if (removeCount > 0) {
-        beginResetModel();
-        totalBytes = 0;
-        // Recalculate total bytes
-        for (const PacketInfo &packet : packets) {
-            totalBytes += packet.packetLength;
-        }
-        endResetModel();
-        
+        evictFirst(removeCount);
         emit statisticsChanged();
     }
 }
 
 void PacketModel::removeExcessPackets() {
-    if (packets.size() <= maxPackets) {
+    if (store.size() <= maxPackets) {
         return;
     }
     
-    int removeCount = packets.size() - maxPackets;
+    int removeCount = store.size() - maxPackets;
     if (removeCount > 0) {
-        beginRemoveRows(QModelIndex(), 0, removeCount - 1);
-        for (int i = 0; i < removeCount; i++) {
-            PacketInfo removedPacket = packets.takeFirst();
-            totalBytes -= removedPacket.packetLength;
-            nextSerialNumber--; // Adjust serial number
-        }
-        endRemoveRows();
-        
+        evictFirst(removeCount);
         emit statisticsChanged();
     }
 }
 
+void PacketModel::evictFirst(int count) {
+    if (count <= 0) {
+        return;
+    }
+    
+    // Serial numbers of the remaining rows do not change, and the running
+    // total only loses what the evicted rows held
+    beginRemoveRows(QModelIndex(), 0, count - 1);
+    totalBytes -= store.removeFirst(count);
+    evictedPackets += count;
+    endRemoveRows();
+}
+
 void PacketModel::checkMemoryLimits() {
-    // Check if we're approaching memory limits
-    if (packets.size() > MAX_PACKETS_IN_MEMORY * 0.9) {
+    // Check if we're approaching memory limits; pressure ends only well
+    // below the threshold so it does not flap around it
+    if (store.size() > MAX_PACKETS_IN_MEMORY * 0.9) {
+        memoryPressure = true;
         emit memoryLimitExceeded();
+    } else if (memoryPressure && store.size() < MAX_PACKETS_IN_MEMORY * 0.75) {
+        memoryPressure = false;
+        emit memoryPressureRelieved();
     }
     
     // Automatically enforce time-based retention policy
@@ -448,11 +534,12 @@ int PacketModel::getCompressionThreshold() const {
 void PacketModel::refreshTimestamps(TimeZoneMode mode, const QTimeZone &customZone) {
     currentTimeZoneMode = mode;
     currentCustomTimeZone = customZone;
+    formattedSecond = std::numeric_limits<qint64>::min();
     
     // Emit data changed for timestamp column to refresh display
-    if (!packets.isEmpty()) {
+    if (rowCount() > 0) {
         QModelIndex topLeft = index(0, Timestamp);
-        QModelIndex bottomRight = index(packets.size() - 1, Timestamp);
+        QModelIndex bottomRight = index(rowCount() - 1, Timestamp);
         emit dataChanged(topLeft, bottomRight, {Qt::DisplayRole});
     }
 }
@@ -460,25 +547,258 @@ void PacketModel::refreshTimestamps(TimeZoneMode mode, const QTimeZone &customZo
 void PacketModel::setTimeZoneMode(TimeZoneMode mode, const QTimeZone &customZone) {
     currentTimeZoneMode = mode;
     currentCustomTimeZone = customZone;
+    formattedSecond = std::numeric_limits<qint64>::min();
 }
 
-QString PacketModel::formatTimestamp(const QDateTime &timestamp) const {
-    QDateTime displayTime;
+QString PacketModel::formatTimestamp(qint64 timestampNs) const {
+    qint64 seconds = timestampNs / NANOSECONDS_PER_SECOND;
+    qint64 fraction = timestampNs % NANOSECONDS_PER_SECOND;
     
-    switch (currentTimeZoneMode) {
-        case UTC_TIME:
-            displayTime = timestamp.toUTC();
-            break;
-        case LOCAL_TIME:
-            displayTime = timestamp.toLocalTime();
-            break;
-        case CUSTOM_TIME:
-            displayTime = timestamp.toTimeZone(currentCustomTimeZone);
-            break;
-        default:
-            displayTime = timestamp.toUTC();
-            break;
+    // Only called for rows a view actually paints
+    if (seconds != formattedSecond) {
+        QDateTime timestamp = QDateTime::fromSecsSinceEpoch(seconds, QTimeZone::UTC);
+        QDateTime displayTime;
+        
+        switch (currentTimeZoneMode) {
+            case UTC_TIME:
+                displayTime = timestamp;
+                break;
+            case LOCAL_TIME:
+                displayTime = timestamp.toLocalTime();
+                break;
+            case CUSTOM_TIME:
+                displayTime = timestamp.toTimeZone(currentCustomTimeZone);
+                break;
+            default:
+                displayTime = timestamp;
+                break;
+        }
+        
+        formattedSecond = seconds;
+        formattedSecondText = displayTime.toString("hh:mm:ss");
+    }
+    
+    return formattedSecondText + QLatin1Char('.') +
+           QString::number(fraction).rightJustified(9, QLatin1Char('0'));
+}
+
+QString PacketModel::formatFullTimestamp(qint64 timestampNs) {
+    qint64 seconds = timestampNs / NANOSECONDS_PER_SECOND;
+    qint64 fraction = timestampNs % NANOSECONDS_PER_SECOND;
+    
+    return QDateTime::fromSecsSinceEpoch(seconds, QTimeZone::UTC).toString("yyyy-MM-dd hh:mm:ss") +
+           QLatin1Char('.') + QString::number(fraction).rightJustified(9, QLatin1Char('0'));
+}
+
+// Mapped capture file backend
+void PacketModel::setMappedCaptureFile(const QSharedPointer<capture_file_t> &file, PacketSummarizer summarizer) {
+    clearPackets();
+    
+    beginResetModel();
+    mappedFile = file;
+    mappedSummarizer = summarizer;
+    endResetModel();
+    
+    emit statisticsChanged();
+}
+
+void PacketModel::appendMappedPackets(const QVector<capture_index_entry_t> &entries) {
+    if (!mappedFile || entries.isEmpty()) {
+        return;
+    }
+    
+    int startRow = mappedIndex.size();
+    beginInsertRows(QModelIndex(), startRow, startRow + entries.size() - 1);
+    mappedIndex += entries;
+    for (const capture_index_entry_t &entry : entries) {
+        totalBytes += capture_index_caplen(&entry);
     }
+    nextSerialNumber = mappedIndex.size() + 1;
+    endInsertRows();
     
-    return displayTime.toString("hh:mm:ss.zzz");
-}
\ No newline at end of file
+    emit packetsBatchAdded(startRow, entries.size());
+    emit statisticsChanged();
+}
+
+bool PacketModel::isMappedBackend() const {
+    return !mappedFile.isNull();
+}
+
+const PacketInfo *PacketModel::mappedPacket(int row) const {
+    if (PacketInfo *cached = mappedRowCache.object(row)) {
+        return cached;
+    }
+    
+    // The slice points straight into the mapping and keeps the file open
+    const capture_index_entry_t &entry = mappedIndex.at(row);
+    int length = static_cast<int>(capture_index_caplen(&entry));
+    const char *data = reinterpret_cast<const char*>(capture_index_data(mappedFile.data(), &entry));
+    PacketSlice slice(PacketSlab::wrap(data, length, mappedFile), 0, length);
+    
+    PacketInfo *packet = new PacketInfo(mappedSummarizer(slice, entry.ts_ns));
+    packet->serialNumber = row + 1;
+    if (packet->moreInfo.isEmpty()) {
+        packet->moreInfo = PacketInfoGenerator::generateMoreInfo(
+            packet->protocolType, packet->sourceIP, packet->destinationIP,
+            packet->packetLength, slice.bytes(), packet->summary);
+    }
+    mappedRowCache.insert(row, packet);
+    return packet;
+}
+
+int PacketModel::serialAt(int row) const {
+    // Mapped rows number from 1; no need to summarize the row for it
+    return mappedFile ? row + 1 : store.serialNumber(row);
+}
+
+qint64 PacketModel::timestampAt(int row) const {
+    return mappedFile ? mappedIndex.at(row).ts_ns : store.timestampNs(row);
+}
+
+QString PacketModel::sourceAt(int row) const {
+    return mappedFile ? mappedPacket(row)->sourceIP : store.sourceText(row);
+}
+
+QString PacketModel::destinationAt(int row) const {
+    return mappedFile ? mappedPacket(row)->destinationIP : store.destinationText(row);
+}
+
+int PacketModel::lengthAt(int row) const {
+    return mappedFile ? mappedPacket(row)->packetLength : store.length(row);
+}
+
+QString PacketModel::protocolAt(int row) const {
+    return mappedFile ? mappedPacket(row)->protocolType : store.protocolName(store.protocolId(row));
+}
+
+void PacketModel::filterRowAt(int row, DisplayFilterRow &out) const {
+    if (mappedFile) {
+        fillFilterRow(*mappedPacket(row), out);
+    } else {
+        store.filterRow(row, out);
+    }
+}
+
+QByteArray PacketModel::frameBytes(int row, QByteArray &scratch) const {
+    if (mappedFile) {
+        const capture_index_entry_t &entry = mappedIndex.at(row);
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(capture_index_data(mappedFile.data(), &entry)),
+                                       static_cast<int>(capture_index_caplen(&entry)));
+    }
+    return store.frameBytes(row, scratch);
+}
+
+int PacketModel::rowOfSerial(int serialNumber) const {
+    if (mappedFile) {
+        // Mapped rows are never evicted and number from 1
+        return serialNumber >= 1 && serialNumber <= mappedIndex.size() ? serialNumber - 1 : -1;
+    }
+    return store.rowOfSerial(serialNumber);
+}
+
+PacketSnapshot PacketModel::snapshot() const {
+    PacketSnapshot rows;
+    rows.store = store;
+    rows.mappedFile = mappedFile;
+    rows.mappedIndex = mappedIndex;
+    rows.mappedSummarizer = mappedSummarizer;
+    return rows;
+}
+
+QString PacketModel::infoAt(int row) const {
+    if (mappedFile) {
+        return mappedPacket(row)->moreInfo;
+    }
+    
+    int serial = store.serialNumber(row);
+    if (QString *cached = infoCache.object(serial)) {
+        return *cached;
+    }
+    QString *text = new QString(store.moreInfo(row));
+    infoCache.insert(serial, text);
+    return *text;
+}
+
+quint8 PacketModel::protocolStyleAt(int row) const {
+    if (mappedFile) {
+        return protocolStyle(mappedPacket(row)->protocolType);
+    }
+    
+    quint16 id = store.protocolId(row);
+    if (id >= protocolStyles.size()) {
+        protocolStyles.resize(id + 1, 0);
+    }
+    if (!(protocolStyles.at(id) & StyleKnown)) {
+        protocolStyles[id] = protocolStyle(store.protocolName(id)) | StyleKnown;
+    }
+    return protocolStyles.at(id);
+}
+
+quint8 PacketModel::protocolStyle(const QString &protocol) {
+    quint8 style = StylePlain;
+    if (protocol.contains("HTTP", Qt::CaseInsensitive)) {
+        style = StyleHttp;
+    } else if (protocol.contains("TLS", Qt::CaseInsensitive)) {
+        style = StyleTls;
+    } else if (protocol.contains("SSH", Qt::CaseInsensitive)) {
+        style = StyleSsh;
+    } else if (protocol.contains("DNS", Qt::CaseInsensitive)) {
+        style = StyleDns;
+    } else if (protocol.contains("ARP", Qt::CaseInsensitive)) {
+        style = StyleArp;
+    }
+    if (protocol.contains("Error", Qt::CaseInsensitive)) {
+        style |= StyleBold;
+    }
+    return style;
+}
+
+// PacketSnapshot implementation
+int PacketSnapshot::size() const {
+    return mappedFile ? mappedIndex.size() : store.size();
+}
+
+int PacketSnapshot::serialAt(int row) const {
+    return mappedFile ? row + 1 : store.serialNumber(row);
+}
+
+qint64 PacketSnapshot::timestampAt(int row) const {
+    return mappedFile ? mappedIndex.at(row).ts_ns : store.timestampNs(row);
+}
+
+QString PacketSnapshot::sourceAt(int row) const {
+    return mappedFile ? mappedPacket(row).sourceIP : store.sourceText(row);
+}
+
+QString PacketSnapshot::destinationAt(int row) const {
+    return mappedFile ? mappedPacket(row).destinationIP : store.destinationText(row);
+}
+
+int PacketSnapshot::lengthAt(int row) const {
+    return mappedFile ? static_cast<int>(capture_index_caplen(&mappedIndex.at(row))) : store.length(row);
+}
+
+QString PacketSnapshot::protocolAt(int row) const {
+    return mappedFile ? mappedPacket(row).protocolType : store.protocolName(store.protocolId(row));
+}
+
+void PacketSnapshot::filterRowAt(int row, DisplayFilterRow &out) const {
+    if (mappedFile) {
+        fillFilterRow(mappedPacket(row), out);
+        out.serialNumber = row + 1;
+    } else {
+        store.filterRow(row, out);
+    }
+}
+
+const PacketInfo &PacketSnapshot::mappedPacket(int row) const {
+    // Readers go field by field through one row before the next
+    if (row != cachedRow) {
+        const capture_index_entry_t &entry = mappedIndex.at(row);
+        int length = static_cast<int>(capture_index_caplen(&entry));
+        const char *data = reinterpret_cast<const char*>(capture_index_data(mappedFile.data(), &entry));
+        cachedPacket = mappedSummarizer(PacketSlice(PacketSlab::wrap(data, length, mappedFile), 0, length), entry.ts_ns);
+        cachedRow = row;
+    }
+    return cachedPacket;
+}
@@ -8,10 +8,20 @@
 #include <QString>
 #include <QTimer>
 #include <QTimeZone>
+#include <QCache>
+#include <QSharedPointer>
+#include <QVector>
 
 #include "ProtocolTreeModel.h"
+#include "PacketStore.h"
+#include "../Utils/PacketSlab.h"
 #include "../TimeZoneSettings.h"
 
+extern "C" {
+    #include "../../src/packetcapture/capture_file.h"
+    #include "../../src/packetcapture/packet_summary.h"
+}
+
 // Maximum packets to keep in memory before applying retention policy
 static const int MAX_PACKETS_IN_MEMORY = 100000;
 
@@ -23,25 +33,79 @@ enum PacketRetentionMode {
     RingBufferRetention     // Circular buffer - overwrite oldest packets
 };
 
+// Capture timestamps are nanoseconds since the Unix epoch (UTC)
+static const qint64 NANOSECONDS_PER_SECOND = 1000000000LL;
+
+// One row as handed between the capture side, PacketModel and its
+// consumers. The model does not keep these; it stores the columns in a
+// PacketStore and rebuilds a PacketInfo for getPacket().
 struct PacketInfo {
     int serialNumber;
-    QDateTime timestamp;
+    qint64 timestampNs;                     // Formatted only when a view asks for it
     QString sourceIP;
     QString destinationIP;
     int packetLength;
     QString protocolType;
-    QString moreInfo;
-    QByteArray rawData;
-    ProtocolAnalysisResult analysisResult;  // Changed from pointer to value type
+    QString moreInfo;                       // Left empty while the frame is kept; see PacketStore
+    PacketSlice rawData;                    // Shared view into a capture slab
+    packet_summary_t summary;               // Single-pass L2-L4 decode of rawData
     
-    // Compression flags
-    bool isCompressed;
-    QByteArray compressedData;
+    PacketInfo() : serialNumber(0), timestampNs(0), packetLength(0), summary() {}
     
-    PacketInfo() : serialNumber(0), packetLength(0), isCompressed(false) {}
+    // UTC, millisecond precision; for exports and other non-hot paths
+    QDateTime timestampDateTime() const {
+        return QDateTime::fromMSecsSinceEpoch(timestampNs / 1000000, QTimeZone::UTC);
+    }
     // Default copy constructor and assignment operator are now safe
 };
 
+// A row's frame as stored, safe to read from any thread
+struct PacketBytes {
+    PacketSlice data;            // Empty while the frame is compressed
+    QByteArray compressedData;   // qCompress()ed frame when compression is on
+    int serialNumber = 0;
+    
+    // Inflates on the calling thread, so workers do the decompression
+    QByteArray bytes() const {
+        return compressedData.isEmpty() ? data.bytes() : qUncompress(compressedData);
+    }
+};
+
+// Builds a row summary from raw packet bytes (see PacketCaptureController::summarizePacket)
+typedef PacketInfo (*PacketSummarizer)(const PacketSlice &packetData, qint64 timestampNs);
+
+// The model's rows as they were at one moment, readable on any thread
+// while the model goes on changing. Taking one costs next to nothing: the
+// columns are implicitly shared, and the model's next change copies its
+// own side instead. A copy remembers the last mapped row it summarized, so
+// give every worker its own rather than sharing one.
+class PacketSnapshot
+{
+public:
+    PacketSnapshot() : mappedSummarizer(nullptr), cachedRow(-1) {}
+    
+    int size() const;
+    int serialAt(int row) const;
+    qint64 timestampAt(int row) const;
+    QString sourceAt(int row) const;
+    QString destinationAt(int row) const;
+    int lengthAt(int row) const;
+    QString protocolAt(int row) const;
+    void filterRowAt(int row, DisplayFilterRow &out) const;
+    
+private:
+    friend class PacketModel;
+    
+    const PacketInfo &mappedPacket(int row) const;
+    
+    PacketStore store;
+    QSharedPointer<capture_file_t> mappedFile;
+    QVector<capture_index_entry_t> mappedIndex;
+    PacketSummarizer mappedSummarizer;
+    mutable int cachedRow;
+    mutable PacketInfo cachedPacket;
+};
+
 class PacketModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -70,12 +134,42 @@ public:
     // Packet management
     void addPacket(const PacketInfo &packet);
     void addPacketsBatch(const QList<PacketInfo> &packets);
+    // A full copy of the row with its frame inflated; for single rows.
+    // Code that walks many rows should use the accessors below.
     PacketInfo getPacket(int index) const;
     void clearPackets();
     
+    // Row fields straight from the columns, for either backend. None of
+    // them copies or inflates the frame except infoAt(), which generates
+    // the text from the frame the first time a row is asked for.
+    int serialAt(int row) const;
+    qint64 timestampAt(int row) const;
+    QString sourceAt(int row) const;
+    QString destinationAt(int row) const;
+    int lengthAt(int row) const;
+    QString protocolAt(int row) const;
+    QString infoAt(int row) const;
+    
+    // What a DisplayFilter tests, without formatting anything
+    void filterRowAt(int row, DisplayFilterRow &out) const;
+    
+    // The row's frame without copying it (see PacketStore::frameBytes)
+    QByteArray frameBytes(int row, QByteArray &scratch) const;
+    
+    // Current row of a serial number, -1 once it has been evicted
+    int rowOfSerial(int serialNumber) const;
+    
+    // For reading the rows off the main thread
+    PacketSnapshot snapshot() const;
+    
+    // Frames of rows [first, first + count) without summarizing or
+    // decompressing them, for handing to background workers
+    QVector<PacketBytes> getPacketBytes(int first, int count) const;
+    
     // Statistics
     int getPacketCount() const;
     qint64 getTotalBytes() const;
+    quint64 getEvictedPacketCount() const;  // Removed by retention, cumulative
     
     // Memory management
     void setRetentionMode(PacketRetentionMode mode);
@@ -98,6 +192,17 @@ public:
     // Timezone support
     void refreshTimestamps(TimeZoneMode mode, const QTimeZone &customZone = QTimeZone::utc());
     void setTimeZoneMode(TimeZoneMode mode, const QTimeZone &customZone = QTimeZone::utc());
+    
+    // "yyyy-MM-dd hh:mm:ss.nnnnnnnnn" in UTC
+    static QString formatFullTimestamp(qint64 timestampNs);
+    
+    // Read-only backend over a memory-mapped capture file. Rows are only an
+    // offset index; a row is summarized when a view, the filter or
+    // getPacket() asks for it, and its bytes are paged in by the kernel.
+    // Adding live packets drops the mapped file.
+    void setMappedCaptureFile(const QSharedPointer<capture_file_t> &file, PacketSummarizer summarizer);
+    void appendMappedPackets(const QVector<capture_index_entry_t> &entries);
+    bool isMappedBackend() const;
 
 signals:
     void packetAdded(int index);
@@ -105,14 +210,16 @@ signals:
     void packetsBatchAdded(int startIndex, int count);
     void statisticsChanged();
     void memoryLimitExceeded();  // Emitted when memory limits are reached
+    void memoryPressureRelieved();  // Emitted once usage is back well under the limit
 
 private slots:
     void checkMemoryLimits();
 
 private:
-    QList<PacketInfo> packets;
+    PacketStore store;
     qint64 totalBytes;
     int nextSerialNumber;
+    quint64 evictedPackets;
     
     // Memory management
     PacketRetentionMode retentionMode;
@@ -126,15 +233,38 @@ private:
     int compressionThreshold;
     
     QTimer *memoryCheckTimer;
+    bool memoryPressure;        // Over the limit at the last check
     
     // Timezone settings
     TimeZoneMode currentTimeZoneMode;
     QTimeZone currentCustomTimeZone;
     
+    // Rows on screen mostly share a second, so its zone-converted
+    // "hh:mm:ss" is reused and only the fraction is formatted per row
+    mutable qint64 formattedSecond;
+    mutable QString formattedSecondText;
+    
+    // More Info of rows recently on screen, by serial number
+    mutable QCache<int, QString> infoCache;
+    
+    // Row colouring per interned protocol id, worked out on first use
+    mutable QVector<quint8> protocolStyles;
+    
+    // Mapped capture file backend; only recently used rows are summarized
+    QSharedPointer<capture_file_t> mappedFile;
+    QVector<capture_index_entry_t> mappedIndex;
+    PacketSummarizer mappedSummarizer;
+    mutable QCache<int, PacketInfo> mappedRowCache;
+    
+    const PacketInfo *mappedPacket(int row) const;
+    quint8 protocolStyleAt(int row) const;
+    
+    static quint8 protocolStyle(const QString &protocol);
     void enforceRetentionPolicy();
+    void evictFirst(int count);
     void removeOldPackets();
     void removeExcessPackets();
-    QString formatTimestamp(const QDateTime &timestamp) const;
+    QString formatTimestamp(qint64 timestampNs) const;
 };
 
 #endif // PACKETMODEL_H
\ No newline at end of file
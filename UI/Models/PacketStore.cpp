@@ -0,0 +1,450 @@
+#include "PacketStore.h"
+#include "PacketModel.h"
+#include "../Utils/PacketInfoGenerator.h"
+#include <QtEndian>
+#include <cstring>
+#include <netinet/if_ether.h>
+#include <arpa/inet.h>
+#include <zlib.h>
+
+// StringPool implementation
+quint32 StringPool::intern(const QString &text) {
+    auto it = ids.constFind(text);
+    if (it != ids.constEnd()) {
+        return it.value();
+    }
+
+    quint32 id = static_cast<quint32>(strings.size());
+    strings.append(text);
+    ids.insert(text, id);
+    return id;
+}
+
+void StringPool::clear() {
+    strings.clear();
+    ids.clear();
+}
+
+// Rows the columns start out with; they double whenever they are full
+static const int INITIAL_CAPACITY = 1024;
+
+// Copies a ring column to a new capacity with row 0 at position 0
+template <typename T>
+static void relayout(QVector<T> &column, int head, int count, int capacity) {
+    QVector<T> grown(capacity);
+    int mask = column.size() - 1;
+    for (int row = 0; row < count; ++row) {
+        grown[row] = column.at((head + row) & mask);
+    }
+    column.swap(grown);
+}
+
+// PacketStore implementation
+PacketStore::PacketStore()
+    : head(0)
+    , count(0)
+    , capacity(0)
+    , firstSerial(1)
+    , lastSlab(nullptr)
+    , lastSlabSlot(0)
+    , compressedBase(0)
+    , detachedInfoBase(0)
+{
+}
+
+void PacketStore::reserve(int rows) {
+    if (rows > capacity) {
+        grow(rows);
+    }
+}
+
+void PacketStore::grow(int minimum) {
+    int grown = qMax(capacity, INITIAL_CAPACITY);
+    while (grown < minimum) {
+        grown *= 2;
+    }
+
+    if (capacity == 0) {
+        // Nothing to move yet
+        timestamps.resize(grown);
+        lengths.resize(grown);
+        protocols.resize(grown);
+        addressKinds.resize(grown);
+        appProtos.resize(grown);
+        l3s.resize(grown);
+        l4Protos.resize(grown);
+        sourcePorts.resize(grown);
+        destinationPorts.resize(grown);
+        sources.resize(grown);
+        destinations.resize(grown);
+        frameSlots.resize(grown);
+        frameOffsets.resize(grown);
+    } else {
+        relayout(timestamps, head, count, grown);
+        relayout(lengths, head, count, grown);
+        relayout(protocols, head, count, grown);
+        relayout(addressKinds, head, count, grown);
+        relayout(appProtos, head, count, grown);
+        relayout(l3s, head, count, grown);
+        relayout(l4Protos, head, count, grown);
+        relayout(sourcePorts, head, count, grown);
+        relayout(destinationPorts, head, count, grown);
+        relayout(sources, head, count, grown);
+        relayout(destinations, head, count, grown);
+        relayout(frameSlots, head, count, grown);
+        relayout(frameOffsets, head, count, grown);
+    }
+    head = 0;
+    capacity = grown;
+}
+
+void PacketStore::append(const PacketInfo &packet, int serialNumber, const QByteArray &compressedFrame) {
+    const packet_summary_t &summary = packet.summary;
+
+    if (count == 0) {
+        firstSerial = serialNumber;
+    }
+    Q_ASSERT(serialNumber == firstSerial + count);
+    if (count == capacity) {
+        grow(count + 1);
+    }
+
+    quint8 kind;
+    switch (summary.l3) {
+        case PACKET_L3_IPV4:
+            kind = AddressIPv4;
+            break;
+        case PACKET_L3_IPV6:
+            kind = AddressIPv6;
+            break;
+        default:
+            kind = summary.ethertype == ETH_P_IP || summary.ethertype == ETH_P_IPV6 ||
+                   (summary.flags & PACKET_SUMMARY_TRUNCATED) ? AddressUnknown : AddressNonIP;
+            break;
+    }
+
+    quint32 slot;
+    quint32 offset;
+    if (!compressedFrame.isEmpty()) {
+        slot = COMPRESSED;
+        offset = compressedBase + static_cast<quint32>(compressedFrames.size());
+        compressedFrames.append(compressedFrame);
+    } else if (packet.rawData.sharedSlab()) {
+        slot = slabSlot(packet.rawData.sharedSlab());
+        offset = static_cast<quint32>(packet.rawData.offset());
+    } else {
+        slot = NO_FRAME;
+        offset = detachedInfoBase + static_cast<quint32>(detachedInfo.size());
+        detachedInfo.append(packet.moreInfo);
+    }
+
+    int pos = position(count);
+    timestamps[pos] = packet.timestampNs;
+    lengths[pos] = packet.rawData.isEmpty() ? packet.packetLength : packet.rawData.size();
+    protocols[pos] = internProtocol(packet.protocolType);
+    addressKinds[pos] = kind;
+    appProtos[pos] = summary.app_proto;
+    l3s[pos] = summary.l3;
+    l4Protos[pos] = summary.l4_proto;
+    bool ports = summary.flags & PACKET_SUMMARY_HAS_PORTS;
+    sourcePorts[pos] = ports ? summary.src_port : 0;
+    destinationPorts[pos] = ports ? summary.dst_port : 0;
+    memcpy(sources[pos].bytes, summary.src_addr, sizeof(summary.src_addr));
+    memcpy(destinations[pos].bytes, summary.dst_addr, sizeof(summary.dst_addr));
+    frameSlots[pos] = slot;
+    frameOffsets[pos] = offset;
+    count++;
+}
+
+qint64 PacketStore::removeFirst(int rows) {
+    rows = qMin(rows, count);
+    if (rows <= 0) {
+        return 0;
+    }
+
+    qint64 bytes = 0;
+    int compressed = 0;
+    int detached = 0;
+    for (int row = 0; row < rows; ++row) {
+        int pos = position(row);
+        bytes += lengths.at(pos);
+
+        quint32 slot = frameSlots.at(pos);
+        if (slot == COMPRESSED) {
+            compressed++;
+        } else if (slot == NO_FRAME) {
+            detached++;
+        } else {
+            releaseSlabSlot(slot);
+        }
+    }
+
+    // Side lists are in row order, so the evicted entries lead them
+    compressedFrames.remove(0, compressed);
+    compressedBase += static_cast<quint32>(compressed);
+    detachedInfo.remove(0, detached);
+    detachedInfoBase += static_cast<quint32>(detached);
+
+    head = position(rows);
+    count -= rows;
+    firstSerial += rows;
+    return bytes;
+}
+
+void PacketStore::clear() {
+    timestamps = QVector<qint64>();
+    lengths = QVector<qint32>();
+    protocols = QVector<quint16>();
+    addressKinds = QVector<quint8>();
+    appProtos = QVector<quint8>();
+    l3s = QVector<quint8>();
+    l4Protos = QVector<quint8>();
+    sourcePorts = QVector<quint16>();
+    destinationPorts = QVector<quint16>();
+    sources = QVector<Address>();
+    destinations = QVector<Address>();
+    frameSlots = QVector<quint32>();
+    frameOffsets = QVector<quint32>();
+    head = 0;
+    count = 0;
+    capacity = 0;
+    firstSerial = 1;
+
+    protocolPool.clear();
+    slabSlots.clear();
+    freeSlabSlots.clear();
+    slabSlotIndex.clear();
+    lastSlab = nullptr;
+    lastSlabSlot = 0;
+    compressedFrames.clear();
+    compressedBase = 0;
+    detachedInfo.clear();
+    detachedInfoBase = 0;
+}
+
+int PacketStore::lowerBound(qint64 timestampNs) const {
+    int first = 0;
+    int last = count;
+    while (first < last) {
+        int middle = first + (last - first) / 2;
+        if (timestamps.at(position(middle)) < timestampNs) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+int PacketStore::rowOfSerial(int serialNumber) const {
+    int row = serialNumber - firstSerial;
+    return row >= 0 && row < count ? row : -1;
+}
+
+quint16 PacketStore::internProtocol(const QString &name) {
+    // Every "Ethernet 0x...." seen could in theory use up the 16-bit ids
+    if (protocolPool.size() >= 0xffff && !protocolPool.contains(name)) {
+        return static_cast<quint16>(protocolPool.intern(QStringLiteral("Other")));
+    }
+    return static_cast<quint16>(protocolPool.intern(name));
+}
+
+QString PacketStore::sourceText(int row) const {
+    int pos = position(row);
+    return addressText(addressKinds.at(pos), sources.at(pos));
+}
+
+QString PacketStore::destinationText(int row) const {
+    int pos = position(row);
+    return addressText(addressKinds.at(pos), destinations.at(pos));
+}
+
+void PacketStore::filterRow(int row, DisplayFilterRow &out) const {
+    int pos = position(row);
+    out.source = sources.at(pos).bytes;
+    out.destination = destinations.at(pos).bytes;
+    out.serialNumber = serialNumber(row);
+    out.length = lengths.at(pos);
+    out.sourcePort = sourcePorts.at(pos);
+    out.destinationPort = destinationPorts.at(pos);
+    out.l3 = l3s.at(pos);
+    out.l4 = l4Protos.at(pos);
+    out.appProto = appProtos.at(pos);
+}
+
+PacketSlice PacketStore::frame(int row) const {
+    int pos = position(row);
+    quint32 slot = frameSlots.at(pos);
+    if (slot == COMPRESSED || slot == NO_FRAME) {
+        return PacketSlice();
+    }
+    return PacketSlice(slabSlots.at(static_cast<int>(slot)).slab,
+                       static_cast<int>(frameOffsets.at(pos)), lengths.at(pos));
+}
+
+QByteArray PacketStore::compressedFrame(int row) const {
+    int pos = position(row);
+    if (frameSlots.at(pos) != COMPRESSED) {
+        return QByteArray();
+    }
+    return compressedFrames.at(static_cast<int>(frameOffsets.at(pos) - compressedBase));
+}
+
+QByteArray PacketStore::frameBytes(int row, QByteArray &scratch) const {
+    int pos = position(row);
+    quint32 slot = frameSlots.at(pos);
+    if (slot == NO_FRAME) {
+        return QByteArray();
+    }
+    if (slot != COMPRESSED) {
+        const PacketSlab *slab = slabSlots.at(static_cast<int>(slot)).slab.data();
+        return QByteArray::fromRawData(slab->constData() + frameOffsets.at(pos), lengths.at(pos));
+    }
+
+    // qCompress() output: the inflated size as 4 big-endian bytes, then a
+    // zlib stream. Inflating straight into scratch is what qUncompress()
+    // cannot do.
+    const QByteArray &packed = compressedFrames.at(static_cast<int>(frameOffsets.at(pos) - compressedBase));
+    if (packed.size() < 4) {
+        return QByteArray();
+    }
+    uLongf inflated = qFromBigEndian<quint32>(packed.constData());
+    scratch.resize(static_cast<int>(inflated));
+    if (uncompress(reinterpret_cast<Bytef*>(scratch.data()), &inflated,
+                   reinterpret_cast<const Bytef*>(packed.constData() + 4),
+                   static_cast<uLong>(packed.size() - 4)) != Z_OK) {
+        scratch.clear();
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(scratch.constData(), static_cast<int>(inflated));
+}
+
+QString PacketStore::moreInfo(int row) const {
+    int pos = position(row);
+    if (frameSlots.at(pos) == NO_FRAME) {
+        return detachedInfo.at(static_cast<int>(frameOffsets.at(pos) - detachedInfoBase));
+    }
+
+    QByteArray bytes = frameBytes(row, inflateScratch);
+
+    return PacketInfoGenerator::generateMoreInfo(
+        protocolName(protocols.at(pos)),
+        sourceText(row),
+        destinationText(row),
+        lengths.at(pos),
+        bytes,
+        summaryOf(row, bytes)
+    );
+}
+
+PacketInfo PacketStore::packet(int row) const {
+    int pos = position(row);
+    PacketInfo packet;
+    packet.serialNumber = serialNumber(row);
+    packet.timestampNs = timestamps.at(pos);
+    packet.packetLength = lengths.at(pos);
+    packet.rawData = isCompressed(row) ? PacketSlice(qUncompress(compressedFrame(row))) : frame(row);
+
+    QByteArray bytes = packet.rawData.bytes();
+    packet.summary = summaryOf(row, bytes);
+    packet.sourceIP = sourceText(row);
+    packet.destinationIP = destinationText(row);
+    packet.protocolType = protocolName(protocols.at(pos));
+    if (frameSlots.at(pos) == NO_FRAME) {
+        packet.moreInfo = moreInfo(row);
+    } else {
+        packet.moreInfo = PacketInfoGenerator::generateMoreInfo(
+            packet.protocolType,
+            packet.sourceIP,
+            packet.destinationIP,
+            packet.packetLength,
+            bytes,
+            packet.summary
+        );
+    }
+    return packet;
+}
+
+packet_summary_t PacketStore::summaryOf(int row, const QByteArray &frame) const {
+    int pos = position(row);
+    packet_summary_t summary;
+    if (frame.isEmpty()) {
+        // Only what the columns hold
+        memset(&summary, 0, sizeof(summary));
+        summary.l3 = l3s.at(pos);
+        summary.l4_proto = l4Protos.at(pos);
+        summary.src_port = sourcePorts.at(pos);
+        summary.dst_port = destinationPorts.at(pos);
+        if (summary.src_port != 0 || summary.dst_port != 0) {
+            summary.flags |= PACKET_SUMMARY_HAS_PORTS;
+        }
+        memcpy(summary.src_addr, sources.at(pos).bytes, sizeof(summary.src_addr));
+        memcpy(summary.dst_addr, destinations.at(pos).bytes, sizeof(summary.dst_addr));
+    } else {
+        packet_summary_decode(reinterpret_cast<const uint8_t*>(frame.constData()),
+                              static_cast<size_t>(frame.size()), &summary);
+    }
+
+    // The verdict may have come from the flow's payload, which a re-decode
+    // of this frame alone cannot repeat
+    summary.app_proto = appProtos.at(pos);
+    return summary;
+}
+
+QString PacketStore::addressText(quint8 kind, const Address &address) {
+    char text[INET6_ADDRSTRLEN];
+
+    switch (kind) {
+        case AddressIPv4:
+            inet_ntop(AF_INET, address.bytes, text, sizeof(text));
+            return QString::fromLatin1(text);
+        case AddressIPv6:
+            inet_ntop(AF_INET6, address.bytes, text, sizeof(text));
+            return QString::fromLatin1(text);
+        case AddressUnknown:
+            return QStringLiteral("Unknown");
+        default:
+            return QStringLiteral("Non-IP");
+    }
+}
+
+quint32 PacketStore::slabSlot(const QSharedPointer<PacketSlab> &slab) {
+    // Consecutive packets almost always share the slab being filled
+    quint32 slot;
+    if (slab.data() == lastSlab) {
+        slot = lastSlabSlot;
+    } else {
+        auto it = slabSlotIndex.constFind(slab.data());
+        if (it != slabSlotIndex.constEnd()) {
+            slot = it.value();
+        } else if (!freeSlabSlots.isEmpty()) {
+            slot = freeSlabSlots.takeLast();
+            slabSlots[static_cast<int>(slot)] = SlabSlot{slab, 0};
+            slabSlotIndex.insert(slab.data(), slot);
+        } else {
+            slot = static_cast<quint32>(slabSlots.size());
+            slabSlots.append(SlabSlot{slab, 0});
+            slabSlotIndex.insert(slab.data(), slot);
+        }
+        lastSlab = slab.data();
+        lastSlabSlot = slot;
+    }
+
+    slabSlots[static_cast<int>(slot)].rows++;
+    return slot;
+}
+
+void PacketStore::releaseSlabSlot(quint32 slot) {
+    SlabSlot &entry = slabSlots[static_cast<int>(slot)];
+    if (--entry.rows > 0) {
+        return;
+    }
+
+    // The address may come back for a new slab, so forget it now
+    slabSlotIndex.remove(entry.slab.data());
+    if (lastSlab == entry.slab.data()) {
+        lastSlab = nullptr;
+    }
+    entry.slab.reset();
+    freeSlabSlots.append(slot);
+}
@@ -0,0 +1,215 @@
+#ifndef PACKETSTORE_H
+#define PACKETSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "DisplayFilter.h"
+#include "../Utils/PacketSlab.h"
+
+extern "C" {
+    #include "../../src/packetcapture/packet_summary.h"
+}
+
+struct PacketInfo;
+
+/**
+ * @brief Hands out small dense ids for strings that repeat a lot
+ *
+ * Ids are never reused until clear(), so they can be stored per row and
+ * compared directly.
+ */
+class StringPool
+{
+public:
+    quint32 intern(const QString &text);
+    const QString &at(quint32 id) const { return strings.at(static_cast<int>(id)); }
+    bool contains(const QString &text) const { return ids.contains(text); }
+    int size() const { return strings.size(); }
+    void clear();
+
+private:
+    QVector<QString> strings;
+    QHash<QString, quint32> ids;
+};
+
+/**
+ * @brief Struct-of-arrays storage behind PacketModel
+ *
+ * Every row is a handful of fixed-width columns: timestamp, length, an
+ * interned protocol id, both addresses as 16 raw bytes, the L3/L4
+ * protocols and ports display filters test, and a (slab slot, offset)
+ * reference to the frame. That is ROW_BYTES of metadata per
+ * packet, with no per-row heap allocation. The address and info strings
+ * are not kept at all; they are formatted from the columns and the frame
+ * when something asks for them, which for the table is only the rows on
+ * screen.
+ *
+ * The columns are rings over a power-of-two capacity. Row 0 is wherever
+ * the head currently is, so evicting the oldest rows only moves the head
+ * and never shifts the others. Serial numbers are consecutive, so a row's
+ * serial is the head's plus its row number and never changes while the
+ * row is stored.
+ *
+ * Frames either stay in the capture slab they were received into or,
+ * when compressed, move to a side list kept in row order. Rows that come
+ * without a frame (summary-only overload batches) keep their More Info
+ * text in a second such list instead, as it cannot be generated later.
+ */
+class PacketStore
+{
+public:
+    // How an address column is displayed
+    enum AddressKind : quint8 {
+        AddressNonIP = 0,
+        AddressIPv4,
+        AddressIPv6,
+        AddressUnknown      // IP header cut short by the snap length
+    };
+
+    struct Address {
+        quint8 bytes[16];
+    };
+
+    static constexpr int ROW_BYTES = sizeof(qint64) + 3 * sizeof(qint32) + 3 * sizeof(quint16) +
+                                     4 * sizeof(quint8) + 2 * sizeof(Address);
+    static_assert(ROW_BYTES < 64, "per-packet metadata budget");
+
+    PacketStore();
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    void reserve(int rows);
+
+    /**
+     * @brief Add a summarized packet as the last row
+     * @param serialNumber Must follow the last row's, unless the store is empty
+     * @param compressedFrame qCompress()ed frame to keep instead of the slab
+     *        reference, or empty to keep the frame where it is
+     */
+    void append(const PacketInfo &packet, int serialNumber, const QByteArray &compressedFrame);
+
+    /**
+     * @brief Drop the oldest rows
+     *
+     * Costs O(rows) whatever the size of the store. Slabs go back once no
+     * row references them.
+     * @return Bytes the dropped rows accounted for
+     */
+    qint64 removeFirst(int rows);
+    void clear();
+
+    /**
+     * @brief First row whose timestamp is not before timestampNs
+     *
+     * Binary search; rows are expected in capture order.
+     */
+    int lowerBound(qint64 timestampNs) const;
+
+    // -1 once the row has been evicted
+    int rowOfSerial(int serialNumber) const;
+
+    int serialNumber(int row) const { return firstSerial + row; }
+    qint64 timestampNs(int row) const { return timestamps.at(position(row)); }
+    int length(int row) const { return lengths.at(position(row)); }
+    quint16 protocolId(int row) const { return protocols.at(position(row)); }
+    const QString &protocolName(quint16 id) const { return protocolPool.at(id); }
+    quint16 internProtocol(const QString &name);
+
+    QString sourceText(int row) const;
+    QString destinationText(int row) const;
+
+    // The binary fields a DisplayFilter tests, pointing into the columns
+    void filterRow(int row, DisplayFilterRow &out) const;
+
+    bool isCompressed(int row) const { return frameSlots.at(position(row)) == COMPRESSED; }
+
+    // Empty for compressed rows
+    PacketSlice frame(int row) const;
+    QByteArray compressedFrame(int row) const;
+
+    /**
+     * @brief The frame's bytes without copying them
+     *
+     * A raw view into the slab, or, for a compressed row, into scratch
+     * after inflating the frame there. scratch keeps its capacity, so a
+     * loop over many rows allocates only when a frame is larger than any
+     * before it. The view is valid until the row is evicted or scratch is
+     * reused.
+     */
+    QByteArray frameBytes(int row, QByteArray &scratch) const;
+
+    /**
+     * @brief The More Info text, generated from the frame on every call
+     */
+    QString moreInfo(int row) const;
+
+    /**
+     * @brief Rebuild the full row, summary and strings included
+     */
+    PacketInfo packet(int row) const;
+
+private:
+    // frameSlots values that are not slab slots
+    static constexpr quint32 NO_FRAME = 0xffffffffu;
+    static constexpr quint32 COMPRESSED = 0xfffffffeu;
+
+    struct SlabSlot {
+        QSharedPointer<PacketSlab> slab;
+        int rows;
+    };
+
+    // Position of a row in the column rings
+    int position(int row) const { return (head + row) & (capacity - 1); }
+    void grow(int minimum);
+
+    static QString addressText(quint8 kind, const Address &address);
+    packet_summary_t summaryOf(int row, const QByteArray &frame) const;
+    quint32 slabSlot(const QSharedPointer<PacketSlab> &slab);
+    void releaseSlabSlot(quint32 slot);
+
+    // Per-row columns, all indexed by position(row)
+    QVector<qint64> timestamps;
+    QVector<qint32> lengths;
+    QVector<quint16> protocols;
+    QVector<quint8> addressKinds;
+    QVector<quint8> appProtos;           // PORT_APP_*, including heuristic verdicts
+    QVector<quint8> l3s;                 // PACKET_L3_*
+    QVector<quint8> l4Protos;            // IP protocol number
+    QVector<quint16> sourcePorts;        // 0 unless the summary had ports
+    QVector<quint16> destinationPorts;
+    QVector<Address> sources;
+    QVector<Address> destinations;
+    QVector<quint32> frameSlots;         // Slab slot, NO_FRAME or COMPRESSED
+    QVector<quint32> frameOffsets;       // Into the slab, else a sequence number in the side list
+
+    int head;
+    int count;
+    int capacity;                        // Of every column; a power of two
+    int firstSerial;                     // Of row 0
+
+    StringPool protocolPool;
+
+    // Distinct slabs the rows point into; freed slots are reused
+    QVector<SlabSlot> slabSlots;
+    QVector<quint32> freeSlabSlots;
+    QHash<const PacketSlab*, quint32> slabSlotIndex;
+    const PacketSlab *lastSlab;
+    quint32 lastSlabSlot;
+
+    // Compressed frames in row order; the first one has sequence number
+    // compressedBase
+    QList<QByteArray> compressedFrames;
+    quint32 compressedBase;
+    mutable QByteArray inflateScratch;   // For moreInfo()
+
+    // Likewise for the More Info of rows without a frame
+    QList<QString> detachedInfo;
+    quint32 detachedInfoBase;
+};
+
+#endif // PACKETSTORE_H
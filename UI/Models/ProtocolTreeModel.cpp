@@ -5,7 +5,7 @@
 
 // ProtocolTreeItem implementation
 ProtocolTreeItem::ProtocolTreeItem(const QString &name, const QString &value, ProtocolTreeItem *parent)
-    : itemName(name), itemValue(value), parent(parent)
+    : itemName(name), itemValue(value), byteOffset(-1), byteLength(0), parent(parent)
 {
 }
 
@@ -62,6 +62,11 @@ void ProtocolTreeItem::setValue(const QString &value) {
     itemValue = value;
 }
 
+void ProtocolTreeItem::setByteRange(int offset, int length) {
+    byteOffset = offset;
+    byteLength = length;
+}
+
 QString ProtocolTreeItem::getName() const {
     return itemName;
 }
@@ -70,6 +75,14 @@ QString ProtocolTreeItem::getValue() const {
     return itemValue;
 }
 
+int ProtocolTreeItem::getOffset() const {
+    return byteOffset;
+}
+
+int ProtocolTreeItem::getLength() const {
+    return byteLength;
+}
+
 // ProtocolTreeModel implementation
 ProtocolTreeModel::ProtocolTreeModel(QObject *parent)
     : QAbstractItemModel(parent)
@@ -115,6 +128,18 @@ QVariant ProtocolTreeModel::data(const QModelIndex &index, int role) const {
         }
         return QVariant();
     }
+    else if (role == FieldNameRole) {
+        return item->getName();
+    }
+    else if (role == FieldValueRole) {
+        return item->getValue();
+    }
+    else if (role == StartOffsetRole) {
+        return item->getOffset() >= 0 ? QVariant(item->getOffset()) : QVariant();
+    }
+    else if (role == LengthRole) {
+        return item->getOffset() >= 0 ? QVariant(item->getLength()) : QVariant();
+    }
     else if (role == Qt::ToolTipRole) {
         QString tooltip = item->getName();
         if (!item->getValue().isEmpty()) {
@@ -250,20 +275,24 @@ void ProtocolTreeModel::setupModelData(const ProtocolAnalysisResult &result) {
 
 void ProtocolTreeModel::addProtocolLayer(const ProtocolLayer &layer, ProtocolTreeItem *parent) {
     ProtocolTreeItem *layerItem = new ProtocolTreeItem(layer.name, "", parent);
+    layerItem->setByteRange(layer.offset, layer.length);
     parent->appendChild(layerItem);
     
-    // Add fields for this layer
-    QMapIterator<QString, QString> fieldIterator(layer.fields);
-    while (fieldIterator.hasNext()) {
-        fieldIterator.next();
-        ProtocolTreeItem *fieldItem = new ProtocolTreeItem(fieldIterator.key(), 
-                                                          fieldIterator.value(), 
-                                                          layerItem);
-        layerItem->appendChild(fieldItem);
-    }
-    
-    // Add sub-layers
+    // Interleave fields and sub-layers in the order they were decoded
+    int fieldIndex = 0;
     for (const ProtocolLayer &subLayer : layer.subLayers) {
+        for (; fieldIndex < subLayer.position && fieldIndex < layer.fields.size(); fieldIndex++) {
+            addProtocolField(layer.fields.at(fieldIndex), layerItem);
+        }
         addProtocolLayer(subLayer, layerItem);
     }
-}
\ No newline at end of file
+    for (; fieldIndex < layer.fields.size(); fieldIndex++) {
+        addProtocolField(layer.fields.at(fieldIndex), layerItem);
+    }
+}
+
+void ProtocolTreeModel::addProtocolField(const ProtocolField &field, ProtocolTreeItem *parent) {
+    ProtocolTreeItem *fieldItem = new ProtocolTreeItem(field.name, field.value, parent);
+    fieldItem->setByteRange(field.offset, field.length);
+    parent->appendChild(fieldItem);
+}
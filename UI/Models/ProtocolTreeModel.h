@@ -5,16 +5,36 @@
 #include <QModelIndex>
 #include <QVariant>
 #include <QString>
-#include <QMap>
 #include <QList>
 
+// offset/length locate the bytes a field or layer was decoded from;
+// offset is -1 when there is no single byte range.
+struct ProtocolField {
+    QString name;
+    QString value;
+    int offset = -1;
+    int length = 0;
+    
+    ProtocolField() = default;
+    ProtocolField(const QString &fieldName, const QString &fieldValue, int fieldOffset = -1, int fieldLength = 0)
+        : name(fieldName), value(fieldValue), offset(fieldOffset), length(fieldLength) {}
+};
+
 struct ProtocolLayer {
     QString name;
-    QMap<QString, QString> fields;
+    QList<ProtocolField> fields;        // in decode order
     QList<ProtocolLayer> subLayers;
+    int offset = -1;
+    int length = 0;
+    int position = 0;                   // parent fields decoded before this layer
     
     ProtocolLayer() = default;
-    ProtocolLayer(const QString &layerName) : name(layerName) {}
+    ProtocolLayer(const QString &layerName, int layerOffset = -1, int layerLength = 0)
+        : name(layerName), offset(layerOffset), length(layerLength) {}
+    
+    void addField(const QString &fieldName, const QString &fieldValue, int fieldOffset = -1, int fieldLength = 0) {
+        fields.append(ProtocolField(fieldName, fieldValue, fieldOffset, fieldLength));
+    }
 };
 
 struct ProtocolAnalysisResult {
@@ -43,13 +63,18 @@ public:
     
     void setName(const QString &name);
     void setValue(const QString &value);
+    void setByteRange(int offset, int length);
     QString getName() const;
     QString getValue() const;
+    int getOffset() const;
+    int getLength() const;
 
 private:
     QList<ProtocolTreeItem*> childItems;
     QString itemName;
     QString itemValue;
+    int byteOffset;
+    int byteLength;
     ProtocolTreeItem *parent;
 };
 
@@ -84,6 +109,7 @@ public:
 private:
     void setupModelData(const ProtocolAnalysisResult &result);
     void addProtocolLayer(const ProtocolLayer &layer, ProtocolTreeItem *parent);
+    void addProtocolField(const ProtocolField &field, ProtocolTreeItem *parent);
     
     ProtocolTreeItem *rootItem;
 };
@@ -8,6 +8,205 @@
 #include <QMutexLocker>
 #include <QCoreApplication>
 #include <QTimeZone>
+#include <QRunnable>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+
+// Kernel buffer requested for live captures; large enough to absorb
+// short bursts on a 1 GbE link while the loop is flushing a batch
+static const int CAPTURE_KERNEL_BUFFER_BYTES = 32 * 1024 * 1024;
+
+// Reservoir sampling window and token bucket depth
+static const qint64 RESERVOIR_WINDOW_NS = NANOSECONDS_PER_SECOND;
+static const qint64 TOKEN_BUCKET_BURST_NS = NANOSECONDS_PER_SECOND / 10;
+
+// Flows kept by a worker that is sampling because it is short of credits
+static const quint64 OVERLOAD_SAMPLE_FLOWS = 8;
+
+// Direction-independent hash of the 5-tuple, so both halves of a
+// conversation fall on the same side of the flow sampling decision.
+// Fragments are hashed without ports; non-IP frames hash their MAC pair.
+static quint32 packetFlowHash(const uchar *data, int length) {
+    if (length < 14) {
+        return 0;
+    }
+    
+    int offset = 14;
+    quint16 etherType = quint16((data[12] << 8) | data[13]);
+    for (int tags = 0; tags < 2 && (etherType == 0x8100 || etherType == 0x88a8) && length >= offset + 4; ++tags) {
+        etherType = quint16((data[offset + 2] << 8) | data[offset + 3]);
+        offset += 4;
+    }
+    
+    const uchar *addressA = data + 6;
+    const uchar *addressB = data;
+    int addressLength = 6;
+    quint8 protocol = 0;
+    int transportOffset = -1;
+    
+    if (etherType == 0x0800 && length >= offset + 20) {
+        bool fragment = ((data[offset + 6] & 0x3f) | data[offset + 7]) != 0;
+        protocol = data[offset + 9];
+        addressA = data + offset + 12;
+        addressB = data + offset + 16;
+        addressLength = 4;
+        if (!fragment) {
+            transportOffset = offset + (data[offset] & 0x0f) * 4;
+        }
+    } else if (etherType == 0x86dd && length >= offset + 40) {
+        // Extension headers are not walked; such packets hash without ports
+        protocol = data[offset + 6];
+        addressA = data + offset + 8;
+        addressB = data + offset + 24;
+        addressLength = 16;
+        transportOffset = offset + 40;
+    }
+    
+    quint16 portA = 0;
+    quint16 portB = 0;
+    if (transportOffset >= 0 && (protocol == 6 || protocol == 17 || protocol == 132) &&
+        length >= transportOffset + 4) {
+        portA = quint16((data[transportOffset] << 8) | data[transportOffset + 1]);
+        portB = quint16((data[transportOffset + 2] << 8) | data[transportOffset + 3]);
+    }
+    
+    int order = memcmp(addressA, addressB, addressLength);
+    if (order > 0 || (order == 0 && portA > portB)) {
+        std::swap(addressA, addressB);
+        std::swap(portA, portB);
+    }
+    
+    // FNV-1a over the canonical tuple, then a murmur3 finalizer so the high
+    // bits used by the sampling decision are well mixed
+    quint32 hash = 2166136261u;
+    auto mix = [&hash](const uchar *bytes, int count) {
+        for (int i = 0; i < count; ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+    const uchar tail[7] = {uchar(portA >> 8), uchar(portA), uchar(portB >> 8), uchar(portB),
+                           protocol, uchar(etherType >> 8), uchar(etherType)};
+    mix(addressA, addressLength);
+    mix(addressB, addressLength);
+    mix(tail, sizeof(tail));
+    
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Summarizes one batch slot on the controller's pool. The slot is only
+// read here; the controller returns it to the ring once this is done.
+class SummarizeBatchTask : public QRunnable
+{
+public:
+    SummarizeBatchTask(PacketCaptureController *controller,
+                       const QSharedPointer<PacketBatchRing> &ring,
+                       const PacketBatchSlot *slot,
+                       quint64 generation,
+                       quint64 sequence,
+                       bool hugePages,
+                       const QList<QString> &targetMACs)
+        : controller(controller)
+        , ring(ring)
+        , slot(slot)
+        , generation(generation)
+        , sequence(sequence)
+        , hugePages(hugePages)
+        , targetMACs(targetMACs)
+    {
+    }
+    
+    void run() override {
+        // The single copy: into one slab sized to the batch
+        qint64 batchBytes = slot->data.size();
+        for (const TPacketBlockBatch &block : slot->blocks) {
+            for (const struct tpacket3_hdr *frame : block->frames) {
+                tpacket_frame_t info;
+                tpacket_frame_info(frame, &info);
+                batchBytes += info.caplen;
+            }
+        }
+        PacketSlabStore batchSlabs(static_cast<int>(qBound<qint64>(1, batchBytes, PacketSlabStore::DEFAULT_SLAB_BYTES * 16)),
+                                   hugePages);
+        
+        QList<PacketInfo> packets;
+        QList<PacketInfo> summaries;
+        packets.reserve(slot->records.size() + slot->blockFrameCount);
+        int rejected = 0;
+        
+        for (const PacketRecord &record : slot->records) {
+            summarize(slot->data.constData() + record.offset, record.length, record.timestampNs,
+                      batchSlabs, packets, rejected);
+        }
+        
+        for (const TPacketBlockBatch &block : slot->blocks) {
+            for (const struct tpacket3_hdr *frame : block->frames) {
+                tpacket_frame_t info;
+                tpacket_frame_info(frame, &info);
+                summarize(reinterpret_cast<const char*>(info.data), info.caplen,
+                          qint64(info.ts_sec) * NANOSECONDS_PER_SECOND + info.ts_nsec,
+                          batchSlabs, packets, rejected);
+            }
+        }
+        
+        // Fanout workers summarized theirs already; summary-only packets
+        // were filtered by the worker
+        for (PacketInfo summary : slot->summaries) {
+            if (!targetMACs.isEmpty() && !summary.rawData.isEmpty() &&
+                !PacketCaptureController::isTargetPacket(summary.rawData.bytes(), targetMACs)) {
+                continue;
+            }
+            validate(summary, summaries, rejected);
+        }
+        
+        QMetaObject::invokeMethod(controller, "onBatchSummarized", Qt::QueuedConnection,
+                                  Q_ARG(QSharedPointer<PacketBatchRing>, ring),
+                                  Q_ARG(quint64, generation),
+                                  Q_ARG(quint64, sequence),
+                                  Q_ARG(QList<PacketInfo>, packets),
+                                  Q_ARG(QList<PacketInfo>, summaries),
+                                  Q_ARG(int, rejected));
+    }
+    
+private:
+    void summarize(const char *data, int length, qint64 timestampNs, PacketSlabStore &slabs,
+                   QList<PacketInfo> &packets, int &rejected) const {
+        // Filter before anything is copied into the slab
+        if (!PacketCaptureController::isTargetPacket(QByteArray::fromRawData(data, length), targetMACs)) {
+            return;
+        }
+        validate(PacketCaptureController::summarizePacket(slabs.append(data, length), timestampNs),
+                 packets, rejected);
+    }
+    
+    static void validate(PacketInfo packet, QList<PacketInfo> &packets, int &rejected) {
+        // The real serial number is assigned on delivery
+        packet.serialNumber = 1;
+        if (DataValidator::isValidPacketInfo(packet)) {
+            packets.append(packet);
+        } else {
+            rejected++;
+        }
+    }
+    
+    PacketCaptureController *controller;
+    QSharedPointer<PacketBatchRing> ring;
+    const PacketBatchSlot *slot;
+    quint64 generation;
+    quint64 sequence;
+    bool hugePages;
+    QList<QString> targetMACs;  // Empty outside spoofing mode
+};
 
 // PacketCaptureController implementation
 PacketCaptureController::PacketCaptureController(const QString &interface, QObject *parent)
@@ -19,28 +218,52 @@ PacketCaptureController::PacketCaptureController(const QString &interface, QObje
     , spoofingMode(false)
     , packetCount(0)
     , totalBytes(0)
+    , validationRejects(0)
     , statisticsTimer(new QTimer(this))
     , ringBufferEnabled(false)
     , ringBufferSize(100000)
     , backpressureActive(false)
     , backpressureDelayMs(0)
+    , awaitingConsumer(false)
+    , creditReturnScheduled(false)
     , samplingMode(NoSampling)
     , samplingRate(100)  // Sample every 100th packet
     , targetRate(1000)   // Target 1000 packets per second
     , sampledPacketCount(0)
+    , captureLoopMode(BlockingLoop)
+    , maxBatchPackets(512)
+    , flushIntervalMs(20)
+    , captureBackend(PcapBackend)
+    , tpacketBlockSize(TPACKET_RING_DEFAULT_BLOCK_SIZE)
+    , tpacketBlockCount(TPACKET_RING_DEFAULT_BLOCK_COUNT)
+    , tpacketRetireTimeoutMs(TPACKET_RING_DEFAULT_RETIRE_TIMEOUT_MS)
+    , fanoutWorkers(1)
+    , fanoutGroupId(-1)
+    , mergeTimer(new QTimer(this))
+    , summarizeGeneration(0)
+    , diskWriter(nullptr)
 {
+    // Summarization runs beside the GUI thread, not on it
+    summarizePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+
     setupWorker();
     
     // Statistics timer
     connect(statisticsTimer, &QTimer::timeout, this, [this]() {
         emit statisticsUpdated(packetCount, totalBytes);
+        emit captureStatistics(packetCount, static_cast<int>(getDropStatistics().totalDropped()));
     });
     statisticsTimer->start(1000); // Update statistics every second
+    
+    // Merge window for batches arriving from several fanout workers
+    mergeTimer->setSingleShot(true);
+    connect(mergeTimer, &QTimer::timeout, this, &PacketCaptureController::flushMergedPackets);
 }
 
 PacketCaptureController::~PacketCaptureController() {
     stopCapture();
     cleanupWorker();
+    summarizePool.waitForDone();
 }
 
 bool PacketCaptureController::isCapturing() const {
@@ -89,44 +312,38 @@ void PacketCaptureController::startCapture() {
         capturing = true;
         packetCount = 0;
         totalBytes = 0;
+        validationRejects = 0;
+        retiredDropStats = CaptureDropStats();
         sampledPacketCount = 0;
+        resetSummarizePipelines();
+        creditsOwed.clear();
+        awaitingConsumer = false;
+        backpressureActive = false;
         
-        // Set filter if specified
-        if (!currentFilter.isEmpty()) {
-            QMetaObject::invokeMethod(captureWorker, "setFilter", 
-                                     Qt::QueuedConnection,
-                                     Q_ARG(QString, currentFilter));
-        }
-        
-        // Set spoofing targets if in spoofing mode
-        if (spoofingMode && !this->targetMACs.isEmpty()) {
-            captureWorker->spoofingTargets = this->targetMACs;
-            captureWorker->spoofingModeActive = true;
+        // Fanout: extra workers join the primary one in a shared PACKET_FANOUT group
+        int workerCount = resolveFanoutWorkerCount();
+        if (workerCount > 1) {
+            if (captureBackend != TPacketV3Backend) {
+                LOG_WARNING("Fanout capture requires the TPACKET_V3 backend, switching backend");
+                captureBackend = TPacketV3Backend;
+            }
+            static int fanoutSequence = 0;
+            fanoutGroupId = (QCoreApplication::applicationPid() + fanoutSequence++) & 0xffff;
+            setupFanoutWorkers(workerCount - 1);
+        } else {
+            fanoutGroupId = -1;
         }
         
-        // Configure ring buffer if enabled
-        if (ringBufferEnabled) {
-            QMetaObject::invokeMethod(captureWorker, "setRingBufferEnabled", 
-                                     Qt::QueuedConnection,
-                                     Q_ARG(bool, ringBufferEnabled));
-            QMetaObject::invokeMethod(captureWorker, "setRingBufferSize", 
-                                     Qt::QueuedConnection,
-                                     Q_ARG(int, ringBufferSize));
+        configureWorker(captureWorker, fanoutGroupId >= 0 ? 0 : -1);
+        for (int i = 0; i < fanoutWorkerList.size(); ++i) {
+            configureWorker(fanoutWorkerList[i], i + 1);
         }
-        
-        // Configure packet sampling
-        QMetaObject::invokeMethod(captureWorker, "setSamplingMode", 
-                                 Qt::QueuedConnection,
-                                 Q_ARG(PacketCaptureWorker::SamplingMode, static_cast<PacketCaptureWorker::SamplingMode>(samplingMode)));
-        QMetaObject::invokeMethod(captureWorker, "setSamplingRate", 
-                                 Qt::QueuedConnection,
-                                 Q_ARG(int, samplingRate));
-        QMetaObject::invokeMethod(captureWorker, "setTargetRate", 
-                                 Qt::QueuedConnection,
-                                 Q_ARG(int, targetRate));
+        startDiskWriter();
         
         // Start capture
-        QMetaObject::invokeMethod(captureWorker, "startCapture", Qt::QueuedConnection);
+        for (PacketCaptureWorker *worker : activeWorkers()) {
+            QMetaObject::invokeMethod(worker, "startCapture", Qt::QueuedConnection);
+        }
         
         emit captureStatusChanged(true);
         
@@ -146,18 +363,42 @@ void PacketCaptureController::startCapture() {
 }
 
 void PacketCaptureController::stopCapture() {
-    QMutexLocker locker(&captureMutex);
+    // Hand over whatever the fanout workers have already delivered
+    flushMergedPackets();
     
-    if (!capturing) {
-        return;
+    {
+        QMutexLocker locker(&captureMutex);
+        
+        if (!capturing) {
+            return;
+        }
+        
+        capturing = false;
+        
+        for (PacketCaptureWorker *worker : activeWorkers()) {
+            QMetaObject::invokeMethod(worker, "stopCapture", Qt::QueuedConnection);
+            worker->wakeCaptureLoop();
+        }
+        
+        // Workers close their feeds when they stop; the file is closed after that
+        if (diskWriter) {
+            diskWriter->finish();
+        }
     }
     
-    capturing = false;
-    
-    if (captureWorker) {
-        QMetaObject::invokeMethod(captureWorker, "stopCapture", Qt::QueuedConnection);
+    // Wait for the primary worker's last batch. Once its stopCapture has
+    // run, the blocking loop has returned to the thread's event loop
+    if (captureWorker && captureThread && captureThread->isRunning()) {
+        QMetaObject::invokeMethod(captureWorker, []() {}, Qt::BlockingQueuedConnection);
     }
     
+    // Joining can take seconds; don't hold up isCapturing() and the
+    // statistics getters meanwhile
+    cleanupFanoutWorkers();
+    
+    // Everything the workers committed before stopping still reaches the model
+    drainSummarizePipelines();
+    
     emit captureStatusChanged(false);
     
     qDebug() << "Stopped packet capture. Total packets:" << packetCount << "Total bytes:" << totalBytes;
@@ -166,10 +407,13 @@ void PacketCaptureController::stopCapture() {
 void PacketCaptureController::setPacketFilter(const QString &filter) {
     currentFilter = filter;
     
-    if (captureWorker && capturing) {
-        QMetaObject::invokeMethod(captureWorker, "setFilter", 
-                                 Qt::QueuedConnection,
-                                 Q_ARG(QString, filter));
+    if (capturing) {
+        for (PacketCaptureWorker *worker : activeWorkers()) {
+            QMetaObject::invokeMethod(worker, "setFilter", 
+                                     Qt::QueuedConnection,
+                                     Q_ARG(QString, filter));
+            worker->wakeCaptureLoop();
+        }
     }
 }
 
@@ -231,6 +475,327 @@ int PacketCaptureController::getTargetRate() const {
     return targetRate;
 }
 
+double PacketCaptureController::getEffectiveSamplingRatio() const {
+    return getDropStatistics().samplingRatio();
+}
+
+// Capture loop configuration methods
+void PacketCaptureController::setCaptureLoopMode(CaptureLoopMode mode) {
+    captureLoopMode = mode;
+}
+
+void PacketCaptureController::setBatchThresholds(int maxBatchPackets, int flushIntervalMs) {
+    this->maxBatchPackets = qMax(1, maxBatchPackets);
+    this->flushIntervalMs = qMax(1, flushIntervalMs);
+    
+    if (capturing) {
+        for (PacketCaptureWorker *worker : activeWorkers()) {
+            QMetaObject::invokeMethod(worker, "setBatchThresholds",
+                                     Qt::QueuedConnection,
+                                     Q_ARG(int, this->maxBatchPackets),
+                                     Q_ARG(int, this->flushIntervalMs));
+            worker->wakeCaptureLoop();
+        }
+    }
+}
+
+PacketCaptureController::CaptureLoopMode PacketCaptureController::getCaptureLoopMode() const {
+    return captureLoopMode;
+}
+
+int PacketCaptureController::getMaxBatchPackets() const {
+    return maxBatchPackets;
+}
+
+int PacketCaptureController::getFlushIntervalMs() const {
+    return flushIntervalMs;
+}
+
+// Capture backend configuration methods
+void PacketCaptureController::setCaptureBackend(CaptureBackend backend) {
+    captureBackend = backend;
+}
+
+void PacketCaptureController::setTPacketRingConfig(int blockSize, int blockCount, int retireTimeoutMs) {
+    tpacketBlockSize = blockSize;
+    tpacketBlockCount = qMax(1, blockCount);
+    tpacketRetireTimeoutMs = qMax(1, retireTimeoutMs);
+}
+
+PacketCaptureController::CaptureBackend PacketCaptureController::getCaptureBackend() const {
+    return captureBackend;
+}
+
+int PacketCaptureController::getTPacketBlockSize() const {
+    return tpacketBlockSize;
+}
+
+int PacketCaptureController::getTPacketBlockCount() const {
+    return tpacketBlockCount;
+}
+
+int PacketCaptureController::getTPacketRetireTimeoutMs() const {
+    return tpacketRetireTimeoutMs;
+}
+
+// Fanout configuration methods
+void PacketCaptureController::setFanoutWorkers(int count) {
+    fanoutWorkers = qMax(0, count);
+}
+
+int PacketCaptureController::getFanoutWorkers() const {
+    return fanoutWorkers;
+}
+
+// Batch ring statistics
+int PacketCaptureController::getBatchRingOccupancy() const {
+    int occupancy = 0;
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        occupancy += worker->batchRing()->occupancy();
+    }
+    return occupancy;
+}
+
+int PacketCaptureController::getBatchRingCapacity() const {
+    int capacity = 0;
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        capacity += worker->batchRing()->capacity();
+    }
+    return capacity;
+}
+
+quint64 PacketCaptureController::getBatchRingOverflowEvents() const {
+    quint64 events = 0;
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        events += worker->batchRing()->overflowEvents();
+    }
+    return events;
+}
+
+quint64 PacketCaptureController::getBatchRingDroppedPackets() const {
+    quint64 dropped = retiredDropStats.ringOverflows;
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        dropped += worker->batchRing()->droppedPackets();
+    }
+    return dropped;
+}
+
+CaptureDropStats PacketCaptureController::getDropStatistics() const {
+    CaptureDropStats stats = retiredDropStats;
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        worker->addDropStatistics(stats);
+        stats.ringOverflows += worker->batchRing()->droppedPackets();
+    }
+    
+    QMutexLocker locker(&captureMutex);
+    stats.validationRejects = validationRejects;
+    if (diskWriter) {
+        stats.diskWriterDrops = diskWriter->droppedPackets();
+    }
+    return stats;
+}
+
+// Capture-to-disk configuration
+void PacketCaptureController::setDiskCapture(const DiskCaptureSettings &settings) {
+    QMutexLocker locker(&captureMutex);
+    diskCapture = settings;
+}
+
+DiskCaptureSettings PacketCaptureController::getDiskCapture() const {
+    QMutexLocker locker(&captureMutex);
+    return diskCapture;
+}
+
+QString PacketCaptureController::getDiskCaptureFile() const {
+    QMutexLocker locker(&captureMutex);
+    return diskWriter ? diskWriter->currentFile() : QString();
+}
+
+quint64 PacketCaptureController::getDiskPacketsWritten() const {
+    QMutexLocker locker(&captureMutex);
+    return diskWriter ? diskWriter->packetsWritten() : 0;
+}
+
+void PacketCaptureController::startDiskWriter() {
+    // Called with captureMutex held, after the workers are configured
+    delete diskWriter;
+    diskWriter = nullptr;
+    
+    if (diskCapture.enabled) {
+        CaptureDiskWriter *writer = new CaptureDiskWriter(this);
+        if (writer->start(diskCapture)) {
+            connect(writer, &CaptureDiskWriter::writeError, this, &PacketCaptureController::captureError);
+            diskWriter = writer;
+        } else {
+            QString errorMsg = QString("Cannot write capture file: %1").arg(writer->lastError());
+            LOG_CAPTURE_ERROR(errorMsg, diskCapture.path);
+            emit captureError(errorMsg);
+            delete writer;
+        }
+    }
+    
+    // Every worker gets a feed, or a null one to stop a previous capture's
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        QSharedPointer<DiskWriterFeed> feed;
+        if (diskWriter) {
+            feed = diskWriter->createFeed();
+        }
+        QMetaObject::invokeMethod(worker, "setDiskWriterFeed",
+                                 Qt::QueuedConnection,
+                                 Q_ARG(QSharedPointer<DiskWriterFeed>, feed));
+    }
+}
+
+// Packet slab configuration
+void PacketCaptureController::setPacketSlabHugePages(bool enabled) {
+    slabStore.setHugePagesEnabled(enabled);
+    
+    for (PacketCaptureWorker *worker : activeWorkers()) {
+        QMetaObject::invokeMethod(worker, "setPacketSlabHugePages",
+                                 Qt::QueuedConnection,
+                                 Q_ARG(bool, enabled));
+    }
+}
+
+bool PacketCaptureController::isPacketSlabHugePages() const {
+    return slabStore.hugePagesEnabled();
+}
+
+void PacketCaptureController::configureWorker(PacketCaptureWorker *worker, int fanoutIndex) {
+    // Set filter if specified
+    if (!currentFilter.isEmpty()) {
+        QMetaObject::invokeMethod(worker, "setFilter", 
+                                 Qt::QueuedConnection,
+                                 Q_ARG(QString, currentFilter));
+    }
+    
+    // Set spoofing targets if in spoofing mode
+    if (spoofingMode && !this->targetMACs.isEmpty()) {
+        worker->spoofingTargets = this->targetMACs;
+        worker->spoofingModeActive = true;
+    }
+    
+    // Configure ring buffer if enabled
+    if (ringBufferEnabled) {
+        QMetaObject::invokeMethod(worker, "setRingBufferEnabled", 
+                                 Qt::QueuedConnection,
+                                 Q_ARG(bool, ringBufferEnabled));
+        QMetaObject::invokeMethod(worker, "setRingBufferSize", 
+                                 Qt::QueuedConnection,
+                                 Q_ARG(int, ringBufferSize));
+    }
+    
+    // Configure packet sampling; fanout workers split the target rate
+    int workerCount = qMax(1, activeWorkers().size());
+    QMetaObject::invokeMethod(worker, "setSamplingMode", 
+                             Qt::QueuedConnection,
+                             Q_ARG(PacketCaptureWorker::SamplingMode, static_cast<PacketCaptureWorker::SamplingMode>(samplingMode)));
+    QMetaObject::invokeMethod(worker, "setSamplingRate", 
+                             Qt::QueuedConnection,
+                             Q_ARG(int, samplingRate));
+    QMetaObject::invokeMethod(worker, "setTargetRate", 
+                             Qt::QueuedConnection,
+                             Q_ARG(int, (targetRate + workerCount - 1) / workerCount));
+    
+    // Configure capture loop
+    QMetaObject::invokeMethod(worker, "setCaptureLoopMode",
+                             Qt::QueuedConnection,
+                             Q_ARG(PacketCaptureWorker::CaptureLoopMode, static_cast<PacketCaptureWorker::CaptureLoopMode>(captureLoopMode)));
+    QMetaObject::invokeMethod(worker, "setBatchThresholds",
+                             Qt::QueuedConnection,
+                             Q_ARG(int, maxBatchPackets),
+                             Q_ARG(int, flushIntervalMs));
+    
+    // Configure capture backend
+    QMetaObject::invokeMethod(worker, "setTPacketRingConfig",
+                             Qt::QueuedConnection,
+                             Q_ARG(int, tpacketBlockSize),
+                             Q_ARG(int, tpacketBlockCount),
+                             Q_ARG(int, tpacketRetireTimeoutMs));
+    QMetaObject::invokeMethod(worker, "setCaptureBackend",
+                             Qt::QueuedConnection,
+                             Q_ARG(PacketCaptureWorker::CaptureBackend, static_cast<PacketCaptureWorker::CaptureBackend>(captureBackend)));
+    QMetaObject::invokeMethod(worker, "setFanoutGroup",
+                             Qt::QueuedConnection,
+                             Q_ARG(int, fanoutIndex >= 0 ? fanoutGroupId : -1),
+                             Q_ARG(int, fanoutIndex));
+    QMetaObject::invokeMethod(worker, "setPacketSlabHugePages",
+                             Qt::QueuedConnection,
+                             Q_ARG(bool, slabStore.hugePagesEnabled()));
+}
+
+void PacketCaptureController::setupFanoutWorkers(int count) {
+    cleanupFanoutWorkers();
+    
+    for (int i = 0; i < count; ++i) {
+        QThread *thread = new QThread(this);
+        PacketCaptureWorker *worker = new PacketCaptureWorker(networkInterface);
+        worker->moveToThread(thread);
+        
+        // Fanout workers summarize on their own thread; only the primary
+        // worker reports finished so the capture status changes once
+        connectBatchRing(worker);
+        connect(worker, &PacketCaptureWorker::errorOccurred,
+                this, &PacketCaptureController::handleWorkerError,
+                Qt::QueuedConnection);
+        
+        thread->start();
+        
+        fanoutThreads.append(thread);
+        fanoutWorkerList.append(worker);
+    }
+    
+    qDebug() << "Started" << count << "additional fanout workers for interface:" << networkInterface;
+}
+
+void PacketCaptureController::cleanupFanoutWorkers() {
+    for (int i = 0; i < fanoutThreads.size(); ++i) {
+        PacketCaptureWorker *worker = fanoutWorkerList[i];
+        stopWorkerThread(fanoutThreads[i], worker);
+        
+        // Keep what this worker counted in the capture's totals
+        worker->closeCapture();
+        worker->addDropStatistics(retiredDropStats);
+        retiredDropStats.ringOverflows += worker->batchRing()->droppedPackets();
+        delete worker;
+        delete fanoutThreads[i];
+    }
+    
+    fanoutThreads.clear();
+    fanoutWorkerList.clear();
+}
+
+void PacketCaptureController::stopWorkerThread(QThread *thread, PacketCaptureWorker *worker) {
+    // The blocking capture loop does not return to the thread's event
+    // loop on its own, so interrupt it before asking the thread to quit
+    thread->requestInterruption();
+    if (worker) {
+        worker->wakeCaptureLoop();
+    }
+    thread->quit();
+    if (!thread->wait(5000)) {
+        qWarning() << "Capture thread did not finish within timeout, terminating";
+        thread->terminate();
+        thread->wait(1000);
+    }
+}
+
+QList<PacketCaptureWorker*> PacketCaptureController::activeWorkers() const {
+    QList<PacketCaptureWorker*> workers;
+    if (captureWorker) {
+        workers.append(captureWorker);
+    }
+    workers.append(fanoutWorkerList);
+    return workers;
+}
+
+int PacketCaptureController::resolveFanoutWorkerCount() const {
+    if (fanoutWorkers == 0) {
+        return qMax(1, QThread::idealThreadCount());
+    }
+    return qMax(1, fanoutWorkers);
+}
+
 void PacketCaptureController::setupWorker() {
     if (captureThread || captureWorker) {
         cleanupWorker();
@@ -244,9 +809,7 @@ void PacketCaptureController::setupWorker() {
     connect(captureWorker, &PacketCaptureWorker::packetReady,
             this, &PacketCaptureController::processCapturedPacket,
             Qt::QueuedConnection);
-    connect(captureWorker, &PacketCaptureWorker::packetsBatchReady,
-            this, &PacketCaptureController::processCapturedPacketBatch,
-            Qt::QueuedConnection);
+    connectBatchRing(captureWorker);
     connect(captureWorker, &PacketCaptureWorker::errorOccurred,
             this, &PacketCaptureController::handleWorkerError,
             Qt::QueuedConnection);
@@ -271,21 +834,18 @@ void PacketCaptureController::cleanupWorker() {
         stopCapture();
     }
     
+    cleanupFanoutWorkers();
+    
     if (captureThread) {
-        captureThread->quit();
-        if (!captureThread->wait(5000)) {
-            qWarning() << "Capture thread did not finish within timeout, terminating";
-            captureThread->terminate();
-            captureThread->wait(1000);
-        }
+        stopWorkerThread(captureThread, captureWorker);
         captureThread = nullptr;
     }
     
     captureWorker = nullptr; // Will be deleted by thread finished signal
 }
 
-bool PacketCaptureController::isTargetPacket(const QByteArray &packetData) const {
-    if (!spoofingMode || targetMACs.isEmpty() || packetData.size() < 14) {
+bool PacketCaptureController::isTargetPacket(const QByteArray &packetData, const QList<QString> &targetMACs) {
+    if (targetMACs.isEmpty() || packetData.size() < 14) {
         return true; // In normal mode, accept all packets
     }
     
@@ -321,35 +881,43 @@ bool PacketCaptureController::isTargetPacket(const QByteArray &packetData) const
     return false;
 }
 
-PacketInfo PacketCaptureController::createPacketInfo(const QByteArray &packetData, const struct timeval &timestamp) {
+PacketInfo PacketCaptureController::createPacketInfo(const PacketSlice &packetData, const struct timeval &timestamp) {
+    return createPacketInfo(packetData, qint64(timestamp.tv_sec) * NANOSECONDS_PER_SECOND +
+                                        qint64(timestamp.tv_usec) * 1000);
+}
+
+PacketInfo PacketCaptureController::createPacketInfo(const PacketSlice &packetData, qint64 timestampNs) {
+    PacketInfo packet = summarizePacket(packetData, timestampNs);
+    
+    // Set serial number - this will be overridden by PacketModel but needs to be valid for validation
+    packet.serialNumber = packetCount + 1;
+    
+    return packet;
+}
+
+PacketInfo PacketCaptureController::summarizePacket(const PacketSlice &packetData, qint64 timestampNs) {
     PacketInfo packet;
     
     // Set basic packet information
-    packet.timestamp = QDateTime::fromSecsSinceEpoch(timestamp.tv_sec, QTimeZone::UTC)
-                      .addMSecs(timestamp.tv_usec / 1000);
+    packet.timestampNs = timestampNs;
     packet.packetLength = packetData.size();
     packet.rawData = packetData;
     
-    // Set serial number - this will be overridden by PacketModel but needs to be valid for validation
-    packet.serialNumber = packetCount + 1;
-    
-    // Extract basic protocol information using wrapper (lightweight operations)
-    packet.sourceIP = ProtocolAnalysisWrapper::extractSourceIP(packetData);
-    packet.destinationIP = ProtocolAnalysisWrapper::extractDestinationIP(packetData);
-    packet.protocolType = ProtocolAnalysisWrapper::extractProtocolType(packetData);
+    // One walk over L2-L4; every column below is formatted from it
+    packet_summary_decode(reinterpret_cast<const uint8_t*>(packetData.data()),
+                          static_cast<size_t>(packetData.size()), &packet.summary);
     
-    // Generate more info for the packet
-    packet.moreInfo = PacketInfoGenerator::generateMoreInfo(
-        packet.protocolType,
-        packet.sourceIP,
-        packet.destinationIP,
-        packet.packetLength,
-        packet.rawData
-    );
+    // Services on unregistered ports are recognised from their payload;
+    // verdicts are shared with the other pool threads and the protocol tree
+    packet_summary_classify_flow(reinterpret_cast<const uint8_t*>(packetData.data()), &packet.summary,
+                                 app_flow_shared_cache());
+    packet.sourceIP = ProtocolAnalysisWrapper::summarySourceIP(packet.summary);
+    packet.destinationIP = ProtocolAnalysisWrapper::summaryDestinationIP(packet.summary);
+    packet.protocolType = ProtocolAnalysisWrapper::summaryProtocolType(packet.summary);
     
-    // PERFORMANCE IMPROVEMENT: Don't perform full protocol analysis immediately
-    // Analysis will be done lazily when packet is selected
-    // analysisResult is now initialized with default constructor
+    // More Info is generated by PacketModel from the stored frame, and only
+    // for rows that are shown. Full protocol analysis waits until the packet
+    // is selected (see SelectionDissector)
     
     return packet;
 }
@@ -361,12 +929,14 @@ void PacketCaptureController::processCapturedPacket(const QByteArray &packetData
     
     try {
         
-        PacketInfo packet = createPacketInfo(packetData, timestamp);
+        PacketInfo packet = createPacketInfo(slabStore.append(packetData.constData(), packetData.size()), timestamp);
         
         
         // Validate packet
         if (!DataValidator::isValidPacketInfo(packet)) {
             qWarning() << "Invalid packet data:" << DataValidator::getLastError();
+            QMutexLocker locker(&captureMutex);
+            validationRejects++;
             return;
         }
         
@@ -396,111 +966,345 @@ void PacketCaptureController::handleWorkerError(const QString &error) {
     emit captureStatusChanged(false);
 }
 
-void PacketCaptureController::processCapturedPacketBatch(const QList<QPair<QByteArray, struct timeval>> &packets) {
-    if (!capturing || packets.isEmpty()) {
+void PacketCaptureController::connectBatchRing(PacketCaptureWorker *worker) {
+    // The lambda holds its own reference so a late notification from a
+    // worker that is being torn down never touches a freed ring
+    QSharedPointer<PacketBatchRing> ring = worker->batchRing();
+    connect(worker, &PacketCaptureWorker::batchesAvailable,
+            this, [this, ring]() { drainBatchRing(ring); },
+            Qt::QueuedConnection);
+}
+
+void PacketCaptureController::drainBatchRing(const QSharedPointer<PacketBatchRing> &ring) {
+    SummarizePipeline &pipeline = summarizePipelines[ring.data()];
+    pipeline.ring = ring;
+    
+    QList<QString> filterMACs = spoofingMode ? targetMACs : QList<QString>();
+    bool hugePages = slabStore.hugePagesEnabled();
+    
+    do {
+        // Every committed slot goes to the pool at once; the ring gets it
+        // back in onBatchSummarized
+        PacketBatchSlot *slot;
+        while ((slot = ring->peekRead(pipeline.dispatched)) != nullptr) {
+            summarizePool.start(new SummarizeBatchTask(this, ring, slot, summarizeGeneration,
+                                                       pipeline.nextSequence++, hugePages, filterMACs));
+            pipeline.dispatched++;
+        }
+    } while (ring->finishDrain(pipeline.dispatched));
+}
+
+void PacketCaptureController::onBatchSummarized(QSharedPointer<PacketBatchRing> ring, quint64 generation, quint64 sequence,
+                                                const QList<PacketInfo> &packets, const QList<PacketInfo> &summaries,
+                                                int rejected) {
+    // Slots of a previous capture were released by resetSummarizePipelines()
+    auto it = summarizePipelines.find(ring.data());
+    if (generation != summarizeGeneration || it == summarizePipelines.end()) {
         return;
     }
     
-    try {
-        QList<PacketInfo> processedPackets;
+    SummarizePipeline &pipeline = it.value();
+    SummarizedBatch &batch = pipeline.finished[sequence];
+    batch.packets = packets;
+    batch.summaries = summaries;
+    batch.rejected = rejected;
+    
+    // Deliver and release strictly in ring order
+    while (!pipeline.finished.isEmpty() && pipeline.finished.firstKey() == pipeline.nextRelease) {
+        SummarizedBatch ready = pipeline.finished.take(pipeline.nextRelease++);
         
-        for (const auto &packetPair : packets) {
-            // In spoofing mode, filter packets to only include target devices
-            if (spoofingMode && !isTargetPacket(packetPair.first)) {
-                continue;
-            }
-            
-            PacketInfo packet = createPacketInfo(packetPair.first, packetPair.second);
-            
-            // Validate packet
-            if (DataValidator::isValidPacketInfo(packet)) {
-                processedPackets.append(packet);
-                
-                // Update statistics
-                {
-                    QMutexLocker locker(&captureMutex);
-                    packetCount++;
-                    totalBytes += packet.packetLength;
-                }
-            }
-        }
+        ring->beginRead()->reset();
+        ring->endRead();
+        pipeline.dispatched--;
         
-        // Emit batch of processed packets
-        if (!processedPackets.isEmpty()) {
-            emit packetsBatchCaptured(processedPackets);
-            
-            // Update sampled packet count
-            {
-                QMutexLocker locker(&captureMutex);
-                sampledPacketCount += processedPackets.size();
-            }
+        // Owed before delivery: the consumer may acknowledge from inside the emit.
+        // The generation check above already dropped batches of an earlier
+        // capture; the tail of this one arrives after capturing clears
+        creditsOwed.append(ring);
+        countDeliveredPackets(ready.packets, ready.rejected);
+        emitProcessedPackets(ready.packets);
+        if (!ready.summaries.isEmpty()) {
+            processSummarizedPackets(ready.summaries);
         }
         
-    } catch (const std::exception &e) {
-        qWarning() << "Error processing packet batch:" << e.what();
+        // Nothing of it is waiting downstream, so nobody else will
+        // acknowledge it
+        if (!awaitingConsumer && mergedPackets.isEmpty()) {
+            returnOwedCredits();
+        }
     }
+    
+    // Pick up slots committed while the pool was busy
+    drainBatchRing(ring);
 }
 
-void PacketCaptureController::handleWorkerFinished() {
-    qDebug() << "Capture worker finished";
+void PacketCaptureController::drainSummarizePipelines() {
+    // The fanout workers are gone by now; their rings live on in the pipelines
+    QList<QSharedPointer<PacketBatchRing>> rings;
+    if (captureWorker) {
+        rings.append(captureWorker->batchRing());
+    }
+    for (const SummarizePipeline &pipeline : summarizePipelines) {
+        if (!rings.contains(pipeline.ring)) {
+            rings.append(pipeline.ring);
+        }
+    }
+    for (const QSharedPointer<PacketBatchRing> &ring : rings) {
+        drainBatchRing(ring);
+    }
     
-    {
-        QMutexLocker locker(&captureMutex);
-        capturing = false;
+    // Results come back as queued calls, and each may dispatch the next slots
+    auto inFlight = [this]() {
+        for (const SummarizePipeline &pipeline : summarizePipelines) {
+            if (pipeline.dispatched > 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    while (inFlight()) {
+        summarizePool.waitForDone();
+        QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
     }
     
-    emit captureStatusChanged(false);
+    flushMergedPackets();
 }
 
-void PacketCaptureController::onMemoryLimitExceeded() {
-    // Apply backpressure when memory limits are exceeded
-    if (!backpressureActive) {
-        backpressureActive = true;
-        backpressureDelayMs = 100; // Start with 100ms delay
-        
-        if (captureWorker) {
-            QMetaObject::invokeMethod(captureWorker, "setBackpressureDelay",
-                                     Qt::QueuedConnection,
-                                     Q_ARG(int, backpressureDelayMs));
+void PacketCaptureController::resetSummarizePipelines() {
+    // Results still queued from the last capture are ignored; their slots
+    // go back to the rings here
+    summarizePool.waitForDone();
+    for (SummarizePipeline &pipeline : summarizePipelines) {
+        for (; pipeline.dispatched > 0; pipeline.dispatched--) {
+            pipeline.ring->beginRead()->reset();
+            pipeline.ring->endRead();
+        }
+    }
+    summarizePipelines.clear();
+    summarizeGeneration++;
+}
+
+void PacketCaptureController::countDeliveredPackets(QList<PacketInfo> &packets, int rejected) {
+    QMutexLocker locker(&captureMutex);
+    validationRejects += rejected;
+    for (PacketInfo &packet : packets) {
+        packet.serialNumber = ++packetCount;
+        totalBytes += packet.packetLength;
+    }
+}
+
+void PacketCaptureController::grantBatchCredits() {
+    awaitingConsumer = false;
+    returnOwedCredits();
+}
+
+void PacketCaptureController::returnOwedCredits() {
+    if (creditsOwed.isEmpty()) {
+        return;
+    }
+    
+    // Under backpressure credits trickle back, so workers stay degraded
+    if (backpressureActive) {
+        if (!creditReturnScheduled) {
+            creditReturnScheduled = true;
+            QTimer::singleShot(backpressureDelayMs, this, [this]() {
+                creditReturnScheduled = false;
+                
+                // One credit per ring per tick: every fanout ring is paced
+                // at the full rate, not a share of it
+                QList<PacketBatchRing*> granted;
+                for (auto it = creditsOwed.begin(); it != creditsOwed.end();) {
+                    if (granted.contains(it->data())) {
+                        ++it;
+                        continue;
+                    }
+                    granted.append(it->data());
+                    (*it)->grantCredits(1);
+                    it = creditsOwed.erase(it);
+                }
+                returnOwedCredits();
+            });
+        }
+        return;
+    }
+    
+    for (const QSharedPointer<PacketBatchRing> &ring : creditsOwed) {
+        ring->grantCredits(1);
+    }
+    creditsOwed.clear();
+}
+
+void PacketCaptureController::processSummarizedPackets(const QList<PacketInfo> &packets) {
+    // Filtered and validated on the pool already
+    QList<PacketInfo> accepted = packets;
+    countDeliveredPackets(accepted, 0);
+    mergedPackets.append(accepted);
+    
+    // Merge per-worker batches into one model update per flush window
+    if (mergedPackets.size() >= maxBatchPackets) {
+        flushMergedPackets();
+    } else if (!mergedPackets.isEmpty() && !mergeTimer->isActive()) {
+        mergeTimer->start(flushIntervalMs);
+    }
+}
+
+void PacketCaptureController::flushMergedPackets() {
+    mergeTimer->stop();
+    
+    if (mergedPackets.isEmpty()) {
+        return;
+    }
+    
+    // Each worker delivers in order, but the workers interleave; restore
+    // capture order across them before the rows reach the model
+    std::stable_sort(mergedPackets.begin(), mergedPackets.end(),
+                     [](const PacketInfo &a, const PacketInfo &b) { return a.timestampNs < b.timestampNs; });
+    
+    QList<PacketInfo> merged;
+    merged.swap(mergedPackets);
+    emitProcessedPackets(merged);
+}
+
+void PacketCaptureController::emitProcessedPackets(const QList<PacketInfo> &processedPackets) {
+    // Emit batch of processed packets
+    if (!processedPackets.isEmpty()) {
+        awaitingConsumer = true;
+        emit packetsBatchCaptured(processedPackets);
+        
+        // Update sampled packet count
+        {
+            QMutexLocker locker(&captureMutex);
+            sampledPacketCount += processedPackets.size();
         }
+    }
+}
+
+void PacketCaptureController::handleWorkerFinished() {
+    qDebug() << "Capture worker finished";
+    
+    {
+        QMutexLocker locker(&captureMutex);
+        capturing = false;
+    }
+    
+    emit captureStatusChanged(false);
+}
+
+void PacketCaptureController::onMemoryLimitExceeded() {
+    // Apply backpressure when memory limits are exceeded; credits returned
+    // from now on are paced, so the workers degrade instead of stalling
+    if (!backpressureActive) {
+        backpressureActive = true;
+        backpressureDelayMs = 100; // Start with 100ms delay
         
         emit backpressureApplied();
     } else {
         // Increase backpressure if already active
         backpressureDelayMs = qMin(backpressureDelayMs * 2, 1000); // Max 1 second delay
-        
-        if (captureWorker) {
-            QMetaObject::invokeMethod(captureWorker, "setBackpressureDelay",
-                                     Qt::QueuedConnection,
-                                     Q_ARG(int, backpressureDelayMs));
-        }
     }
 }
 
+void PacketCaptureController::onMemoryPressureRelieved() {
+    if (!backpressureActive) {
+        return;
+    }
+    backpressureActive = false;
+    backpressureDelayMs = 0;
+    
+    // Credits held back by the pacing go out now, unless a batch is still
+    // on its way to the consumer, which will acknowledge it
+    if (!awaitingConsumer) {
+        returnOwedCredits();
+    }
+    emit backpressureReleased();
+}
+
 // PacketCaptureWorker implementation
 PacketCaptureWorker::PacketCaptureWorker(const QString &interface)
     : QObject(nullptr) // No parent - will be moved to thread
     , interface(interface)
     , pcapHandle(nullptr)
+    , pcapTimestampUnitNs(1000)
     , shouldStop(false)
     , spoofingModeActive(false)
     , processTimer(new QTimer(this))
-    , backpressureDelayMs(0)
     , samplingMode(NoSampling)
     , samplingRate(100)
     , targetRate(1000)
     , packetCounter(0)
-    , lastSampleTime(0)
+    , bucketTokens(0)
+    , bucketRefillNs(0)
+    , reservoirUsed(0)
+    , reservoirSeen(0)
+    , reservoirWindowStartNs(0)
+    , samplingRandom(QRandomGenerator::global()->generate())
+    , captureLoopMode(BlockingLoop)
+    , maxBatchPackets(512)
+    , flushIntervalMs(20)
+    , wakeEventFd(-1)
+    , loopRunning(false)
+    , lastFlushTime(0)
+    , ring(new PacketBatchRing())
+    , writeSlot(nullptr)
+    , batchPolicy(FullBatch)
+    , batchRingFull(false)
+    , captureBackend(PcapBackend)
+    , tpacketBlockSize(TPACKET_RING_DEFAULT_BLOCK_SIZE)
+    , tpacketBlockCount(TPACKET_RING_DEFAULT_BLOCK_COUNT)
+    , tpacketRetireTimeoutMs(TPACKET_RING_DEFAULT_RETIRE_TIMEOUT_MS)
+    , fanoutGroupId(-1)
+    , fanoutWorkerIndex(-1)
+    , kernelReceivedCount(0)
+    , kernelDropCount(0)
+    , interfaceDropCount(0)
+    , samplingSeenCount(0)
+    , samplingDiscardCount(0)
+    , overloadSummaryOnlyCount(0)
+    , overloadSampledCount(0)
+    , overloadSpilledCount(0)
+    , overloadDroppedCount(0)
+    , lastKernelStatsTime(0)
 {
     // Initialize error buffer
     memset(errorBuffer, 0, sizeof(errorBuffer));
+    memset(&lastPcapStats, 0, sizeof(lastPcapStats));
     
     // Setup packet processing timer
     connect(processTimer, &QTimer::timeout, this, &PacketCaptureWorker::processPackets);
+    
+    // Wake-up channel for the blocking capture loop
+    wakeEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeEventFd == -1) {
+        qWarning() << "Failed to create capture wake eventfd:" << strerror(errno)
+                   << "- falling back to timer polling";
+        captureLoopMode = TimerPollingLoop;
+    }
 }
 
 PacketCaptureWorker::~PacketCaptureWorker() {
+    if (diskFeed) {
+        diskFeed->close();
+    }
     cleanupPcap();
+    if (wakeEventFd != -1) {
+        close(wakeEventFd);
+        wakeEventFd = -1;
+    }
+}
+
+void PacketCaptureWorker::wakeCaptureLoop() {
+    if (wakeEventFd == -1) {
+        return;
+    }
+    
+    uint64_t one = 1;
+    if (write(wakeEventFd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+        qWarning() << "Failed to wake capture loop:" << strerror(errno);
+    }
+}
+
+QSharedPointer<PacketBatchRing> PacketCaptureWorker::batchRing() const {
+    return ring;
 }
 
 void PacketCaptureWorker::initialize() {
@@ -518,7 +1322,7 @@ void PacketCaptureWorker::initialize() {
 void PacketCaptureWorker::startCapture() {
     try {
         
-        if (!pcapHandle) {
+        if (!isCaptureOpen()) {
             if (!initializePcap()) {
                 QString errorMsg = QString("Failed to initialize pcap: %1").arg(errorBuffer);
                 printf("[ERROR] %s\n", errorMsg.toUtf8().constData());
@@ -527,12 +1331,28 @@ void PacketCaptureWorker::startCapture() {
                 emit errorOccurred(errorMsg);
                 return;
             }
+            
+            if (!packetFilter.isEmpty() && !applyFilter(packetFilter)) {
+                emit errorOccurred(QString("Failed to apply filter: %1").arg(packetFilter));
+            }
         }
         
         shouldStop = false;
+        ring->resetCounters();
+        ring->resetCredits();
+        resetDropCounters();
+        pinToFanoutCore();
     
-        // Start packet processing timer - increased interval for better performance
-        processTimer->start(200); // Process packets every 200ms for high-speed capture
+        if (captureLoopMode == BlockingLoop && wakeEventFd != -1) {
+            // Run the loop from the event queue so that configuration calls
+            // queued before startCapture are applied first
+            if (!loopRunning) {
+                QMetaObject::invokeMethod(this, "runCaptureLoop", Qt::QueuedConnection);
+            }
+        } else {
+            // Start packet processing timer - increased interval for better performance
+            processTimer->start(200); // Process packets every 200ms for high-speed capture
+        }
         
         LOG_INFO("Started packet capture worker");
         
@@ -551,11 +1371,27 @@ void PacketCaptureWorker::stopCapture() {
     shouldStop = true;
     processTimer->stop();
     
+    // Hand out the sample of the window that was still open
+    flushReservoir();
+    flushPendingBatch();
+    
+    if (diskFeed) {
+        diskFeed->close();
+        diskFeed.reset();
+    }
+    
     qDebug() << "Stopped packet capture worker";
     emit finished();
 }
 
 void PacketCaptureWorker::setFilter(const QString &filter) {
+    packetFilter = filter;
+    
+    // Applied by startCapture once the capture source is (re)opened
+    if (!isCaptureOpen()) {
+        return;
+    }
+    
     if (!applyFilter(filter)) {
         emit errorOccurred(QString("Failed to apply filter: %1").arg(filter));
     } else {
@@ -563,90 +1399,567 @@ void PacketCaptureWorker::setFilter(const QString &filter) {
     }
 }
 
-void PacketCaptureWorker::setBackpressureDelay(int delayMs) {
-    backpressureDelayMs = delayMs;
-}
-
 void PacketCaptureWorker::setSamplingMode(SamplingMode mode) {
+    if (samplingMode == ReservoirSampling && mode != ReservoirSampling) {
+        flushReservoir();
+    }
     samplingMode = mode;
+    packetCounter = 0;
+    bucketRefillNs = 0;
 }
 
 void PacketCaptureWorker::setSamplingRate(int rate) {
-    samplingRate = rate;
+    samplingRate = qMax(1, rate);
 }
 
 void PacketCaptureWorker::setTargetRate(int packetsPerSecond) {
-    targetRate = packetsPerSecond;
+    targetRate = qMax(1, packetsPerSecond);
+    bucketRefillNs = 0;
 }
 
-void PacketCaptureWorker::processPackets() {
-    if (!pcapHandle || shouldStop) {
+void PacketCaptureWorker::setCaptureLoopMode(CaptureLoopMode mode) {
+    if (mode == BlockingLoop && wakeEventFd == -1) {
+        qWarning() << "Blocking capture loop unavailable, keeping timer polling";
+        return;
+    }
+    captureLoopMode = mode;
+}
+
+void PacketCaptureWorker::setBatchThresholds(int maxBatchPackets, int flushIntervalMs) {
+    this->maxBatchPackets = qMax(1, maxBatchPackets);
+    this->flushIntervalMs = qMax(1, flushIntervalMs);
+}
+
+void PacketCaptureWorker::setCaptureBackend(CaptureBackend backend) {
+    if (backend == captureBackend) {
         return;
     }
     
-    // Apply backpressure delay if active
-    if (backpressureDelayMs > 0) {
-        // Sleep for the backpressure delay
-        QThread::msleep(backpressureDelayMs);
+    // The handle opened by initialize() belongs to the old backend;
+    // startCapture reopens with the new one
+    cleanupPcap();
+    captureBackend = backend;
+}
+
+void PacketCaptureWorker::setTPacketRingConfig(int blockSize, int blockCount, int retireTimeoutMs) {
+    if (blockSize == tpacketBlockSize && blockCount == tpacketBlockCount &&
+        retireTimeoutMs == tpacketRetireTimeoutMs) {
+        return;
     }
     
-    // Get current time for rate-based sampling
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+    tpacketBlockSize = blockSize;
+    tpacketBlockCount = blockCount;
+    tpacketRetireTimeoutMs = retireTimeoutMs;
     
-    // Process up to 500 packets per timer tick for better batching
-    QList<QPair<QByteArray, struct timeval>> batchedPackets;
+    // Ring geometry is fixed once mapped, so rebuild it on the next start
+    if (tpacketRing) {
+        cleanupPcap();
+    }
+}
+
+void PacketCaptureWorker::setFanoutGroup(int groupId, int workerIndex) {
+    fanoutWorkerIndex = workerIndex;
     
-    for (int i = 0; i < 500 && !shouldStop; ++i) {
-        struct pcap_pkthdr *header;
-        const u_char *packetData;
+    if (groupId == fanoutGroupId) {
+        return;
+    }
+    
+    // Group membership cannot be changed on an open socket
+    fanoutGroupId = groupId;
+    if (tpacketRing) {
+        cleanupPcap();
+    }
+}
+
+void PacketCaptureWorker::setPacketSlabHugePages(bool enabled) {
+    slabStore.setHugePagesEnabled(enabled);
+}
+
+void PacketCaptureWorker::setDiskWriterFeed(QSharedPointer<DiskWriterFeed> feed) {
+    if (diskFeed && diskFeed != feed) {
+        diskFeed->close();
+    }
+    diskFeed = feed;
+}
+
+void PacketCaptureWorker::pinToFanoutCore() {
+    int cores = QThread::idealThreadCount();
+    if (fanoutWorkerIndex < 0 || cores <= 1) {
+        return;
+    }
+    
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(fanoutWorkerIndex % cores, &cpuSet);
+    
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0) {
+        qWarning() << "Failed to pin fanout worker" << fanoutWorkerIndex << ":" << strerror(result);
+    }
+}
+
+bool PacketCaptureWorker::shouldSamplePacket(const char *packet, int length, qint64 timestampNs) {
+    // Single writer; a plain store avoids a locked add per packet
+    samplingSeenCount.store(samplingSeenCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    
+    bool sampled = true;
+    
+    switch (samplingMode) {
+    case CountBasedSampling:
+        // Sample every Nth packet
+        packetCounter++;
+        sampled = (packetCounter % samplingRate == 0);
+        break;
         
-        int result = pcap_next_ex(pcapHandle, &header, &packetData);
+    case RateBasedSampling:
+        sampled = takeSamplingToken(timestampNs);
+        break;
         
-        if (result == 1) {
-            // Check if we should sample this packet
-            bool shouldSample = true;
+    case FlowHashSampling:
+        // Multiply-shift maps the hash onto [0, samplingRate); bucket 0 is kept
+        sampled = ((quint64(packetFlowHash(reinterpret_cast<const uchar*>(packet), length)) *
+                    quint64(samplingRate)) >> 32) == 0;
+        break;
+        
+    case ReservoirSampling:
+        // Kept or discarded when the window closes
+        offerToReservoir(packet, length, timestampNs);
+        return false;
+        
+    case NoSampling:
+    default:
+        // Sample all packets
+        break;
+    }
+    
+    if (!sampled) {
+        samplingDiscardCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    return sampled;
+}
+
+bool PacketCaptureWorker::takeSamplingToken(qint64 timestampNs) {
+    // Each nanosecond adds targetRate billionths of a token and a packet
+    // costs a whole one. The bucket holds TOKEN_BUCKET_BURST_NS worth, but
+    // never less than one token, so a span of T seconds passes at most
+    // targetRate * T packets plus one bucketful: 1.1x targetRate over a
+    // second, or targetRate + 1 below 10 packets per second.
+    const qint64 capacity = qMax<qint64>(NANOSECONDS_PER_SECOND, qint64(targetRate) * TOKEN_BUCKET_BURST_NS);
+    qint64 elapsed = timestampNs - bucketRefillNs;
+    
+    if (bucketRefillNs == 0) {
+        bucketTokens = capacity;
+        bucketRefillNs = timestampNs;
+    } else if (elapsed > 0) {
+        // A gap long enough to fill the bucket is clamped before the
+        // multiply, which would overflow after a few hours of silence
+        const qint64 fillNs = (capacity - bucketTokens) / targetRate + 1;
+        bucketTokens = elapsed >= fillNs ? capacity : qMin(capacity, bucketTokens + elapsed * targetRate);
+        bucketRefillNs = timestampNs;
+    }
+    
+    if (bucketTokens < NANOSECONDS_PER_SECOND) {
+        return false;
+    }
+    bucketTokens -= NANOSECONDS_PER_SECOND;
+    return true;
+}
+
+void PacketCaptureWorker::offerToReservoir(const char *packet, int length, qint64 timestampNs) {
+    if (reservoirSeen > 0 && timestampNs - reservoirWindowStartNs >= RESERVOIR_WINDOW_NS) {
+        flushReservoir();
+    }
+    if (reservoirSeen == 0) {
+        reservoirWindowStartNs = timestampNs;
+    }
+    
+    // Algorithm R: the n-th packet replaces a random entry with probability k/n
+    reservoirSeen++;
+    int slot;
+    if (reservoirUsed < targetRate) {
+        slot = reservoirUsed++;
+        if (reservoir.size() < reservoirUsed) {
+            reservoir.resize(reservoirUsed);
+        }
+    } else {
+        quint64 pick = samplingRandom.bounded(reservoirSeen);
+        if (pick >= quint64(targetRate)) {
+            return;
+        }
+        slot = int(pick);
+    }
+    
+    ReservoirEntry &entry = reservoir[slot];
+    entry.data.resize(length);
+    memcpy(entry.data.data(), packet, length);
+    entry.timestampNs = timestampNs;
+    entry.sequence = reservoirSeen;
+}
+
+void PacketCaptureWorker::flushReservoir() {
+    if (reservoirSeen == 0) {
+        return;
+    }
+    
+    samplingDiscardCount.fetch_add(reservoirSeen - quint64(reservoirUsed), std::memory_order_relaxed);
+    
+    // Replacement scrambles the order; hand the sample out in capture order
+    std::sort(reservoir.begin(), reservoir.begin() + reservoirUsed,
+              [](const ReservoirEntry &a, const ReservoirEntry &b) { return a.sequence < b.sequence; });
+    
+    for (int i = 0; i < reservoirUsed; ++i) {
+        const ReservoirEntry &entry = reservoir.at(i);
+        deliverPacket(entry.data.constData(), entry.data.size(), entry.timestampNs);
+    }
+    
+    reservoirUsed = 0;
+    reservoirSeen = 0;
+}
+
+void PacketCaptureWorker::packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet) {
+    PacketCaptureWorker *worker = reinterpret_cast<PacketCaptureWorker*>(userData);
+    
+    // The disk copy is taken ahead of sampling and the batch ring
+    if (worker->diskFeed) {
+        worker->diskFeed->appendPacket(reinterpret_cast<const char*>(packet), pkthdr->caplen, pkthdr->len,
+                                       worker->pcapTimestampNs(pkthdr->ts));
+    }
+    
+    if (!worker->shouldSamplePacket(reinterpret_cast<const char*>(packet), pkthdr->caplen,
+                                    worker->pcapTimestampNs(pkthdr->ts))) {
+        return;
+    }
+    
+    worker->deliverPacket(reinterpret_cast<const char*>(packet), pkthdr->caplen, worker->pcapTimestampNs(pkthdr->ts));
+}
+
+PacketBatchSlot *PacketCaptureWorker::acquireWriteSlot() {
+    // The policy holds for the whole batch; out of credits no batch is
+    // opened and the decision is retaken for every packet
+    if (!writeSlot) {
+        batchPolicy = chooseBatchPolicy();
+        if (batchPolicy != SpillBatch) {
+            writeSlot = ring->beginWrite();
+        }
+    }
+    return writeSlot;
+}
+
+PacketCaptureWorker::BatchPolicy PacketCaptureWorker::chooseBatchPolicy() const {
+    int credits = ring->availableCredits();
+    int window = ring->capacity();
+    
+    if (credits <= 0) {
+        return SpillBatch;
+    }
+    if (credits > window / 2) {
+        return FullBatch;
+    }
+    if (credits > window / 4) {
+        return SummaryOnlyBatch;
+    }
+    return SampledBatch;
+}
+
+void PacketCaptureWorker::deliverPacket(const char *packet, int length, qint64 timestampNs) {
+    PacketBatchSlot *slot = acquireWriteSlot();
+    if (!slot && batchPolicy != SpillBatch) {
+        // Credits normally keep the ring from filling; count the stall once
+        // and every packet it costs
+        if (!batchRingFull) {
+            batchRingFull = true;
+            ring->noteOverflow(1);
+        } else {
+            ring->noteDropped(1);
+        }
+        return;
+    }
+    if (slot) {
+        batchRingFull = false;
+    }
+    
+    if (routeBatchPacket(slot, packet, length, timestampNs)) {
+        slot->appendPacket(packet, length, timestampNs);
+    }
+}
+
+bool PacketCaptureWorker::routeBatchPacket(PacketBatchSlot *slot, const char *packet, int length, qint64 timestampNs) {
+    switch (batchPolicy) {
+    case FullBatch:
+        return true;
+        
+    case SampledBatch:
+        if (((quint64(packetFlowHash(reinterpret_cast<const uchar*>(packet), length)) *
+              OVERLOAD_SAMPLE_FLOWS) >> 32) != 0) {
+            overloadSampledCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Q_FALLTHROUGH();
+        
+    case SummaryOnlyBatch: {
+        if (spoofingModeActive && !isPacketFromTarget(QByteArray::fromRawData(packet, length))) {
+            return false;
+        }
+        
+        // Summarized straight from the capture buffer; no payload is kept
+        PacketInfo summary = PacketCaptureController::summarizePacket(
+            PacketSlice(PacketSlab::wrap(packet, length, QSharedPointer<const void>()), 0, length), timestampNs);
+        
+        // Nothing to generate it from later, so the model keeps this text
+        summary.moreInfo = PacketInfoGenerator::generateMoreInfo(
+            summary.protocolType, summary.sourceIP, summary.destinationIP, summary.packetLength,
+            QByteArray::fromRawData(packet, length), summary.summary);
+        summary.rawData = PacketSlice();
+        slot->summaries.append(summary);
+        overloadSummaryOnlyCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+        
+    case SpillBatch:
+        // Every packet was already handed to the disk writer ahead of sampling
+        (diskFeed ? overloadSpilledCount : overloadDroppedCount).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return false;
+}
+
+void PacketCaptureWorker::flushPendingBatch() {
+    lastFlushTime = QDateTime::currentMSecsSinceEpoch();
+    refreshKernelStats();
+    
+    // A quiet link still closes the reservoir window on time
+    if (reservoirSeen > 0 &&
+        lastFlushTime * 1000000 - reservoirWindowStartNs >= RESERVOIR_WINDOW_NS) {
+        flushReservoir();
+    }
+    
+    if (diskFeed) {
+        diskFeed->flush();
+    }
+    
+    if (!writeSlot || writeSlot->isEmpty()) {
+        return;
+    }
+    
+    writeSlot = nullptr;
+    ring->spendCredit();
+    if (ring->commitWrite()) {
+        emit batchesAvailable();
+    }
+}
+
+void PacketCaptureWorker::runCaptureLoop() {
+    if (loopRunning || !isCaptureOpen() || shouldStop) {
+        return;
+    }
+    
+    int pcapFd = captureFd();
+    if (pcapFd == -1) {
+        qWarning() << "Interface" << interface << "has no selectable fd, falling back to timer polling";
+        processTimer->start(200);
+        return;
+    }
+    
+    loopRunning = true;
+    lastFlushTime = QDateTime::currentMSecsSinceEpoch();
+    
+    // Set while the ring is readable but its next block is still held by the
+    // controller; the socket stays readable until the block is released
+    bool ringStalled = false;
+    
+    struct pollfd pollFds[2];
+    pollFds[0].fd = pcapFd;
+    pollFds[0].events = POLLIN;
+    pollFds[1].fd = wakeEventFd;
+    pollFds[1].events = POLLIN;
+    
+    qDebug() << "Entering blocking capture loop - batch:" << maxBatchPackets
+             << "packets, flush:" << flushIntervalMs << "ms";
+    
+    while (!shouldStop && isCaptureOpen() && !QThread::currentThread()->isInterruptionRequested()) {
+        // Sleep until packets arrive, a command is queued, or the pending
+        // batch is due for its time-based flush
+        int timeoutMs = flushIntervalMs;
+        int pendingPackets = writeSlot ? writeSlot->packetCount() : 0;
+        if (pendingPackets > 0) {
+            qint64 sinceFlush = QDateTime::currentMSecsSinceEpoch() - lastFlushTime;
+            timeoutMs = static_cast<int>(qMax<qint64>(0, flushIntervalMs - sinceFlush));
+        }
+        
+        pollFds[0].revents = 0;
+        pollFds[1].revents = 0;
+        int ready;
+        if (ringStalled) {
+            ready = poll(&pollFds[1], 1, qMin(timeoutMs, 1));
+            ringStalled = false;
+        } else {
+            ready = poll(pollFds, 2, timeoutMs);
+        }
+        
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            emit errorOccurred(QString("Capture poll failed: %1").arg(strerror(errno)));
+            shouldStop = true;
+            break;
+        }
+        
+        if (pollFds[1].revents & POLLIN) {
+            uint64_t wakeCount = 0;
+            if (read(wakeEventFd, &wakeCount, sizeof(wakeCount)) == -1 && errno != EAGAIN) {
+                qWarning() << "Failed to drain capture wake eventfd:" << strerror(errno);
+            }
             
-            switch (samplingMode) {
-            case CountBasedSampling:
-                // Sample every Nth packet
-                packetCounter++;
-                shouldSample = (packetCounter % samplingRate == 0);
+            // Deliver queued stop/filter/configuration calls on this thread
+            QCoreApplication::processEvents();
+            if (shouldStop || !isCaptureOpen()) {
                 break;
-                
-            case RateBasedSampling: {
-                // Sample to maintain target rate
-                packetCounter++;
-                
-                // Calculate current rate
-                if (lastSampleTime == 0) {
-                    lastSampleTime = currentTime;
-                }
-                
-                qint64 timeElapsed = currentTime - lastSampleTime;
-                if (timeElapsed > 0) {
-                    int currentRate = (packetCounter * 1000) / timeElapsed;
-                    shouldSample = (currentRate <= targetRate);
-                    
-                    // Reset counter periodically
-                    if (timeElapsed > 1000) {
-                        packetCounter = 0;
-                        lastSampleTime = currentTime;
-                    }
-                }
+            }
+        }
+        
+        if (tpacketRing) {
+            if (pollFds[0].revents & (POLLERR | POLLNVAL)) {
+                emit errorOccurred(QString("Capture socket error on interface %1").arg(interface));
+                shouldStop = true;
                 break;
             }
-                
-            case NoSampling:
-            default:
-                // Sample all packets
-                shouldSample = true;
+            if (pollFds[0].revents & POLLIN) {
+                ringStalled = !drainTPacketRing();
+            }
+        } else if (pollFds[0].revents & (POLLIN | POLLERR)) {
+            int room = qMax(1, maxBatchPackets - pendingPackets);
+            int result = pcap_dispatch(pcapHandle, room, &PacketCaptureWorker::packetHandler,
+                                       reinterpret_cast<u_char*>(this));
+            
+            if (result == PCAP_ERROR) {
+                emit errorOccurred(QString("Packet capture error: %1").arg(pcap_geterr(pcapHandle)));
+                shouldStop = true;
                 break;
             }
+        }
+        
+        pendingPackets = writeSlot ? writeSlot->packetCount() : 0;
+        if (pendingPackets >= maxBatchPackets ||
+            QDateTime::currentMSecsSinceEpoch() - lastFlushTime >= flushIntervalMs) {
+            flushPendingBatch();
+        }
+    }
+    
+    flushPendingBatch();
+    loopRunning = false;
+    
+    qDebug() << "Left blocking capture loop for interface:" << interface;
+}
+
+bool PacketCaptureWorker::drainTPacketRing() {
+    bool handedOut = false;
+    
+    while (!shouldStop) {
+        // Only a full batch ring leaves retired blocks with the kernel; out
+        // of credits the blocks are consumed and their packets spilled
+        PacketBatchSlot *slot = acquireWriteSlot();
+        if (!slot && batchPolicy != SpillBatch) {
+            // Polled again on every pass while stalled; one stall is one overflow
+            if (!batchRingFull) {
+                batchRingFull = true;
+                ring->noteOverflow(0);
+            }
+            break;
+        }
+        if (slot) {
+            batchRingFull = false;
+        }
+        
+        struct tpacket_block_desc *block = tpacket_ring_next_block(&tpacketRing->ring);
+        if (!block) {
+            break;
+        }
+        
+        TPacketBlockBatch batch(new TPacketBlockLease(tpacketRing, block));
+        
+        uint32_t frameCount = tpacket_block_frame_count(block);
+        batch->frames.reserve(frameCount);
+        
+        // Only frame pointers are collected; payloads stay in the ring
+        const struct tpacket3_hdr *frame = tpacket_block_first_frame(block);
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            tpacket_frame_t info;
+            tpacket_frame_info(frame, &info);
+            qint64 timestampNs = qint64(info.ts_sec) * NANOSECONDS_PER_SECOND + info.ts_nsec;
+            
+            if (diskFeed) {
+                diskFeed->appendPacket(reinterpret_cast<const char*>(info.data), info.caplen, info.wirelen,
+                                       timestampNs);
+            }
+            const char *data = reinterpret_cast<const char*>(info.data);
+            if (shouldSamplePacket(data, info.caplen, timestampNs) &&
+                routeBatchPacket(slot, data, info.caplen, timestampNs)) {
+                batch->frames.append(frame);
+            }
+            frame = tpacket_block_next_frame(frame);
+        }
+        handedOut = true;
+        
+        // Blocks with nothing sampled are released right here
+        if (batch->frames.isEmpty()) {
+            if (slot && !slot->isEmpty()) {
+                flushPendingBatch();
+            }
+            continue;
+        }
+        
+        if (fanoutGroupId >= 0) {
+            // Fanout workers summarize on their own core and give the block
+            // back as soon as the frames have been copied out
+            for (const struct tpacket3_hdr *sampledFrame : batch->frames) {
+                tpacket_frame_t info;
+                tpacket_frame_info(sampledFrame, &info);
+                
+                slot->summaries.append(PacketCaptureController::summarizePacket(
+                    slabStore.append(reinterpret_cast<const char*>(info.data), info.caplen),
+                    qint64(info.ts_sec) * NANOSECONDS_PER_SECOND + info.ts_nsec));
+            }
+        } else {
+            slot->appendBlock(batch);
+        }
+        
+        // One retired block is already a batch
+        flushPendingBatch();
+    }
+    
+    return handedOut;
+}
+
+void PacketCaptureWorker::processPackets() {
+    if (tpacketRing && !shouldStop) {
+        drainTPacketRing();
+        return;
+    }
+    
+    if (!pcapHandle || shouldStop) {
+        return;
+    }
+    
+    // Process up to 500 packets per timer tick for better batching
+    for (int i = 0; i < 500 && !shouldStop; ++i) {
+        struct pcap_pkthdr *header;
+        const u_char *packetData;
+        
+        int result = pcap_next_ex(pcapHandle, &header, &packetData);
+        
+        if (result == 1) {
+            if (diskFeed) {
+                diskFeed->appendPacket(reinterpret_cast<const char*>(packetData), header->caplen, header->len,
+                                       pcapTimestampNs(header->ts));
+            }
+            
+            // Check if we should sample this packet
+            bool shouldSample = shouldSamplePacket(reinterpret_cast<const char*>(packetData), header->caplen,
+                                                   pcapTimestampNs(header->ts));
             
             if (shouldSample) {
-                // Packet captured successfully - add to batch
-                QByteArray packet(reinterpret_cast<const char*>(packetData), header->caplen);
-                batchedPackets.append(qMakePair(packet, header->ts));
+                deliverPacket(reinterpret_cast<const char*>(packetData), header->caplen, pcapTimestampNs(header->ts));
             }
         } else if (result == 0) {
             // Timeout - no packet available
@@ -665,31 +1978,70 @@ void PacketCaptureWorker::processPackets() {
         }
     }
     
-    // Emit batched packets if any were captured
-    if (!batchedPackets.isEmpty()) {
-        emit packetsBatchReady(batchedPackets);
-    }
+    // Publish batched packets if any were captured
+    flushPendingBatch();
 }
 
 bool PacketCaptureWorker::initializePcap() {
     
-    if (pcapHandle) {
+    if (isCaptureOpen()) {
         cleanupPcap();
     }
     
+    if (captureBackend == TPacketV3Backend) {
+        return initializeTPacketRing();
+    }
+    
     
-    // Open interface for live capture
-    pcapHandle = pcap_open_live(interface.toUtf8().constData(),
-                               65536,  // snaplen - capture entire packet
-                               1,      // promiscuous mode
-                               1,      // timeout in milliseconds
-                               errorBuffer);
+    // Create the handle first so immediate mode and the kernel buffer size
+    // can be configured before activation
+    pcapHandle = pcap_create(interface.toUtf8().constData(), errorBuffer);
     
     if (!pcapHandle) {
         qWarning() << "Failed to open interface" << interface << ":" << errorBuffer;
         return false;
     }
     
+    pcap_set_snaplen(pcapHandle, 65536);    // capture entire packet
+    pcap_set_promisc(pcapHandle, 1);        // promiscuous mode
+    pcap_set_timeout(pcapHandle, 1);        // timeout in milliseconds
+    pcap_set_buffer_size(pcapHandle, CAPTURE_KERNEL_BUFFER_BYTES);
+    
+#ifdef PCAP_TSTAMP_PRECISION_NANO
+    // Ask for nanosecond timestamps; older kernels/drivers stay at microseconds
+    if (pcap_set_tstamp_precision(pcapHandle, PCAP_TSTAMP_PRECISION_NANO) != 0) {
+        qDebug() << "Nanosecond timestamps not supported on" << interface;
+    }
+#endif
+    
+    // Deliver packets as soon as they arrive; batching is done by the loop
+    if (pcap_set_immediate_mode(pcapHandle, 1) != 0) {
+        qWarning() << "Failed to enable immediate mode on" << interface;
+    }
+    
+    int status = pcap_activate(pcapHandle);
+    if (status < 0) {
+        snprintf(errorBuffer, sizeof(errorBuffer), "%s", pcap_geterr(pcapHandle));
+        qWarning() << "Failed to activate interface" << interface << ":" << errorBuffer;
+        pcap_close(pcapHandle);
+        pcapHandle = nullptr;
+        return false;
+    } else if (status > 0) {
+        qWarning() << "Interface" << interface << "activated with warning:" << pcap_geterr(pcapHandle);
+    }
+    
+    // Kernel counters of a fresh handle start at zero
+    memset(&lastPcapStats, 0, sizeof(lastPcapStats));
+    
+    // pcap_pkthdr keeps using struct timeval; tv_usec carries nanoseconds
+    // when the handle runs at nano precision
+    pcapTimestampUnitNs = 1000;
+#ifdef PCAP_TSTAMP_PRECISION_NANO
+    if (pcap_get_tstamp_precision(pcapHandle) == PCAP_TSTAMP_PRECISION_NANO) {
+        pcapTimestampUnitNs = 1;
+    }
+#endif
+    
     
     // Set non-blocking mode
     if (pcap_setnonblock(pcapHandle, 1, errorBuffer) == -1) {
@@ -701,14 +2053,160 @@ bool PacketCaptureWorker::initializePcap() {
     return true;
 }
 
+bool PacketCaptureWorker::initializeTPacketRing() {
+    tpacket_ring_config_t config;
+    tpacket_ring_default_config(&config);
+    config.block_size = static_cast<unsigned int>(tpacketBlockSize);
+    config.block_count = static_cast<unsigned int>(tpacketBlockCount);
+    config.retire_timeout_ms = static_cast<unsigned int>(tpacketRetireTimeoutMs);
+    
+    QSharedPointer<TPacketRingHandle> ringHandle(new TPacketRingHandle());
+    if (tpacket_ring_open(&ringHandle->ring, interface.toUtf8().constData(), &config) != 0) {
+        snprintf(errorBuffer, sizeof(errorBuffer), "%s", ringHandle->ring.error);
+        qWarning() << "Failed to open TPACKET_V3 ring on" << interface << ":" << errorBuffer;
+        return false;
+    }
+    
+    if (fanoutGroupId >= 0 && tpacket_ring_join_fanout(&ringHandle->ring, static_cast<uint16_t>(fanoutGroupId)) != 0) {
+        snprintf(errorBuffer, sizeof(errorBuffer), "%s", ringHandle->ring.error);
+        qWarning() << "Failed to join fanout group" << fanoutGroupId << "on" << interface << ":" << errorBuffer;
+        return false;
+    }
+    
+    tpacketRing = ringHandle;
+    
+    qDebug() << "Opened TPACKET_V3 ring on" << interface << "-" << tpacketBlockCount
+             << "blocks of" << tpacketBlockSize << "bytes, retire timeout" << tpacketRetireTimeoutMs << "ms";
+    return true;
+}
+
 void PacketCaptureWorker::cleanupPcap() {
+    // Keep whatever the kernel counted up to now
+    refreshKernelStats(true);
+    
     if (pcapHandle) {
         pcap_close(pcapHandle);
         pcapHandle = nullptr;
     }
+    
+    // Blocks still queued to the controller keep the mapping alive
+    tpacketRing.reset();
+}
+
+bool PacketCaptureWorker::isCaptureOpen() const {
+    return pcapHandle || tpacketRing;
+}
+
+int PacketCaptureWorker::captureFd() const {
+    if (tpacketRing) {
+        return tpacketRing->ring.fd;
+    }
+    return pcapHandle ? pcap_get_selectable_fd(pcapHandle) : -1;
+}
+
+void PacketCaptureWorker::closeCapture() {
+    cleanupPcap();
+}
+
+void PacketCaptureWorker::addDropStatistics(CaptureDropStats &stats) const {
+    stats.kernelReceived += kernelReceivedCount.load(std::memory_order_relaxed);
+    stats.kernelDrops += kernelDropCount.load(std::memory_order_relaxed);
+    stats.interfaceDrops += interfaceDropCount.load(std::memory_order_relaxed);
+    stats.samplingSeen += samplingSeenCount.load(std::memory_order_relaxed);
+    stats.samplingDiscards += samplingDiscardCount.load(std::memory_order_relaxed);
+    stats.overloadSummaryOnly += overloadSummaryOnlyCount.load(std::memory_order_relaxed);
+    stats.overloadSampled += overloadSampledCount.load(std::memory_order_relaxed);
+    stats.overloadSpilled += overloadSpilledCount.load(std::memory_order_relaxed);
+    stats.overloadDropped += overloadDroppedCount.load(std::memory_order_relaxed);
+}
+
+void PacketCaptureWorker::refreshKernelStats(bool force) {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!force && now - lastKernelStatsTime < 1000) {
+        return;
+    }
+    lastKernelStatsTime = now;
+    
+    if (tpacketRing) {
+        // PACKET_STATISTICS resets on every read, so each call is a delta
+        tpacket_ring_stats_t stats;
+        if (tpacket_ring_stats(&tpacketRing->ring, &stats) == 0) {
+            kernelReceivedCount.fetch_add(stats.packets, std::memory_order_relaxed);
+            kernelDropCount.fetch_add(stats.drops, std::memory_order_relaxed);
+        }
+    } else if (pcapHandle) {
+        // libpcap counters are cumulative 32-bit values; unsigned
+        // subtraction keeps the delta right across a wrap
+        struct pcap_stat stats;
+        if (pcap_stats(pcapHandle, &stats) == 0) {
+            kernelReceivedCount.fetch_add(static_cast<u_int>(stats.ps_recv - lastPcapStats.ps_recv),
+                                          std::memory_order_relaxed);
+            kernelDropCount.fetch_add(static_cast<u_int>(stats.ps_drop - lastPcapStats.ps_drop),
+                                      std::memory_order_relaxed);
+            interfaceDropCount.fetch_add(static_cast<u_int>(stats.ps_ifdrop - lastPcapStats.ps_ifdrop),
+                                         std::memory_order_relaxed);
+            lastPcapStats = stats;
+        }
+    }
+}
+
+void PacketCaptureWorker::resetDropCounters() {
+    // Fold in anything counted before this start, then begin from zero
+    refreshKernelStats(true);
+    kernelReceivedCount.store(0, std::memory_order_relaxed);
+    kernelDropCount.store(0, std::memory_order_relaxed);
+    interfaceDropCount.store(0, std::memory_order_relaxed);
+    samplingSeenCount.store(0, std::memory_order_relaxed);
+    samplingDiscardCount.store(0, std::memory_order_relaxed);
+    overloadSummaryOnlyCount.store(0, std::memory_order_relaxed);
+    overloadSampledCount.store(0, std::memory_order_relaxed);
+    overloadSpilledCount.store(0, std::memory_order_relaxed);
+    overloadDroppedCount.store(0, std::memory_order_relaxed);
+    reservoirUsed = 0;
+    reservoirSeen = 0;
+    bucketRefillNs = 0;
+}
+
+qint64 PacketCaptureWorker::pcapTimestampNs(const struct timeval &ts) const {
+    return qint64(ts.tv_sec) * NANOSECONDS_PER_SECOND + qint64(ts.tv_usec) * pcapTimestampUnitNs;
+}
+
+bool PacketCaptureWorker::applyTPacketFilter(const QString &filter) {
+    if (filter.isEmpty()) {
+        return tpacket_ring_set_filter(&tpacketRing->ring, nullptr, 0) == 0;
+    }
+    
+    // Compile against a dead Ethernet handle; the result is plain classic BPF
+    // that the packet socket accepts directly
+    pcap_t *compiler = pcap_open_dead(DLT_EN10MB, 65536);
+    if (!compiler) {
+        return false;
+    }
+    
+    struct bpf_program filterProgram;
+    if (pcap_compile(compiler, &filterProgram, filter.toUtf8().constData(), 1, PCAP_NETMASK_UNKNOWN) == -1) {
+        qWarning() << "Failed to compile filter" << filter << ":" << pcap_geterr(compiler);
+        pcap_close(compiler);
+        return false;
+    }
+    
+    bool applied = tpacket_ring_set_filter(&tpacketRing->ring,
+                                           reinterpret_cast<const struct sock_filter*>(filterProgram.bf_insns),
+                                           static_cast<unsigned short>(filterProgram.bf_len)) == 0;
+    if (!applied) {
+        qWarning() << "Failed to apply filter" << filter << ":" << tpacketRing->ring.error;
+    }
+    
+    pcap_freecode(&filterProgram);
+    pcap_close(compiler);
+    return applied;
 }
 
 bool PacketCaptureWorker::applyFilter(const QString &filter) {
+    if (tpacketRing) {
+        return applyTPacketFilter(filter);
+    }
+    
     if (!pcapHandle) {
         return false;
     }
@@ -6,9 +6,18 @@
 #include <QTimer>
 #include <QMutex>
 #include <QQueue>
+#include <QHash>
+#include <QMap>
+#include <QThreadPool>
 #include <QString>
 #include <QByteArray>
+#include <QSharedPointer>
+#include <QVector>
+#include <QRandomGenerator>
+#include <atomic>
 #include "Models/PacketModel.h"
+#include "Utils/PacketBatchRing.h"
+#include "CaptureDiskWriter.h"
 
 extern "C" {
     #include <pcap.h>
@@ -17,6 +26,39 @@ extern "C" {
 
 class PacketCaptureWorker;
 
+// Where packets went missing, per pipeline stage, since capture started
+struct CaptureDropStats {
+    quint64 kernelReceived = 0;     // Seen by the capture socket (ps_recv / tp_packets)
+    quint64 kernelDrops = 0;        // No room in the kernel buffer (ps_drop / tp_drops)
+    quint64 interfaceDrops = 0;     // Dropped by the NIC or driver (ps_ifdrop)
+    quint64 ringOverflows = 0;      // Worker -> controller batch ring full
+    quint64 samplingSeen = 0;       // Offered to packet sampling
+    quint64 samplingDiscards = 0;   // Skipped on purpose by packet sampling
+    quint64 validationRejects = 0;  // Failed DataValidator::isValidPacketInfo
+    quint64 diskWriterDrops = 0;    // Disk writer ring full; missing from the capture file only
+    
+    // Deliberate degradation while the consumer is short of batch credits
+    quint64 overloadSummaryOnly = 0;  // Reached the model without payload
+    quint64 overloadSampled = 0;      // Sampled out
+    quint64 overloadSpilled = 0;      // Out of credits; only in the capture file
+    quint64 overloadDropped = 0;      // Out of credits, no capture file
+    
+    // Packets that were captured but never reached the model
+    quint64 totalDropped() const {
+        return kernelDrops + interfaceDrops + ringOverflows + validationRejects +
+               overloadSampled + overloadSpilled + overloadDropped;
+    }
+    
+    // Fraction of packets sampling let through; divide sampled counts by it
+    // to estimate the traffic that was actually seen
+    double samplingRatio() const {
+        if (samplingSeen == 0 || samplingDiscards >= samplingSeen) {
+            return samplingSeen == 0 ? 1.0 : 0.0;
+        }
+        return double(samplingSeen - samplingDiscards) / double(samplingSeen);
+    }
+};
+
 class PacketCaptureController : public QObject
 {
     Q_OBJECT
@@ -26,7 +68,21 @@ public:
     enum SamplingMode {
         NoSampling,         // Capture all packets (default)
         CountBasedSampling, // Sample every Nth packet
-        RateBasedSampling   // Sample to maintain target rate
+        RateBasedSampling,  // Token bucket: at most targetRate packets per second
+        FlowHashSampling,   // Keep 1 in samplingRate flows, every packet of a kept flow
+        ReservoirSampling   // Uniform sample of targetRate packets per one-second window
+    };
+    
+    // How the worker thread pulls packets out of libpcap
+    enum CaptureLoopMode {
+        BlockingLoop,       // Dedicated poll()/pcap_dispatch loop (default)
+        TimerPollingLoop    // Legacy 200ms QTimer poll
+    };
+    
+    // Where packets come from
+    enum CaptureBackend {
+        PcapBackend,        // libpcap handle (default)
+        TPacketV3Backend    // AF_PACKET TPACKET_V3 mmap ring, Linux only
     };
     
     explicit PacketCaptureController(const QString &interface, QObject *parent = nullptr);
@@ -36,7 +92,8 @@ public:
     QString getInterface() const;
     bool isSpoofingMode() const;
     void setSpoofingMode(bool enabled, const QList<QString> &targetMACs = QList<QString>());
-    PacketInfo createPacketInfo(const QByteArray &packetData, const struct timeval &timestamp);
+    PacketInfo createPacketInfo(const PacketSlice &packetData, const struct timeval &timestamp);
+    PacketInfo createPacketInfo(const PacketSlice &packetData, qint64 timestampNs);
     
     // Ring buffer configuration
     void setRingBufferEnabled(bool enabled);
@@ -46,16 +103,71 @@ public:
     
     // Packet sampling configuration
     void setSamplingMode(SamplingMode mode);
-    void setSamplingRate(int rate);  // For count-based: every Nth packet
-    void setTargetRate(int packetsPerSecond);  // For rate-based: target rate
+    void setSamplingRate(int rate);  // For count-based and flow-hash: 1 in N
+    void setTargetRate(int packetsPerSecond);  // For rate-based and reservoir: packets per second
     SamplingMode getSamplingMode() const;
     int getSamplingRate() const;
     int getTargetRate() const;
+    double getEffectiveSamplingRatio() const;  // Measured kept/seen since capture started
+    
+    // Capture loop configuration
+    void setCaptureLoopMode(CaptureLoopMode mode);
+    void setBatchThresholds(int maxBatchPackets, int flushIntervalMs);
+    CaptureLoopMode getCaptureLoopMode() const;
+    int getMaxBatchPackets() const;
+    int getFlushIntervalMs() const;
+    
+    // Capture backend configuration (takes effect on the next startCapture)
+    void setCaptureBackend(CaptureBackend backend);
+    void setTPacketRingConfig(int blockSize, int blockCount, int retireTimeoutMs);
+    CaptureBackend getCaptureBackend() const;
+    int getTPacketBlockSize() const;
+    int getTPacketBlockCount() const;
+    int getTPacketRetireTimeoutMs() const;
+    
+    // Fanout capture: 1 = single worker (default), 0 = one worker per core,
+    // N = N workers sharing a PACKET_FANOUT group. Requires TPACKET_V3
+    void setFanoutWorkers(int count);
+    int getFanoutWorkers() const;
+    
+    // Worker -> controller batch ring counters, summed over all workers
+    int getBatchRingOccupancy() const;
+    int getBatchRingCapacity() const;
+    quint64 getBatchRingOverflowEvents() const;
+    quint64 getBatchRingDroppedPackets() const;
+    
+    // Drop accounting, summed over all workers
+    CaptureDropStats getDropStatistics() const;
+    
+    // Packet payload slabs; huge pages apply to slabs mapped from now on
+    void setPacketSlabHugePages(bool enabled);
+    bool isPacketSlabHugePages() const;
+    
+    // Continuous capture to pcapng files (takes effect on the next startCapture)
+    void setDiskCapture(const DiskCaptureSettings &settings);
+    DiskCaptureSettings getDiskCapture() const;
+    QString getDiskCaptureFile() const;
+    quint64 getDiskPacketsWritten() const;
+    
+    // Builds the list-view summary for a packet; safe to call from any thread
+    static PacketInfo summarizePacket(const PacketSlice &packetData, qint64 timestampNs);
+    
+    // Spoofing-mode MAC filter; safe to call from any thread
+    static bool isTargetPacket(const QByteArray &packetData, const QList<QString> &targetMACs);
     
 public slots:
     void startCapture();
     void stopCapture();
     void setPacketFilter(const QString &filter);
+    
+    // Called by the consumer once the batches delivered so far are in the
+    // model; returns their credits to the capture workers
+    void grantBatchCredits();
+    
+    // Memory pressure from the consumer's model: credits are paced back
+    // while it lasts (see backpressureActive)
+    void onMemoryLimitExceeded();
+    void onMemoryPressureRelieved();
 
 signals:
     void packetCaptured(const PacketInfo &packet);
@@ -63,20 +175,37 @@ signals:
     void captureError(const QString &error);
     void captureStatusChanged(bool isCapturing);
     void statisticsUpdated(int packetCount, qint64 bytes);
+    void captureStatistics(int packetsReceived, int packetsDropped);  // Once a second, see getDropStatistics()
     void backpressureApplied(); // Emitted when capture rate is throttled
+    void backpressureReleased(); // Emitted when credits flow freely again
     void samplingApplied(); // Emitted when packet sampling is active
 
 private slots:
     void processCapturedPacket(const QByteArray &packetData, const struct timeval &timestamp);
-    void processCapturedPacketBatch(const QList<QPair<QByteArray, struct timeval>> &packets);
+    void flushMergedPackets();
+    void onBatchSummarized(QSharedPointer<PacketBatchRing> ring, quint64 generation, quint64 sequence,
+                           const QList<PacketInfo> &packets, const QList<PacketInfo> &summaries, int rejected);
     void handleWorkerError(const QString &error);
     void handleWorkerFinished();
-    void onMemoryLimitExceeded();
 
 private:
     void setupWorker();
     void cleanupWorker();
-    bool isTargetPacket(const QByteArray &packetData) const;
+    void configureWorker(PacketCaptureWorker *worker, int fanoutIndex);
+    void setupFanoutWorkers(int count);
+    void cleanupFanoutWorkers();
+    void stopWorkerThread(QThread *thread, PacketCaptureWorker *worker);
+    QList<PacketCaptureWorker*> activeWorkers() const;
+    int resolveFanoutWorkerCount() const;
+    void startDiskWriter();
+    void emitProcessedPackets(const QList<PacketInfo> &processedPackets);
+    void connectBatchRing(PacketCaptureWorker *worker);
+    void drainBatchRing(const QSharedPointer<PacketBatchRing> &ring);
+    void drainSummarizePipelines();  // Delivers every committed batch; for stopCapture
+    void resetSummarizePipelines();
+    void countDeliveredPackets(QList<PacketInfo> &packets, int rejected);
+    void processSummarizedPackets(const QList<PacketInfo> &packets);
+    void returnOwedCredits();
     
     QString networkInterface;
     QThread *captureThread;
@@ -91,22 +220,75 @@ private:
     // Statistics
     int packetCount;
     qint64 totalBytes;
+    quint64 validationRejects;
     QTimer *statisticsTimer;
     
     // Ring buffer support
     bool ringBufferEnabled;
     int ringBufferSize;
     
-    // Backpressure control
+    // Backpressure control: while active, each worker's ring gets a batch
+    // credit back at most once per backpressureDelayMs, so they degrade early
     bool backpressureActive;
     int backpressureDelayMs;
     
+    // Credit-based flow control; one entry per drained slot whose packets
+    // the consumer has not acknowledged yet
+    QList<QSharedPointer<PacketBatchRing>> creditsOwed;
+    bool awaitingConsumer;
+    bool creditReturnScheduled;
+    
     // Packet sampling
     SamplingMode samplingMode;
     int samplingRate;
     int targetRate;
     int sampledPacketCount;
     
+    // Capture loop
+    CaptureLoopMode captureLoopMode;
+    int maxBatchPackets;
+    int flushIntervalMs;
+    
+    // Capture backend
+    CaptureBackend captureBackend;
+    int tpacketBlockSize;
+    int tpacketBlockCount;
+    int tpacketRetireTimeoutMs;
+    
+    // Fanout capture; worker 0 is captureWorker, the rest live here
+    int fanoutWorkers;
+    int fanoutGroupId;
+    QList<QThread*> fanoutThreads;
+    QList<PacketCaptureWorker*> fanoutWorkerList;
+    CaptureDropStats retiredDropStats;    // Fanout workers torn down since capture started
+    QList<PacketInfo> mergedPackets;
+    QTimer *mergeTimer;
+    
+    // Payloads of packets copied on the controller thread
+    PacketSlabStore slabStore;
+    
+    // Batch slots are summarized on a thread pool, possibly out of order,
+    // and released back to their ring strictly in order
+    struct SummarizedBatch {
+        QList<PacketInfo> packets;    // Summarized from copied records and ring frames
+        QList<PacketInfo> summaries;  // Summarized by a fanout worker, merged by timestamp
+        int rejected = 0;             // Failed validation
+    };
+    struct SummarizePipeline {
+        QSharedPointer<PacketBatchRing> ring;  // Keeps the key pointer valid
+        int dispatched = 0;                    // Taken from the ring, not released
+        quint64 nextSequence = 0;
+        quint64 nextRelease = 0;
+        QMap<quint64, SummarizedBatch> finished;
+    };
+    QThreadPool summarizePool;
+    QHash<PacketBatchRing*, SummarizePipeline> summarizePipelines;
+    quint64 summarizeGeneration;
+    
+    // Capture-to-disk; the writer of the last capture is kept for its counters
+    DiskCaptureSettings diskCapture;
+    CaptureDiskWriter *diskWriter;
+    
     // Thread safety
     mutable QMutex captureMutex;
 };
@@ -120,11 +302,39 @@ public:
     enum SamplingMode {
         NoSampling,         // Capture all packets (default)
         CountBasedSampling, // Sample every Nth packet
-        RateBasedSampling   // Sample to maintain target rate
+        RateBasedSampling,  // Token bucket: at most targetRate packets per second
+        FlowHashSampling,   // Keep 1 in samplingRate flows, every packet of a kept flow
+        ReservoirSampling   // Uniform sample of targetRate packets per one-second window
+    };
+    
+    // Capture loop modes (mirrors PacketCaptureController::CaptureLoopMode)
+    enum CaptureLoopMode {
+        BlockingLoop,
+        TimerPollingLoop
+    };
+    
+    // Capture backends (mirrors PacketCaptureController::CaptureBackend)
+    enum CaptureBackend {
+        PcapBackend,
+        TPacketV3Backend
     };
     
     explicit PacketCaptureWorker(const QString &interface);
     ~PacketCaptureWorker();
+    
+    // Thread-safe: wakes the blocking capture loop so queued commands
+    // (stop, filter changes, configuration) are handled immediately
+    void wakeCaptureLoop();
+    
+    // Batches produced by this worker; the controller is the only consumer
+    QSharedPointer<PacketBatchRing> batchRing() const;
+    
+    // Thread-safe: adds this worker's kernel and sampling counters
+    void addDropStatistics(CaptureDropStats &stats) const;
+    
+    // Once the worker's thread has stopped: closes the capture and takes the
+    // kernel's last counters
+    void closeCapture();
 
 public slots:
     void initialize();
@@ -132,31 +342,67 @@ public slots:
     void stopCapture();
     void setFilter(const QString &filter);
     
-    // Backpressure control
-    void setBackpressureDelay(int delayMs);
-    
     // Packet sampling configuration
     void setSamplingMode(SamplingMode mode);
     void setSamplingRate(int rate);
     void setTargetRate(int packetsPerSecond);
+    
+    // Capture loop configuration
+    void setCaptureLoopMode(CaptureLoopMode mode);
+    void setBatchThresholds(int maxBatchPackets, int flushIntervalMs);
+    
+    // Capture backend configuration
+    void setCaptureBackend(CaptureBackend backend);
+    void setTPacketRingConfig(int blockSize, int blockCount, int retireTimeoutMs);
+    void setFanoutGroup(int groupId, int workerIndex);  // groupId < 0 leaves the group
+    void setPacketSlabHugePages(bool enabled);
+    void setDiskWriterFeed(QSharedPointer<DiskWriterFeed> feed);  // null stops writing to disk
 
 signals:
     void packetReady(const QByteArray &packetData, const struct timeval &timestamp);
-    void packetsBatchReady(const QList<QPair<QByteArray, struct timeval>> &packets);
+    void batchesAvailable();  // Coalesced: sent once per idle -> non-empty transition of the batch ring
     void errorOccurred(const QString &error);
     void finished();
 
 private slots:
     void processPackets();
+    void runCaptureLoop();
 
 private:
+    // Overload decision for the next batch, from the credits left in the ring
+    enum BatchPolicy {
+        FullBatch,          // Payloads copied as usual
+        SummaryOnlyBatch,   // Summarized on this thread, payload not kept
+        SampledBatch,       // Summary only, for 1 in OVERLOAD_SAMPLE_FLOWS flows
+        SpillBatch          // No batch; packets reach only the capture file, if any
+    };
+    
     static void packetHandler(u_char *userData, const struct pcap_pkthdr *pkthdr, const u_char *packet);
+    BatchPolicy chooseBatchPolicy() const;
+    void deliverPacket(const char *packet, int length, qint64 timestampNs);
+    bool routeBatchPacket(PacketBatchSlot *slot, const char *packet, int length, qint64 timestampNs);
+    bool shouldSamplePacket(const char *packet, int length, qint64 timestampNs);
+    bool takeSamplingToken(qint64 timestampNs);
+    void offerToReservoir(const char *packet, int length, qint64 timestampNs);
+    void flushReservoir();
+    PacketBatchSlot *acquireWriteSlot();
+    void flushPendingBatch();
     bool initializePcap();
+    bool initializeTPacketRing();
     void cleanupPcap();
     bool applyFilter(const QString &filter);
+    bool applyTPacketFilter(const QString &filter);
+    bool isCaptureOpen() const;
+    int captureFd() const;
+    qint64 pcapTimestampNs(const struct timeval &ts) const;
+    void refreshKernelStats(bool force = false);
+    void resetDropCounters();
+    bool drainTPacketRing();
+    void pinToFanoutCore();
     
     QString interface;
     pcap_t *pcapHandle;
+    qint64 pcapTimestampUnitNs;  // 1 with nanosecond precision, 1000 otherwise
     bool shouldStop;
     QString packetFilter;
     
@@ -173,15 +419,70 @@ private:
     QMutex queueMutex;
     QTimer *processTimer;
     
-    // Backpressure control
-    int backpressureDelayMs;
-    
-    // Packet sampling
+    // Packet sampling; all decisions use packet timestamps
     SamplingMode samplingMode;
     int samplingRate;
     int targetRate;
     int packetCounter;
-    qint64 lastSampleTime;
+    qint64 bucketTokens;       // Token bucket, in billionths of a packet
+    qint64 bucketRefillNs;
+    
+    // Reservoir sampling (Algorithm R) over the current window
+    struct ReservoirEntry {
+        QByteArray data;       // Keeps its capacity across windows
+        qint64 timestampNs;
+        quint64 sequence;      // Arrival order within the window
+    };
+    QVector<ReservoirEntry> reservoir;
+    int reservoirUsed;
+    quint64 reservoirSeen;
+    qint64 reservoirWindowStartNs;
+    QRandomGenerator samplingRandom;
+    
+    // Blocking capture loop
+    CaptureLoopMode captureLoopMode;
+    int maxBatchPackets;
+    int flushIntervalMs;
+    int wakeEventFd;
+    bool loopRunning;
+    qint64 lastFlushTime;
+    
+    // Hand-off to the controller; writeSlot is the batch being filled
+    QSharedPointer<PacketBatchRing> ring;
+    PacketBatchSlot *writeSlot;
+    BatchPolicy batchPolicy;
+    bool batchRingFull;               // Counted as one overflow until a slot frees up
+    
+    // TPACKET_V3 backend
+    CaptureBackend captureBackend;
+    int tpacketBlockSize;
+    int tpacketBlockCount;
+    int tpacketRetireTimeoutMs;
+    QSharedPointer<TPacketRingHandle> tpacketRing;
+    
+    // Fanout membership
+    int fanoutGroupId;
+    int fanoutWorkerIndex;
+    
+    // Payloads of packets summarized on this thread (fanout workers)
+    PacketSlabStore slabStore;
+    
+    // Every captured packet, ahead of sampling, goes here when writing to disk
+    QSharedPointer<DiskWriterFeed> diskFeed;
+    
+    // Drop accounting, written by this thread and read by the controller.
+    // Kernel counters are polled at most once a second
+    std::atomic<quint64> kernelReceivedCount;
+    std::atomic<quint64> kernelDropCount;
+    std::atomic<quint64> interfaceDropCount;
+    std::atomic<quint64> samplingSeenCount;
+    std::atomic<quint64> samplingDiscardCount;
+    std::atomic<quint64> overloadSummaryOnlyCount;
+    std::atomic<quint64> overloadSampledCount;
+    std::atomic<quint64> overloadSpilledCount;
+    std::atomic<quint64> overloadDroppedCount;
+    struct pcap_stat lastPcapStats;
+    qint64 lastKernelStatsTime;
     
     // Error handling
     char errorBuffer[PCAP_ERRBUF_SIZE];
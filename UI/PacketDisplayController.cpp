@@ -4,6 +4,7 @@
 #include "ProtocolTreeView.h"
 #include "Models/PacketModel.h"
 #include "Models/ProtocolTreeModel.h"
+#include "SelectionDissector.h"
 #include "Wrappers/ProtocolAnalysisWrapper.h"
 #include <QDebug>
 #include <QTimer>
@@ -18,6 +19,9 @@ PacketDisplayController::PacketDisplayController(QObject *parent)
     , m_currentSelection(-1)
     , m_currentHighlightStart(-1)
     , m_currentHighlightLength(0)
+    , m_dissector(new SelectionDissector(this))
+    , m_currentSerial(0)
+    , m_displayedSerial(0)
     , m_delayedUpdateTimer(new QTimer(this))
     , m_pendingUpdateIndex(-1)
     , m_updatePending(false)
@@ -29,6 +33,7 @@ PacketDisplayController::PacketDisplayController(QObject *parent)
     m_delayedUpdateTimer->setSingleShot(true);
     m_delayedUpdateTimer->setInterval(50); // 50ms delay to batch updates
     connect(m_delayedUpdateTimer, &QTimer::timeout, this, &PacketDisplayController::processDelayedUpdate);
+    connect(m_dissector, &SelectionDissector::dissected, this, &PacketDisplayController::onPacketDissected);
     
     qDebug() << "PacketDisplayController: Initialized";
 }
@@ -71,8 +76,12 @@ void PacketDisplayController::setModels(PacketModel *packetModel, ProtocolTreeMo
     if (m_packetModel) {
         connect(m_packetModel, &PacketModel::rowsInserted,
                 this, &PacketDisplayController::refreshCurrentSelection);
+        connect(m_packetModel, &PacketModel::rowsRemoved,
+                this, &PacketDisplayController::onPacketsEvicted);
         connect(m_packetModel, &PacketModel::modelReset,
                 this, &PacketDisplayController::clearDisplays);
+        connect(m_packetModel, &PacketModel::modelReset,
+                m_dissector, &SelectionDissector::clear);
     }
     
     qDebug() << "PacketDisplayController: Models connected";
@@ -100,8 +109,12 @@ void PacketDisplayController::onPacketSelected(int packetIndex)
     m_currentFieldName.clear();
     m_currentFieldValue.clear();
     
-    // Schedule delayed update to prevent UI flooding during rapid selections
-    scheduleDelayedUpdate(packetIndex);
+    // Update right away: the hex view is cheap and dissection runs in the
+    // background, so arrowing through the table never waits on either
+    m_delayedUpdateTimer->stop();
+    m_pendingUpdateIndex = packetIndex;
+    m_updatePending = true;
+    processDelayedUpdate();
     
     emit selectionChanged(packetIndex);
     
@@ -148,6 +161,8 @@ void PacketDisplayController::onBytesHighlighted(int startOffset, int length)
 void PacketDisplayController::clearDisplays()
 {
     m_currentSelection = -1;
+    m_currentSerial = 0;
+    m_displayedSerial = 0;
     m_currentFieldName.clear();
     m_currentFieldValue.clear();
     m_currentHighlightStart = -1;
@@ -169,10 +184,41 @@ void PacketDisplayController::clearDisplays()
 
 void PacketDisplayController::refreshCurrentSelection()
 {
-    if (m_currentSelection >= 0 && isValidPacketIndex(m_currentSelection)) {
-        // Re-select the current packet to refresh displays
-        scheduleDelayedUpdate(m_currentSelection);
-        qDebug() << "PacketDisplayController: Refreshed current selection:" << m_currentSelection;
+    if (m_currentSelection < 0 || m_currentSerial == 0) {
+        return;
+    }
+    
+    // Re-select the current packet to refresh displays; look it up by serial,
+    // the row it was selected at may have moved since
+    int row = m_packetModel->rowOfSerial(m_currentSerial);
+    if (row < 0) {
+        clearDisplays();
+        return;
+    }
+    m_currentSelection = row;
+    scheduleDelayedUpdate(row);
+    qDebug() << "PacketDisplayController: Refreshed current selection:" << m_currentSelection;
+}
+
+void PacketDisplayController::onPacketsEvicted()
+{
+    if (m_currentSelection < 0 || m_currentSerial == 0) {
+        return;
+    }
+    
+    // Evicting the oldest rows shifts every row after them down
+    int row = m_packetModel->rowOfSerial(m_currentSerial);
+    if (row < 0) {
+        m_delayedUpdateTimer->stop();
+        m_updatePending = false;
+        clearDisplays();
+        qDebug() << "PacketDisplayController: Selected packet" << m_currentSerial << "was evicted";
+        return;
+    }
+    
+    m_currentSelection = row;
+    if (m_updatePending) {
+        m_pendingUpdateIndex = row;
     }
 }
 
@@ -193,13 +239,14 @@ void PacketDisplayController::processDelayedUpdate()
     }
     
     PacketInfo packet = getPacketSafely(m_pendingUpdateIndex);
+    m_currentSerial = packet.serialNumber;
     
     try {
         // Update hex view
         updateHexView(packet);
         
         // Update protocol tree
-        updateProtocolTree(packet);
+        updateProtocolTree(m_pendingUpdateIndex, packet);
         
         qDebug() << "PacketDisplayController: Updated displays for packet" << m_pendingUpdateIndex;
         
@@ -222,49 +269,88 @@ void PacketDisplayController::updateHexView(const PacketInfo &packet)
         m_hexView->clear();
         qDebug() << "PacketDisplayController: Cleared hex view (no data)";
     } else {
-        m_hexView->displayPacketData(packet.rawData);
+        m_hexView->displayPacketData(packet.rawData.toByteArray());
         qDebug() << "PacketDisplayController: Updated hex view with" << packet.rawData.size() << "bytes";
     }
 }
 
-void PacketDisplayController::updateProtocolTree(const PacketInfo &packet)
+void PacketDisplayController::updateProtocolTree(int packetIndex, const PacketInfo &packet)
 {
     if (!m_protocolModel) {
         return;
     }
     
-    // PERFORMANCE IMPROVEMENT: Lazy protocol analysis
-    // If analysis hasn't been done yet, do it now (only when user selects the packet)
-    PacketInfo mutablePacket = packet; // Create mutable copy
+    // The user moved on: whatever was queued for the old neighbourhood is stale
+    m_dissector->cancelPending();
     
-    if (mutablePacket.analysisResult.summary.isEmpty()) {
-        // Perform analysis now (lazy evaluation)
-        mutablePacket.analysisResult = ProtocolAnalysisWrapper::analyzePacket(mutablePacket.rawData);
-        
-        // Update the packet in the model with the analysis result
-        if (m_packetModel) {
-            // Note: This would require adding a method to update analysis in PacketModel
-            // For now, we'll just use the local analysis
+    if (const ProtocolAnalysisResult *result = m_dissector->cached(packet.serialNumber)) {
+        showAnalysis(*result);
+    } else {
+        // onPacketDissected() fills the tree in when the result arrives
+        if (m_displayedSerial != 0) {
+            m_protocolModel->clear();
+            m_displayedSerial = 0;
+        }
+        QVector<PacketBytes> frame = m_packetModel->getPacketBytes(packetIndex, 1);
+        if (!frame.isEmpty()) {
+            m_dissector->request(packet.serialNumber, frame.first(), false);
         }
-        
-        qDebug() << "PacketDisplayController: Performed lazy protocol analysis for packet";
     }
     
-    if (!mutablePacket.analysisResult.hasError && !mutablePacket.analysisResult.summary.isEmpty()) {
-        m_protocolModel->setProtocolData(mutablePacket.analysisResult);
+    prefetchAround(packetIndex);
+}
+
+void PacketDisplayController::showAnalysis(const ProtocolAnalysisResult &result)
+{
+    // Rows arriving during a capture refresh the selection; rebuilding the
+    // same tree would only collapse it
+    if (m_displayedSerial == m_currentSerial) {
+        return;
+    }
+    m_displayedSerial = m_currentSerial;
+    
+    if (!result.hasError && !result.summary.isEmpty()) {
+        m_protocolModel->setProtocolData(result);
         qDebug() << "PacketDisplayController: Updated protocol tree with" 
-                 << mutablePacket.analysisResult.layers.size() << "layers";
+                 << result.layers.size() << "layers";
     } else {
         m_protocolModel->clear();
-        if (mutablePacket.analysisResult.hasError) {
+        if (result.hasError) {
             qWarning() << "PacketDisplayController: Protocol analysis error:" 
-                       << mutablePacket.analysisResult.errorMessage;
+                       << result.errorMessage;
         } else {
             qDebug() << "PacketDisplayController: Cleared protocol tree (no analysis)";
         }
     }
 }
 
+void PacketDisplayController::onPacketDissected(int serial)
+{
+    if (m_currentSelection < 0 || serial != m_currentSerial || !m_protocolModel) {
+        return;
+    }
+    if (const ProtocolAnalysisResult *result = m_dissector->cached(serial)) {
+        showAnalysis(*result);
+    }
+}
+
+void PacketDisplayController::prefetchAround(int packetIndex)
+{
+    const int rows = SelectionDissector::PREFETCH_ROWS;
+    int first = qMax(0, packetIndex - rows);
+    QVector<PacketBytes> frames = m_packetModel->getPacketBytes(first, packetIndex + rows + 1 - first);
+    
+    // Nearest rows first, alternating below and above the selection
+    for (int distance = 1; distance <= rows; ++distance) {
+        for (int row : {packetIndex + distance, packetIndex - distance}) {
+            int offset = row - first;
+            if (offset >= 0 && offset < frames.size()) {
+                m_dissector->request(frames[offset].serialNumber, frames[offset], true);
+            }
+        }
+    }
+}
+
 bool PacketDisplayController::isValidPacketIndex(int index) const
 {
     return m_packetModel && index >= 0 && index < m_packetModel->rowCount();
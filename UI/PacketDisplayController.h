@@ -10,6 +10,7 @@ class ProtocolTreeModel;
 class HexView;
 class ProtocolTreeView;
 class PacketTableView;
+class SelectionDissector;
 struct PacketInfo;
 struct ProtocolAnalysisResult;
 
@@ -100,6 +101,16 @@ private slots:
      */
     void processDelayedUpdate();
 
+    /**
+     * @brief Show a background dissection if it belongs to the selection
+     */
+    void onPacketDissected(int serial);
+
+    /**
+     * @brief Follow the selected packet to its new row, or clear it once evicted
+     */
+    void onPacketsEvicted();
+
 private:
     /**
      * @brief Update hex view with packet data
@@ -107,9 +118,19 @@ private:
     void updateHexView(const PacketInfo &packet);
 
     /**
-     * @brief Update protocol tree with analysis results
+     * @brief Update protocol tree from the dissection cache, or request it
      */
-    void updateProtocolTree(const PacketInfo &packet);
+    void updateProtocolTree(int packetIndex, const PacketInfo &packet);
+
+    /**
+     * @brief Put an analysis result into the protocol tree
+     */
+    void showAnalysis(const ProtocolAnalysisResult &result);
+
+    /**
+     * @brief Queue dissection of the rows around packetIndex, nearest first
+     */
+    void prefetchAround(int packetIndex);
 
     /**
      * @brief Validate packet index
@@ -142,6 +163,11 @@ private:
     int m_currentHighlightStart;
     int m_currentHighlightLength;
 
+    // Dissection off the GUI thread
+    SelectionDissector *m_dissector;
+    int m_currentSerial;    // Serial number of the selected packet
+    int m_displayedSerial;  // Serial number the protocol tree shows, 0 for none
+
     // Update management
     QTimer *m_delayedUpdateTimer;
     int m_pendingUpdateIndex;
@@ -1,5 +1,5 @@
 #include "PacketFilterWidget.h"
-#include <QRegularExpression>
+#include "Models/DisplayFilter.h"
 #include <QMessageBox>
 
 
@@ -35,7 +35,7 @@ void PacketFilterWidget::setupCustomFilter()
     customFilterLayout = new QHBoxLayout();
     
     customFilterEdit = new QLineEdit(this);
-    customFilterEdit->setPlaceholderText("Search packets... (e.g., 192.168.1.1, TCP, HTTP)");
+    customFilterEdit->setPlaceholderText("Filter or search packets... (e.g., ip.addr == 10.0.0.0/8 and tcp.port in {80 443}, 192.168.1.1)");
 
     
     clearButton = new QPushButton("Clear", this);
@@ -63,6 +63,16 @@ void PacketFilterWidget::onFilterTextChanged()
     // Clear any previous styling
     customFilterEdit->setStyleSheet("");
     
+    // Say whether the text is taken as a display filter or searched for
+    QString error;
+    if (filter.isEmpty()) {
+        customFilterEdit->setToolTip(QString());
+    } else if (DisplayFilter::compile(filter, &error).isValid()) {
+        customFilterEdit->setToolTip("Display filter");
+    } else {
+        customFilterEdit->setToolTip(QString("Text search (not a display filter: %1)").arg(error));
+    }
+    
     // Update current filter
     currentFilter.customFilter = filter;
     currentFilter.enabled = !filter.isEmpty();
@@ -107,24 +117,7 @@ bool PacketFilterWidget::validateFilter(const QString &filter) const
         return true;
     }
     
-    // Basic validation for common filter patterns
-    QStringList validPatterns = {
-        "ip\\.src\\s*==\\s*[\\d\\.]+",
-        "ip\\.dst\\s*==\\s*[\\d\\.]+", 
-        "tcp\\.port\\s*==\\s*\\d+",
-        "udp\\.port\\s*==\\s*\\d+",
-        "protocol\\s*==\\s*\\w+",
-        "\\w+\\s*(and|or|not)\\s*\\w+"
-    };
-    
-    // Allow combinations with and, or, not
-    QString normalizedFilter = filter.toLower();
-    
-    // Basic syntax check - ensure balanced parentheses
-    int openParens = normalizedFilter.count('(');
-    int closeParens = normalizedFilter.count(')');
-    
-    return openParens == closeParens;
+    return DisplayFilter::compile(filter).isValid();
 }
 
 PacketFilterWidget::FilterCriteria PacketFilterWidget::getCurrentFilter() const
@@ -1,6 +1,7 @@
 #include "PacketTableView.h"
 #include "Models/ProtocolTreeModel.h"
 #include "Models/PacketModel.h"
+#include "Wrappers/ProtocolAnalysisWrapper.h"
 #include <QHeaderView>
 #include <QScrollBar>
 #include <QApplication>
@@ -221,7 +222,7 @@ void PacketTableView::onCopyPacketInfo()
                                 "Length: %6 bytes\n"
                                 "More Info: %7\n")
                          .arg(packet.serialNumber)
-                         .arg(packet.timestamp.toString("yyyy-MM-dd hh:mm:ss.zzz"))
+                         .arg(PacketModel::formatFullTimestamp(packet.timestampNs))
                          .arg(packet.sourceIP)
                          .arg(packet.destinationIP)
                          .arg(packet.protocolType)
@@ -260,7 +261,7 @@ void PacketTableView::onExportPacket()
     // Create JSON representation
     QJsonObject packetJson;
     packetJson["serialNumber"] = packet.serialNumber;
-    packetJson["timestamp"] = packet.timestamp.toString(Qt::ISODate);
+    packetJson["timestamp"] = packet.timestampDateTime().toString(Qt::ISODate);
     packetJson["sourceIP"] = packet.sourceIP;
     packetJson["destinationIP"] = packet.destinationIP;
     packetJson["protocolType"] = packet.protocolType;
@@ -268,13 +269,14 @@ void PacketTableView::onExportPacket()
     packetJson["packetLength"] = packet.packetLength;
     packetJson["rawData"] = QString(packet.rawData.toHex());
     
-    // Add protocol analysis if available
-    if (!packet.analysisResult.summary.isEmpty()) {
+    // Add protocol analysis; one packet, so dissecting it here is cheap
+    ProtocolAnalysisResult analysis = ProtocolAnalysisWrapper::analyzePacket(packet.rawData.bytes());
+    if (!analysis.summary.isEmpty()) {
         QJsonObject analysisJson;
-        analysisJson["summary"] = packet.analysisResult.summary;
-        analysisJson["hasError"] = packet.analysisResult.hasError;
-        if (packet.analysisResult.hasError) {
-            analysisJson["errorMessage"] = packet.analysisResult.errorMessage;
+        analysisJson["summary"] = analysis.summary;
+        analysisJson["hasError"] = analysis.hasError;
+        if (analysis.hasError) {
+            analysisJson["errorMessage"] = analysis.errorMessage;
         }
         packetJson["analysis"] = analysisJson;
     }
@@ -0,0 +1,64 @@
+#include "SelectionDissector.h"
+#include <QRunnable>
+
+namespace {
+
+// QThreadPool runs higher priorities first, FIFO within one
+const int SELECTION_PRIORITY = 1;
+const int PREFETCH_PRIORITY = 0;
+
+}
+
+SelectionDissector::SelectionDissector(QObject *parent)
+    : QObject(parent)
+    , results(CACHE_PACKETS)
+    , epoch(0)
+{
+    // One thread for the selection, one to keep the neighbours warm
+    pool.setMaxThreadCount(2);
+}
+
+SelectionDissector::~SelectionDissector() {
+    pool.clear();
+    pool.waitForDone();
+}
+
+const ProtocolAnalysisResult *SelectionDissector::cached(int serial) {
+    return results.object(serial);
+}
+
+void SelectionDissector::request(int serial, const PacketBytes &frame, bool prefetch) {
+    if (results.contains(serial) || queued.contains(serial)) {
+        return;
+    }
+    queued.insert(serial);
+
+    quint64 jobEpoch = epoch;
+    pool.start(QRunnable::create([this, jobEpoch, serial, frame]() {
+        ProtocolAnalysisResult result = ProtocolAnalysisWrapper::analyzePacket(frame.bytes());
+        QMetaObject::invokeMethod(this, [this, jobEpoch, serial, result]() {
+            onDissected(jobEpoch, serial, result);
+        }, Qt::QueuedConnection);
+    }), prefetch ? PREFETCH_PRIORITY : SELECTION_PRIORITY);
+}
+
+void SelectionDissector::cancelPending() {
+    pool.clear();
+    // Jobs already running still report back and are cached then
+    queued.clear();
+}
+
+void SelectionDissector::clear() {
+    cancelPending();
+    results.clear();
+    epoch++;
+}
+
+void SelectionDissector::onDissected(quint64 jobEpoch, int serial, const ProtocolAnalysisResult &result) {
+    if (jobEpoch != epoch) {
+        return;
+    }
+    queued.remove(serial);
+    results.insert(serial, new ProtocolAnalysisResult(result));
+    emit dissected(serial);
+}
@@ -0,0 +1,67 @@
+#ifndef SELECTIONDISSECTOR_H
+#define SELECTIONDISSECTOR_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QCache>
+#include <QSet>
+#include "Models/PacketModel.h"
+#include "Wrappers/ProtocolAnalysisWrapper.h"
+
+/**
+ * @brief Dissects selected packets, and the rows around them, off the GUI thread
+ *
+ * Results land in a bounded LRU keyed by serial number, so moving back
+ * and forth through the table is served from memory. Work for the
+ * selection is queued ahead of prefetches; cancelPending() drops whatever
+ * has not started yet when the user moves on. A packet that is already
+ * being dissected finishes and is cached.
+ */
+class SelectionDissector : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int CACHE_PACKETS = 256;
+    static constexpr int PREFETCH_ROWS = 8;
+
+    explicit SelectionDissector(QObject *parent = nullptr);
+    ~SelectionDissector();
+
+    /**
+     * @brief Cached dissection of serial, or nullptr; marks it recently used
+     */
+    const ProtocolAnalysisResult *cached(int serial);
+
+    /**
+     * @brief Dissect frame in the background unless it is cached or queued
+     * @param prefetch Queue behind every selection request
+     */
+    void request(int serial, const PacketBytes &frame, bool prefetch);
+
+    /**
+     * @brief Drop queued requests that have not started
+     */
+    void cancelPending();
+
+    /**
+     * @brief Forget everything; serial numbers are about to be reused
+     */
+    void clear();
+
+signals:
+    /**
+     * @brief serial is now in the cache
+     */
+    void dissected(int serial);
+
+private:
+    void onDissected(quint64 epoch, int serial, const ProtocolAnalysisResult &result);
+
+    QThreadPool pool;
+    QCache<int, ProtocolAnalysisResult> results;
+    QSet<int> queued;
+    quint64 epoch;  // Bumped by clear(); older results are discarded
+};
+
+#endif // SELECTIONDISSECTOR_H
@@ -2,7 +2,7 @@
 #include <QRegularExpression>
 #include <QHostAddress>
 
-QString DataValidator::lastError;
+thread_local QString DataValidator::lastError;
 
 bool DataValidator::isValidPacketInfo(const PacketInfo &packet) {
     if (packet.serialNumber <= 0) {
@@ -10,17 +10,21 @@ bool DataValidator::isValidPacketInfo(const PacketInfo &packet) {
         return false;
     }
     
-    if (!isValidTimestamp(packet.timestamp)) {
+    if (!isValidTimestamp(packet.timestampNs)) {
         setError("Invalid timestamp");
         return false;
     }
     
-    if (!isValidIPAddress(packet.sourceIP)) {
+    // Addresses and protocol names formatted from a decoded IP header need
+    // no re-parsing
+    bool decoded = packet.summary.l3 == PACKET_L3_IPV4 || packet.summary.l3 == PACKET_L3_IPV6;
+    
+    if (!decoded && !isValidIPAddress(packet.sourceIP)) {
         setError("Invalid source IP address");
         return false;
     }
     
-    if (!isValidIPAddress(packet.destinationIP)) {
+    if (!decoded && !isValidIPAddress(packet.destinationIP)) {
         setError("Invalid destination IP address");
         return false;
     }
@@ -30,7 +34,7 @@ bool DataValidator::isValidPacketInfo(const PacketInfo &packet) {
         return false;
     }
     
-    if (!isValidProtocolType(packet.protocolType)) {
+    if (!decoded && !isValidProtocolType(packet.protocolType)) {
         setError("Invalid protocol type");
         return false;
     }
@@ -83,19 +87,21 @@ bool DataValidator::isValidPacketLength(int length) {
     return length > 0 && length <= 65535;
 }
 
-bool DataValidator::isValidTimestamp(const QDateTime &timestamp) {
-    if (!timestamp.isValid()) {
+bool DataValidator::isValidTimestamp(qint64 timestampNs) {
+    if (timestampNs <= 0) {
         return false;
     }
     
+    // Compared in nanoseconds so the per-packet check needs no QDateTime math
+    qint64 nowNs = QDateTime::currentMSecsSinceEpoch() * 1000000;
+    
     // Timestamp should not be in the future (with some tolerance)
-    QDateTime now = QDateTime::currentDateTime();
-    QDateTime maxFuture = now.addSecs(60); // 1 minute tolerance
+    qint64 maxFuture = nowNs + 60 * NANOSECONDS_PER_SECOND; // 1 minute tolerance
     
     // Timestamp should not be too old (more than 1 year)
-    QDateTime minPast = now.addYears(-1);
+    qint64 minPast = nowNs - 366LL * 24 * 3600 * NANOSECONDS_PER_SECOND;
     
-    return timestamp >= minPast && timestamp <= maxFuture;
+    return timestampNs >= minPast && timestampNs <= maxFuture;
 }
 
 QString DataValidator::sanitizeIPAddress(const QString &ip) {
@@ -171,19 +177,23 @@ bool DataValidator::isValidProtocolLayer(const ProtocolLayer &layer) {
     }
     
     // Validate fields
-    QMapIterator<QString, QString> it(layer.fields);
-    while (it.hasNext()) {
-        it.next();
-        if (it.key().isEmpty()) {
+    for (const ProtocolField &field : layer.fields) {
+        if (field.name.isEmpty()) {
             setError("Protocol field has empty name");
             return false;
         }
-        if (it.key().length() > 100 || it.value().length() > 500) {
+        if (field.name.length() > 512 || field.value.length() > 512) {
             setError("Protocol field name or value too long");
             return false;
         }
     }
     
+    for (const ProtocolLayer &subLayer : layer.subLayers) {
+        if (!isValidProtocolLayer(subLayer)) {
+            return false;
+        }
+    }
+    
     return true;
 }
 
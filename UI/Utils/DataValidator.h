@@ -15,7 +15,7 @@ public:
     static bool isValidIPAddress(const QString &ip);
     static bool isValidProtocolType(const QString &protocol);
     static bool isValidPacketLength(int length);
-    static bool isValidTimestamp(const QDateTime &timestamp);
+    static bool isValidTimestamp(qint64 timestampNs);
     
     // Data sanitization
     static QString sanitizeIPAddress(const QString &ip);
@@ -33,7 +33,7 @@ public:
     static QString getLastError();
     
 private:
-    static QString lastError;
+    static thread_local QString lastError;  // Validation also runs on pool threads
     static void setError(const QString &error);
     
     // IP address validation helpers
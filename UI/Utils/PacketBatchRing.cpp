@@ -0,0 +1,164 @@
+#include "PacketBatchRing.h"
+
+// PacketBatchSlot implementation
+void PacketBatchSlot::appendPacket(const char *packet, int length, qint64 timestampNs, int wireLength) {
+    PacketRecord record;
+    record.offset = data.size();
+    record.length = length;
+    record.wireLength = qMax(length, wireLength);
+    record.timestampNs = timestampNs;
+
+    data.append(packet, length);
+    records.append(record);
+}
+
+void PacketBatchSlot::appendBlock(const TPacketBlockBatch &block) {
+    blocks.append(block);
+    blockFrameCount += block->frames.size();
+}
+
+int PacketBatchSlot::packetCount() const {
+    return records.size() + summaries.size() + blockFrameCount;
+}
+
+bool PacketBatchSlot::isEmpty() const {
+    return packetCount() == 0;
+}
+
+void PacketBatchSlot::reset() {
+    // resize(0)/clear() on unshared Qt6 containers keep their allocation
+    data.resize(0);
+    records.resize(0);
+    blocks.clear();
+    summaries.clear();
+    blockFrameCount = 0;
+}
+
+// PacketBatchRing implementation
+PacketBatchRing::PacketBatchRing(int slotCount, int slotBytes, int slotPackets)
+    : batchSlots(qMax(2, slotCount))
+    , writeIndex(0)
+    , readIndex(0)
+    , wakePending(false)
+    , credits(qMax(2, slotCount))
+    , peakOccupancy(0)
+    , overflowCount(0)
+    , overflowPackets(0)
+{
+    for (PacketBatchSlot &slot : batchSlots) {
+        slot.data.reserve(slotBytes);
+        slot.records.reserve(slotPackets);
+    }
+}
+
+PacketBatchSlot *PacketBatchRing::beginWrite() {
+    quint64 head = writeIndex.load(std::memory_order_relaxed);
+    quint64 tail = readIndex.load(std::memory_order_acquire);
+
+    if (head - tail >= static_cast<quint64>(batchSlots.size())) {
+        return nullptr;
+    }
+    return &batchSlots[static_cast<int>(head % batchSlots.size())];
+}
+
+bool PacketBatchRing::commitWrite() {
+    quint64 head = writeIndex.load(std::memory_order_relaxed) + 1;
+    writeIndex.store(head, std::memory_order_release);
+
+    int used = static_cast<int>(head - readIndex.load(std::memory_order_relaxed));
+    if (used > peakOccupancy.load(std::memory_order_relaxed)) {
+        peakOccupancy.store(used, std::memory_order_relaxed);
+    }
+
+    // Coalesce: only the transition from idle asks for a notification
+    return !wakePending.exchange(true, std::memory_order_acq_rel);
+}
+
+void PacketBatchRing::noteOverflow(int droppedPackets) {
+    overflowCount.fetch_add(1, std::memory_order_relaxed);
+    overflowPackets.fetch_add(static_cast<quint64>(droppedPackets), std::memory_order_relaxed);
+}
+
+void PacketBatchRing::noteDropped(int droppedPackets) {
+    overflowPackets.fetch_add(static_cast<quint64>(droppedPackets), std::memory_order_relaxed);
+}
+
+PacketBatchSlot *PacketBatchRing::beginRead() {
+    quint64 tail = readIndex.load(std::memory_order_relaxed);
+    if (tail == writeIndex.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &batchSlots[static_cast<int>(tail % batchSlots.size())];
+}
+
+PacketBatchSlot *PacketBatchRing::peekRead(int ahead) {
+    quint64 position = readIndex.load(std::memory_order_relaxed) + static_cast<quint64>(ahead);
+    if (position >= writeIndex.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &batchSlots[static_cast<int>(position % batchSlots.size())];
+}
+
+void PacketBatchRing::endRead() {
+    readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool PacketBatchRing::finishDrain(int inFlight) {
+    wakePending.store(false, std::memory_order_seq_cst);
+
+    if (occupancy() <= inFlight) {
+        return false;
+    }
+
+    // A batch was committed between the last read and clearing the flag.
+    // Keep draining unless the producer already queued a fresh notification.
+    return !wakePending.exchange(true, std::memory_order_acq_rel);
+}
+
+int PacketBatchRing::availableCredits() const {
+    return credits.load(std::memory_order_acquire);
+}
+
+void PacketBatchRing::spendCredit() {
+    credits.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void PacketBatchRing::grantCredits(int count) {
+    // Never more credits than slots, whatever the consumer grants
+    int current = credits.load(std::memory_order_relaxed);
+    int granted;
+    do {
+        granted = qMin(capacity(), current + count);
+    } while (!credits.compare_exchange_weak(current, granted, std::memory_order_acq_rel));
+}
+
+void PacketBatchRing::resetCredits() {
+    credits.store(capacity() - occupancy(), std::memory_order_release);
+}
+
+int PacketBatchRing::capacity() const {
+    return batchSlots.size();
+}
+
+int PacketBatchRing::occupancy() const {
+    return static_cast<int>(writeIndex.load(std::memory_order_acquire) -
+                            readIndex.load(std::memory_order_acquire));
+}
+
+int PacketBatchRing::highWatermark() const {
+    return peakOccupancy.load(std::memory_order_relaxed);
+}
+
+quint64 PacketBatchRing::overflowEvents() const {
+    return overflowCount.load(std::memory_order_relaxed);
+}
+
+quint64 PacketBatchRing::droppedPackets() const {
+    return overflowPackets.load(std::memory_order_relaxed);
+}
+
+void PacketBatchRing::resetCounters() {
+    peakOccupancy.store(occupancy(), std::memory_order_relaxed);
+    overflowCount.store(0, std::memory_order_relaxed);
+    overflowPackets.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,168 @@
+#ifndef PACKETBATCHRING_H
+#define PACKETBATCHRING_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSharedPointer>
+#include <QVector>
+#include <atomic>
+#include "../Models/PacketModel.h"
+
+extern "C" {
+    #include "../../src/packetcapture/tpacket_ring.h"
+}
+
+/**
+ * @brief Owns an open TPACKET_V3 ring
+ *
+ * Shared between the capture worker and every block still in flight so the
+ * mapping is only torn down once nothing points into it.
+ */
+class TPacketRingHandle
+{
+public:
+    TPacketRingHandle() : ring() { ring.fd = -1; }
+    ~TPacketRingHandle() { tpacket_ring_close(&ring); }
+
+    tpacket_ring_t ring;
+};
+
+/**
+ * @brief A retired ring block handed from a worker to the controller
+ *
+ * Frames are read in place from the mapping; the block is returned to the
+ * kernel when the last reference goes away.
+ */
+class TPacketBlockLease
+{
+public:
+    TPacketBlockLease(const QSharedPointer<TPacketRingHandle> &ring, struct tpacket_block_desc *block)
+        : ring(ring), block(block) {}
+    ~TPacketBlockLease() { tpacket_ring_release_block(&ring->ring, block); }
+
+    // Frames that passed sampling, in capture order
+    QVector<const struct tpacket3_hdr*> frames;
+
+private:
+    QSharedPointer<TPacketRingHandle> ring;
+    struct tpacket_block_desc *block;
+};
+
+typedef QSharedPointer<TPacketBlockLease> TPacketBlockBatch;
+
+/**
+ * @brief Location of one copied packet inside a batch slot's arena
+ */
+struct PacketRecord {
+    int offset;
+    int length;
+    int wireLength;  // Original length on the wire, >= length
+    qint64 timestampNs;
+};
+
+/**
+ * @brief One reusable batch slot
+ *
+ * Copied packets are packed back to back in @c data. Slots keep their
+ * capacity across reuse, so a warmed-up ring does not allocate per batch.
+ * A slot may instead carry zero-copy ring blocks or, for fanout workers,
+ * packets already summarized on the worker thread.
+ */
+struct PacketBatchSlot {
+    QByteArray data;
+    QVector<PacketRecord> records;
+    QList<TPacketBlockBatch> blocks;
+    QList<PacketInfo> summaries;
+    int blockFrameCount = 0;
+
+    void appendPacket(const char *packet, int length, qint64 timestampNs, int wireLength = -1);
+    void appendBlock(const TPacketBlockBatch &block);
+    int packetCount() const;
+    bool isEmpty() const;
+
+    /**
+     * @brief Empty the slot without giving up its capacity; releases held blocks
+     */
+    void reset();
+};
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of batch slots
+ *
+ * The capture worker fills the slot returned by beginWrite() and publishes
+ * it with commitWrite(); the controller reads slots in order with
+ * beginRead()/endRead(). When the ring is full the producer counts an
+ * overflow instead of blocking. Only the first commit after the consumer
+ * went idle asks for a wake-up, so one queued notification covers any
+ * number of batches.
+ *
+ * The ring also carries batch credits for flow control: it starts with one
+ * credit per slot, the producer spends one per committed batch and the
+ * consumer grants it back once the batch has been absorbed downstream, not
+ * merely read. The producer can see how far behind the consumer is and
+ * degrade before the ring is full.
+ */
+class PacketBatchRing
+{
+public:
+    static constexpr int DEFAULT_SLOT_COUNT = 32;
+    static constexpr int DEFAULT_SLOT_BYTES = 256 * 1024;
+    static constexpr int DEFAULT_SLOT_PACKETS = 512;
+
+    explicit PacketBatchRing(int slotCount = DEFAULT_SLOT_COUNT,
+                             int slotBytes = DEFAULT_SLOT_BYTES,
+                             int slotPackets = DEFAULT_SLOT_PACKETS);
+
+    // Producer side (capture worker thread)
+    PacketBatchSlot *beginWrite();
+    bool commitWrite();  // true if the consumer must be notified
+    void noteOverflow(int droppedPackets);
+    void noteDropped(int droppedPackets);  // More losses of an overflow already noted
+
+    // Consumer side (controller thread)
+    PacketBatchSlot *beginRead();
+    void endRead();
+
+    /**
+     * @brief Committed slot @p ahead positions past the oldest unreleased one
+     *
+     * Lets the consumer work on several slots at once; they are still
+     * released oldest first with endRead(). nullptr if not committed yet.
+     */
+    PacketBatchSlot *peekRead(int ahead);
+
+    /**
+     * @brief Called by the consumer once it has taken every committed slot
+     * @param inFlight slots taken with peekRead() that are not released yet
+     * @return true if batches raced in and the consumer should keep draining
+     */
+    bool finishDrain(int inFlight = 0);
+
+    // Batch credits
+    int availableCredits() const;
+    void spendCredit();
+    void grantCredits(int count);
+    void resetCredits();
+
+    int capacity() const;
+    int occupancy() const;
+    int highWatermark() const;
+    quint64 overflowEvents() const;
+    quint64 droppedPackets() const;
+    void resetCounters();
+
+private:
+    QVector<PacketBatchSlot> batchSlots;
+
+    // Producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<quint64> writeIndex;
+    alignas(64) std::atomic<quint64> readIndex;
+    alignas(64) std::atomic<bool> wakePending;
+    alignas(64) std::atomic<int> credits;
+
+    std::atomic<int> peakOccupancy;
+    std::atomic<quint64> overflowCount;
+    std::atomic<quint64> overflowPackets;
+};
+
+#endif // PACKETBATCHRING_H
@@ -1,63 +1,76 @@
 #include "PacketInfoGenerator.h"
 #include <QRegularExpression>
 #include <QStringList>
+#include <netinet/in.h>
 
 QString PacketInfoGenerator::generateMoreInfo(const QString &protocolType, 
                                              const QString &sourceIP, 
                                              const QString &destinationIP,
                                              int packetLength,
-                                             const QByteArray &rawData)
+                                             const QByteArray &rawData,
+                                             const packet_summary_t &summary)
 {
     QString info;
     
-    // Protocol-specific information
-    if (protocolType.contains("TCP", Qt::CaseInsensitive)) {
-        info = generateTcpInfo(rawData, sourceIP, destinationIP);
-    }
-    else if (protocolType.contains("HTTP", Qt::CaseInsensitive) && !protocolType.contains("HTTPS", Qt::CaseInsensitive)) {
+    // Protocol-specific information, keyed on the same port registry
+    // verdict that named the protocol column
+    switch (summary.app_proto) {
+    case PORT_APP_HTTP:
         info = generateHttpInfo(rawData);
         if (info.isEmpty()) {
             info = "HTTP Traffic";
         }
-    }
-    else if (protocolType.contains("HTTPS", Qt::CaseInsensitive) || protocolType.contains("TLS", Qt::CaseInsensitive)) {
+        break;
+    case PORT_APP_HTTPS:
         info = generateTlsInfo(rawData);
         if (info.isEmpty()) {
             info = "HTTPS/TLS Traffic";
         }
-    }
-    else if (protocolType.contains("DNS", Qt::CaseInsensitive)) {
-        info = generateDnsInfo(rawData);
-    }
-    else if (protocolType.contains("SSH", Qt::CaseInsensitive)) {
+        break;
+    case PORT_APP_DNS:
+        info = generateDnsInfo(rawData, summary);
+        break;
+    case PORT_APP_SSH:
         info = generateSshInfo(rawData);
         if (info.isEmpty()) {
             info = "SSH Encrypted Traffic";
         }
-    }
-    else if (protocolType.contains("DHCP", Qt::CaseInsensitive)) {
-        info = generateDhcpInfo(rawData);
-    }
-    else if (protocolType.contains("ARP", Qt::CaseInsensitive)) {
-        info = generateArpInfo(rawData);
-    }
-    else if (protocolType.contains("ICMP", Qt::CaseInsensitive)) {
-        info = generateIcmpInfo(rawData);
-    }
-    else if (protocolType.contains("FTP", Qt::CaseInsensitive)) {
+        break;
+    case PORT_APP_DHCP:
+        info = generateDhcpInfo(rawData, summary);
+        break;
+    case PORT_APP_FTP:
         info = generateFtpInfo(rawData);
         if (info.isEmpty()) {
             info = "FTP Unencrypted";
         }
-    }
-    else if (protocolType.contains("SMTP", Qt::CaseInsensitive)) {
+        break;
+    case PORT_APP_SMTP:
         info = generateSmtpInfo(rawData);
         if (info.isEmpty()) {
             info = "SMTP Mail Transfer";
         }
-    }
-    else if (protocolType.contains("UDP", Qt::CaseInsensitive)) {
-        info = QString("UDP %1 → %2").arg(sourceIP, destinationIP);
+        break;
+    case PORT_APP_NONE:
+        if (summary.l3 == PACKET_L3_ARP) {
+            info = generateArpInfo(rawData);
+        } else if (summary.l4_proto == IPPROTO_ICMP || summary.l4_proto == IPPROTO_ICMPV6) {
+            info = generateIcmpInfo(rawData, summary);
+        } else if (summary.l4_proto == IPPROTO_TCP) {
+            info = generateTcpInfo(summary, sourceIP, destinationIP);
+        } else if (summary.l4_proto == IPPROTO_UDP) {
+            info = QString("UDP %1 → %2").arg(sourceIP, destinationIP);
+        }
+        break;
+    default:
+        // Registered protocols without a generator of their own (NTP,
+        // QUIC, SNMP, ...) get the same text as their transport
+        if (summary.l4_proto == IPPROTO_TCP) {
+            info = generateTcpInfo(summary, sourceIP, destinationIP);
+        } else if (summary.l4_proto == IPPROTO_UDP) {
+            info = QString("UDP %1 → %2").arg(sourceIP, destinationIP);
+        }
+        break;
     }
     
     // Add security indicators
@@ -79,27 +92,16 @@ QString PacketInfoGenerator::generateMoreInfo(const QString &protocolType,
     return info;
 }
 
-QString PacketInfoGenerator::generateTcpInfo(const QByteArray &rawData, const QString &sourceIP, const QString &destinationIP)
+QString PacketInfoGenerator::generateTcpInfo(const packet_summary_t &summary, const QString &sourceIP, const QString &destinationIP)
 {
-    if (rawData.size() < 54) return QString(); // Ethernet + IP + TCP minimum
-    
-    // Skip Ethernet (14) and IP (20) headers to get to TCP
-    int tcpOffset = 34;
-    if (rawData.size() < tcpOffset + 20) return QString();
+    // Header fields come from the decoder, which honours IP options and IPv6
+    if (!(summary.flags & PACKET_SUMMARY_HAS_TCP)) return QString();
     
-    const unsigned char *tcpHeader = reinterpret_cast<const unsigned char*>(rawData.data() + tcpOffset);
-    
-    // Extract TCP flags (byte 13 of TCP header)
-    unsigned char flags = tcpHeader[13];
-    QString flagStr = extractTcpFlags(QByteArray(reinterpret_cast<const char*>(&flags), 1));
-    
-    // Extract ports (bytes 0-1 source, 2-3 destination)
-    unsigned short srcPort = (tcpHeader[0] << 8) | tcpHeader[1];
-    unsigned short dstPort = (tcpHeader[2] << 8) | tcpHeader[3];
-    
-    // Extract sequence and ack numbers
-    unsigned int seqNum = (tcpHeader[4] << 24) | (tcpHeader[5] << 16) | (tcpHeader[6] << 8) | tcpHeader[7];
-    unsigned int ackNum = (tcpHeader[8] << 24) | (tcpHeader[9] << 16) | (tcpHeader[10] << 8) | tcpHeader[11];
+    unsigned char flags = summary.tcp_flags;
+    unsigned short srcPort = summary.src_port;
+    unsigned short dstPort = summary.dst_port;
+    unsigned int seqNum = summary.tcp_seq;
+    unsigned int ackNum = summary.tcp_ack;
     
     QString info;
     
@@ -127,6 +129,9 @@ QString PacketInfoGenerator::generateTcpInfo(const QByteArray &rawData, const QS
     // Add sequence info for data packets
     if ((flags & 0x08) || (flags & 0x18)) { // PSH or PSH+ACK
         info += QString(" Seq=%1").arg(seqNum);
+        if (flags & 0x10) {
+            info += QString(" Ack=%1").arg(ackNum);
+        }
     }
     
     // Check for well-known ports and add application hints
@@ -181,12 +186,12 @@ QString PacketInfoGenerator::generateHttpInfo(const QByteArray &rawData)
     return QString();
 }
 
-QString PacketInfoGenerator::generateDnsInfo(const QByteArray &rawData)
+QString PacketInfoGenerator::generateDnsInfo(const QByteArray &rawData, const packet_summary_t &summary)
 {
-    if (rawData.size() < 42) return QString(); // Ethernet + IP + UDP + DNS minimum
+    if (!(summary.flags & PACKET_SUMMARY_HAS_PORTS)) return QString();
     
-    // Skip to DNS header (Ethernet 14 + IP 20 + UDP 8 = 42)
-    int dnsOffset = 42;
+    // DNS header follows the UDP header
+    int dnsOffset = summary.payload_offset;
     if (rawData.size() < dnsOffset + 12) return QString();
     
     const unsigned char *dnsHeader = reinterpret_cast<const unsigned char*>(rawData.data() + dnsOffset);
@@ -268,12 +273,12 @@ QString PacketInfoGenerator::generateTlsInfo(const QByteArray &rawData)
     return QString();
 }
 
-QString PacketInfoGenerator::generateDhcpInfo(const QByteArray &rawData)
+QString PacketInfoGenerator::generateDhcpInfo(const QByteArray &rawData, const packet_summary_t &summary)
 {
-    if (rawData.size() < 282) return QString(); // Minimum DHCP packet size
+    if (!(summary.flags & PACKET_SUMMARY_HAS_PORTS)) return QString();
     
-    // DHCP starts after Ethernet + IP + UDP (42 bytes)
-    int dhcpOffset = 42;
+    // DHCP starts after the UDP header
+    int dhcpOffset = summary.payload_offset;
     if (rawData.size() < dhcpOffset + 240) return QString();
     
     const unsigned char *dhcpHeader = reinterpret_cast<const unsigned char*>(rawData.data() + dhcpOffset);
@@ -332,12 +337,12 @@ QString PacketInfoGenerator::generateArpInfo(const QByteArray &rawData)
     return QString("ARP Opcode %1").arg(opcode);
 }
 
-QString PacketInfoGenerator::generateIcmpInfo(const QByteArray &rawData)
+QString PacketInfoGenerator::generateIcmpInfo(const QByteArray &rawData, const packet_summary_t &summary)
 {
-    if (rawData.size() < 42) return QString(); // Minimum ICMP packet
+    // ICMP starts right after the IP header (options included)
+    if (summary.l4_proto != IPPROTO_ICMP || rawData.size() < summary.payload_offset + 8) return QString();
     
-    // ICMP starts after Ethernet + IP headers (34 bytes minimum)
-    const unsigned char *icmpHeader = reinterpret_cast<const unsigned char*>(rawData.data() + 34);
+    const unsigned char *icmpHeader = reinterpret_cast<const unsigned char*>(rawData.data() + summary.payload_offset);
     
     unsigned char type = icmpHeader[0];
     unsigned char code = icmpHeader[1];
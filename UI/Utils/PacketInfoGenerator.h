@@ -4,6 +4,10 @@
 #include <QString>
 #include <QByteArray>
 
+extern "C" {
+    #include "../../src/packetcapture/packet_summary.h"
+}
+
 class PacketInfoGenerator
 {
 public:
@@ -11,17 +15,18 @@ public:
                                    const QString &sourceIP, 
                                    const QString &destinationIP,
                                    int packetLength,
-                                   const QByteArray &rawData);
+                                   const QByteArray &rawData,
+                                   const packet_summary_t &summary);
 
 private:
-    static QString generateTcpInfo(const QByteArray &rawData, const QString &sourceIP, const QString &destinationIP);
+    static QString generateTcpInfo(const packet_summary_t &summary, const QString &sourceIP, const QString &destinationIP);
     static QString generateHttpInfo(const QByteArray &rawData);
-    static QString generateDnsInfo(const QByteArray &rawData);
+    static QString generateDnsInfo(const QByteArray &rawData, const packet_summary_t &summary);
     static QString generateSshInfo(const QByteArray &rawData);
     static QString generateTlsInfo(const QByteArray &rawData);
-    static QString generateDhcpInfo(const QByteArray &rawData);
+    static QString generateDhcpInfo(const QByteArray &rawData, const packet_summary_t &summary);
     static QString generateArpInfo(const QByteArray &rawData);
-    static QString generateIcmpInfo(const QByteArray &rawData);
+    static QString generateIcmpInfo(const QByteArray &rawData, const packet_summary_t &summary);
     static QString generateFtpInfo(const QByteArray &rawData);
     static QString generateSmtpInfo(const QByteArray &rawData);
     
@@ -0,0 +1,187 @@
+#include "PacketSlab.h"
+
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+    #include <sys/mman.h>
+}
+
+namespace {
+// Smallest huge page size on the platforms we run on; MAP_HUGETLB needs
+// lengths that are a multiple of it
+const int HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+}
+
+std::atomic<int> PacketSlab::totalSlabs(0);
+std::atomic<qint64> PacketSlab::totalBytes(0);
+
+// PacketSlab implementation
+PacketSlab::PacketSlab(char *base, int capacity, Backing backing)
+    : base(base)
+    , slabCapacity(capacity)
+    , slabUsed(0)
+    , backing(backing)
+{
+    totalSlabs.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(capacity, std::memory_order_relaxed);
+}
+
+PacketSlab::~PacketSlab() {
+    if (backing == PageMapping || backing == HugePageMapping) {
+        munmap(base, static_cast<size_t>(slabCapacity));
+    }
+    totalSlabs.fetch_sub(1, std::memory_order_relaxed);
+    totalBytes.fetch_sub(slabCapacity, std::memory_order_relaxed);
+}
+
+QSharedPointer<PacketSlab> PacketSlab::create(int capacity, bool hugePages) {
+    if (capacity <= 0) {
+        return QSharedPointer<PacketSlab>();
+    }
+
+    void *map = MAP_FAILED;
+    Backing backing = PageMapping;
+
+#ifdef MAP_HUGETLB
+    if (hugePages) {
+        int hugeCapacity = (capacity + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+        map = mmap(nullptr, static_cast<size_t>(hugeCapacity), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (map != MAP_FAILED) {
+            capacity = hugeCapacity;
+            backing = HugePageMapping;
+        }
+    }
+#endif
+
+    if (map == MAP_FAILED) {
+        // No reserved huge pages: use normal pages and let THP back them if it can
+        map = mmap(nullptr, static_cast<size_t>(capacity), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            qWarning() << "PacketSlab: failed to map" << capacity << "byte slab:" << strerror(errno);
+            return QSharedPointer<PacketSlab>();
+        }
+#ifdef MADV_HUGEPAGE
+        if (hugePages) {
+            madvise(map, static_cast<size_t>(capacity), MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    return QSharedPointer<PacketSlab>(new PacketSlab(static_cast<char*>(map), capacity, backing));
+}
+
+QSharedPointer<PacketSlab> PacketSlab::adopt(const QByteArray &bytes) {
+    // Shares the QByteArray's buffer; constData() on an unshared copy never detaches
+    PacketSlab *slab = new PacketSlab(nullptr, bytes.size(), AdoptedBytes);
+    slab->adopted = bytes;
+    slab->base = const_cast<char*>(slab->adopted.constData());
+    slab->slabUsed = bytes.size();
+    return QSharedPointer<PacketSlab>(slab);
+}
+
+QSharedPointer<PacketSlab> PacketSlab::wrap(const char *data, int length, const QSharedPointer<const void> &owner) {
+    PacketSlab *slab = new PacketSlab(const_cast<char*>(data), length, ExternalBytes);
+    slab->externalOwner = owner;
+    slab->slabUsed = length;
+    return QSharedPointer<PacketSlab>(slab);
+}
+
+int PacketSlab::append(const char *data, int length) {
+    if (backing == AdoptedBytes || backing == ExternalBytes || length > remaining()) {
+        return -1;
+    }
+
+    int offset = slabUsed;
+    memcpy(base + offset, data, static_cast<size_t>(length));
+    slabUsed += length;
+    return offset;
+}
+
+int PacketSlab::liveSlabs() {
+    return totalSlabs.load(std::memory_order_relaxed);
+}
+
+qint64 PacketSlab::liveBytes() {
+    return totalBytes.load(std::memory_order_relaxed);
+}
+
+// PacketSlice implementation
+PacketSlice::PacketSlice(const QByteArray &bytes)
+    : sliceOffset(0)
+    , sliceLength(bytes.size())
+{
+    if (!bytes.isEmpty()) {
+        slab = PacketSlab::adopt(bytes);
+    }
+}
+
+QByteArray PacketSlice::bytes() const {
+    if (isEmpty()) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(constData(), sliceLength);
+}
+
+QByteArray PacketSlice::toByteArray() const {
+    if (isEmpty()) {
+        return QByteArray();
+    }
+    return QByteArray(constData(), sliceLength);
+}
+
+QByteArray PacketSlice::toHex() const {
+    return bytes().toHex();
+}
+
+void PacketSlice::clear() {
+    slab.reset();
+    sliceOffset = 0;
+    sliceLength = 0;
+}
+
+// PacketSlabStore implementation
+PacketSlabStore::PacketSlabStore(int slabBytes, bool hugePages)
+    : slabBytes(slabBytes)
+    , useHugePages(hugePages)
+    , allocatedSlabs(0)
+{
+}
+
+PacketSlice PacketSlabStore::append(const char *data, int length) {
+    if (length <= 0) {
+        return PacketSlice();
+    }
+
+    // Frames larger than a slab get their own buffer
+    if (length > slabBytes) {
+        return PacketSlice(QByteArray(data, length));
+    }
+
+    int offset = current ? current->append(data, length) : -1;
+    if (offset < 0) {
+        // Roll over; the old slab stays alive while any slice points into it
+        current = PacketSlab::create(slabBytes, useHugePages);
+        if (!current) {
+            return PacketSlice(QByteArray(data, length));
+        }
+        allocatedSlabs++;
+        offset = current->append(data, length);
+    }
+
+    return PacketSlice(current, offset, length);
+}
+
+void PacketSlabStore::setHugePagesEnabled(bool enabled) {
+    if (useHugePages != enabled) {
+        useHugePages = enabled;
+        current.reset();
+    }
+}
+
+void PacketSlabStore::reset() {
+    current.reset();
+}
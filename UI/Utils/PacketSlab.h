@@ -0,0 +1,151 @@
+#ifndef PACKETSLAB_H
+#define PACKETSLAB_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <atomic>
+
+/**
+ * @brief One large contiguous buffer that captured frames are packed into
+ *
+ * A slab is filled front to back by a single PacketSlabStore and never
+ * written behind a handed-out slice, so readers on other threads only ever
+ * see immutable bytes. Slabs are reference counted through the slices that
+ * point into them; the memory goes back to the system when the last packet
+ * stored in it is evicted.
+ */
+class PacketSlab
+{
+public:
+    /**
+     * @brief Map a new empty slab
+     * @param capacity Size in bytes
+     * @param hugePages Try MAP_HUGETLB first, then fall back to regular pages
+     * @return nullptr if the mapping failed
+     */
+    static QSharedPointer<PacketSlab> create(int capacity, bool hugePages);
+
+    /**
+     * @brief Wrap existing bytes as a full, read-only slab without copying
+     */
+    static QSharedPointer<PacketSlab> adopt(const QByteArray &bytes);
+
+    /**
+     * @brief Wrap read-only memory owned elsewhere, e.g. a mapped capture file
+     * @param owner Kept alive for as long as the slab is referenced
+     */
+    static QSharedPointer<PacketSlab> wrap(const char *data, int length, const QSharedPointer<const void> &owner);
+
+    ~PacketSlab();
+
+    const char *constData() const { return base; }
+    int capacity() const { return slabCapacity; }
+    int used() const { return slabUsed; }
+    int remaining() const { return slabCapacity - slabUsed; }
+    bool isHugePageBacked() const { return backing == HugePageMapping; }
+
+    /**
+     * @brief Copy a frame to the end of the slab
+     * @return Offset of the frame, or -1 if it does not fit
+     */
+    int append(const char *data, int length);
+
+    // Process-wide totals for diagnostics
+    static int liveSlabs();
+    static qint64 liveBytes();
+
+private:
+    enum Backing {
+        PageMapping,
+        HugePageMapping,
+        AdoptedBytes,
+        ExternalBytes
+    };
+
+    PacketSlab(char *base, int capacity, Backing backing);
+    Q_DISABLE_COPY(PacketSlab)
+
+    char *base;
+    int slabCapacity;
+    int slabUsed;
+    Backing backing;
+    QByteArray adopted;
+    QSharedPointer<const void> externalOwner;
+
+    static std::atomic<int> totalSlabs;
+    static std::atomic<qint64> totalBytes;
+};
+
+/**
+ * @brief Reference-counted (slab, offset, length) view of one packet
+ *
+ * Offers the read-only subset of QByteArray that packet consumers use.
+ * bytes() is a zero-copy QByteArray that is only valid while the slice is
+ * alive; use toByteArray() for anything that keeps the data.
+ */
+class PacketSlice
+{
+public:
+    PacketSlice() : sliceOffset(0), sliceLength(0) {}
+    PacketSlice(const QSharedPointer<PacketSlab> &slab, int offset, int length)
+        : slab(slab), sliceOffset(offset), sliceLength(length) {}
+
+    // Lets code that still builds packets from a QByteArray assign it directly
+    PacketSlice(const QByteArray &bytes);
+
+    const char *constData() const { return slab ? slab->constData() + sliceOffset : nullptr; }
+    const char *data() const { return constData(); }
+    int size() const { return sliceLength; }
+    int length() const { return sliceLength; }
+    bool isEmpty() const { return sliceLength == 0; }
+    char at(int i) const { return constData()[i]; }
+    char operator[](int i) const { return at(i); }
+
+    QByteArray bytes() const;
+    QByteArray toByteArray() const;
+    QByteArray toHex() const;
+    void clear();
+
+    // For stores that keep the slab and the offset apart
+    const QSharedPointer<PacketSlab> &sharedSlab() const { return slab; }
+    int offset() const { return sliceOffset; }
+
+private:
+    QSharedPointer<PacketSlab> slab;
+    int sliceOffset;
+    int sliceLength;
+};
+
+/**
+ * @brief Appends packets into a rolling series of slabs
+ *
+ * Owned by exactly one thread. Only the slab currently being filled is held
+ * here; full slabs live on through the slices that reference them.
+ */
+class PacketSlabStore
+{
+public:
+    static constexpr int DEFAULT_SLAB_BYTES = 4 * 1024 * 1024;
+
+    explicit PacketSlabStore(int slabBytes = DEFAULT_SLAB_BYTES, bool hugePages = false);
+
+    PacketSlice append(const char *data, int length);
+
+    void setHugePagesEnabled(bool enabled);
+    bool hugePagesEnabled() const { return useHugePages; }
+    int slabSize() const { return slabBytes; }
+    quint64 slabsAllocated() const { return allocatedSlabs; }
+
+    /**
+     * @brief Drop the current slab; existing slices stay valid
+     */
+    void reset();
+
+private:
+    QSharedPointer<PacketSlab> current;
+    int slabBytes;
+    bool useHugePages;
+    quint64 allocatedSlabs;
+};
+
+#endif // PACKETSLAB_H
@@ -310,6 +310,17 @@ int SettingsManager::getCaptureTimeout() const
     return m_settings->value(getCategoryKey(Capture, "timeout"), m_defaults.defaultCaptureTimeout).toInt();
 }
 
+void SettingsManager::setDecodeAsRules(const QStringList &rules)
+{
+    m_settings->setValue(getCategoryKey(Capture, "decode_as"), rules);
+    emit settingChanged("capture/decode_as", rules);
+}
+
+QStringList SettingsManager::getDecodeAsRules() const
+{
+    return m_settings->value(getCategoryKey(Capture, "decode_as")).toStringList();
+}
+
 // Display settings
 void SettingsManager::setPacketTableColumns(const QStringList &columns)
 {
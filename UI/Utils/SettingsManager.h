@@ -99,6 +99,10 @@ public:
     
     void setCaptureTimeout(int timeoutSeconds);
     int getCaptureTimeout() const;
+    
+    // Port registry overrides, "tcp/8080=http" style
+    void setDecodeAsRules(const QStringList &rules);
+    QStringList getDecodeAsRules() const;
 
     // Display settings
     void setPacketTableColumns(const QStringList &columns);
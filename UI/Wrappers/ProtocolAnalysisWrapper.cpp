@@ -1,10 +1,8 @@
 #include "ProtocolAnalysisWrapper.h"
 #include "../Utils/NetworkInterfaceManager.h"
 #include <QDebug>
-#include <QProcess>
-#include <QTemporaryFile>
 #include <QTextStream>
-#include <QRegularExpression>
+#include <QVector>
 #include <QHostAddress>
 #include <QDateTime>
 #include <netinet/ip.h>
@@ -12,92 +10,94 @@
 #include <netinet/udp.h>
 #include <netinet/if_ether.h>
 #include <arpa/inet.h>
-#include <unistd.h>
-#include <fcntl.h>
-#include <sys/wait.h>
 
-// Output redirection helper class
-class StdoutRedirector {
-private:
-    int originalStdout;
-    int pipefd[2];
-    QString capturedOutput;
+namespace {
+
+// Builds ProtocolLayers from the dissector's visitor callbacks
+struct LayerTreeBuilder {
+    QList<ProtocolLayer> layers;
+    QList<ProtocolLayer> openLayers;
     
-public:
-    StdoutRedirector() : originalStdout(-1) {
-        if (pipe(pipefd) == -1) {
-            qWarning() << "Failed to create pipe for stdout redirection";
-            return;
+    void close() {
+        ProtocolLayer layer = openLayers.takeLast();
+        if (openLayers.isEmpty()) {
+            layers.append(layer);
+        } else {
+            openLayers.last().subLayers.append(layer);
         }
-        
-        // Make read end non-blocking
-        int flags = fcntl(pipefd[0], F_GETFL);
-        fcntl(pipefd[0], F_SETFL, flags | O_NONBLOCK);
-    }
-    
-    ~StdoutRedirector() {
-        restore();
-        if (pipefd[0] != -1) close(pipefd[0]);
-        if (pipefd[1] != -1) close(pipefd[1]);
     }
     
-    bool redirect() {
-        if (pipefd[1] == -1) return false;
-        
-        // Save original stdout
-        originalStdout = dup(STDOUT_FILENO);
-        if (originalStdout == -1) {
-            qWarning() << "Failed to duplicate stdout";
-            return false;
-        }
-        
-        // Redirect stdout to pipe
-        if (dup2(pipefd[1], STDOUT_FILENO) == -1) {
-            qWarning() << "Failed to redirect stdout";
-            close(originalStdout);
-            originalStdout = -1;
-            return false;
+    QList<ProtocolLayer> finish() {
+        while (!openLayers.isEmpty()) {
+            close();
         }
-        
-        return true;
+        return layers;
     }
-    
-    void restore() {
-        if (originalStdout != -1) {
-            // Flush any remaining output
-            fflush(stdout);
-            
-            // Restore original stdout
-            dup2(originalStdout, STDOUT_FILENO);
-            close(originalStdout);
-            originalStdout = -1;
-        }
+};
+
+LayerTreeBuilder *builderOf(const dissect_ctx_t *ctx) {
+    return static_cast<LayerTreeBuilder*>(ctx->opaque);
+}
+
+void onBeginLayer(const dissect_ctx_t *ctx, const char *name, int offset, int length) {
+    LayerTreeBuilder *builder = builderOf(ctx);
+    ProtocolLayer layer(QString::fromUtf8(name), offset, length);
+    if (!builder->openLayers.isEmpty()) {
+        layer.position = builder->openLayers.last().fields.size();
     }
-    
-    QString readOutput() {
-        if (pipefd[0] == -1) return QString();
-        
-        char buffer[4096];
-        QString output;
-        
-        // Read all available data from pipe
-        while (true) {
-            ssize_t bytesRead = read(pipefd[0], buffer, sizeof(buffer) - 1);
-            if (bytesRead <= 0) {
-                break; // No more data or error
-            }
-            
-            buffer[bytesRead] = '\0';
-            output += QString::fromUtf8(buffer);
+    builder->openLayers.append(layer);
+}
+
+void onField(const dissect_ctx_t *ctx, const char *name, const char *value, int offset, int length) {
+    LayerTreeBuilder *builder = builderOf(ctx);
+    ProtocolLayer *layer;
+    if (!builder->openLayers.isEmpty()) {
+        layer = &builder->openLayers.last();
+    } else {
+        // Fields outside any layer, e.g. a truncated Ethernet header
+        if (builder->layers.isEmpty() || builder->layers.last().name != "General Information") {
+            builder->layers.append(ProtocolLayer("General Information"));
         }
-        
-        return output;
+        layer = &builder->layers.last();
+    }
+    // Free-text notes show their text in the name column
+    if (name) {
+        layer->addField(QString::fromUtf8(name), QString::fromUtf8(value), offset, length);
+    } else {
+        layer->addField(QString::fromUtf8(value), QString(), offset, length);
+    }
+}
+
+void onEndLayer(const dissect_ctx_t *ctx) {
+    LayerTreeBuilder *builder = builderOf(ctx);
+    if (!builder->openLayers.isEmpty()) {
+        builder->close();
     }
+}
+
+const dissect_visitor_t layerTreeVisitor = {
+    onBeginLayer,
+    onField,
+    onEndLayer
 };
 
-ProtocolAnalysisResult ProtocolAnalysisWrapper::analyzePacket(const QByteArray &packetData) {
-    ProtocolAnalysisResult result;
+}
+
+QList<ProtocolLayer> ProtocolAnalysisWrapper::dissectLayers(const QByteArray &packetData, dissect_state_t *state) {
+    // Zero-initialized per thread, so pool threads never share counters
+    thread_local dissect_state_t threadState;
     
+    const u_char *data = reinterpret_cast<const u_char*>(packetData.constData());
+    LayerTreeBuilder builder;
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &layerTreeVisitor, &builder, state ? state : &threadState,
+                     data, packetData.size());
+    dissect_packet(&ctx, data, packetData.size());
+    return builder.finish();
+}
+
+ProtocolAnalysisResult ProtocolAnalysisWrapper::analyzePacket(const QByteArray &packetData, dissect_state_t *state) {
+    ProtocolAnalysisResult result;
     
     if (packetData.isEmpty()) {
         result.hasError = true;
@@ -106,61 +106,20 @@ ProtocolAnalysisResult ProtocolAnalysisWrapper::analyzePacket(const QByteArray &
     }
     
     try {
+        result.layers = dissectLayers(packetData, state);
         
-        // Create stdout redirector
-        StdoutRedirector redirector;
-        
-        // Redirect stdout to capture printf output
-        if (!redirector.redirect()) {
-            qWarning() << "Failed to redirect stdout, falling back to basic analysis";
-            result.hasError = true;
-            result.errorMessage = "Failed to capture protocol analysis output";
-        } else {
-            
-            // Call the C library function - output will go to our pipe
-            const u_char *data = reinterpret_cast<const u_char*>(packetData.constData());
-            identify_protocol(data, packetData.size());
-            
-            
-            // Flush stdout to ensure all output is written
-            fflush(stdout);
-            
-            // Restore stdout and read captured output
-            redirector.restore();
-            QString capturedOutput = redirector.readOutput();
-            
-            
-            // Parse the captured output
-            if (!capturedOutput.isEmpty()) {
-                result = parseProtocolOutput(capturedOutput);
-            } else {
-                qWarning() << "No output captured from protocol analysis";
-                result.hasError = true;
-                result.errorMessage = "No protocol analysis output captured";
-            }
-        }
-        
-        // Generate hex dump regardless of analysis success
         result.hexDump = generateHexDump(packetData);
-        
-        // Extract summary information
         result.summary = extractProtocolSummary(packetData);
         
-        // If analysis failed but we have basic info, mark as partial success
-        if (result.hasError && !result.summary.isEmpty()) {
-            result.hasError = false;
-            result.errorMessage.clear();
-            
-            // Create a basic protocol layer from summary
-            if (result.layers.isEmpty()) {
-                ProtocolLayer basicLayer("Basic Analysis");
-                basicLayer.fields["Summary"] = result.summary;
-                basicLayer.fields["Source IP"] = extractSourceIP(packetData);
-                basicLayer.fields["Destination IP"] = extractDestinationIP(packetData);
-                basicLayer.fields["Protocol"] = extractProtocolType(packetData);
-                basicLayer.fields["Packet Length"] = QString::number(packetData.size());
-                result.layers.append(basicLayer);
-            }
+        // Nothing decoded: fall back to the one-pass summary
+        if (result.layers.isEmpty()) {
+            ProtocolLayer basicLayer("Basic Analysis");
+            basicLayer.addField("Summary", result.summary);
+            basicLayer.addField("Source IP", extractSourceIP(packetData));
+            basicLayer.addField("Destination IP", extractDestinationIP(packetData));
+            basicLayer.addField("Protocol", extractProtocolType(packetData));
+            basicLayer.addField("Packet Length", QString::number(packetData.size()), 0, packetData.size());
+            result.layers.append(basicLayer);
         }
         
     } catch (const std::exception &e) {
@@ -243,13 +202,7 @@ QString ProtocolAnalysisWrapper::extractProtocolSummary(const QByteArray &packet
                         summary = QString("TCP %1:%2 → %3:%4").arg(srcIP).arg(srcPort).arg(dstIP).arg(dstPort);
                         
                         // Add application protocol if known
-                        if (srcPort == 80 || dstPort == 80) {
-                            summary += " (HTTP)";
-                        } else if (srcPort == 443 || dstPort == 443) {
-                            summary += " (HTTPS)";
-                        } else if (srcPort == 22 || dstPort == 22) {
-                            summary += " (SSH)";
-                        }
+                        summary += appSuffix(IPPROTO_TCP, srcPort, dstPort);
                     } else {
                         summary = QString("TCP %1 → %2").arg(srcIP, dstIP);
                     }
@@ -266,11 +219,7 @@ QString ProtocolAnalysisWrapper::extractProtocolSummary(const QByteArray &packet
                         summary = QString("UDP %1:%2 → %3:%4").arg(srcIP).arg(srcPort).arg(dstIP).arg(dstPort);
                         
                         // Add application protocol if known
-                        if (srcPort == 53 || dstPort == 53) {
-                            summary += " (DNS)";
-                        } else if ((srcPort == 67 && dstPort == 68) || (srcPort == 68 && dstPort == 67)) {
-                            summary += " (DHCP)";
-                        }
+                        summary += appSuffix(IPPROTO_UDP, srcPort, dstPort);
                     } else {
                         summary = QString("UDP %1 → %2").arg(srcIP, dstIP);
                     }
@@ -299,183 +248,127 @@ QString ProtocolAnalysisWrapper::extractProtocolSummary(const QByteArray &packet
     return summary;
 }
 
-QString ProtocolAnalysisWrapper::extractSourceIP(const QByteArray &packetData) {
-    if (packetData.size() < (int)(sizeof(struct ethhdr) + sizeof(struct iphdr))) {
-        return "Unknown";
-    }
+QString ProtocolAnalysisWrapper::appSuffix(uint8_t l4Proto, uint16_t srcPort, uint16_t dstPort) {
+    const char *name = port_registry_app_name(port_registry_classify(l4Proto, srcPort, dstPort));
+    return name ? QString(" (%1)").arg(QLatin1String(name)) : QString();
+}
+
+int ProtocolAnalysisWrapper::applyDecodeAs(const QStringList &rules) {
+    port_registry_clear_all();
     
-    const struct ethhdr *eth = reinterpret_cast<const struct ethhdr*>(packetData.constData());
-    if (ntohs(eth->h_proto) != ETH_P_IP) {
-        return "Non-IPv4";
+    int applied = 0;
+    for (const QString &rule : rules) {
+        // "tcp/8080=http"
+        QStringList sides = rule.trimmed().split('=');
+        QStringList target = sides.value(0).split('/');
+        if (sides.size() != 2 || target.size() != 2) {
+            qWarning() << "Ignoring malformed decode-as rule" << rule;
+            continue;
+        }
+        
+        QString l4 = target[0].trimmed().toLower();
+        bool portOk = false;
+        uint port = target[1].trimmed().toUInt(&portOk);
+        int app = port_registry_app_from_name(sides[1].trimmed().toLatin1().constData());
+        uint8_t l4Proto = l4 == "tcp" ? IPPROTO_TCP : l4 == "udp" ? IPPROTO_UDP : 0;
+        if (!l4Proto || !portOk || port > 65535 || app < 0 ||
+            port_registry_decode_as(l4Proto, static_cast<uint16_t>(port), static_cast<uint8_t>(app)) != 0) {
+            qWarning() << "Ignoring decode-as rule" << rule;
+            continue;
+        }
+        applied++;
     }
-    
-    const struct iphdr *ip = reinterpret_cast<const struct iphdr*>(
-        packetData.constData() + sizeof(struct ethhdr));
-    
-    return ipToString(ip->saddr);
+    return applied;
+}
+
+QString ProtocolAnalysisWrapper::extractSourceIP(const QByteArray &packetData) {
+    return summarySourceIP(decodeSummary(packetData));
 }
 
 QString ProtocolAnalysisWrapper::extractDestinationIP(const QByteArray &packetData) {
-    if (packetData.size() < (int)(sizeof(struct ethhdr) + sizeof(struct iphdr))) {
-        return "Unknown";
-    }
-    
-    const struct ethhdr *eth = reinterpret_cast<const struct ethhdr*>(packetData.constData());
-    if (ntohs(eth->h_proto) != ETH_P_IP) {
-        return "Non-IPv4";
-    }
-    
-    const struct iphdr *ip = reinterpret_cast<const struct iphdr*>(
-        packetData.constData() + sizeof(struct ethhdr));
-    
-    return ipToString(ip->daddr);
+    return summaryDestinationIP(decodeSummary(packetData));
 }
 
 QString ProtocolAnalysisWrapper::extractProtocolType(const QByteArray &packetData) {
-    if (packetData.size() < (int)sizeof(struct ethhdr)) {
-        return "Unknown";
-    }
-    
-    const struct ethhdr *eth = reinterpret_cast<const struct ethhdr*>(packetData.constData());
-    uint16_t ethType = ntohs(eth->h_proto);
-    
-    switch (ethType) {
-        case ETH_P_IP: {
-            if (packetData.size() < (int)(sizeof(struct ethhdr) + sizeof(struct iphdr))) {
-                return "IPv4";
-            }
-            
-            const struct iphdr *ip = reinterpret_cast<const struct iphdr*>(
-                packetData.constData() + sizeof(struct ethhdr));
-            
-            switch (ip->protocol) {
-                case IPPROTO_TCP: {
-                    // Try to identify application protocol
-                    if (packetData.size() >= (int)(sizeof(struct ethhdr) + sizeof(struct iphdr) + sizeof(struct tcphdr))) {
-                        const struct tcphdr *tcp = reinterpret_cast<const struct tcphdr*>(
-                            packetData.constData() + sizeof(struct ethhdr) + (ip->ihl * 4));
-                        
-                        uint16_t srcPort = ntohs(tcp->source);
-                        uint16_t dstPort = ntohs(tcp->dest);
-                        
-                        if (srcPort == 80 || dstPort == 80) return "HTTP";
-                        if (srcPort == 443 || dstPort == 443) return "HTTPS";
-                        if (srcPort == 22 || dstPort == 22) return "SSH";
-                        if (srcPort == 21 || dstPort == 21) return "FTP";
-                        if (srcPort == 25 || dstPort == 25) return "SMTP";
-                    }
-                    return "TCP";
-                }
-                case IPPROTO_UDP: {
-                    // Try to identify application protocol
-                    if (packetData.size() >= (int)(sizeof(struct ethhdr) + sizeof(struct iphdr) + sizeof(struct udphdr))) {
-                        const struct udphdr *udp = reinterpret_cast<const struct udphdr*>(
-                            packetData.constData() + sizeof(struct ethhdr) + (ip->ihl * 4));
-                        
-                        uint16_t srcPort = ntohs(udp->source);
-                        uint16_t dstPort = ntohs(udp->dest);
-                        
-                        if (srcPort == 53 || dstPort == 53) return "DNS";
-                        if ((srcPort == 67 && dstPort == 68) || (srcPort == 68 && dstPort == 67)) return "DHCP";
-                        if (srcPort == 123 || dstPort == 123) return "NTP";
-                    }
-                    return "UDP";
-                }
-                case IPPROTO_ICMP:
-                    return "ICMP";
-                default:
-                    return QString("IPv4 Protocol %1").arg(ip->protocol);
-            }
-        }
-        case ETH_P_IPV6:
-            return "IPv6";
-        case ETH_P_ARP:
-            return "ARP";
-        default:
-            return QString("Ethernet 0x%1").arg(ethType, 4, 16, QChar('0'));
-    }
+    return summaryProtocolType(decodeSummary(packetData));
 }
 
-ProtocolAnalysisResult ProtocolAnalysisWrapper::parseProtocolOutput(const QString &output) {
-    ProtocolAnalysisResult result;
-    
-    if (output.isEmpty()) {
-        result.hasError = true;
-        result.errorMessage = "No analysis output received";
-        return result;
+packet_summary_t ProtocolAnalysisWrapper::decodeSummary(const QByteArray &packetData) {
+    packet_summary_t summary;
+    packet_summary_decode(reinterpret_cast<const uint8_t*>(packetData.constData()),
+                          static_cast<size_t>(packetData.size()), &summary);
+    return summary;
+}
+
+QString ProtocolAnalysisWrapper::summarySourceIP(const packet_summary_t &summary) {
+    return summaryAddress(summary, summary.src_addr);
+}
+
+QString ProtocolAnalysisWrapper::summaryDestinationIP(const packet_summary_t &summary) {
+    return summaryAddress(summary, summary.dst_addr);
+}
+
+QString ProtocolAnalysisWrapper::summaryProtocolType(const packet_summary_t &summary) {
+    // Built once and shared, so application names cost no allocation
+    static const QVector<QString> appNames = [] {
+        QVector<QString> names(PORT_APP_COUNT);
+        for (int app = PORT_APP_NONE + 1; app < PORT_APP_COUNT; ++app) {
+            names[app] = QString::fromLatin1(port_registry_app_name(static_cast<uint8_t>(app)));
+        }
+        return names;
+    }();
+    if (summary.app_proto != PORT_APP_NONE && summary.app_proto < PORT_APP_COUNT) {
+        return appNames[summary.app_proto];
     }
     
-    // Parse the output from the C library
-    // This is a simplified parser - in a real implementation, you might want
-    // to modify the C library to output structured data (JSON, XML, etc.)
-    
-    QStringList lines = output.split('\n', Qt::SkipEmptyParts);
-    ProtocolLayer currentLayer;
-    bool inLayer = false;
-    
-    for (const QString &line : lines) {
-        QString trimmedLine = line.trimmed();
-        
-        if (trimmedLine.startsWith("===") && trimmedLine.endsWith("===")) {
-            // This is a protocol layer header
-            if (inLayer && !currentLayer.name.isEmpty()) {
-                result.layers.append(currentLayer);
-            }
-            
-            // Extract layer name
-            QString layerName = trimmedLine;
-            layerName.remove("===");
-            layerName = layerName.trimmed();
-            
-            currentLayer = ProtocolLayer(layerName);
-            inLayer = true;
+    if (summary.l3 == PACKET_L3_IPV4 || summary.l3 == PACKET_L3_IPV6) {
+        switch (summary.l4_proto) {
+            case IPPROTO_TCP: return QStringLiteral("TCP");
+            case IPPROTO_UDP: return QStringLiteral("UDP");
+            case IPPROTO_ICMP: return QStringLiteral("ICMP");
+            case IPPROTO_ICMPV6: return QStringLiteral("ICMPv6");
+            default: break;
         }
-        else if (inLayer && trimmedLine.contains(":")) {
-            // This looks like a field: value pair
-            int colonIndex = trimmedLine.indexOf(':');
-            if (colonIndex > 0) {
-                QString fieldName = trimmedLine.left(colonIndex).trimmed();
-                QString fieldValue = trimmedLine.mid(colonIndex + 1).trimmed();
-                
-                if (!fieldName.isEmpty()) {
-                    currentLayer.fields[fieldName] = fieldValue;
-                }
-            }
-        }
-        else if (!trimmedLine.isEmpty() && !trimmedLine.startsWith("=")) {
-            // General information - add to current layer or create a general info layer
-            if (!inLayer) {
-                currentLayer = ProtocolLayer("General Information");
-                inLayer = true;
-            }
-            
-            // Try to extract key-value pairs from general text
-            if (trimmedLine.contains(":")) {
-                int colonIndex = trimmedLine.indexOf(':');
-                QString key = trimmedLine.left(colonIndex).trimmed();
-                QString value = trimmedLine.mid(colonIndex + 1).trimmed();
-                currentLayer.fields[key] = value;
-            } else {
-                // Add as a general info field
-                currentLayer.fields[QString("Info %1").arg(currentLayer.fields.size() + 1)] = trimmedLine;
-            }
+        if (summary.l3 == PACKET_L3_IPV6) {
+            return QStringLiteral("IPv6");
         }
+        return QString("IPv4 Protocol %1").arg(summary.l4_proto);
     }
     
-    // Add the last layer
-    if (inLayer && !currentLayer.name.isEmpty()) {
-        result.layers.append(currentLayer);
+    switch (summary.ethertype) {
+        case 0:
+            if (summary.flags & PACKET_SUMMARY_TRUNCATED) {
+                return QStringLiteral("Unknown");
+            }
+            break;
+        case ETH_P_IP: return QStringLiteral("IPv4");
+        case ETH_P_IPV6: return QStringLiteral("IPv6");
+        case ETH_P_ARP: return QStringLiteral("ARP");
+        default: break;
     }
+    return QString("Ethernet 0x%1").arg(summary.ethertype, 4, 16, QChar('0'));
+}
+
+QString ProtocolAnalysisWrapper::summaryAddress(const packet_summary_t &summary, const uint8_t *address) {
+    char text[INET6_ADDRSTRLEN];
     
-    // If no layers were parsed, create a simple text layer
-    if (result.layers.isEmpty()) {
-        ProtocolLayer textLayer("Raw Output");
-        textLayer.fields["Content"] = output;
-        result.layers.append(textLayer);
+    switch (summary.l3) {
+        case PACKET_L3_IPV4:
+            inet_ntop(AF_INET, address, text, sizeof(text));
+            return QString::fromLatin1(text);
+        case PACKET_L3_IPV6:
+            inet_ntop(AF_INET6, address, text, sizeof(text));
+            return QString::fromLatin1(text);
+        default:
+            break;
     }
     
-    result.hasError = false;
-    return result;
+    // IP header cut short by the snap length
+    if (summary.ethertype == ETH_P_IP || summary.ethertype == ETH_P_IPV6 ||
+        (summary.flags & PACKET_SUMMARY_TRUNCATED)) {
+        return QStringLiteral("Unknown");
+    }
+    return QStringLiteral("Non-IP");
 }
 
 QString ProtocolAnalysisWrapper::ipToString(uint32_t ip) {
@@ -3,10 +3,12 @@
 
 #include <QString>
 #include <QByteArray>
+#include <QStringList>
 #include "../Models/ProtocolTreeModel.h"
 
 extern "C" {
     #include "protocol.h"
+    #include "packet_summary.h"
     #include <pcap.h>
     #include <sys/types.h>
 }
@@ -14,17 +16,29 @@ extern "C" {
 class ProtocolAnalysisWrapper
 {
 public:
-    static ProtocolAnalysisResult analyzePacket(const QByteArray &packetData);
+    // state collects the dissectors' statistics and must belong to the
+    // calling thread; by default each thread gets a private one
+    static ProtocolAnalysisResult analyzePacket(const QByteArray &packetData, dissect_state_t *state = nullptr);
+    // Only the layer tree of analyzePacket(), for bulk work on worker threads
+    static QList<ProtocolLayer> dissectLayers(const QByteArray &packetData, dissect_state_t *state = nullptr);
     static QString generateHexDump(const QByteArray &data);
     static QString extractProtocolSummary(const QByteArray &packetData);
     static QString extractSourceIP(const QByteArray &packetData);
     static QString extractDestinationIP(const QByteArray &packetData);
     static QString extractProtocolType(const QByteArray &packetData);
     
+    // Row fields from a single packet_summary_decode() pass
+    static packet_summary_t decodeSummary(const QByteArray &packetData);
+    static QString summarySourceIP(const packet_summary_t &summary);
+    static QString summaryDestinationIP(const packet_summary_t &summary);
+    static QString summaryProtocolType(const packet_summary_t &summary);
+    
+    // Replaces the port registry's decode-as overrides with rules like
+    // "tcp/8080=http" or "udp/5353=none"; returns how many were applied,
+    // bad ones are skipped with a warning
+    static int applyDecodeAs(const QStringList &rules);
+    
 private:
-    static ProtocolAnalysisResult parseProtocolOutput(const QString &output);
-    static void captureProtocolOutput(void (*analysisFunction)(const u_char*, int), 
-                                    const u_char *data, int len, QString &output);
     static ProtocolLayer parseEthernetLayer(const u_char *packet, int len);
     static ProtocolLayer parseIPLayer(const u_char *packet, int len);
     static ProtocolLayer parseTransportLayer(const u_char *packet, int len);
@@ -32,6 +46,8 @@ private:
     
     // Helper functions for packet parsing
     static QString ipToString(uint32_t ip);
+    static QString appSuffix(uint8_t l4Proto, uint16_t srcPort, uint16_t dstPort);
+    static QString summaryAddress(const packet_summary_t &summary, const uint8_t *address);
     static QString formatTimestamp(const struct timeval &tv);
     static QString formatMacAddress(const u_char *mac);
 };
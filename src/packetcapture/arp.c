@@ -215,6 +215,10 @@ void *sniff_thread(void *arg) {
     unsigned char buffer[65536];
     int packet_count = 0;
     
+    // This thread's dissection counters and ARP tables
+    dissect_state_t dissect_state;
+    dissect_state_init(&dissect_state);
+    
     while (!should_shutdown) {
         int len = recvfrom(sock, buffer, sizeof(buffer), 0, NULL, NULL);
         
@@ -286,7 +290,7 @@ void *sniff_thread(void *arg) {
                 printf("Dest MAC: %02x:%02x:%02x:%02x:%02x:%02x\n",
                        eth->ether_dhost[0], eth->ether_dhost[1], eth->ether_dhost[2],
                        eth->ether_dhost[3], eth->ether_dhost[4], eth->ether_dhost[5]);
-                identify_protocol(buffer, len);
+                identify_protocol(&dissect_state, buffer, len);
                 printf("----------------------------------------\n");
             }
         }
@@ -0,0 +1,379 @@
+#include "capture_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define PCAP_MAGIC_USEC 0xa1b2c3d4u
+#define PCAP_MAGIC_NSEC 0xa1b23c4du
+#define PCAP_FILE_HEADER_LEN 24
+#define PCAP_RECORD_HEADER_LEN 16
+
+#define PCAPNG_BLOCK_SHB 0x0a0d0d0au
+#define PCAPNG_BLOCK_IDB 0x00000001u
+#define PCAPNG_BLOCK_OPB 0x00000002u
+#define PCAPNG_BLOCK_SPB 0x00000003u
+#define PCAPNG_BLOCK_EPB 0x00000006u
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4du
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_IF_TSRESOL 9
+#define PCAPNG_OPT_IF_TSOFFSET 14
+
+#define NSEC_PER_SEC 1000000000LL
+
+static void set_error(capture_file_t *file, const char *what) {
+    snprintf(file->error, sizeof(file->error), "%s: %s", what, strerror(errno));
+}
+
+static uint16_t read16(const capture_file_t *file, const uint8_t *p) {
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return file->swapped ? __builtin_bswap16(value) : value;
+}
+
+static uint32_t read32(const capture_file_t *file, const uint8_t *p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return file->swapped ? __builtin_bswap32(value) : value;
+}
+
+static uint64_t read64(const capture_file_t *file, const uint8_t *p) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return file->swapped ? __builtin_bswap64(value) : value;
+}
+
+static int make_entry(capture_file_t *file, capture_index_entry_t *entry,
+                      size_t data_offset, uint32_t caplen, int64_t ts_ns) {
+    if (data_offset > CAPTURE_INDEX_MAX_OFFSET || caplen > CAPTURE_INDEX_MAX_CAPLEN) {
+        snprintf(file->error, sizeof(file->error), "Record at offset %zu exceeds the index limits", data_offset);
+        return -1;
+    }
+    entry->location = (uint64_t)data_offset | ((uint64_t)caplen << CAPTURE_INDEX_OFFSET_BITS);
+    entry->ts_ns = ts_ns;
+    return 0;
+}
+
+// Timestamp units of one pcapng interface to nanoseconds
+static int64_t pcapng_ts_to_ns(const capture_file_iface_t *iface, uint64_t units) {
+    int64_t ns;
+    unsigned int exponent = iface->tsresol & 0x7f;
+
+    if (iface->tsresol & 0x80) {
+        // Binary fraction: 2^-exponent seconds per unit
+        uint64_t seconds = exponent >= 64 ? 0 : units >> exponent;
+        uint64_t fraction = exponent >= 64 ? units : units & ((1ULL << exponent) - 1);
+        ns = (int64_t)seconds * NSEC_PER_SEC +
+             (int64_t)(((unsigned __int128)fraction * NSEC_PER_SEC) >> exponent);
+    } else if (exponent <= 9) {
+        int64_t scale = 1;
+        for (unsigned int i = exponent; i < 9; ++i) {
+            scale *= 10;
+        }
+        ns = (int64_t)units * scale;
+    } else {
+        uint64_t divisor = 1;
+        for (unsigned int i = 9; i < exponent && i < 28; ++i) {
+            divisor *= 10;
+        }
+        ns = (int64_t)(units / divisor);
+    }
+
+    return ns + iface->tsoffset_ns;
+}
+
+static int pcapng_add_iface(capture_file_t *file, const uint8_t *body, size_t body_len) {
+    if (body_len < 8) {
+        snprintf(file->error, sizeof(file->error), "Truncated interface description block");
+        return -1;
+    }
+
+    if (file->iface_count == file->iface_capacity) {
+        unsigned int capacity = file->iface_capacity ? file->iface_capacity * 2 : 4;
+        capture_file_iface_t *ifaces = realloc(file->ifaces, capacity * sizeof(*ifaces));
+        if (!ifaces) {
+            set_error(file, "realloc");
+            return -1;
+        }
+        file->ifaces = ifaces;
+        file->iface_capacity = capacity;
+    }
+
+    capture_file_iface_t *iface = &file->ifaces[file->iface_count++];
+    iface->linktype = read16(file, body);
+    iface->tsresol = 6;  // microseconds unless if_tsresol says otherwise
+    iface->tsoffset_ns = 0;
+
+    // Options: code(2) length(2) value padded to 4 bytes
+    size_t pos = 8;
+    while (pos + 4 <= body_len) {
+        uint16_t code = read16(file, body + pos);
+        uint16_t length = read16(file, body + pos + 2);
+        pos += 4;
+        if (code == PCAPNG_OPT_ENDOFOPT || pos + length > body_len) {
+            break;
+        }
+        if (code == PCAPNG_OPT_IF_TSRESOL && length >= 1) {
+            iface->tsresol = body[pos];
+        } else if (code == PCAPNG_OPT_IF_TSOFFSET && length >= 8) {
+            iface->tsoffset_ns = (int64_t)read64(file, body + pos) * NSEC_PER_SEC;
+        }
+        pos += (length + 3u) & ~3u;
+    }
+
+    if (file->linktype < 0) {
+        file->linktype = iface->linktype;
+    } else if (file->linktype != iface->linktype) {
+        file->mixed_linktypes = 1;
+    }
+    return 0;
+}
+
+static int pcapng_read_shb(capture_file_t *file, size_t offset) {
+    if (offset + 12 > file->size) {
+        file->truncated = 1;
+        return 0;
+    }
+
+    // The byte-order magic decides how every length in the section is read
+    uint32_t magic;
+    memcpy(&magic, file->map + offset + 8, sizeof(magic));
+    if (magic == PCAPNG_BYTE_ORDER_MAGIC) {
+        file->swapped = 0;
+    } else if (magic == __builtin_bswap32(PCAPNG_BYTE_ORDER_MAGIC)) {
+        file->swapped = 1;
+    } else {
+        snprintf(file->error, sizeof(file->error), "Bad pcapng byte-order magic at offset %zu", offset);
+        return -1;
+    }
+
+    // Interface ids are local to a section
+    file->iface_count = 0;
+    return 1;
+}
+
+static int index_pcap(capture_file_t *file, capture_index_entry_t *entries, int max_entries) {
+    int count = 0;
+    size_t offset = file->next_offset;
+    int64_t fraction_scale = file->nanosecond ? 1 : 1000;
+
+    while (count < max_entries) {
+        if (offset + PCAP_RECORD_HEADER_LEN > file->size) {
+            file->truncated = offset != file->size;
+            break;
+        }
+
+        const uint8_t *header = file->map + offset;
+        uint32_t ts_sec = read32(file, header);
+        uint32_t ts_frac = read32(file, header + 4);
+        uint32_t caplen = read32(file, header + 8);
+        size_t data_offset = offset + PCAP_RECORD_HEADER_LEN;
+
+        if (caplen > file->size - data_offset) {
+            file->truncated = 1;
+            break;
+        }
+
+        if (make_entry(file, &entries[count], data_offset, caplen,
+                       (int64_t)ts_sec * NSEC_PER_SEC + (int64_t)ts_frac * fraction_scale) < 0) {
+            return -1;
+        }
+        count++;
+        offset = data_offset + caplen;
+    }
+
+    file->next_offset = offset;
+    return count;
+}
+
+static int index_pcapng(capture_file_t *file, capture_index_entry_t *entries, int max_entries) {
+    int count = 0;
+    size_t offset = file->next_offset;
+
+    while (count < max_entries) {
+        if (offset + 12 > file->size) {
+            file->truncated = offset != file->size;
+            break;
+        }
+
+        uint32_t type;
+        memcpy(&type, file->map + offset, sizeof(type));  // SHB type is a palindrome
+        if (type == PCAPNG_BLOCK_SHB) {
+            int result = pcapng_read_shb(file, offset);
+            if (result <= 0) {
+                if (result < 0) {
+                    return -1;
+                }
+                break;
+            }
+        }
+        type = read32(file, file->map + offset);
+
+        uint32_t block_len = read32(file, file->map + offset + 4);
+        if (block_len < 12 || block_len % 4 != 0) {
+            snprintf(file->error, sizeof(file->error), "Bad pcapng block length %u at offset %zu", block_len, offset);
+            return -1;
+        }
+        if (block_len > file->size - offset) {
+            file->truncated = 1;
+            break;
+        }
+
+        const uint8_t *body = file->map + offset + 8;
+        size_t body_len = block_len - 12;
+
+        if (type == PCAPNG_BLOCK_IDB) {
+            if (pcapng_add_iface(file, body, body_len) < 0) {
+                return -1;
+            }
+        } else if (type == PCAPNG_BLOCK_EPB || type == PCAPNG_BLOCK_OPB) {
+            // EPB: if_id(4) ts_high(4) ts_low(4) caplen(4) len(4) data
+            // OPB: if_id(2) drops(2) ts_high(4) ts_low(4) caplen(4) len(4) data
+            if (body_len < 20) {
+                snprintf(file->error, sizeof(file->error), "Truncated packet block at offset %zu", offset);
+                return -1;
+            }
+            uint32_t if_id = type == PCAPNG_BLOCK_EPB ? read32(file, body) : read16(file, body);
+            uint64_t units = ((uint64_t)read32(file, body + 4) << 32) | read32(file, body + 8);
+            uint32_t caplen = read32(file, body + 12);
+            if (if_id >= file->iface_count || caplen > body_len - 20) {
+                snprintf(file->error, sizeof(file->error), "Inconsistent packet block at offset %zu", offset);
+                return -1;
+            }
+            if (make_entry(file, &entries[count], (size_t)(body + 20 - file->map), caplen,
+                           pcapng_ts_to_ns(&file->ifaces[if_id], units)) < 0) {
+                return -1;
+            }
+            count++;
+        } else if (type == PCAPNG_BLOCK_SPB) {
+            // Simple packet blocks carry no timestamp and belong to interface 0
+            if (body_len < 4 || file->iface_count == 0) {
+                snprintf(file->error, sizeof(file->error), "Inconsistent simple packet block at offset %zu", offset);
+                return -1;
+            }
+            uint32_t wirelen = read32(file, body);
+            uint32_t caplen = wirelen < body_len - 4 ? wirelen : (uint32_t)(body_len - 4);
+            if (make_entry(file, &entries[count], (size_t)(body + 4 - file->map), caplen, 0) < 0) {
+                return -1;
+            }
+            count++;
+        }
+        // Name resolution, statistics and custom blocks are skipped
+
+        offset += block_len;
+    }
+
+    file->next_offset = offset;
+    return count;
+}
+
+int capture_file_open(capture_file_t *file, const char *path) {
+    memset(file, 0, sizeof(*file));
+    file->fd = -1;
+    file->linktype = -1;
+
+    file->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) {
+        set_error(file, "open");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(file->fd, &st) < 0) {
+        set_error(file, "fstat");
+        capture_file_close(file);
+        return -1;
+    }
+    if (st.st_size < 12) {
+        snprintf(file->error, sizeof(file->error), "File is too small to be a capture");
+        capture_file_close(file);
+        return -1;
+    }
+
+    file->size = (size_t)st.st_size;
+    void *map = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (map == MAP_FAILED) {
+        set_error(file, "mmap");
+        file->size = 0;
+        capture_file_close(file);
+        return -1;
+    }
+    file->map = (const uint8_t *)map;
+
+    // Indexing reads front to back exactly once
+    madvise(map, file->size, MADV_SEQUENTIAL);
+
+    uint32_t magic;
+    memcpy(&magic, file->map, sizeof(magic));
+
+    if (magic == PCAPNG_BLOCK_SHB) {
+        file->format = CAPTURE_FORMAT_PCAPNG;
+        file->next_offset = 0;
+        return 0;
+    }
+
+    if (magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC) {
+        file->swapped = 0;
+    } else if (magic == __builtin_bswap32(PCAP_MAGIC_USEC) || magic == __builtin_bswap32(PCAP_MAGIC_NSEC)) {
+        file->swapped = 1;
+        magic = __builtin_bswap32(magic);
+    } else {
+        snprintf(file->error, sizeof(file->error), "Not a pcap or pcapng file (magic 0x%08x)", magic);
+        capture_file_close(file);
+        return -1;
+    }
+
+    if (file->size < PCAP_FILE_HEADER_LEN) {
+        snprintf(file->error, sizeof(file->error), "Truncated pcap file header");
+        capture_file_close(file);
+        return -1;
+    }
+
+    file->format = CAPTURE_FORMAT_PCAP;
+    file->nanosecond = magic == PCAP_MAGIC_NSEC;
+    file->linktype = (int)(read32(file, file->map + 20) & 0xffff);
+    file->next_offset = PCAP_FILE_HEADER_LEN;
+    return 0;
+}
+
+void capture_file_close(capture_file_t *file) {
+    free(file->ifaces);
+    file->ifaces = NULL;
+    file->iface_count = 0;
+    file->iface_capacity = 0;
+    if (file->map) {
+        munmap((void *)file->map, file->size);
+        file->map = NULL;
+        file->size = 0;
+    }
+    if (file->fd >= 0) {
+        close(file->fd);
+        file->fd = -1;
+    }
+}
+
+int capture_file_index(capture_file_t *file, capture_index_entry_t *entries, int max_entries) {
+    if (!file->map) {
+        snprintf(file->error, sizeof(file->error), "File is not open");
+        return -1;
+    }
+    if (max_entries <= 0) {
+        return 0;
+    }
+
+    if (file->format == CAPTURE_FORMAT_PCAPNG) {
+        return index_pcapng(file, entries, max_entries);
+    }
+    return index_pcap(file, entries, max_entries);
+}
+
+void capture_file_end_sequential(capture_file_t *file) {
+    if (file->map) {
+        madvise((void *)file->map, file->size, MADV_NORMAL);
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CAPTURE_FILE_ERRBUF_SIZE 256
+
+// Index entries pack the data offset and captured length into one word
+#define CAPTURE_INDEX_OFFSET_BITS 40
+#define CAPTURE_INDEX_MAX_OFFSET ((1ULL << CAPTURE_INDEX_OFFSET_BITS) - 1)
+#define CAPTURE_INDEX_MAX_CAPLEN ((1u << (64 - CAPTURE_INDEX_OFFSET_BITS)) - 1)
+
+// LINKTYPE_ETHERNET, the only link layer the summarizer understands
+#define CAPTURE_LINKTYPE_ETHERNET 1
+
+typedef enum {
+    CAPTURE_FORMAT_PCAP,
+    CAPTURE_FORMAT_PCAPNG
+} capture_file_format_t;
+
+// 16 bytes per packet: where its bytes start, how many, and when it arrived
+typedef struct {
+    uint64_t location;  // data offset (low 40 bits) | caplen << 40
+    int64_t ts_ns;      // nanoseconds since the Unix epoch
+} capture_index_entry_t;
+
+// pcapng interface description, valid for the current section only
+typedef struct {
+    uint16_t linktype;
+    uint8_t tsresol;       // if_tsresol: 10^-n, or 2^-n with the high bit set
+    int64_t tsoffset_ns;   // if_tsoffset
+} capture_file_iface_t;
+
+// Read-only memory-mapped pcap or pcapng file
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t size;
+    capture_file_format_t format;
+    int swapped;           // file byte order differs from the host
+    int nanosecond;        // pcap only: nanosecond magic
+    int linktype;          // link type of the first interface
+    int mixed_linktypes;   // pcapng with interfaces of different link types
+    int truncated;         // stopped at an incomplete trailing record
+    size_t next_offset;    // where capture_file_index() continues
+    capture_file_iface_t *ifaces;
+    unsigned int iface_count;
+    unsigned int iface_capacity;
+    char error[CAPTURE_FILE_ERRBUF_SIZE];
+} capture_file_t;
+
+int capture_file_open(capture_file_t *file, const char *path);
+void capture_file_close(capture_file_t *file);
+
+// Walks the next records into entries. Returns the number written, 0 once
+// the end of the file is reached, or -1 on a malformed file (see error).
+int capture_file_index(capture_file_t *file, capture_index_entry_t *entries, int max_entries);
+
+// Indexing is done: drop the sequential read-ahead hint so rows can be
+// paged in at random without the kernel discarding them behind the reader
+void capture_file_end_sequential(capture_file_t *file);
+
+static inline uint64_t capture_index_offset(const capture_index_entry_t *entry) {
+    return entry->location & CAPTURE_INDEX_MAX_OFFSET;
+}
+
+static inline uint32_t capture_index_caplen(const capture_index_entry_t *entry) {
+    return (uint32_t)(entry->location >> CAPTURE_INDEX_OFFSET_BITS);
+}
+
+static inline const uint8_t *capture_index_data(const capture_file_t *file, const capture_index_entry_t *entry) {
+    return file->map + capture_index_offset(entry);
+}
+
+#endif // CAPTURE_FILE_H
@@ -0,0 +1,303 @@
+#include "packet_summary.h"
+
+#include <string.h>
+
+#define ETH_HEADER_LEN 14
+#define VLAN_TAG_LEN 4
+#define MAX_VLAN_TAGS 2
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_ARP 0x0806
+#define ETHERTYPE_VLAN 0x8100
+#define ETHERTYPE_QINQ 0x88a8
+#define ETHERTYPE_IPV6 0x86dd
+
+#define IPPROTO_NUM_HOPOPTS 0
+#define IPPROTO_NUM_TCP 6
+#define IPPROTO_NUM_UDP 17
+#define IPPROTO_NUM_ROUTING 43
+#define IPPROTO_NUM_FRAGMENT 44
+#define IPPROTO_NUM_AH 51
+#define IPPROTO_NUM_DSTOPTS 60
+
+#define IPV6_HEADER_LEN 40
+#define IPV6_MAX_EXT_HEADERS 8
+#define TCP_MIN_HEADER_LEN 20
+#define UDP_HEADER_LEN 8
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Decodes the transport header at offset; end is the last byte IP says
+// belongs to this packet (bounded by the capture)
+static void decode_l4(const uint8_t *data, size_t offset, size_t end, packet_summary_t *summary) {
+    summary->payload_offset = (uint16_t)offset;
+
+    if (summary->l4_proto == IPPROTO_NUM_TCP) {
+        if (end - offset < TCP_MIN_HEADER_LEN) {
+            summary->flags |= PACKET_SUMMARY_TRUNCATED;
+            return;
+        }
+        const uint8_t *tcp = data + offset;
+        size_t header_len = (size_t)(tcp[12] >> 4) * 4;
+        summary->src_port = get16(tcp);
+        summary->dst_port = get16(tcp + 2);
+        summary->tcp_seq = get32(tcp + 4);
+        summary->tcp_ack = get32(tcp + 8);
+        summary->tcp_flags = tcp[13];
+        summary->flags |= PACKET_SUMMARY_HAS_PORTS | PACKET_SUMMARY_HAS_TCP;
+
+        if (header_len < TCP_MIN_HEADER_LEN || header_len > end - offset) {
+            summary->flags |= PACKET_SUMMARY_TRUNCATED;
+            header_len = header_len < TCP_MIN_HEADER_LEN ? TCP_MIN_HEADER_LEN : end - offset;
+        }
+        offset += header_len;
+    } else if (summary->l4_proto == IPPROTO_NUM_UDP) {
+        if (end - offset < UDP_HEADER_LEN) {
+            summary->flags |= PACKET_SUMMARY_TRUNCATED;
+            return;
+        }
+        summary->src_port = get16(data + offset);
+        summary->dst_port = get16(data + offset + 2);
+        summary->flags |= PACKET_SUMMARY_HAS_PORTS;
+        offset += UDP_HEADER_LEN;
+    } else {
+        return;
+    }
+
+    summary->payload_offset = (uint16_t)offset;
+    summary->payload_length = (uint16_t)(end - offset);
+    summary->app_proto = port_registry_classify(summary->l4_proto, summary->src_port, summary->dst_port);
+}
+
+static void decode_ipv4(const uint8_t *data, size_t offset, size_t len, packet_summary_t *summary) {
+    if (len - offset < 20) {
+        summary->flags |= PACKET_SUMMARY_TRUNCATED;
+        return;
+    }
+    const uint8_t *ip = data + offset;
+    size_t header_len = (size_t)(ip[0] & 0x0f) * 4;
+
+    summary->l3 = PACKET_L3_IPV4;
+    summary->l4_proto = ip[9];
+    memcpy(summary->src_addr, ip + 12, 4);
+    memcpy(summary->dst_addr, ip + 16, 4);
+
+    if (header_len < 20 || header_len > len - offset) {
+        summary->flags |= PACKET_SUMMARY_TRUNCATED;
+        return;
+    }
+
+    // Trailing Ethernet padding is not payload
+    size_t end = offset + get16(ip + 2);
+    if (end > len || end < offset + header_len) {
+        end = len;
+    }
+
+    summary->payload_offset = (uint16_t)(offset + header_len);
+    summary->payload_length = (uint16_t)(end - offset - header_len);
+
+    if ((get16(ip + 6) & 0x1fff) != 0) {
+        summary->flags |= PACKET_SUMMARY_FRAGMENT;
+        return;
+    }
+    decode_l4(data, offset + header_len, end, summary);
+}
+
+static void decode_ipv6(const uint8_t *data, size_t offset, size_t len, packet_summary_t *summary) {
+    if (len - offset < IPV6_HEADER_LEN) {
+        summary->flags |= PACKET_SUMMARY_TRUNCATED;
+        return;
+    }
+    const uint8_t *ip = data + offset;
+    uint8_t next = ip[6];
+
+    summary->l3 = PACKET_L3_IPV6;
+    memcpy(summary->src_addr, ip + 8, 16);
+    memcpy(summary->dst_addr, ip + 24, 16);
+
+    size_t end = offset + IPV6_HEADER_LEN + get16(ip + 4);
+    if (end > len || get16(ip + 4) == 0) {
+        end = len;  // Short capture or jumbogram
+    }
+    offset += IPV6_HEADER_LEN;
+
+    for (int i = 0; i < IPV6_MAX_EXT_HEADERS; i++) {
+        size_t ext_len;
+        if (next == IPPROTO_NUM_HOPOPTS || next == IPPROTO_NUM_ROUTING || next == IPPROTO_NUM_DSTOPTS) {
+            if (end - offset < 8) break;
+            ext_len = ((size_t)data[offset + 1] + 1) * 8;
+        } else if (next == IPPROTO_NUM_FRAGMENT) {
+            if (end - offset < 8) break;
+            if ((get16(data + offset + 2) & 0xfff8) != 0) {
+                summary->flags |= PACKET_SUMMARY_FRAGMENT;
+            }
+            ext_len = 8;
+        } else if (next == IPPROTO_NUM_AH) {
+            if (end - offset < 8) break;
+            ext_len = ((size_t)data[offset + 1] + 2) * 4;
+        } else {
+            break;
+        }
+
+        if (ext_len > end - offset) {
+            summary->flags |= PACKET_SUMMARY_TRUNCATED;
+            break;
+        }
+        next = data[offset];
+        offset += ext_len;
+    }
+
+    summary->l4_proto = next;
+    summary->payload_offset = (uint16_t)offset;
+    summary->payload_length = (uint16_t)(end - offset);
+    if (!(summary->flags & PACKET_SUMMARY_FRAGMENT)) {
+        decode_l4(data, offset, end, summary);
+    }
+}
+
+int packet_summary_decode(const uint8_t *data, size_t len, packet_summary_t *summary) {
+    memset(summary, 0, sizeof(*summary));
+
+    // Offsets are 16 bits wide; nothing past a 64 KiB frame is decoded anyway
+    if (len > 0xffff) {
+        len = 0xffff;
+    }
+    if (len < ETH_HEADER_LEN) {
+        summary->flags |= PACKET_SUMMARY_TRUNCATED;
+        return -1;
+    }
+
+    size_t offset = ETH_HEADER_LEN;
+    uint16_t ethertype = get16(data + 12);
+    for (int tags = 0; tags < MAX_VLAN_TAGS && (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_QINQ); tags++) {
+        if (len - offset < VLAN_TAG_LEN) {
+            summary->flags |= PACKET_SUMMARY_TRUNCATED;
+            break;
+        }
+        ethertype = get16(data + offset + 2);
+        offset += VLAN_TAG_LEN;
+    }
+
+    summary->ethertype = ethertype;
+    summary->payload_offset = (uint16_t)offset;
+    summary->payload_length = (uint16_t)(len - offset);
+
+    switch (ethertype) {
+    case ETHERTYPE_IPV4:
+        decode_ipv4(data, offset, len, summary);
+        break;
+    case ETHERTYPE_IPV6:
+        decode_ipv6(data, offset, len, summary);
+        break;
+    case ETHERTYPE_ARP:
+        summary->l3 = PACKET_L3_ARP;
+        break;
+    default:
+        break;
+    }
+    return 0;
+}
+
+void packet_summary_classify_flow(const uint8_t *data, packet_summary_t *summary, app_flow_cache_t *cache) {
+    if (summary->app_proto != PORT_APP_NONE || !(summary->flags & PACKET_SUMMARY_HAS_PORTS)) {
+        return;
+    }
+    size_t addr_len = summary->l3 == PACKET_L3_IPV6 ? 16 : 4;
+    uint64_t flow = app_flow_key(summary->l4_proto, summary->src_addr, summary->dst_addr, addr_len,
+                                 summary->src_port, summary->dst_port);
+    summary->app_proto = app_flow_classify(cache, flow, summary->l4_proto, summary->src_port, summary->dst_port,
+                                           data + summary->payload_offset, summary->payload_length);
+}
+
+#ifdef PACKET_SUMMARY_BENCH
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_FRAMES 4
+#define BENCH_ITERATIONS 20000000L
+
+static size_t build_ipv4(uint8_t *frame, uint8_t proto, uint16_t src_port, uint16_t dst_port, int vlan) {
+    size_t offset = 12;
+    memset(frame, 0, 128);
+    if (vlan) {
+        frame[offset++] = 0x81; frame[offset++] = 0x00;
+        frame[offset++] = 0x00; frame[offset++] = 0x2a;
+    }
+    frame[offset++] = 0x08; frame[offset++] = 0x00;
+
+    uint8_t *ip = frame + offset;
+    size_t l4_len = proto == IPPROTO_NUM_TCP ? 32 : 8;
+    ip[0] = 0x46;  // 24-byte header with options
+    ip[2] = 0; ip[3] = (uint8_t)(24 + l4_len + 16);
+    ip[8] = 64; ip[9] = proto;
+    ip[12] = 192; ip[13] = 168; ip[14] = 1; ip[15] = 10;
+    ip[16] = 10; ip[17] = 0; ip[18] = 0; ip[19] = 1;
+
+    uint8_t *l4 = ip + 24;
+    l4[0] = (uint8_t)(src_port >> 8); l4[1] = (uint8_t)src_port;
+    l4[2] = (uint8_t)(dst_port >> 8); l4[3] = (uint8_t)dst_port;
+    if (proto == IPPROTO_NUM_TCP) {
+        l4[12] = 0x80;  // 32-byte header with options
+        l4[13] = 0x18;
+    }
+    return offset + 24 + l4_len + 16;
+}
+
+static size_t build_ipv6_tcp(uint8_t *frame) {
+    memset(frame, 0, 128);
+    frame[12] = 0x86; frame[13] = 0xdd;
+    uint8_t *ip = frame + ETH_HEADER_LEN;
+    ip[0] = 0x60;
+    ip[5] = 8 + 20 + 16;
+    ip[6] = IPPROTO_NUM_HOPOPTS;
+    ip[8] = 0xfe; ip[9] = 0x80; ip[23] = 1;
+    ip[24] = 0xfe; ip[25] = 0x80; ip[39] = 2;
+    uint8_t *hop = ip + IPV6_HEADER_LEN;
+    hop[0] = IPPROTO_NUM_TCP;
+    uint8_t *tcp = hop + 8;
+    tcp[0] = 0xc0; tcp[1] = 0x01; tcp[2] = 0x01; tcp[3] = 0xbb;
+    tcp[12] = 0x50; tcp[13] = 0x02;
+    return ETH_HEADER_LEN + IPV6_HEADER_LEN + 8 + 20 + 16;
+}
+
+int main(void) {
+    static uint8_t frames[BENCH_FRAMES][128];
+    size_t lengths[BENCH_FRAMES];
+    lengths[0] = build_ipv4(frames[0], IPPROTO_NUM_TCP, 51000, 443, 0);
+    lengths[1] = build_ipv4(frames[1], IPPROTO_NUM_UDP, 40000, 53, 0);
+    lengths[2] = build_ipv4(frames[2], IPPROTO_NUM_TCP, 22, 50000, 1);
+    lengths[3] = build_ipv6_tcp(frames[3]);
+
+    packet_summary_t summary;
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        packet_summary_decode(frames[i], lengths[i], &summary);
+        printf("frame %d: l3=%u l4=%u ports=%u->%u app=%s payload=%u+%u flags=0x%02x\n",
+               i, summary.l3, summary.l4_proto, summary.src_port, summary.dst_port,
+               port_registry_app_name(summary.app_proto) ? port_registry_app_name(summary.app_proto) : "-",
+               summary.payload_offset, summary.payload_length, summary.flags);
+    }
+
+    struct timespec start, end;
+    uint64_t sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < BENCH_ITERATIONS; i++) {
+        int frame = (int)(i & (BENCH_FRAMES - 1));
+        packet_summary_decode(frames[frame], lengths[frame], &summary);
+        sink += summary.src_port + summary.payload_offset;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed_ns = (double)(end.tv_sec - start.tv_sec) * 1e9 + (double)(end.tv_nsec - start.tv_nsec);
+    printf("%ld packets, %.2f ns/packet (sizeof(packet_summary_t) = %zu, checksum %llu)\n",
+           BENCH_ITERATIONS, elapsed_ns / BENCH_ITERATIONS, sizeof(packet_summary_t),
+           (unsigned long long)sink);
+    return EXIT_SUCCESS;
+}
+#endif
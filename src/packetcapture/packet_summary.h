@@ -0,0 +1,53 @@
+#ifndef PACKET_SUMMARY_H
+#define PACKET_SUMMARY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../protocols/port_registry.h"
+#include "../protocols/app_heuristics.h"
+
+// Network layer found behind Ethernet (and up to two VLAN tags)
+#define PACKET_L3_NONE 0
+#define PACKET_L3_IPV4 1
+#define PACKET_L3_IPV6 2
+#define PACKET_L3_ARP  3
+
+// packet_summary_t.flags
+#define PACKET_SUMMARY_HAS_PORTS  0x01  // src_port/dst_port are valid
+#define PACKET_SUMMARY_HAS_TCP    0x02  // tcp_flags/tcp_seq/tcp_ack are valid
+#define PACKET_SUMMARY_TRUNCATED  0x04  // a header ran past the captured bytes
+#define PACKET_SUMMARY_FRAGMENT   0x08  // non-first IPv4 fragment, no L4 header
+
+// Everything the packet table needs, decoded in one pass over L2-L4.
+// Fixed size and pointer-free, so it can be copied around freely and
+// decoded on any thread without allocating. Addresses stay in network
+// byte order; IPv4 uses the first 4 bytes of each address.
+typedef struct {
+    uint8_t src_addr[16];
+    uint8_t dst_addr[16];
+    uint32_t tcp_seq;
+    uint32_t tcp_ack;
+    uint16_t ethertype;       // innermost, after VLAN tags
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint16_t payload_offset;  // first byte after the L4 (or last decoded) header
+    uint16_t payload_length;  // captured payload bytes, IP padding excluded
+    uint8_t l3;               // PACKET_L3_*
+    uint8_t l4_proto;         // IP protocol number, IPv6 extension headers skipped
+    uint8_t tcp_flags;
+    uint8_t app_proto;        // PORT_APP_*, from the port registry
+    uint8_t flags;            // PACKET_SUMMARY_*
+    uint8_t reserved;
+} packet_summary_t;
+
+// Decodes an Ethernet frame into *summary. Always fills the summary as far
+// as the captured bytes allow; returns 0, or -1 if not even the Ethernet
+// header was captured.
+int packet_summary_decode(const uint8_t *data, size_t len, packet_summary_t *summary);
+
+// Fills in app_proto from the payload signatures when the ports left it
+// unknown, going through the flow's cached verdict. data is the frame the
+// summary was decoded from; cache is normally app_flow_shared_cache().
+void packet_summary_classify_flow(const uint8_t *data, packet_summary_t *summary, app_flow_cache_t *cache);
+
+#endif // PACKET_SUMMARY_H
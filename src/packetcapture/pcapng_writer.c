@@ -0,0 +1,336 @@
+#define _GNU_SOURCE
+#include "pcapng_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PCAPNG_BLOCK_SHB 0x0a0d0d0au
+#define PCAPNG_BLOCK_IDB 0x00000001u
+#define PCAPNG_BLOCK_EPB 0x00000006u
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4du
+#define PCAPNG_OPT_IF_TSRESOL 9
+
+#define SHB_LEN 28
+#define IDB_LEN 32
+#define EPB_HEADER_LEN 28  // type, length, if_id, ts_high, ts_low, caplen, wirelen
+#define EPB_TRAILER_LEN 4
+
+#define NSEC_PER_SEC 1000000000LL
+
+// what may be a file path; both parts are bounded so the message always
+// fits PCAPNG_WRITER_ERRBUF_SIZE with the errno text intact
+static void set_error(pcapng_writer_t *writer, const char *what) {
+    snprintf(writer->error, sizeof(writer->error), "%.170s: %.80s", what, strerror(errno));
+}
+
+static size_t align_up(size_t value, size_t align) {
+    return (value + align - 1) / align * align;
+}
+
+static void put32(uint8_t **p, uint32_t value) {
+    memcpy(*p, &value, sizeof(value));
+    *p += sizeof(value);
+}
+
+static void put16(uint8_t **p, uint16_t value) {
+    memcpy(*p, &value, sizeof(value));
+    *p += sizeof(value);
+}
+
+// O_DIRECT refused this write (filesystem or alignment): carry on buffered
+static int drop_direct(pcapng_writer_t *writer) {
+#ifdef O_DIRECT
+    int flags = fcntl(writer->fd, F_GETFL);
+    if (flags < 0 || fcntl(writer->fd, F_SETFL, flags & ~O_DIRECT) < 0) {
+        set_error(writer, "fcntl(O_DIRECT)");
+        return -1;
+    }
+#endif
+    writer->direct = 0;
+    return 0;
+}
+
+static int write_all(pcapng_writer_t *writer, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(writer->fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL && writer->direct) {
+                if (drop_direct(writer) < 0) {
+                    return -1;
+                }
+                continue;
+            }
+            set_error(writer, "write");
+            return -1;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+static int flush_buffer(pcapng_writer_t *writer, int final) {
+    size_t len = writer->buffer_used;
+
+    // Direct writes go out in whole pages; the tail waits for more data
+    if (writer->direct && !final) {
+        len -= len % PCAPNG_WRITER_DIRECT_ALIGN;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    if (writer->direct && len % PCAPNG_WRITER_DIRECT_ALIGN != 0 && drop_direct(writer) < 0) {
+        return -1;
+    }
+
+    if (write_all(writer, writer->buffer, len) < 0) {
+        return -1;
+    }
+
+    memmove(writer->buffer, writer->buffer + len, writer->buffer_used - len);
+    writer->buffer_used -= len;
+    writer->bytes_written += len;
+    return 0;
+}
+
+static void append_headers(pcapng_writer_t *writer) {
+    uint8_t *p = writer->buffer + writer->buffer_used;
+
+    // Section header: host byte order, unknown section length
+    put32(&p, PCAPNG_BLOCK_SHB);
+    put32(&p, SHB_LEN);
+    put32(&p, PCAPNG_BYTE_ORDER_MAGIC);
+    put16(&p, 1);
+    put16(&p, 0);
+    put32(&p, 0xffffffffu);
+    put32(&p, 0xffffffffu);
+    put32(&p, SHB_LEN);
+
+    // One interface with nanosecond timestamps (if_tsresol = 9)
+    put32(&p, PCAPNG_BLOCK_IDB);
+    put32(&p, IDB_LEN);
+    put16(&p, (uint16_t)writer->linktype);
+    put16(&p, 0);
+    put32(&p, writer->snaplen);
+    put16(&p, PCAPNG_OPT_IF_TSRESOL);
+    put16(&p, 1);
+    put32(&p, 9);  // value byte plus padding
+    put32(&p, 0);  // opt_endofopt
+    put32(&p, IDB_LEN);
+
+    writer->buffer_used += SHB_LEN + IDB_LEN;
+    writer->file_bytes += SHB_LEN + IDB_LEN;
+}
+
+static void format_path(pcapng_writer_t *writer) {
+    if (!writer->rotating) {
+        snprintf(writer->current_path, sizeof(writer->current_path), "%s", writer->base_path);
+        return;
+    }
+
+    char stamp[16];
+    time_t now = time(NULL);
+    struct tm local;
+    localtime_r(&now, &local);
+    strftime(stamp, sizeof(stamp), "%Y%m%d%H%M%S", &local);
+
+    // base_path has its extension stripped in pcapng_writer_open
+    snprintf(writer->current_path, sizeof(writer->current_path), "%.4000s_%05u_%s.pcapng",
+             writer->base_path, writer->file_number + 1, stamp);
+}
+
+static int open_next_file(pcapng_writer_t *writer) {
+    format_path(writer);
+
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    writer->fd = -1;
+    writer->direct = 0;
+#ifdef O_DIRECT
+    if (writer->want_direct) {
+        writer->fd = open(writer->current_path, flags | O_DIRECT, 0644);
+        writer->direct = writer->fd >= 0;
+    }
+#endif
+    if (writer->fd < 0) {
+        writer->fd = open(writer->current_path, flags, 0644);
+    }
+    if (writer->fd < 0) {
+        set_error(writer, writer->current_path);
+        return -1;
+    }
+
+    // Ring of files: the newest replaces the oldest
+    if (writer->ring_files > 0) {
+        unsigned int slot;
+        if (writer->ring_count == writer->ring_files) {
+            slot = writer->ring_oldest;
+            unlink(writer->ring_paths[slot]);
+            writer->ring_oldest = (writer->ring_oldest + 1) % writer->ring_files;
+        } else {
+            slot = (writer->ring_oldest + writer->ring_count) % writer->ring_files;
+            writer->ring_count++;
+        }
+        snprintf(writer->ring_paths[slot], PCAPNG_WRITER_PATH_SIZE, "%s", writer->current_path);
+    }
+
+    writer->file_number++;
+    writer->files_opened++;
+    writer->file_bytes = 0;
+    writer->file_start_ns = -1;
+    append_headers(writer);
+    return 0;
+}
+
+static int close_current_file(pcapng_writer_t *writer) {
+    if (writer->fd < 0) {
+        return 0;
+    }
+
+    int result = flush_buffer(writer, 1);
+    if (close(writer->fd) < 0 && result == 0) {
+        set_error(writer, "close");
+        result = -1;
+    }
+    writer->fd = -1;
+    writer->buffer_used = 0;
+    return result;
+}
+
+void pcapng_writer_default_config(pcapng_writer_config_t *config) {
+    memset(config, 0, sizeof(*config));
+    config->linktype = 1;  // LINKTYPE_ETHERNET
+    config->snaplen = PCAPNG_WRITER_DEFAULT_SNAPLEN;
+    config->buffer_size = PCAPNG_WRITER_DEFAULT_BUFFER_SIZE;
+    config->direct_io = 1;
+}
+
+int pcapng_writer_open(pcapng_writer_t *writer, const pcapng_writer_config_t *config) {
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+
+    if (!config->path || !config->path[0] || strlen(config->path) >= PCAPNG_WRITER_PATH_SIZE - 32) {
+        snprintf(writer->error, sizeof(writer->error), "Invalid capture file path");
+        return -1;
+    }
+
+    writer->linktype = config->linktype;
+    writer->snaplen = config->snaplen ? config->snaplen : PCAPNG_WRITER_DEFAULT_SNAPLEN;
+    writer->want_direct = config->direct_io;
+    writer->max_file_bytes = config->max_file_bytes;
+    writer->max_file_ns = (int64_t)config->max_file_seconds * NSEC_PER_SEC;
+    writer->rotating = config->max_file_bytes > 0 || config->max_file_seconds > 0;
+    writer->ring_files = writer->rotating ? config->ring_files : 0;
+
+    snprintf(writer->base_path, sizeof(writer->base_path), "%s", config->path);
+    if (writer->rotating) {
+        char *dot = strrchr(writer->base_path, '.');
+        char *slash = strrchr(writer->base_path, '/');
+        if (dot && (!slash || dot > slash + 1)) {
+            *dot = '\0';
+        }
+    }
+
+    // Room for the largest block plus the page tail an O_DIRECT flush keeps
+    size_t min_buffer = align_up(writer->snaplen + EPB_HEADER_LEN + EPB_TRAILER_LEN + 3 +
+                                 SHB_LEN + IDB_LEN + PCAPNG_WRITER_DIRECT_ALIGN,
+                                 PCAPNG_WRITER_DIRECT_ALIGN);
+    writer->buffer_size = align_up(config->buffer_size, PCAPNG_WRITER_DIRECT_ALIGN);
+    if (writer->buffer_size < min_buffer) {
+        writer->buffer_size = min_buffer;
+    }
+
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, PCAPNG_WRITER_DIRECT_ALIGN, writer->buffer_size) != 0) {
+        snprintf(writer->error, sizeof(writer->error), "Cannot allocate %zu byte write buffer", writer->buffer_size);
+        return -1;
+    }
+    writer->buffer = buffer;
+
+    if (writer->ring_files > 0) {
+        writer->ring_paths = calloc(writer->ring_files, sizeof(*writer->ring_paths));
+        if (!writer->ring_paths) {
+            set_error(writer, "calloc");
+            pcapng_writer_close(writer);
+            return -1;
+        }
+    }
+
+    if (open_next_file(writer) < 0) {
+        pcapng_writer_close(writer);
+        return -1;
+    }
+    return 0;
+}
+
+int pcapng_writer_write(pcapng_writer_t *writer, const uint8_t *data, uint32_t caplen,
+                        uint32_t wirelen, int64_t ts_ns) {
+    if (writer->fd < 0) {
+        snprintf(writer->error, sizeof(writer->error), "Writer is not open");
+        return -1;
+    }
+
+    if (caplen > writer->snaplen) {
+        caplen = writer->snaplen;
+    }
+    size_t padded = align_up(caplen, 4);
+    size_t block_len = EPB_HEADER_LEN + padded + EPB_TRAILER_LEN;
+
+    if (writer->rotating && writer->file_start_ns >= 0 &&
+        ((writer->max_file_bytes > 0 && writer->file_bytes + block_len > writer->max_file_bytes) ||
+         (writer->max_file_ns > 0 && ts_ns - writer->file_start_ns >= writer->max_file_ns))) {
+        if (close_current_file(writer) < 0 || open_next_file(writer) < 0) {
+            return -1;
+        }
+    }
+
+    if (block_len > writer->buffer_size - writer->buffer_used && flush_buffer(writer, 0) < 0) {
+        return -1;
+    }
+
+    uint64_t units = (uint64_t)ts_ns;
+    uint8_t *p = writer->buffer + writer->buffer_used;
+    put32(&p, PCAPNG_BLOCK_EPB);
+    put32(&p, (uint32_t)block_len);
+    put32(&p, 0);
+    put32(&p, (uint32_t)(units >> 32));
+    put32(&p, (uint32_t)units);
+    put32(&p, caplen);
+    put32(&p, wirelen < caplen ? caplen : wirelen);
+    memcpy(p, data, caplen);
+    memset(p + caplen, 0, padded - caplen);
+    p += padded;
+    put32(&p, (uint32_t)block_len);
+
+    writer->buffer_used += block_len;
+    writer->file_bytes += block_len;
+    writer->packets_written++;
+    if (writer->file_start_ns < 0) {
+        writer->file_start_ns = ts_ns;
+    }
+    return 0;
+}
+
+int pcapng_writer_flush(pcapng_writer_t *writer) {
+    if (writer->fd < 0) {
+        return 0;
+    }
+    return flush_buffer(writer, 0);
+}
+
+int pcapng_writer_close(pcapng_writer_t *writer) {
+    int result = close_current_file(writer);
+
+    free(writer->buffer);
+    writer->buffer = NULL;
+    free(writer->ring_paths);
+    writer->ring_paths = NULL;
+    return result;
+}
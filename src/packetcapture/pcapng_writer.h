@@ -0,0 +1,75 @@
+#ifndef PCAPNG_WRITER_H
+#define PCAPNG_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PCAPNG_WRITER_ERRBUF_SIZE 256
+#define PCAPNG_WRITER_PATH_SIZE 4096
+
+// Writes leave in 4 MiB chunks; O_DIRECT needs 4 KiB aligned lengths
+#define PCAPNG_WRITER_DEFAULT_BUFFER_SIZE (4u << 20)
+#define PCAPNG_WRITER_DIRECT_ALIGN 4096
+#define PCAPNG_WRITER_DEFAULT_SNAPLEN 262144
+
+// Output and rotation. With max_file_bytes and max_file_seconds both 0 the
+// capture goes to path as-is; otherwise files are named
+// <base>_<NNNNN>_<YYYYmmddHHMMSS>.pcapng next to it and, when ring_files is
+// non-zero, only the newest ring_files files are kept.
+typedef struct {
+    const char *path;
+    int linktype;
+    uint32_t snaplen;
+    size_t buffer_size;
+    int direct_io;
+    uint64_t max_file_bytes;
+    uint32_t max_file_seconds;
+    unsigned int ring_files;
+} pcapng_writer_config_t;
+
+typedef struct {
+    int fd;
+    int direct;            // fd is open with O_DIRECT
+    uint8_t *buffer;       // aligned for O_DIRECT
+    size_t buffer_size;
+    size_t buffer_used;
+
+    char base_path[PCAPNG_WRITER_PATH_SIZE];
+    char current_path[PCAPNG_WRITER_PATH_SIZE];
+    int rotating;
+    int want_direct;
+    int linktype;
+    uint32_t snaplen;
+    uint64_t max_file_bytes;
+    int64_t max_file_ns;
+    unsigned int ring_files;
+    char (*ring_paths)[PCAPNG_WRITER_PATH_SIZE];
+    unsigned int ring_count;   // files currently kept
+    unsigned int ring_oldest;  // index of the oldest kept file
+
+    unsigned int file_number;
+    uint64_t file_bytes;       // bytes of the current file, buffered included
+    int64_t file_start_ns;     // first packet in the current file, -1 if none
+
+    uint64_t packets_written;
+    uint64_t bytes_written;
+    unsigned int files_opened;
+    char error[PCAPNG_WRITER_ERRBUF_SIZE];
+} pcapng_writer_t;
+
+void pcapng_writer_default_config(pcapng_writer_config_t *config);
+int pcapng_writer_open(pcapng_writer_t *writer, const pcapng_writer_config_t *config);
+
+// Appends one Enhanced Packet Block, rotating first when the current file
+// is full or older than max_file_seconds (measured in packet time)
+int pcapng_writer_write(pcapng_writer_t *writer, const uint8_t *data, uint32_t caplen,
+                        uint32_t wirelen, int64_t ts_ns);
+
+// Hands buffered blocks to the kernel. With O_DIRECT a partial trailing
+// page stays buffered until the next flush or close.
+int pcapng_writer_flush(pcapng_writer_t *writer);
+
+// Writes everything out and closes the current file
+int pcapng_writer_close(pcapng_writer_t *writer);
+
+#endif // PCAPNG_WRITER_H
@@ -12,9 +12,10 @@
 #include <ctype.h> // for isprint
 
 // Enhanced TCP packet parsing with detailed analysis
-void parse_tcp_packet(const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip) {
+void parse_tcp_packet(dissect_ctx_t *ctx, const u_char *payload, int payload_len,
+                      const void *src_addr, const void *dst_addr, size_t addr_len) {
     if (payload_len < (int)sizeof(struct tcphdr)) {
-        printf("TCP packet too short\n");
+        dissect_note(ctx, payload, payload_len, "TCP packet too short");
         return;
     }
     
@@ -23,23 +24,31 @@ void parse_tcp_packet(const u_char *payload, int payload_len, uint32_t src_ip, u
     uint16_t dst_port = ntohs(tcp_hdr->dest);
     int tcp_header_len = tcp_hdr->doff * 4;
     
+    // Flows are keyed on the full addresses, so IPv6 flows that share
+    // their low 32 bits stay apart
+    uint64_t flow = app_flow_key(IPPROTO_TCP, src_addr, dst_addr, addr_len, src_port, dst_port);
+    uint32_t src_ip = 0, dst_ip = 0;
+    if (addr_len == sizeof(src_ip)) {
+        memcpy(&src_ip, src_addr, sizeof(src_ip));
+        memcpy(&dst_ip, dst_addr, sizeof(dst_ip));
+    }
+    
     // Use detailed TCP analyzer
-    parse_tcp_with_context(payload, payload_len, src_ip, dst_ip);
+    dissect_tcp(ctx, payload, payload_len, src_ip, dst_ip, flow);
     
     // Parse application layer if there's payload
     if (payload_len > tcp_header_len) {
         const u_char *app_payload = payload + tcp_header_len;
         int app_payload_len = payload_len - tcp_header_len;
-        parse_application_layer(app_payload, app_payload_len, src_port, dst_port, 1);
+        parse_application_layer(ctx, app_payload, app_payload_len, src_port, dst_port, 1, flow);
     }
 }
 
 // Enhanced UDP packet parsing with detailed analysis
-void parse_udp_packet(const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip) {
-    (void)src_ip; // Suppress unused parameter warning
-    (void)dst_ip; // Suppress unused parameter warning
+void parse_udp_packet(dissect_ctx_t *ctx, const u_char *payload, int payload_len,
+                      const void *src_addr, const void *dst_addr, size_t addr_len) {
     if (payload_len < (int)sizeof(struct udphdr)) {
-        printf("UDP packet too short\n");
+        dissect_note(ctx, payload, payload_len, "UDP packet too short");
         return;
     }
     
@@ -48,192 +57,142 @@ void parse_udp_packet(const u_char *payload, int payload_len, uint32_t src_ip, u
     uint16_t dst_port = ntohs(udp_hdr->dest);
     
     // Use detailed UDP analyzer
-    parse_udp(payload, payload_len);
+    dissect_udp(ctx, payload, payload_len);
     
     // Parse application layer
     const u_char *app_payload = payload + sizeof(struct udphdr);
     int app_payload_len = payload_len - sizeof(struct udphdr);
     
     if (app_payload_len > 0) {
-        parse_application_layer(app_payload, app_payload_len, src_port, dst_port, 0);
+        uint64_t flow = app_flow_key(IPPROTO_UDP, src_addr, dst_addr, addr_len, src_port, dst_port);
+        parse_application_layer(ctx, app_payload, app_payload_len, src_port, dst_port, 0, flow);
     }
 }
 
-// Parse application layer protocols
-void parse_application_layer(const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port, int is_tcp) {
+static int payload_starts_with(const u_char *payload, int payload_len, const char *prefix) {
+    int prefix_len = (int)strlen(prefix);
+    return payload_len >= prefix_len && memcmp(payload, prefix, prefix_len) == 0;
+}
+
+// Parse application layer protocols: registered ports first, then the
+// payload signatures, remembered per flow in the shared verdict cache
+void parse_application_layer(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port, int is_tcp, uint64_t flow_key) {
     if (payload_len <= 0) return;
     
-    // DNS (usually UDP port 53, but can be TCP)
-    if (src_port == 53 || dst_port == 53) {
-        printf("\n=== DNS Analysis ===\n");
+    switch (app_flow_classify(app_flow_shared_cache(), flow_key, is_tcp ? IPPROTO_TCP : IPPROTO_UDP,
+                              src_port, dst_port, payload, (size_t)payload_len)) {
+    case PORT_APP_DNS:
+        dissect_begin(ctx, "DNS Analysis", payload, payload_len);
         // Use the UDP's DNS parser for both TCP and UDP
-        parse_dns_packet(payload, payload_len, src_port, dst_port);
-        printf("===================\n");
-        return;
-    }
-    
-    // HTTP (TCP port 80)
-    if (is_tcp && (src_port == 80 || dst_port == 80)) {
+        parse_dns_packet(ctx, payload, payload_len, src_port, dst_port);
+        dissect_end(ctx);
+        break;
+        
+    case PORT_APP_HTTP:
         // Check if it looks like HTTP
-        if (payload_len > 4 && 
-            (strncmp((char*)payload, "GET ", 4) == 0 ||
-             strncmp((char*)payload, "POST ", 5) == 0 ||
-             strncmp((char*)payload, "HTTP/", 5) == 0 ||
-             strncmp((char*)payload, "PUT ", 4) == 0 ||
-             strncmp((char*)payload, "DELETE ", 7) == 0)) {
-            printf("\n=== HTTP Analysis ===\n");
-            parse_http(payload, payload_len);
-            printf("====================\n");
+        if (payload_starts_with(payload, payload_len, "GET ") ||
+            payload_starts_with(payload, payload_len, "POST ") ||
+            payload_starts_with(payload, payload_len, "HTTP/") ||
+            payload_starts_with(payload, payload_len, "PUT ") ||
+            payload_starts_with(payload, payload_len, "DELETE ")) {
+            dissect_http(ctx, payload, payload_len);
         }
-        return;
-    }
-    
-    // HTTPS/TLS (TCP port 443)
-    if (is_tcp && (src_port == 443 || dst_port == 443)) {
-        printf("\n=== HTTPS/TLS Analysis ===\n");
-        if (payload_len > 0 && payload[0] == 0x16) {
-            parse_tls_handshake(payload, payload_len);
-        } else if (payload_len > 0 && payload[0] == 0x15) {
-            printf("TLS Alert message detected\n");
-        } else if (payload_len > 0 && payload[0] == 0x17) {
-            printf("TLS Application Data (encrypted)\n");
+        break;
+        
+    case PORT_APP_HTTPS:
+        if (payload[0] == 0x16) {
+            dissect_tls_handshake(ctx, payload, payload_len);
+            break;
+        }
+        dissect_begin(ctx, "HTTPS/TLS Analysis", payload, payload_len);
+        if (payload[0] == 0x15) {
+            dissect_note(ctx, payload, 1, "TLS Alert message detected");
+        } else if (payload[0] == 0x17) {
+            dissect_note(ctx, payload, 1, "TLS Application Data (encrypted)");
         } else {
-            printf("Encrypted HTTPS traffic detected\n");
+            dissect_note(ctx, NULL, 0, "Encrypted HTTPS traffic detected");
         }
-        printf("=========================\n");
-        return;
-    }
-    
-    // QUIC (UDP port 443 or 80)
-    if (!is_tcp && (src_port == 443 || dst_port == 443 || src_port == 80 || dst_port == 80)) {
+        dissect_end(ctx);
+        break;
+        
+    case PORT_APP_QUIC:
         if (detect_quic_packet(payload, payload_len)) {
-            printf("\n=== QUIC Analysis ===\n");
-            parse_quic(payload, payload_len, (int)src_port, (int)dst_port);
-            printf("====================\n");
-            return;
+            dissect_quic(ctx, payload, payload_len, (int)src_port, (int)dst_port);
         }
+        break;
+        
+    case PORT_APP_DHCP:
+        dissect_dhcp(ctx, payload, payload_len);
+        break;
+        
+    case PORT_APP_SSH:
+        dissect_ssh(ctx, payload, payload_len, (int)src_port, (int)dst_port);
+        break;
+        
+    case PORT_APP_FTP:
+        dissect_ftp(ctx, payload, payload_len, (int)src_port, (int)dst_port);
+        break;
+        
+    case PORT_APP_SMTP:
+        dissect_smtp(ctx, payload, payload_len, (int)src_port, (int)dst_port);
+        break;
+        
+    case PORT_APP_IMAP:
+        dissect_imap(ctx, payload, payload_len, (int)src_port, (int)dst_port);
+        break;
+        
+    case PORT_APP_SNMP:
+        dissect_snmp(ctx, payload, payload_len, (int)src_port, (int)dst_port);
+        break;
+        
+    case PORT_APP_POP3: {
+        dissect_begin(ctx, "POP3 Analysis", payload, payload_len);
+        dissect_note(ctx, NULL, 0, "POP3 traffic detected (port %u <-> %u)", src_port, dst_port);
+        int preview_len = payload_len < 100 ? payload_len : 100;
+        dissect_buf_t preview;
+        dissect_buf_init(&preview);
+        dissect_buf_ascii(&preview, payload, preview_len);
+        dissect_field(ctx, "Data preview", payload, preview_len, "%s", preview.text);
+        dissect_end(ctx);
+        break;
     }
-    
-    // DHCP (UDP ports 67/68)
-    if (!is_tcp && ((src_port == 67 && dst_port == 68) || (src_port == 68 && dst_port == 67))) {
-        printf("\n=== DHCP Analysis ===\n");
-        parse_dhcp(payload, payload_len);
-        printf("====================\n");
-        return;
-    }
-    
-    // SSH (TCP port 22)
-    if (is_tcp && (src_port == 22 || dst_port == 22)) {
-        printf("\n=== SSH Analysis ===\n");
-        parse_ssh(payload, payload_len, (int)src_port, (int)dst_port);
-        printf("===================\n");
-        return;
-    }
-    
-    // FTP (TCP port 21 or 20)
-    if (is_tcp && (src_port == 21 || dst_port == 21 || src_port == 20 || dst_port == 20)) {
-        printf("\n=== FTP Analysis ===\n");
-        parse_ftp(payload, payload_len, (int)src_port, (int)dst_port);
-        printf("==================\n");
-        return;
-    }
-    
-    // SMTP (TCP port 25, 465, 587)
-    if (is_tcp && (src_port == 25 || dst_port == 25 || src_port == 465 || dst_port == 465 || src_port == 587 || dst_port == 587)) {
-        printf("\n=== SMTP Analysis ===\n");
-        parse_smtp(payload, payload_len, (int)src_port, (int)dst_port);
-        printf("===================\n");
-        return;
-    }
-    
-    // IMAP (TCP port 143, 993)
-    if (is_tcp && (src_port == 143 || dst_port == 143 || src_port == 993 || dst_port == 993)) {
-        printf("\n=== IMAP Analysis ===\n");
-        parse_imap(payload, payload_len, (int)src_port, (int)dst_port);
-        printf("===================\n");
-        return;
-    }
-    
-    // SNMP (UDP ports 161, 162)
-    if (!is_tcp && (src_port == 161 || dst_port == 161 || src_port == 162 || dst_port == 162)) {
-        printf("\n=== SNMP Analysis ===\n");
-        parse_snmp(payload, payload_len, (int)src_port, (int)dst_port);
-        printf("===================\n");
-        return;
-    }
-    
-    // Generic protocol detection for other common ports
-    if (is_tcp) {
-        // POP3 (TCP port 110, 995)
-        if (src_port == 110 || dst_port == 110 || src_port == 995 || dst_port == 995) {
-            printf("\n=== POP3 Analysis ===\n");
-            printf("POP3 traffic detected (port %u <-> %u)\n", src_port, dst_port);
-            if (payload_len > 0) {
-                printf("Data preview: ");
-                for (int i = 0; i < payload_len && i < 100; i++) {
-                    if (payload[i] >= 32 && payload[i] <= 126) {
-                        printf("%c", payload[i]);
-                    } else {
-                        printf(".");
-                    }
-                }
-                printf("\n");
-            }
-            printf("====================\n");
-            return;
-        }
         
-        // Telnet (TCP port 23)
-        if (src_port == 23 || dst_port == 23) {
-            printf("\n=== Telnet Analysis ===\n");
-            printf("Telnet traffic detected (port %u <-> %u)\n", src_port, dst_port);
-            printf("WARNING: Unencrypted protocol!\n");
-            printf("======================\n");
-            return;
-        }
-    } else {
-        // NTP (UDP port 123)
-        if (src_port == 123 || dst_port == 123) {
-            printf("\n=== NTP Analysis ===\n");
-            printf("NTP traffic detected (port %u <-> %u)\n", src_port, dst_port);
-            printf("Payload length: %d bytes\n", payload_len);
-            printf("==================\n");
-            return;
-        }
+    case PORT_APP_TELNET:
+        dissect_begin(ctx, "Telnet Analysis", payload, payload_len);
+        dissect_note(ctx, NULL, 0, "Telnet traffic detected (port %u <-> %u)", src_port, dst_port);
+        dissect_note(ctx, NULL, 0, "WARNING: Unencrypted protocol!");
+        dissect_end(ctx);
+        break;
         
-        // TFTP (UDP port 69)
-        if (src_port == 69 || dst_port == 69) {
-            printf("\n=== TFTP Analysis ===\n");
-            printf("TFTP traffic detected (port %u <-> %u)\n", src_port, dst_port);
-            printf("Payload length: %d bytes\n", payload_len);
-            printf("===================\n");
-            return;
-        }
+    case PORT_APP_NTP:
+        dissect_begin(ctx, "NTP Analysis", payload, payload_len);
+        dissect_note(ctx, NULL, 0, "NTP traffic detected (port %u <-> %u)", src_port, dst_port);
+        dissect_field(ctx, "Payload length", payload, payload_len, "%d bytes", payload_len);
+        dissect_end(ctx);
+        break;
+        
+    case PORT_APP_TFTP:
+        dissect_begin(ctx, "TFTP Analysis", payload, payload_len);
+        dissect_note(ctx, NULL, 0, "TFTP traffic detected (port %u <-> %u)", src_port, dst_port);
+        dissect_field(ctx, "Payload length", payload, payload_len, "%d bytes", payload_len);
+        dissect_end(ctx);
+        break;
+        
+    default:
+        // Registered without a dissector (NetBIOS, SIP) or not registered
+        break;
     }
 }
 
 // Helper functions for protocol identification (kept for compatibility)
 void identify_tcp_protocol(uint16_t src, uint16_t dst) {
-    if (src == 80 || dst == 80) printf("HTTP");
-    else if (src == 443 || dst == 443) printf("HTTPS (TLS/SSL)");
-    else if (src == 21 || dst == 21) printf("FTP");
-    else if (src == 25 || dst == 25) printf("SMTP");
-    else if (src == 110 || dst == 110) printf("POP3");
-    else if (src == 143 || dst == 143) printf("IMAP");
-    else if (src == 22 || dst == 22) printf("SSH");
-    else if (src == 139 || dst == 139) printf("NetBIOS");
-    else if (src == 5060 || dst == 5060 || src == 5061 || dst == 5061) printf("SIP");
-    else printf("TCP");
+    const char *name = port_registry_app_name(port_registry_classify(IPPROTO_TCP, src, dst));
+    printf("%s", name ? name : "TCP");
 }
 
 void identify_udp_protocol(uint16_t src, uint16_t dst) {
-    if (src == 53 || dst == 53) printf("DNS");
-    else if (src == 67 || dst == 67 || src == 68 || dst == 68) printf("DHCP");
-    else if (src == 123 || dst == 123) printf("NTP");
-    else if (src == 137 || dst == 137 || src == 138 || dst == 138) printf("NetBIOS");
-    else if (src == 161 || dst == 161 || src == 162 || dst == 162) printf("SNMP");
-    else if (src == 5060 || dst == 5060 || src == 5061 || dst == 5061) printf("SIP");
-    else printf("UDP");
+    const char *name = port_registry_app_name(port_registry_classify(IPPROTO_UDP, src, dst));
+    printf("%s", name ? name : "UDP");
 }
 
 // Function to print hex values and ASCII representation of a packet
@@ -261,113 +220,126 @@ void print_hex(const u_char *data, int len) {
     }
 }
 
-void identify_protocol(const u_char *packet, int packet_len) {
+static void dissect_mac(dissect_ctx_t *ctx, const char *name, const u_char *mac) {
+    dissect_field(ctx, name, mac, ETH_ALEN, "%02x:%02x:%02x:%02x:%02x:%02x",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+void dissect_packet(dissect_ctx_t *ctx, const u_char *packet, int packet_len) {
+    dissect_begin(ctx, "Frame", packet, packet_len);
+    dissect_field(ctx, "Packet Length", packet, packet_len, "%d bytes", packet_len);
+    dissect_end(ctx);
+
+    if (packet_len < (int)sizeof(struct ethhdr)) {
+        dissect_note(ctx, packet, packet_len, "Truncated Ethernet header");
+        return;
+    }
+
     struct ethhdr *eth = (struct ethhdr *)packet;
     uint16_t eth_type = ntohs(eth->h_proto);
     const u_char *payload = packet + sizeof(struct ethhdr);
+    int payload_len = packet_len - (int)sizeof(struct ethhdr);
 
-    printf("\n=== PACKET ANALYSIS ===\n");
-    printf("Packet Length: %d bytes\n", packet_len);
+    dissect_begin(ctx, "Ethernet II", packet, sizeof(struct ethhdr));
+    dissect_mac(ctx, "Destination", eth->h_dest);
+    dissect_mac(ctx, "Source", eth->h_source);
+    dissect_field(ctx, "Type", packet + 2 * ETH_ALEN, 2, "0x%04x", eth_type);
+    dissect_end(ctx);
 
     switch (eth_type) {
         case ETH_P_ARP:
-            printf("Protocol: ARP\n");
-            printf("=== ARP Analysis ===\n");
-            parse_arp(packet, packet_len);
-            printf("===================\n");
-            print_hex(packet, packet_len);
+            dissect_arp(ctx, packet, packet_len);
             return;
 
         case ETH_P_IP: {
-            printf("=== IPv4 Analysis ===\n");
-            parse_ipv4(payload, packet_len - sizeof(struct ethhdr));
-            printf("====================\n");
+            dissect_ipv4(ctx, payload, payload_len);
             
             struct iphdr *ip = (struct iphdr *)payload;
+            if (payload_len < (int)sizeof(struct iphdr) || payload_len < ip->ihl * 4) {
+                return;
+            }
 
             const u_char *transport_payload = payload + (ip->ihl * 4);
-            int transport_len = packet_len - sizeof(struct ethhdr) - (ip->ihl * 4);
+            int transport_len = payload_len - (ip->ihl * 4);
 
             switch (ip->protocol) {
                 case IPPROTO_ICMP:
-                    printf("\n=== ICMP Analysis ===\n");
-                    printf("ICMP packet detected\n");
-                    printf("====================\n");
+                    dissect_begin(ctx, "ICMP Analysis", transport_payload, transport_len);
+                    dissect_note(ctx, NULL, 0, "ICMP packet detected");
+                    dissect_end(ctx);
                     break;
 
                 case IPPROTO_TCP:
-                    parse_tcp_packet(transport_payload, transport_len, ip->saddr, ip->daddr);
+                    parse_tcp_packet(ctx, transport_payload, transport_len, &ip->saddr, &ip->daddr, sizeof(ip->saddr));
                     break;
 
                 case IPPROTO_UDP:
-                    parse_udp_packet(transport_payload, transport_len, ip->saddr, ip->daddr);
+                    parse_udp_packet(ctx, transport_payload, transport_len, &ip->saddr, &ip->daddr, sizeof(ip->saddr));
                     break;
 
                 default:
-                    printf("\n=== Unknown IPv4 Protocol ===\n");
-                    printf("Protocol Number: %d\n", ip->protocol);
-                    printf("=============================\n");
+                    dissect_begin(ctx, "Unknown IPv4 Protocol", transport_payload, transport_len);
+                    dissect_field(ctx, "Protocol Number", payload + 9, 1, "%d", ip->protocol);
+                    dissect_end(ctx);
                     break;
             }
-
-            printf("\n=== Raw Packet Data ===\n");
-            print_hex(packet, packet_len);
-            printf("======================\n");
             return;
         }
 
         case ETH_P_IPV6: {
-            printf("=== IPv6 Analysis ===\n");
-            parse_ipv6(payload, packet_len - sizeof(struct ethhdr));
-            printf("====================\n");
+            dissect_ipv6(ctx, payload, payload_len);
             
             struct ip6_hdr *ip6 = (struct ip6_hdr *)payload;
+            if (payload_len < (int)sizeof(struct ip6_hdr)) {
+                return;
+            }
 
             uint8_t nexthdr = ip6->ip6_nxt;
             const u_char *transport_payload = payload + sizeof(struct ip6_hdr);
-            int transport_len = packet_len - sizeof(struct ethhdr) - sizeof(struct ip6_hdr);
+            int transport_len = payload_len - (int)sizeof(struct ip6_hdr);
 
             switch (nexthdr) {
                 case IPPROTO_ICMPV6:
-                    printf("\n=== ICMPv6 Analysis ===\n");
-                    printf("ICMPv6 packet detected\n");
-                    printf("======================\n");
+                    dissect_begin(ctx, "ICMPv6 Analysis", transport_payload, transport_len);
+                    dissect_note(ctx, NULL, 0, "ICMPv6 packet detected");
+                    dissect_end(ctx);
                     break;
 
                 case IPPROTO_TCP:
-                    printf("\n[IPv6 Transport]\n");
-                    parse_tcp_packet(transport_payload, transport_len, 
-                                   *((uint32_t*)&ip6->ip6_src.s6_addr[12]), 
-                                   *((uint32_t*)&ip6->ip6_dst.s6_addr[12]));
+                    parse_tcp_packet(ctx, transport_payload, transport_len,
+                                   ip6->ip6_src.s6_addr, ip6->ip6_dst.s6_addr, sizeof(ip6->ip6_src));
                     break;
 
                 case IPPROTO_UDP:
-                    printf("\n[IPv6 Transport]\n");
-                    parse_udp_packet(transport_payload, transport_len, 
-                                   *((uint32_t*)&ip6->ip6_src.s6_addr[12]), 
-                                   *((uint32_t*)&ip6->ip6_dst.s6_addr[12]));
+                    parse_udp_packet(ctx, transport_payload, transport_len,
+                                   ip6->ip6_src.s6_addr, ip6->ip6_dst.s6_addr, sizeof(ip6->ip6_src));
                     break;
 
                 default:
-                    printf("\n=== Unknown IPv6 Protocol ===\n");
-                    printf("Next Header: %d\n", nexthdr);
-                    printf("=============================\n");
+                    dissect_begin(ctx, "Unknown IPv6 Protocol", transport_payload, transport_len);
+                    dissect_field(ctx, "Next Header", payload + 6, 1, "%d", nexthdr);
+                    dissect_end(ctx);
                     break;
             }
-
-            printf("\n=== Raw Packet Data ===\n");
-            print_hex(packet, packet_len);
-            printf("======================\n");
             return;
         }
 
         default:
-            printf("=== Unknown Ethernet Protocol ===\n");
-            printf("Ethernet Type: 0x%04x\n", eth_type);
-            printf("=================================\n");
-            print_hex(packet, packet_len);
+            dissect_begin(ctx, "Unknown Ethernet Protocol", payload, payload_len);
+            dissect_field(ctx, "Ethernet Type", packet + 2 * ETH_ALEN, 2, "0x%04x", eth_type);
+            dissect_end(ctx);
             return;
     }
-    
-    printf("========================\n");
+}
+
+void identify_protocol(dissect_state_t *state, const u_char *packet, int packet_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, state, packet, packet_len);
+
+    printf("\n");
+    dissect_packet(&ctx, packet, packet_len);
+
+    printf("\n=== Raw Packet Data ===\n");
+    print_hex(packet, packet_len);
+    printf("======================\n");
 }
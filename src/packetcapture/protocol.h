@@ -20,16 +20,29 @@
 #include "../protocols/dhcp/dhcp.h"
 #include "../protocols/https/https.h"
 #include "../protocols/quic/quic.h"
+#include "../protocols/dissect.h"
+#include "../protocols/dissect_state.h"
+#include "../protocols/port_registry.h"
+#include "../protocols/app_heuristics.h"
 
-// Main protocol identification functions
-void identify_protocol(const u_char *packet, int packet_len);
+// Main protocol identification functions. state collects the statistics;
+// give each thread that calls this its own.
+void identify_protocol(dissect_state_t *state, const u_char *packet, int packet_len);
 void identify_tcp_protocol(uint16_t src, uint16_t dst);
 void identify_udp_protocol(uint16_t src, uint16_t dst);
 void print_hex(const u_char *data, int len);
 
+// Walks an Ethernet frame through every protocol analyzer, reporting each
+// layer to ctx's visitor. identify_protocol() is this plus a hex dump on stdout.
+void dissect_packet(dissect_ctx_t *ctx, const u_char *packet, int packet_len);
+
 // Enhanced protocol parsing functions
-void parse_tcp_packet(const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip);
-void parse_udp_packet(const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip);
-void parse_application_layer(const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port, int is_tcp);
+// src_addr/dst_addr are the IP header's addresses, addr_len 4 or 16 bytes
+void parse_tcp_packet(dissect_ctx_t *ctx, const u_char *payload, int payload_len,
+                      const void *src_addr, const void *dst_addr, size_t addr_len);
+void parse_udp_packet(dissect_ctx_t *ctx, const u_char *payload, int payload_len,
+                      const void *src_addr, const void *dst_addr, size_t addr_len);
+// flow_key is app_flow_key() of the packet's flow, 0 to skip the verdict cache
+void parse_application_layer(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port, int is_tcp, uint64_t flow_key);
 
 #endif // PROTOCOL_H
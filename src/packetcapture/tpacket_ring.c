@@ -0,0 +1,257 @@
+#include "tpacket_ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <linux/if_ether.h>
+
+static void set_error(tpacket_ring_t *ring, const char *what) {
+    snprintf(ring->error, sizeof(ring->error), "%s: %s", what, strerror(errno));
+}
+
+static int is_power_of_two(unsigned int value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+void tpacket_ring_default_config(tpacket_ring_config_t *config) {
+    config->block_size = TPACKET_RING_DEFAULT_BLOCK_SIZE;
+    config->block_count = TPACKET_RING_DEFAULT_BLOCK_COUNT;
+    config->frame_size = TPACKET_RING_DEFAULT_FRAME_SIZE;
+    config->retire_timeout_ms = TPACKET_RING_DEFAULT_RETIRE_TIMEOUT_MS;
+    config->promiscuous = 1;
+}
+
+int tpacket_ring_open(tpacket_ring_t *ring, const char *ifname, const tpacket_ring_config_t *config) {
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0 || config->block_size % (unsigned int)page_size != 0 ||
+        !is_power_of_two(config->block_size)) {
+        snprintf(ring->error, sizeof(ring->error),
+                 "Block size %u must be a power-of-two multiple of the page size", config->block_size);
+        return -1;
+    }
+    if (config->block_count == 0 || config->frame_size < TPACKET_ALIGNMENT ||
+        config->frame_size % TPACKET_ALIGNMENT != 0 || config->block_size % config->frame_size != 0) {
+        snprintf(ring->error, sizeof(ring->error), "Invalid ring geometry (%u blocks, frame size %u)",
+                 config->block_count, config->frame_size);
+        return -1;
+    }
+
+    unsigned int ifindex = if_nametoindex(ifname);
+    if (ifindex == 0) {
+        set_error(ring, "if_nametoindex");
+        return -1;
+    }
+
+    ring->fd = socket(AF_PACKET, SOCK_RAW | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    if (ring->fd < 0) {
+        set_error(ring, "socket(AF_PACKET)");
+        return -1;
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        set_error(ring, "PACKET_VERSION");
+        tpacket_ring_close(ring);
+        return -1;
+    }
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = config->block_size;
+    req.tp_block_nr = config->block_count;
+    req.tp_frame_size = config->frame_size;
+    req.tp_frame_nr = (config->block_size / config->frame_size) * config->block_count;
+    req.tp_retire_blk_tov = config->retire_timeout_ms;
+    req.tp_feature_req_word = TP_FT_REQ_FILL_RXHASH;
+
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        set_error(ring, "PACKET_RX_RING");
+        tpacket_ring_close(ring);
+        return -1;
+    }
+
+    ring->map_len = (size_t)config->block_size * config->block_count;
+    void *map = mmap(NULL, ring->map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, 0);
+    if (map == MAP_FAILED) {
+        set_error(ring, "mmap");
+        ring->map_len = 0;
+        tpacket_ring_close(ring);
+        return -1;
+    }
+    ring->map = (uint8_t *)map;
+    ring->block_size = config->block_size;
+    ring->block_count = config->block_count;
+    ring->ifindex = (int)ifindex;
+
+    ring->block_held = calloc(config->block_count, sizeof(uint8_t));
+    if (!ring->block_held) {
+        set_error(ring, "calloc");
+        tpacket_ring_close(ring);
+        return -1;
+    }
+
+    // Bind after the ring exists so no frames are queued outside it
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = ring->ifindex;
+    if (bind(ring->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        set_error(ring, "bind");
+        tpacket_ring_close(ring);
+        return -1;
+    }
+
+    if (config->promiscuous) {
+        struct packet_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.mr_ifindex = ring->ifindex;
+        mreq.mr_type = PACKET_MR_PROMISC;
+        if (setsockopt(ring->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            set_error(ring, "PACKET_ADD_MEMBERSHIP");
+            tpacket_ring_close(ring);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void tpacket_ring_close(tpacket_ring_t *ring) {
+    free(ring->block_held);
+    ring->block_held = NULL;
+    if (ring->map) {
+        munmap(ring->map, ring->map_len);
+        ring->map = NULL;
+        ring->map_len = 0;
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+        ring->fd = -1;
+    }
+}
+
+struct tpacket_block_desc *tpacket_ring_next_block(tpacket_ring_t *ring) {
+    if (!ring->map) {
+        return NULL;
+    }
+
+    unsigned int index = ring->current_block;
+    struct tpacket_block_desc *block =
+        (struct tpacket_block_desc *)(ring->map + (size_t)index * ring->block_size);
+
+    // A block the consumer has not released yet still reads TP_STATUS_USER,
+    // so check ownership first. The release side clears the flag only after
+    // giving the block back, so a cleared flag never exposes a stale block.
+    if (__atomic_load_n(&ring->block_held[index], __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    // Pairs with the kernel's barrier before it flips the status to TP_STATUS_USER
+    uint32_t status = __atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+    if ((status & TP_STATUS_USER) == 0) {
+        return NULL;
+    }
+
+    __atomic_store_n(&ring->block_held[index], 1, __ATOMIC_RELAXED);
+    ring->current_block = (index + 1) % ring->block_count;
+    return block;
+}
+
+void tpacket_ring_release_block(tpacket_ring_t *ring, struct tpacket_block_desc *block) {
+    if (!ring->map || !block) {
+        return;
+    }
+
+    size_t index = (size_t)((uint8_t *)block - ring->map) / ring->block_size;
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->block_held[index], 0, __ATOMIC_RELEASE);
+}
+
+uint32_t tpacket_block_frame_count(const struct tpacket_block_desc *block) {
+    return block->hdr.bh1.num_pkts;
+}
+
+const struct tpacket3_hdr *tpacket_block_first_frame(const struct tpacket_block_desc *block) {
+    return (const struct tpacket3_hdr *)((const uint8_t *)block + block->hdr.bh1.offset_to_first_pkt);
+}
+
+const struct tpacket3_hdr *tpacket_block_next_frame(const struct tpacket3_hdr *frame) {
+    return (const struct tpacket3_hdr *)((const uint8_t *)frame + frame->tp_next_offset);
+}
+
+void tpacket_frame_info(const struct tpacket3_hdr *frame, tpacket_frame_t *info) {
+    info->data = (const uint8_t *)frame + frame->tp_mac;
+    info->caplen = frame->tp_snaplen;
+    info->wirelen = frame->tp_len;
+    info->ts_sec = frame->tp_sec;
+    info->ts_nsec = frame->tp_nsec;
+    info->rxhash = frame->hv1.tp_rxhash;
+}
+
+int tpacket_ring_join_fanout(tpacket_ring_t *ring, uint16_t group_id) {
+    if (ring->fd < 0) {
+        snprintf(ring->error, sizeof(ring->error), "Ring is not open");
+        return -1;
+    }
+
+    // Hash mode uses the kernel's symmetric flow hash; defragment first so
+    // every fragment of a datagram lands on the same member
+    uint32_t fanout_arg = group_id | ((uint32_t)(PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_FANOUT, &fanout_arg, sizeof(fanout_arg)) < 0) {
+        set_error(ring, "PACKET_FANOUT");
+        return -1;
+    }
+    return 0;
+}
+
+int tpacket_ring_set_filter(tpacket_ring_t *ring, const struct sock_filter *insns, unsigned short len) {
+    if (ring->fd < 0) {
+        snprintf(ring->error, sizeof(ring->error), "Ring is not open");
+        return -1;
+    }
+
+    if (!insns || len == 0) {
+        int dummy = 0;
+        // ENOENT just means no filter was attached
+        if (setsockopt(ring->fd, SOL_SOCKET, SO_DETACH_FILTER, &dummy, sizeof(dummy)) < 0 && errno != ENOENT) {
+            set_error(ring, "SO_DETACH_FILTER");
+            return -1;
+        }
+        return 0;
+    }
+
+    struct sock_fprog program;
+    program.len = len;
+    program.filter = (struct sock_filter *)insns;
+    if (setsockopt(ring->fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) < 0) {
+        set_error(ring, "SO_ATTACH_FILTER");
+        return -1;
+    }
+    return 0;
+}
+
+int tpacket_ring_stats(tpacket_ring_t *ring, tpacket_ring_stats_t *stats) {
+    struct tpacket_stats_v3 kstats;
+    socklen_t len = sizeof(kstats);
+    memset(&kstats, 0, sizeof(kstats));
+
+    if (ring->fd < 0 || getsockopt(ring->fd, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) < 0) {
+        set_error(ring, "PACKET_STATISTICS");
+        return -1;
+    }
+
+    stats->packets = kstats.tp_packets;
+    stats->drops = kstats.tp_drops;
+    stats->freeze_count = kstats.tp_freeze_q_cnt;
+    return 0;
+}
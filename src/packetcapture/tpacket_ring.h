@@ -0,0 +1,82 @@
+#ifndef TPACKET_RING_H
+#define TPACKET_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+#define TPACKET_RING_ERRBUF_SIZE 256
+
+// Defaults sized for bursty 1 GbE traffic: 64 x 1 MiB blocks
+#define TPACKET_RING_DEFAULT_BLOCK_SIZE (1u << 20)
+#define TPACKET_RING_DEFAULT_BLOCK_COUNT 64
+#define TPACKET_RING_DEFAULT_FRAME_SIZE 2048
+#define TPACKET_RING_DEFAULT_RETIRE_TIMEOUT_MS 60
+
+// Ring geometry; block_size must be a power-of-two multiple of the page size
+typedef struct {
+    unsigned int block_size;
+    unsigned int block_count;
+    unsigned int frame_size;
+    unsigned int retire_timeout_ms;
+    int promiscuous;
+} tpacket_ring_config_t;
+
+// Memory-mapped AF_PACKET TPACKET_V3 receive ring
+typedef struct {
+    int fd;
+    int ifindex;
+    uint8_t *map;
+    size_t map_len;
+    unsigned int block_size;
+    unsigned int block_count;
+    unsigned int current_block;
+    uint8_t *block_held;  // set while a handed-out block is still in use
+    char error[TPACKET_RING_ERRBUF_SIZE];
+} tpacket_ring_t;
+
+// One frame inside a retired block; data points into the mapped ring
+typedef struct {
+    const uint8_t *data;
+    uint32_t caplen;
+    uint32_t wirelen;
+    uint32_t ts_sec;
+    uint32_t ts_nsec;
+    uint32_t rxhash;
+} tpacket_frame_t;
+
+// Kernel counters since the last call (PACKET_STATISTICS resets on read)
+typedef struct {
+    uint32_t packets;
+    uint32_t drops;
+    uint32_t freeze_count;
+} tpacket_ring_stats_t;
+
+void tpacket_ring_default_config(tpacket_ring_config_t *config);
+int tpacket_ring_open(tpacket_ring_t *ring, const char *ifname, const tpacket_ring_config_t *config);
+void tpacket_ring_close(tpacket_ring_t *ring);
+
+// Block hand-out: returns the next block owned by user space, or NULL when
+// the kernel has not retired it yet (or it is still held from a previous
+// lap). Blocks may be released in any order, from any thread, with
+// tpacket_ring_release_block once their frames are no longer needed.
+struct tpacket_block_desc *tpacket_ring_next_block(tpacket_ring_t *ring);
+void tpacket_ring_release_block(tpacket_ring_t *ring, struct tpacket_block_desc *block);
+
+// Frame iteration within a block
+uint32_t tpacket_block_frame_count(const struct tpacket_block_desc *block);
+const struct tpacket3_hdr *tpacket_block_first_frame(const struct tpacket_block_desc *block);
+const struct tpacket3_hdr *tpacket_block_next_frame(const struct tpacket3_hdr *frame);
+void tpacket_frame_info(const struct tpacket3_hdr *frame, tpacket_frame_t *info);
+
+// Joins a PACKET_FANOUT group in symmetric hash mode so both directions of
+// a flow are delivered to the same ring. Every member must use the same
+// group_id; call after tpacket_ring_open.
+int tpacket_ring_join_fanout(tpacket_ring_t *ring, uint16_t group_id);
+
+// Classic BPF filter; pass NULL/0 to detach
+int tpacket_ring_set_filter(tpacket_ring_t *ring, const struct sock_filter *insns, unsigned short len);
+int tpacket_ring_stats(tpacket_ring_t *ring, tpacket_ring_stats_t *stats);
+
+#endif // TPACKET_RING_H
@@ -0,0 +1,232 @@
+#include "app_heuristics.h"
+
+#include <pthread.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define L4_TCP 6
+#define L4_UDP 17
+
+// Bytes of payload a signature can look at; one SSE2 register
+#define SIG_WIDTH 16
+
+#define SIG_TCP 0x01
+#define SIG_UDP 0x02
+
+// A signature matches when (payload[i] & mask[i]) == bytes[i] for every
+// byte it gives and the payload is at least min_len long
+typedef struct {
+    uint8_t l4;         // SIG_TCP and/or SIG_UDP
+    uint8_t app;        // PORT_APP_*
+    uint8_t min_len;
+    uint8_t len;        // bytes used from text (may contain NULs)
+    const char *text;
+    const char *mask;   // len bytes, NULL to compare text exactly
+} signature_t;
+
+#define LITERAL(l4, app, text) { l4, app, sizeof(text) - 1, sizeof(text) - 1, text, NULL }
+#define MASKED(l4, app, min_len, text, mask) { l4, app, min_len, sizeof(text) - 1, text, mask }
+
+// First match in table order wins
+static const signature_t signatures[] = {
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "GET "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "POST "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "PUT "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "HEAD "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "DELETE "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "OPTIONS "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "PATCH "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "CONNECT "),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "HTTP/1."),
+    LITERAL(SIG_TCP, PORT_APP_HTTP, "PRI * HTTP/2.0"),
+
+    // TLS record header: handshake, application data, alert, change
+    // cipher spec; versions 3.0-3.4
+    MASKED(SIG_TCP, PORT_APP_HTTPS, 5, "\x16\x03\x00", "\xff\xff\xf8"),
+    MASKED(SIG_TCP, PORT_APP_HTTPS, 5, "\x17\x03\x00", "\xff\xff\xf8"),
+    MASKED(SIG_TCP, PORT_APP_HTTPS, 5, "\x15\x03\x00", "\xff\xff\xf8"),
+    MASKED(SIG_TCP, PORT_APP_HTTPS, 5, "\x14\x03\x00", "\xff\xff\xf8"),
+
+    LITERAL(SIG_TCP, PORT_APP_SSH, "SSH-"),
+
+    LITERAL(SIG_TCP, PORT_APP_SMTP, "EHLO "),
+    LITERAL(SIG_TCP, PORT_APP_SMTP, "HELO "),
+    // Shared by SMTP and FTP servers, told apart in refine()
+    LITERAL(SIG_TCP, PORT_APP_FTP, "220 "),
+    LITERAL(SIG_TCP, PORT_APP_FTP, "220-"),
+    LITERAL(SIG_TCP, PORT_APP_IMAP, "* OK "),
+    LITERAL(SIG_TCP, PORT_APP_POP3, "+OK"),
+
+    // QUIC long header (form and fixed bits set), version 1 and 2
+    MASKED(SIG_UDP, PORT_APP_QUIC, 7, "\xc0\x00\x00\x00\x01", "\xc0\xff\xff\xff\xff"),
+    MASKED(SIG_UDP, PORT_APP_QUIC, 7, "\xc0\x6b\x33\x43\xcf", "\xc0\xff\xff\xff\xff"),
+
+    // DNS header sanity: standard query opcode, Z bit clear, one question,
+    // fewer than 256 records per section; room for the root question
+    MASKED(SIG_UDP, PORT_APP_DNS, 17,
+           "\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00",
+           "\x00\x00\x78\x40\xff\xff\xff\x00\xff\x00\xff\x00"),
+};
+
+#define SIGNATURE_COUNT ((int)(sizeof(signatures) / sizeof(signatures[0])))
+_Static_assert(SIGNATURE_COUNT <= 64, "candidate sets are 64-bit masks");
+
+typedef struct {
+    uint8_t pattern[SIG_WIDTH];  // already masked
+    uint8_t mask[SIG_WIDTH];     // 0 past the end of the signature
+    uint8_t min_len;
+    uint8_t app;
+} compiled_signature_t;
+
+static compiled_signature_t compiled[SIGNATURE_COUNT];
+// [0 = TCP, 1 = UDP][first payload byte] -> signatures that can match
+static uint64_t candidates[2][256];
+static pthread_once_t compile_once = PTHREAD_ONCE_INIT;
+
+static void compile_signatures(void) {
+    for (int i = 0; i < SIGNATURE_COUNT; i++) {
+        const signature_t *sig = &signatures[i];
+        compiled_signature_t *out = &compiled[i];
+        for (int b = 0; b < sig->len && b < SIG_WIDTH; b++) {
+            out->mask[b] = sig->mask ? (uint8_t)sig->mask[b] : 0xff;
+            out->pattern[b] = (uint8_t)sig->text[b] & out->mask[b];
+        }
+        out->min_len = sig->min_len;
+        out->app = sig->app;
+
+        for (int first = 0; first < 256; first++) {
+            if ((first & out->mask[0]) != out->pattern[0]) {
+                continue;
+            }
+            if (sig->l4 & SIG_TCP) candidates[0][first] |= 1ULL << i;
+            if (sig->l4 & SIG_UDP) candidates[1][first] |= 1ULL << i;
+        }
+    }
+}
+
+// "220" opens both SMTP and FTP sessions; mail servers say so in the banner
+static uint8_t refine(uint8_t app, const uint8_t *payload, size_t len) {
+    if (app != PORT_APP_FTP || payload[0] != '2') {
+        return app;
+    }
+    size_t line = len < 128 ? len : 128;
+    for (size_t i = 0; i + 4 <= line && payload[i] != '\r' && payload[i] != '\n'; i++) {
+        if (memcmp(payload + i, "SMTP", 4) == 0) {
+            return PORT_APP_SMTP;
+        }
+    }
+    return app;
+}
+
+uint8_t app_heuristics_match(uint8_t l4_proto, const uint8_t *payload, size_t len) {
+    int l4 = l4_proto == L4_TCP ? 0 : l4_proto == L4_UDP ? 1 : -1;
+    if (l4 < 0 || !payload || len == 0) {
+        return PORT_APP_NONE;
+    }
+
+    pthread_once(&compile_once, compile_signatures);
+    uint64_t pending = candidates[l4][payload[0]];
+    if (!pending) {
+        return PORT_APP_NONE;
+    }
+
+    // Short payloads are zero-padded; min_len keeps the padding from matching
+    uint8_t window[SIG_WIDTH] = {0};
+    memcpy(window, payload, len < SIG_WIDTH ? len : SIG_WIDTH);
+#ifdef __SSE2__
+    __m128i data = _mm_loadu_si128((const __m128i *)window);
+#else
+    uint64_t data[2];
+    memcpy(data, window, sizeof(data));
+#endif
+
+    while (pending) {
+        int i = __builtin_ctzll(pending);
+        pending &= pending - 1;
+        const compiled_signature_t *sig = &compiled[i];
+        if (len < sig->min_len) {
+            continue;
+        }
+#ifdef __SSE2__
+        // All 16 bytes compared at once; masked-off bytes compare 0 == 0
+        __m128i masked = _mm_and_si128(data, _mm_loadu_si128((const __m128i *)sig->mask));
+        __m128i equal = _mm_cmpeq_epi8(masked, _mm_loadu_si128((const __m128i *)sig->pattern));
+        if (_mm_movemask_epi8(equal) != 0xffff) {
+            continue;
+        }
+#else
+        uint64_t mask[2], pattern[2];
+        memcpy(mask, sig->mask, sizeof(mask));
+        memcpy(pattern, sig->pattern, sizeof(pattern));
+        if ((data[0] & mask[0]) != pattern[0] || (data[1] & mask[1]) != pattern[1]) {
+            continue;
+        }
+#endif
+        return refine(sig->app, payload, len);
+    }
+    return PORT_APP_NONE;
+}
+
+void app_flow_cache_init(app_flow_cache_t *cache) {
+    memset(cache, 0, sizeof(*cache));
+}
+
+app_flow_cache_t *app_flow_shared_cache(void) {
+    static app_flow_cache_t shared;
+    return &shared;
+}
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t len) {
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t app_flow_key(uint8_t l4_proto, const void *src_addr, const void *dst_addr, size_t addr_len,
+                      uint16_t src_port, uint16_t dst_port) {
+    // Hash the endpoints in a fixed order so both directions agree
+    int order = memcmp(src_addr, dst_addr, addr_len);
+    int src_first = order < 0 || (order == 0 && src_port <= dst_port);
+    const void *first_addr = src_first ? src_addr : dst_addr;
+    const void *second_addr = src_first ? dst_addr : src_addr;
+    uint16_t first_port = src_first ? src_port : dst_port;
+    uint16_t second_port = src_first ? dst_port : src_port;
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = fnv1a(hash, &l4_proto, sizeof(l4_proto));
+    hash = fnv1a(hash, first_addr, addr_len);
+    hash = fnv1a(hash, &first_port, sizeof(first_port));
+    hash = fnv1a(hash, second_addr, addr_len);
+    hash = fnv1a(hash, &second_port, sizeof(second_port));
+    return hash ? hash : 1;
+}
+
+uint8_t app_flow_classify(app_flow_cache_t *cache, uint64_t flow_key, uint8_t l4_proto,
+                          uint16_t src_port, uint16_t dst_port, const uint8_t *payload, size_t len) {
+    uint8_t app = port_registry_classify(l4_proto, src_port, dst_port);
+    if (app != PORT_APP_NONE) {
+        return app;
+    }
+    if (!cache || flow_key == 0) {
+        return app_heuristics_match(l4_proto, payload, len);
+    }
+
+    uint64_t *slot = &cache->slots[(flow_key * 0x9e3779b97f4a7c15ULL) >> (64 - APP_FLOW_CACHE_BITS)];
+    uint64_t tag = flow_key & ~(uint64_t)0xff;
+    uint64_t entry = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    if ((entry & 0xff) != PORT_APP_NONE && (entry & ~(uint64_t)0xff) == tag) {
+        return (uint8_t)entry;
+    }
+
+    // Handshakes, bare ACKs and unrecognised data leave the flow open for
+    // a later packet to decide
+    app = app_heuristics_match(l4_proto, payload, len);
+    if (app != PORT_APP_NONE) {
+        __atomic_store_n(slot, tag | app, __ATOMIC_RELAXED);
+    }
+    return app;
+}
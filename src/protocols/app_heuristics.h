@@ -0,0 +1,48 @@
+#ifndef APP_HEURISTICS_H
+#define APP_HEURISTICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "port_registry.h"
+
+// Content-based classification for traffic on ports the registry does not
+// know. The first bytes of a payload are matched against a compiled set of
+// signatures (HTTP methods and status lines, TLS records, SSH banners,
+// mail/FTP greetings, QUIC long headers, DNS headers); a match is cached
+// per flow so the rest of the flow is not inspected again.
+
+// Direct-mapped, so a busy capture evicts instead of growing
+#define APP_FLOW_CACHE_BITS 12
+#define APP_FLOW_CACHE_SLOTS (1 << APP_FLOW_CACHE_BITS)
+
+// Each slot is one word: the top 56 bits of the flow key and the PORT_APP_*
+// verdict in the low byte, 0 when empty. Slots are read and written with
+// single atomic loads and stores, so one cache can be shared by every
+// thread without locking. All zeroes is a valid empty cache.
+typedef struct {
+    uint64_t slots[APP_FLOW_CACHE_SLOTS];
+} app_flow_cache_t;
+
+void app_flow_cache_init(app_flow_cache_t *cache);
+
+// The cache the packet list and the dissectors share, so a flow gets the
+// same verdict whichever thread or view classifies it
+app_flow_cache_t *app_flow_shared_cache(void);
+
+// Same key for both directions of a flow; never 0. addr_len is 4 or 16.
+uint64_t app_flow_key(uint8_t l4_proto, const void *src_addr, const void *dst_addr, size_t addr_len,
+                      uint16_t src_port, uint16_t dst_port);
+
+// PORT_APP_* whose signature the payload starts with, PORT_APP_NONE if none
+uint8_t app_heuristics_match(uint8_t l4_proto, const uint8_t *payload, size_t len);
+
+// The port registry first (decode-as included), then the flow's cached
+// verdict, then the signatures. The first payload that matches a
+// signature decides an unregistered flow. A payload that matches nothing
+// is not cached, since it may come from the middle of a flow whose
+// opening was missed or is still being classified on another thread.
+// cache may be NULL and flow_key 0 to skip caching.
+uint8_t app_flow_classify(app_flow_cache_t *cache, uint64_t flow_key, uint8_t l4_proto,
+                          uint16_t src_port, uint16_t dst_port, const uint8_t *payload, size_t len);
+
+#endif // APP_HEURISTICS_H
@@ -4,31 +4,7 @@
 #include <arpa/inet.h>
 #include <pcap.h>
 #include "arp.h"
-
-// Simple IP->MAC table to flag changes (potential ARP poisoning)
-#define ARP_SEEN_MAX 64
-struct arp_seen_entry {
-    uint32_t ip_be; // IPv4 in network byte order
-    unsigned char mac[6];
-    int in_use;
-};
-static struct arp_seen_entry arp_seen[ARP_SEEN_MAX];
-
-// Simple MAC->IP table to flag a MAC claiming many IPs
-struct mac_seen_entry {
-    unsigned char mac[6];
-    uint32_t ip_be; // last IP observed for this MAC
-    int in_use;
-};
-static struct mac_seen_entry mac_seen[ARP_SEEN_MAX];
-
-// Track potential ARP scans: unique targets queried by a given source MAC
-struct scan_entry {
-    unsigned char mac[6];
-    uint32_t targets[16]; // up to 16 unique targets tracked
-    int in_use;
-};
-static struct scan_entry scan_table[ARP_SEEN_MAX];
+#include "../dissect_state.h"
 
 static void mac_to_str(const unsigned char *m, char *out, size_t outlen) {
     snprintf(out, outlen, "%02x:%02x:%02x:%02x:%02x:%02x",
@@ -86,28 +62,29 @@ int main(int argc, char **argv) {
 }
 #endif
 
-static void arp_seen_update(uint32_t ip_be, const unsigned char *mac) {
+static void arp_seen_update(dissect_ctx_t *ctx, uint32_t ip_be, const unsigned char *mac) {
+    arp_state_t *state = &ctx->state->arp;
     // Look for existing
     for (int i = 0; i < ARP_SEEN_MAX; i++) {
-        if (arp_seen[i].in_use && arp_seen[i].ip_be == ip_be) {
-            if (memcmp(arp_seen[i].mac, mac, 6) != 0) {
+        if (state->arp_seen[i].in_use && state->arp_seen[i].ip_be == ip_be) {
+            if (memcmp(state->arp_seen[i].mac, mac, 6) != 0) {
                 char oldm[18], newm[18];
-                mac_to_str(arp_seen[i].mac, oldm, sizeof(oldm));
+                mac_to_str(state->arp_seen[i].mac, oldm, sizeof(oldm));
                 mac_to_str(mac, newm, sizeof(newm));
-                struct in_addr a; a.s_addr = ip_be;
-                printf("[Alert] ARP mapping change for %s: %s -> %s\n",
-                       inet_ntoa(a), oldm, newm);
-                memcpy(arp_seen[i].mac, mac, 6);
+                char ip[INET_ADDRSTRLEN];
+                inet_ntop(AF_INET, &ip_be, ip, sizeof(ip));
+                dissect_note(ctx, NULL, 0, "[Alert] ARP mapping change for %s: %s -> %s", ip, oldm, newm);
+                memcpy(state->arp_seen[i].mac, mac, 6);
             }
             return;
         }
     }
     // Insert new
     for (int i = 0; i < ARP_SEEN_MAX; i++) {
-        if (!arp_seen[i].in_use) {
-            arp_seen[i].in_use = 1;
-            arp_seen[i].ip_be = ip_be;
-            memcpy(arp_seen[i].mac, mac, 6);
+        if (!state->arp_seen[i].in_use) {
+            state->arp_seen[i].in_use = 1;
+            state->arp_seen[i].ip_be = ip_be;
+            memcpy(state->arp_seen[i].mac, mac, 6);
             return;
         }
     }
@@ -142,6 +119,13 @@ static int find_arp_offset(const u_char *packet, int packet_len, int *vlan_ids,
 }
 
 void parse_arp(const u_char *packet, int packet_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), packet, packet_len);
+    dissect_arp(&ctx, packet, packet_len);
+}
+
+void dissect_arp(dissect_ctx_t *ctx, const u_char *packet, int packet_len) {
+    arp_state_t *state = &ctx->state->arp;
     int vlan_ids[2] = {0, 0};
     int vlan_count = 0;
     int off = find_arp_offset(packet, packet_len, vlan_ids, &vlan_count);
@@ -156,8 +140,9 @@ void parse_arp(const u_char *packet, int packet_len) {
     unsigned char pln = arp->ea_hdr.ar_pln;
     uint16_t op = ntohs(arp->ea_hdr.ar_op);
     if (!(hrd == ARPHRD_ETHER && pro == ETH_P_IP && hln == 6 && pln == 4)) {
-        printf("ARP (non-IPv4 or non-Ethernet): hrd=%u pro=0x%04x hln=%u pln=%u op=%u\n",
-               hrd, pro, hln, pln, op);
+        dissect_note(ctx, (const u_char *)arp, sizeof(arp->ea_hdr),
+                     "ARP (non-IPv4 or non-Ethernet): hrd=%u pro=0x%04x hln=%u pln=%u op=%u",
+                     hrd, pro, hln, pln, op);
         return;
     }
 
@@ -173,10 +158,13 @@ void parse_arp(const u_char *packet, int packet_len) {
     int probe = (op == ARPOP_REQUEST && *(const uint32_t *)arp->arp_spa == 0);
     int target_mac_zero = (arp->arp_tha[0]|arp->arp_tha[1]|arp->arp_tha[2]|arp->arp_tha[3]|arp->arp_tha[4]|arp->arp_tha[5]) == 0;
 
+    char vlan[24] = "";
+    if (vlan_count == 1) snprintf(vlan, sizeof(vlan), "VLAN %d: ", vlan_ids[0]);
+    else if (vlan_count == 2) snprintf(vlan, sizeof(vlan), "VLAN %d/%d: ", vlan_ids[0], vlan_ids[1]);
+
     if (op == ARPOP_REQUEST) {
-        if (vlan_count == 1) printf("VLAN %d: ", vlan_ids[0]);
-        else if (vlan_count == 2) printf("VLAN %d/%d: ", vlan_ids[0], vlan_ids[1]);
-        printf("ARP who-has %s tell %s (%s)%s%s\n",
+        dissect_note(ctx, (const u_char *)arp, sizeof(*arp), "%sARP who-has %s tell %s (%s)%s%s",
+               vlan,
                dst_ip,
                src_ip,
                sha,
@@ -184,63 +172,69 @@ void parse_arp(const u_char *packet, int packet_len) {
                (!target_mac_zero ? " [warn: target MAC set in request]" : ""));
         // Update scan table: count unique targets per source MAC
         for (int i = 0; i < ARP_SEEN_MAX; i++) {
-            if (scan_table[i].in_use && memcmp(scan_table[i].mac, arp->arp_sha, 6) == 0) {
+            if (state->scan_table[i].in_use && memcmp(state->scan_table[i].mac, arp->arp_sha, 6) == 0) {
                 uint32_t tip; memcpy(&tip, arp->arp_tpa, 4);
                 int known = 0;
-                for (int j = 0; j < 16; j++) if (scan_table[i].targets[j] == tip) { known = 1; break; }
+                for (int j = 0; j < 16; j++) if (state->scan_table[i].targets[j] == tip) { known = 1; break; }
                 if (!known) {
-                    for (int j = 0; j < 16; j++) if (scan_table[i].targets[j] == 0) { scan_table[i].targets[j] = tip; break; }
-                    int unique = 0; for (int j = 0; j < 16; j++) if (scan_table[i].targets[j] != 0) unique++;
+                    for (int j = 0; j < 16; j++) if (state->scan_table[i].targets[j] == 0) { state->scan_table[i].targets[j] = tip; break; }
+                    int unique = 0; for (int j = 0; j < 16; j++) if (state->scan_table[i].targets[j] != 0) unique++;
                     if (unique >= 10) {
-                        printf("[Notice] %s sent ARP requests to %d+ unique targets (possible scan)\n", sha, unique);
+                        dissect_note(ctx, NULL, 0, "[Notice] %s sent ARP requests to %d+ unique targets (possible scan)", sha, unique);
                     }
                 }
                 goto scan_done;
             }
         }
         for (int i = 0; i < ARP_SEEN_MAX; i++) {
-            if (!scan_table[i].in_use) {
-                scan_table[i].in_use = 1;
-                memcpy(scan_table[i].mac, arp->arp_sha, 6);
-                memcpy(&scan_table[i].targets[0], arp->arp_tpa, 4);
+            if (!state->scan_table[i].in_use) {
+                state->scan_table[i].in_use = 1;
+                memcpy(state->scan_table[i].mac, arp->arp_sha, 6);
+                memcpy(&state->scan_table[i].targets[0], arp->arp_tpa, 4);
                 break;
             }
         }
 scan_done:
     } else if (op == ARPOP_REPLY) {
-        if (vlan_count == 1) printf("VLAN %d: ", vlan_ids[0]);
-        else if (vlan_count == 2) printf("VLAN %d/%d: ", vlan_ids[0], vlan_ids[1]);
-        printf("ARP %s is-at %s%s%s\n",
+        dissect_note(ctx, (const u_char *)arp, sizeof(*arp), "%sARP %s is-at %s%s%s",
+               vlan,
                src_ip,
                sha,
                gratuitous ? " [gratuitous]" : "",
                target_mac_zero ? " [warn: target MAC zero in reply]" : "");
         // Update seen table on replies
         uint32_t ip_be; memcpy(&ip_be, arp->arp_spa, 4);
-        arp_seen_update(ip_be, arp->arp_sha);
+        arp_seen_update(ctx, ip_be, arp->arp_sha);
         // MAC->IP observation (flag MAC claiming many different IPs)
         for (int i = 0; i < ARP_SEEN_MAX; i++) {
-            if (mac_seen[i].in_use && memcmp(mac_seen[i].mac, arp->arp_sha, 6) == 0) {
-                if (mac_seen[i].ip_be != ip_be) {
-                    struct in_addr a; a.s_addr = mac_seen[i].ip_be;
-                    printf("[Notice] %s now also claims %s (was %s)\n", sha, src_ip, inet_ntoa(a));
-                    mac_seen[i].ip_be = ip_be;
+            if (state->mac_seen[i].in_use && memcmp(state->mac_seen[i].mac, arp->arp_sha, 6) == 0) {
+                if (state->mac_seen[i].ip_be != ip_be) {
+                    char was[INET_ADDRSTRLEN];
+                    inet_ntop(AF_INET, &state->mac_seen[i].ip_be, was, sizeof(was));
+                    dissect_note(ctx, NULL, 0, "[Notice] %s now also claims %s (was %s)", sha, src_ip, was);
+                    state->mac_seen[i].ip_be = ip_be;
                 }
                 goto mac_done;
             }
         }
         for (int i = 0; i < ARP_SEEN_MAX; i++) {
-            if (!mac_seen[i].in_use) {
-                mac_seen[i].in_use = 1;
-                memcpy(mac_seen[i].mac, arp->arp_sha, 6);
-                mac_seen[i].ip_be = ip_be;
+            if (!state->mac_seen[i].in_use) {
+                state->mac_seen[i].in_use = 1;
+                memcpy(state->mac_seen[i].mac, arp->arp_sha, 6);
+                state->mac_seen[i].ip_be = ip_be;
                 break;
             }
         }
 mac_done:;
     } else {
-        if (vlan_count == 1) printf("VLAN %d: ", vlan_ids[0]);
-        else if (vlan_count == 2) printf("VLAN %d/%d: ", vlan_ids[0], vlan_ids[1]);
-        printf("ARP op %u from %s (%s) to %s (%s)%s\n", op, src_ip, sha, dst_ip, tha, gratuitous ? " [gratuitous]" : "");
+        dissect_note(ctx, (const u_char *)arp, sizeof(*arp), "%sARP op %u from %s (%s) to %s (%s)%s",
+                     vlan, op, src_ip, sha, dst_ip, tha, gratuitous ? " [gratuitous]" : "");
     }
+
+    dissect_field(ctx, "Operation", (const u_char *)&arp->ea_hdr.ar_op, 2, "%u (%s)", op,
+                  op == ARPOP_REQUEST ? "request" : op == ARPOP_REPLY ? "reply" : "other");
+    dissect_field(ctx, "Sender MAC", arp->arp_sha, 6, "%s", sha);
+    dissect_field(ctx, "Sender IP", arp->arp_spa, 4, "%s", src_ip);
+    dissect_field(ctx, "Target MAC", arp->arp_tha, 6, "%s", tha);
+    dissect_field(ctx, "Target IP", arp->arp_tpa, 4, "%s", dst_ip);
 }
@@ -1,8 +1,41 @@
-#ifndef ARP_H
-#define ARP_H
+#ifndef ARP_PROTOCOL_H
+#define ARP_PROTOCOL_H
 
+#include <stdint.h>
 #include <pcap.h>
+#include "../dissect.h"
+
+// Per-pipeline tables behind the poisoning and scan heuristics
+#define ARP_SEEN_MAX 64
+
+// IP->MAC, to flag changes (potential ARP poisoning)
+struct arp_seen_entry {
+    uint32_t ip_be; // IPv4 in network byte order
+    unsigned char mac[6];
+    int in_use;
+};
+
+// MAC->IP, to flag a MAC claiming many IPs
+struct mac_seen_entry {
+    unsigned char mac[6];
+    uint32_t ip_be; // last IP observed for this MAC
+    int in_use;
+};
+
+// Unique targets queried by a given source MAC (potential ARP scans)
+struct scan_entry {
+    unsigned char mac[6];
+    uint32_t targets[16]; // up to 16 unique targets tracked
+    int in_use;
+};
+
+typedef struct {
+    struct arp_seen_entry arp_seen[ARP_SEEN_MAX];
+    struct mac_seen_entry mac_seen[ARP_SEEN_MAX];
+    struct scan_entry scan_table[ARP_SEEN_MAX];
+} arp_state_t;
 
 void parse_arp(const u_char *packet, int packet_len);
+void dissect_arp(dissect_ctx_t *ctx, const u_char *packet, int packet_len);
 
-#endif // ARP_H
+#endif // ARP_PROTOCOL_H
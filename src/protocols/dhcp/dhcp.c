@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <arpa/inet.h>
 #include "dhcp.h"
 
@@ -40,44 +41,65 @@ struct dhcp_header {
     uint8_t options[312];
 };
 
+static void dissect_address(dissect_ctx_t *ctx, const char *name, const uint32_t *addr) {
+    char text[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, addr, text, sizeof(text));
+    dissect_field(ctx, name, (const u_char *)addr, 4, "%s", text);
+}
+
 void parse_dhcp(const u_char *payload, int payload_len) {
-    if (payload_len < (int)sizeof(struct dhcp_header)) return;
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_dhcp(&ctx, payload, payload_len);
+}
+
+void dissect_dhcp(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
+    // Fixed header plus the magic cookie; options are bounded by payload_len
+    int options_offset = (int)offsetof(struct dhcp_header, options);
+    if (payload_len < options_offset + 4) return;
 
     const struct dhcp_header *dhcp = (const struct dhcp_header *)payload;
+    int options_len = payload_len - options_offset;
+    if (options_len > (int)sizeof(dhcp->options)) options_len = (int)sizeof(dhcp->options);
 
-    printf("=== DHCP Packet ===\n");
-    printf("Transaction ID: 0x%08x\n", ntohl(dhcp->xid));
-    printf("Client IP: %s\n", inet_ntoa(*(struct in_addr *)&dhcp->ciaddr));
-    printf("Your IP: %s\n", inet_ntoa(*(struct in_addr *)&dhcp->yiaddr));
-    printf("Server IP: %s\n", inet_ntoa(*(struct in_addr *)&dhcp->siaddr));
-    printf("Gateway IP: %s\n", inet_ntoa(*(struct in_addr *)&dhcp->giaddr));
+    dissect_begin(ctx, "DHCP Packet", payload, payload_len);
+    dissect_field(ctx, "Transaction ID", (const u_char *)&dhcp->xid, 4, "0x%08x", ntohl(dhcp->xid));
+    dissect_address(ctx, "Client IP", &dhcp->ciaddr);
+    dissect_address(ctx, "Your IP", &dhcp->yiaddr);
+    dissect_address(ctx, "Server IP", &dhcp->siaddr);
+    dissect_address(ctx, "Gateway IP", &dhcp->giaddr);
 
-    printf("Client MAC: ");
-    for (int i = 0; i < dhcp->hlen && i < 16; i++)
-        printf("%02x%c", dhcp->chaddr[i], (i == dhcp->hlen - 1) ? '\n' : ':');
+    int hlen = dhcp->hlen < 16 ? dhcp->hlen : 16;
+    dissect_buf_t mac;
+    dissect_buf_init(&mac);
+    for (int i = 0; i < hlen; i++)
+        dissect_buf_printf(&mac, i ? ":%02x" : "%02x", dhcp->chaddr[i]);
+    dissect_field(ctx, "Client MAC", dhcp->chaddr, hlen, "%s", mac.text);
 
     if (dhcp->options[0] != 0x63 || dhcp->options[1] != 0x82 ||
         dhcp->options[2] != 0x53 || dhcp->options[3] != 0x63) {
-        printf("Invalid DHCP magic cookie.\n");
+        dissect_note(ctx, dhcp->options, 4, "Invalid DHCP magic cookie.");
+        dissect_end(ctx);
         return;
     }
 
     int i = 4;
-    while (i < payload_len - (int)((const u_char *)dhcp->options - payload)) {
+    while (i < options_len) {
         uint8_t option = dhcp->options[i++];
         if (option == DHCP_OPTION_END) break;
         if (option == 0) continue;
+        if (i >= options_len) break;
 
         uint8_t len = dhcp->options[i++];
-        if (i + len > 312) break;
+        if (i + len > options_len) break;
 
         if (option == DHCP_OPTION_MSG_TYPE && len == 1) {
             uint8_t msg_type = dhcp->options[i];
-            printf("DHCP Message Type: %s (%d)\n", dhcp_message_type(msg_type), msg_type);
+            dissect_field(ctx, "DHCP Message Type", dhcp->options + i - 2, 3, "%s (%d)", dhcp_message_type(msg_type), msg_type);
         }
 
         i += len;
     }
 
-    printf("===================\n");
+    dissect_end(ctx);
 }
@@ -3,7 +3,9 @@
 
 #include <stdint.h>
 #include <pcap.h>
+#include "../dissect.h"
 
 void parse_dhcp(const u_char *payload, int payload_len);
+void dissect_dhcp(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
 
 #endif
@@ -0,0 +1,159 @@
+#include "dissect.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <string.h>
+
+static FILE *stdout_target(const dissect_ctx_t *ctx) {
+    return ctx->opaque ? (FILE *)ctx->opaque : stdout;
+}
+
+// Top-level layers get the classic banner, nested ones an indented title
+static void stdout_begin_layer(const dissect_ctx_t *ctx, const char *name, int offset, int length) {
+    (void)offset;
+    (void)length;
+    if (ctx->depth == 0) {
+        fprintf(stdout_target(ctx), "=== %s ===\n", name);
+    } else {
+        fprintf(stdout_target(ctx), "%*s%s:\n", 2 * (ctx->depth - 1), "", name);
+    }
+}
+
+static void stdout_field(const dissect_ctx_t *ctx, const char *name, const char *value, int offset, int length) {
+    (void)offset;
+    (void)length;
+    int indent = ctx->depth > 0 ? 2 * (ctx->depth - 1) : 0;
+    if (name) {
+        fprintf(stdout_target(ctx), "%*s%s: %s\n", indent, "", name, value);
+    } else {
+        fprintf(stdout_target(ctx), "%*s%s\n", indent, "", value);
+    }
+}
+
+static void stdout_end_layer(const dissect_ctx_t *ctx) {
+    if (ctx->depth == 0) {
+        fprintf(stdout_target(ctx), "===================\n");
+    }
+}
+
+const dissect_visitor_t dissect_stdout_visitor = {
+    stdout_begin_layer,
+    stdout_field,
+    stdout_end_layer
+};
+
+void dissect_ctx_init(dissect_ctx_t *ctx, const dissect_visitor_t *visitor, void *opaque,
+                      dissect_state_t *state, const u_char *frame, int frame_len) {
+    ctx->visitor = visitor;
+    ctx->opaque = opaque;
+    ctx->state = state;
+    ctx->frame = frame;
+    ctx->frame_len = frame_len;
+    ctx->depth = 0;
+}
+
+// Clamps at/len to the frame; anything outside it has no byte range
+static void byte_range(const dissect_ctx_t *ctx, const u_char *at, int len, int *offset, int *length) {
+    *offset = -1;
+    *length = 0;
+    if (!at || !ctx->frame || at < ctx->frame || at >= ctx->frame + ctx->frame_len || len <= 0) {
+        return;
+    }
+    *offset = (int)(at - ctx->frame);
+    *length = len < ctx->frame_len - *offset ? len : ctx->frame_len - *offset;
+}
+
+void dissect_begin(dissect_ctx_t *ctx, const char *name, const u_char *at, int len) {
+    int offset, length;
+    byte_range(ctx, at, len, &offset, &length);
+    if (ctx->visitor->begin_layer) {
+        ctx->visitor->begin_layer(ctx, name, offset, length);
+    }
+    ctx->depth++;
+}
+
+void dissect_end(dissect_ctx_t *ctx) {
+    if (ctx->depth == 0) {
+        return;
+    }
+    ctx->depth--;
+    if (ctx->visitor->end_layer) {
+        ctx->visitor->end_layer(ctx);
+    }
+}
+
+static void emit(dissect_ctx_t *ctx, const char *name, const u_char *at, int len, const char *fmt, va_list args) {
+    if (!ctx->visitor->field) {
+        return;
+    }
+    char value[DISSECT_VALUE_MAX];
+    int offset, length;
+    vsnprintf(value, sizeof(value), fmt, args);
+    byte_range(ctx, at, len, &offset, &length);
+    ctx->visitor->field(ctx, name, value, offset, length);
+}
+
+void dissect_field(dissect_ctx_t *ctx, const char *name, const u_char *at, int len, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    emit(ctx, name, at, len, fmt, args);
+    va_end(args);
+}
+
+void dissect_note(dissect_ctx_t *ctx, const u_char *at, int len, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    emit(ctx, NULL, at, len, fmt, args);
+    va_end(args);
+}
+
+void dissect_hex_dump(dissect_ctx_t *ctx, const u_char *data, int len) {
+    for (int i = 0; i < len; i += 16) {
+        int row = len - i < 16 ? len - i : 16;
+        dissect_buf_t line;
+        dissect_buf_init(&line);
+        dissect_buf_printf(&line, "%04x  ", i);
+        dissect_buf_hex(&line, data + i, row);
+        dissect_buf_printf(&line, "%*s ", 3 * (16 - row), "");
+        dissect_buf_ascii(&line, data + i, row);
+        dissect_note(ctx, data + i, row, "%s", line.text);
+    }
+}
+
+void dissect_buf_init(dissect_buf_t *buf) {
+    buf->text[0] = '\0';
+    buf->len = 0;
+}
+
+void dissect_buf_printf(dissect_buf_t *buf, const char *fmt, ...) {
+    if (buf->len >= sizeof(buf->text) - 1) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(buf->text + buf->len, sizeof(buf->text) - buf->len, fmt, args);
+    va_end(args);
+    if (written > 0) {
+        buf->len += (size_t)written;
+        if (buf->len > sizeof(buf->text) - 1) {
+            buf->len = sizeof(buf->text) - 1;
+        }
+    }
+}
+
+void dissect_buf_ascii(dissect_buf_t *buf, const u_char *data, int len) {
+    for (int i = 0; i < len && buf->len < sizeof(buf->text) - 1; i++) {
+        buf->text[buf->len++] = isprint(data[i]) ? (char)data[i] : '.';
+    }
+    buf->text[buf->len] = '\0';
+}
+
+void dissect_buf_hex(dissect_buf_t *buf, const u_char *data, int len) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < len && buf->len + 3 < sizeof(buf->text); i++) {
+        buf->text[buf->len++] = digits[data[i] >> 4];
+        buf->text[buf->len++] = digits[data[i] & 0x0f];
+        buf->text[buf->len++] = ' ';
+    }
+    buf->text[buf->len] = '\0';
+}
@@ -0,0 +1,80 @@
+#ifndef DISSECT_H
+#define DISSECT_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <sys/types.h>  // for u_char
+
+// Longest formatted field value; longer values are cut off
+#define DISSECT_VALUE_MAX 512
+
+typedef struct dissect_ctx dissect_ctx_t;
+
+// Statistics and heuristic tables the dissectors update, see dissect_state.h
+typedef struct dissect_state dissect_state_t;
+
+// Receives the dissection of one packet as it is walked. Layers nest;
+// every begin_layer is matched by an end_layer. offset/length give the
+// bytes a layer or field was decoded from, relative to the frame passed
+// to dissect_ctx_init(), or -1/0 when there is no single byte range.
+// name is NULL for free-text lines that are not a name/value pair.
+// Strings are only valid for the duration of the call.
+typedef struct {
+    void (*begin_layer)(const dissect_ctx_t *ctx, const char *name, int offset, int length);
+    void (*field)(const dissect_ctx_t *ctx, const char *name, const char *value, int offset, int length);
+    void (*end_layer)(const dissect_ctx_t *ctx);
+} dissect_visitor_t;
+
+struct dissect_ctx {
+    const dissect_visitor_t *visitor;
+    void *opaque;           // visitor state
+    dissect_state_t *state; // counters and tables, owned by one thread at a time
+    const u_char *frame;    // offsets are relative to this
+    int frame_len;
+    int depth;              // open layers
+};
+
+// Prints "=== Layer ===" headers and "Name: value" lines, the format the
+// CLI tools have always used. opaque is the FILE* to write to, or NULL
+// for stdout.
+extern const dissect_visitor_t dissect_stdout_visitor;
+
+// The state behind the single-threaded parse_*() stdout entry points the
+// CLI tools use. Anything that dissects on more than one thread brings its
+// own from dissect_state_new().
+dissect_state_t *dissect_default_state(void);
+
+// state must not be shared with another thread dissecting concurrently
+void dissect_ctx_init(dissect_ctx_t *ctx, const dissect_visitor_t *visitor, void *opaque,
+                      dissect_state_t *state, const u_char *frame, int frame_len);
+
+// Layers: at/len is the byte range the layer covers (at may be NULL)
+void dissect_begin(dissect_ctx_t *ctx, const char *name, const u_char *at, int len);
+void dissect_end(dissect_ctx_t *ctx);
+
+// Name/value field decoded from at[0..len)
+void dissect_field(dissect_ctx_t *ctx, const char *name, const u_char *at, int len, const char *fmt, ...)
+    __attribute__((format(printf, 5, 6)));
+
+// Free-text line (warnings, verdicts, raw dumps)
+void dissect_note(dissect_ctx_t *ctx, const u_char *at, int len, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+// One note per 16-byte row: "0000  xx xx ...  ascii"
+void dissect_hex_dump(dissect_ctx_t *ctx, const u_char *data, int len);
+
+// Fixed-size text builder for values assembled piece by piece
+typedef struct {
+    char text[DISSECT_VALUE_MAX];
+    size_t len;
+} dissect_buf_t;
+
+void dissect_buf_init(dissect_buf_t *buf);
+void dissect_buf_printf(dissect_buf_t *buf, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+// Printable ASCII, '.' for everything else
+void dissect_buf_ascii(dissect_buf_t *buf, const u_char *data, int len);
+// "xx xx xx "
+void dissect_buf_hex(dissect_buf_t *buf, const u_char *data, int len);
+
+#endif // DISSECT_H
@@ -0,0 +1,39 @@
+#include "dissect_state.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void dissect_state_init(dissect_state_t *state) {
+    memset(state, 0, sizeof(*state));
+}
+
+dissect_state_t *dissect_state_new(void) {
+    return calloc(1, sizeof(dissect_state_t));
+}
+
+void dissect_state_free(dissect_state_t *state) {
+    free(state);
+}
+
+void dissect_state_merge(dissect_state_t *into, const dissect_state_t *from) {
+    merge_ipv4_stats(&into->ipv4, &from->ipv4);
+    merge_ipv6_stats(&into->ipv6, &from->ipv6);
+    merge_udp_stats(&into->udp, &from->udp);
+    merge_ftp_stats(&into->ftp, &from->ftp);
+    merge_http_stats(&into->http, &from->http);
+    merge_tls_stats(&into->tls, &from->tls);
+}
+
+void dissect_state_print(const dissect_state_t *state) {
+    print_ipv4_stats(&state->ipv4);
+    print_ipv6_stats(&state->ipv6);
+    print_udp_stats(&state->udp);
+    print_ftp_stats(&state->ftp);
+    print_http_statistics(&state->http);
+    print_tls_statistics(&state->tls);
+}
+
+dissect_state_t *dissect_default_state(void) {
+    static dissect_state_t state;
+    return &state;
+}
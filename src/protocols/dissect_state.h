@@ -0,0 +1,42 @@
+#ifndef DISSECT_STATE_H
+#define DISSECT_STATE_H
+
+#include "dissect.h"
+#include "arp/arp.h"
+#include "ftp/ftp.h"
+#include "http/http.h"
+#include "https/https.h"
+#include "ipv4/ipv4.h"
+#include "ipv6/ipv6.h"
+#include "udp/udp.h"
+
+// Everything the dissectors remember between packets. Each capture
+// pipeline or worker thread owns one and hands it to dissect_ctx_init();
+// dissectors never touch another state, so separate states can be used
+// from separate threads without locking. Counters from several states are
+// combined with dissect_state_merge() when someone asks for totals.
+// Application verdicts are not kept here but in app_flow_shared_cache(),
+// which is safe to use from any thread.
+struct dissect_state {
+    ipv4_stats_t ipv4;
+    ipv6_stats_t ipv6;
+    udp_stats_t udp;
+    ftp_stats_t ftp;
+    http_stats_t http;
+    tls_stats_t tls;
+    arp_state_t arp;    // heuristics tables, not merged
+};
+
+void dissect_state_init(dissect_state_t *state);
+// Heap-allocated and initialized; NULL when out of memory
+dissect_state_t *dissect_state_new(void);
+void dissect_state_free(dissect_state_t *state);
+
+// Adds from's counters to into's. ARP tables stay per pipeline: a binding
+// seen by one worker says nothing about the order another saw packets in.
+void dissect_state_merge(dissect_state_t *into, const dissect_state_t *from);
+
+// All statistics blocks, in the CLI tools' format
+void dissect_state_print(const dissect_state_t *state);
+
+#endif // DISSECT_STATE_H
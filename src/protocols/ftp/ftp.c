@@ -4,12 +4,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <time.h>
 #include <sys/types.h>
 #include "ftp.h"
-
-// Global statistics
-static ftp_stats_t g_stats = {0};
+#include "../dissect_state.h"
 
 // Sensitive FTP commands that should be redacted
 static const char *sensitive_commands[] = {
@@ -55,9 +52,11 @@ void redact_sensitive_data(char *line, const char *command) {
     }
 }
 
-void parse_ftp_command(const char *line) {
+void parse_ftp_command(dissect_ctx_t *ctx, const u_char *at, const char *line) {
+    ftp_stats_t *stats = &ctx->state->ftp;
     char command[16] = {0};
     char argument[256] = {0};
+    int line_len = (int)strlen(line);
     
     // Extract command and argument
     if (sscanf(line, "%15s %255[^\r\n]", command, argument) >= 1) {
@@ -66,99 +65,101 @@ void parse_ftp_command(const char *line) {
             command[i] = toupper(command[i]);
         }
         
-        printf("  Command: %s", command);
-        
         if (strlen(argument) > 0) {
             if (is_sensitive_command(command)) {
-                printf(" <redacted>\n");
+                dissect_field(ctx, "Command", at, line_len, "%s <redacted>", command);
                 if (strcasecmp(command, "USER") == 0) {
-                    strncpy(g_stats.last_user, argument, sizeof(g_stats.last_user) - 1);
-                    g_stats.login_attempts++;
+                    strncpy(stats->last_user, argument, sizeof(stats->last_user) - 1);
+                    stats->login_attempts++;
                 }
             } else {
-                printf(" %s\n", argument);
+                dissect_field(ctx, "Command", at, line_len, "%s %s", command, argument);
                 
                 // Track file operations
                 if (strcasecmp(command, "RETR") == 0 || strcasecmp(command, "STOR") == 0) {
-                    strncpy(g_stats.last_file, argument, sizeof(g_stats.last_file) - 1);
-                    g_stats.file_transfers++;
+                    strncpy(stats->last_file, argument, sizeof(stats->last_file) - 1);
+                    stats->file_transfers++;
                 } else if (strcasecmp(command, "PORT") == 0 || strcasecmp(command, "PASV") == 0 || 
                           strcasecmp(command, "EPRT") == 0 || strcasecmp(command, "EPSV") == 0) {
-                    g_stats.data_connections++;
+                    stats->data_connections++;
                 }
             }
         } else {
-            printf("\n");
+            dissect_field(ctx, "Command", at, line_len, "%s", command);
         }
         
-        g_stats.client_commands++;
+        stats->client_commands++;
     } else {
-        printf("  Raw: %s\n", line);
+        dissect_field(ctx, "Raw", at, line_len, "%s", line);
     }
 }
 
-void parse_ftp_response(const char *line) {
+void parse_ftp_response(dissect_ctx_t *ctx, const u_char *at, const char *line) {
+    ftp_stats_t *stats = &ctx->state->ftp;
     int code = 0;
     char message[512] = {0};
+    int line_len = (int)strlen(line);
     
     // Parse FTP response code
     if (sscanf(line, "%d %511[^\r\n]", &code, message) >= 1) {
-        printf("  Response: %d", code);
-        
         if (strlen(message) > 0) {
-            printf(" %s\n", message);
+            dissect_field(ctx, "Response", at, line_len, "%d %s", code, message);
         } else {
-            printf("\n");
+            dissect_field(ctx, "Response", at, line_len, "%d", code);
         }
         
         // Analyze response codes
         if (code >= 200 && code < 300) {
-            printf("  Status: Success\n");
+            dissect_field(ctx, "Status", at, 3, "Success");
         } else if (code >= 300 && code < 400) {
-            printf("  Status: Intermediate (more info needed)\n");
+            dissect_field(ctx, "Status", at, 3, "Intermediate (more info needed)");
         } else if (code >= 400 && code < 500) {
-            printf("  Status: Temporary failure\n");
+            dissect_field(ctx, "Status", at, 3, "Temporary failure");
         } else if (code >= 500 && code < 600) {
-            printf("  Status: Permanent failure\n");
+            dissect_field(ctx, "Status", at, 3, "Permanent failure");
         }
         
         // Track login success/failure
         if (code == 230) {
-            printf("  -> LOGIN SUCCESSFUL for user: %s\n", g_stats.last_user);
+            dissect_note(ctx, at, 3, "-> LOGIN SUCCESSFUL for user: %s", stats->last_user);
         } else if (code == 530) {
-            printf("  -> LOGIN FAILED\n");
+            dissect_note(ctx, at, 3, "-> LOGIN FAILED");
         }
         
-        g_stats.server_responses++;
+        stats->server_responses++;
     } else {
         // Handle multiline responses or continuation
-        if (strlen(line) > 3 && line[3] == '-') {
-            printf("  Multiline: %s\n", line);
+        if (line_len > 3 && line[3] == '-') {
+            dissect_field(ctx, "Multiline", at, line_len, "%s", line);
         } else {
-            printf("  Raw: %s\n", line);
+            dissect_field(ctx, "Raw", at, line_len, "%s", line);
         }
     }
 }
 
 void parse_ftp(const u_char *payload, int payload_len, int src_port, int dst_port) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_ftp(&ctx, payload, payload_len, src_port, dst_port);
+}
+
+void dissect_ftp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
+    ftp_stats_t *stats = &ctx->state->ftp;
     // FTP control channel runs on port 21
     if (src_port != 21 && dst_port != 21) return;
     
     if (!is_printable_ascii(payload, payload_len)) return;
     
     // Update statistics
-    g_stats.total_packets++;
-    
-    // Print timestamp
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    printf("\n[%02d:%02d:%02d] ", tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
+    stats->total_packets++;
     
-    printf("=== FTP Packet #%lu ===\n", g_stats.total_packets);
+    char title[48];
+    snprintf(title, sizeof(title), "FTP Packet #%lu", (unsigned long)stats->total_packets);
+    dissect_begin(ctx, title, payload, payload_len);
     
     // Determine direction
     int is_server_response = (src_port == 21);
-    printf("Direction: %s\n", is_server_response ? "Server -> Client" : "Client -> Server");
+    dissect_field(ctx, "Direction", NULL, 0, "%s", is_server_response ? "Server -> Client" : "Client -> Server");
     
     // Copy payload to buffer for processing
     char buffer[2048];
@@ -171,37 +172,50 @@ void parse_ftp(const u_char *payload, int payload_len, int src_port, int dst_por
     char *line = strtok_r(buffer, "\r\n", &saveptr);
     while (line != NULL) {
         if (strlen(line) > 0) {
+            const u_char *at = payload + (line - buffer);
             if (is_server_response) {
-                parse_ftp_response(line);
+                parse_ftp_response(ctx, at, line);
             } else {
-                parse_ftp_command(line);
+                parse_ftp_command(ctx, at, line);
             }
         }
         line = strtok_r(NULL, "\r\n", &saveptr);
     }
     
-    printf("========================\n");
+    dissect_end(ctx);
 }
 
-void print_ftp_stats(void) {
+void print_ftp_stats(const ftp_stats_t *stats) {
     printf("\n--- FTP Traffic Statistics ---\n");
-    printf("Total Packets: %lu\n", g_stats.total_packets);
-    printf("Client Commands: %lu\n", g_stats.client_commands);
-    printf("Server Responses: %lu\n", g_stats.server_responses);
-    printf("Login Attempts: %lu\n", g_stats.login_attempts);
-    printf("File Transfers: %lu\n", g_stats.file_transfers);
-    printf("Data Connections: %lu\n", g_stats.data_connections);
-    if (strlen(g_stats.last_user) > 0) {
-        printf("Last User: %s\n", g_stats.last_user);
+    printf("Total Packets: %lu\n", stats->total_packets);
+    printf("Client Commands: %lu\n", stats->client_commands);
+    printf("Server Responses: %lu\n", stats->server_responses);
+    printf("Login Attempts: %lu\n", stats->login_attempts);
+    printf("File Transfers: %lu\n", stats->file_transfers);
+    printf("Data Connections: %lu\n", stats->data_connections);
+    if (strlen(stats->last_user) > 0) {
+        printf("Last User: %s\n", stats->last_user);
     }
-    if (strlen(g_stats.last_file) > 0) {
-        printf("Last File: %s\n", g_stats.last_file);
+    if (strlen(stats->last_file) > 0) {
+        printf("Last File: %s\n", stats->last_file);
     }
     printf("-----------------------------\n\n");
 }
 
-void reset_ftp_stats(void) {
-    memset(&g_stats, 0, sizeof(g_stats));
+void reset_ftp_stats(ftp_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void merge_ftp_stats(ftp_stats_t *into, const ftp_stats_t *from) {
+    into->total_packets += from->total_packets;
+    into->client_commands += from->client_commands;
+    into->server_responses += from->server_responses;
+    into->login_attempts += from->login_attempts;
+    into->file_transfers += from->file_transfers;
+    into->data_connections += from->data_connections;
+    // Names from the pipeline merged last win
+    if (from->last_user[0]) memcpy(into->last_user, from->last_user, sizeof(into->last_user));
+    if (from->last_file[0]) memcpy(into->last_file, from->last_file, sizeof(into->last_file));
 }
 #ifdef FTP_STANDALONE
 #include <pcap.h>
@@ -292,7 +306,7 @@ int main() {
     printf("Listening for FTP packets on port 21...\n");
     
     // Initialize stats
-    reset_ftp_stats();
+    reset_ftp_stats(&dissect_default_state()->ftp);
     
     // Start packet capture loop (Ctrl+C to stop)
     pcap_loop(g_handle, 0, packet_handler, NULL);
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <pcap.h>
+#include "../dissect.h"
 
 // FTP command structure
 typedef struct {
@@ -39,10 +40,12 @@ typedef struct {
 
 // Function declarations
 void parse_ftp(const u_char *payload, int payload_len, int src_port, int dst_port);
-void parse_ftp_command(const char *line);
-void parse_ftp_response(const char *line);
-void print_ftp_stats(void);
-void reset_ftp_stats(void);
+void dissect_ftp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
+void parse_ftp_command(dissect_ctx_t *ctx, const u_char *at, const char *line);
+void parse_ftp_response(dissect_ctx_t *ctx, const u_char *at, const char *line);
+void print_ftp_stats(const ftp_stats_t *stats);
+void reset_ftp_stats(ftp_stats_t *stats);
+void merge_ftp_stats(ftp_stats_t *into, const ftp_stats_t *from);
 int is_printable_ascii(const u_char *data, int len);
 int is_sensitive_command(const char *command);
 void redact_sensitive_data(char *line, const char *command);
@@ -1,21 +1,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
-#include <time.h>
+#include <strings.h>
 #include "http.h"
-
-// Statistics tracking
-static struct {
-    int requests;
-    int responses;
-    int get_requests;
-    int post_requests;
-    int status_200;
-    int status_404;
-    int status_500;
-    int security_headers_missing;
-    time_t start_time;
-} http_stats = {0};
+#include "../dissect_state.h"
 
 // Get HTTP method name
 const char* get_http_method_name(const char *method) {
@@ -70,68 +58,68 @@ int is_security_header(const char *header_name) {
 }
 
 // Print HTTP statistics
-void print_http_statistics(void) {
+void print_http_statistics(const http_stats_t *stats) {
     printf("\n=== HTTP Statistics ===\n");
-    printf("Total Requests: %d\n", http_stats.requests);
-    printf("Total Responses: %d\n", http_stats.responses);
-    printf("GET Requests: %d\n", http_stats.get_requests);
-    printf("POST Requests: %d\n", http_stats.post_requests);
-    printf("200 OK Responses: %d\n", http_stats.status_200);
-    printf("404 Not Found: %d\n", http_stats.status_404);
-    printf("500 Server Error: %d\n", http_stats.status_500);
-    printf("Missing Security Headers: %d\n", http_stats.security_headers_missing);
+    printf("Total Requests: %lu\n", stats->requests);
+    printf("Total Responses: %lu\n", stats->responses);
+    printf("GET Requests: %lu\n", stats->get_requests);
+    printf("POST Requests: %lu\n", stats->post_requests);
+    printf("200 OK Responses: %lu\n", stats->status_200);
+    printf("404 Not Found: %lu\n", stats->status_404);
+    printf("500 Server Error: %lu\n", stats->status_500);
+    printf("Missing Security Headers: %lu\n", stats->security_headers_missing);
     printf("======================\n");
 }
 
+void merge_http_stats(http_stats_t *into, const http_stats_t *from) {
+    into->requests += from->requests;
+    into->responses += from->responses;
+    into->get_requests += from->get_requests;
+    into->post_requests += from->post_requests;
+    into->status_200 += from->status_200;
+    into->status_404 += from->status_404;
+    into->status_500 += from->status_500;
+    into->security_headers_missing += from->security_headers_missing;
+}
+
 void parse_http(const u_char *payload, int payload_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_http(&ctx, payload, payload_len);
+}
+
+void dissect_http(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
     if (payload_len <= 0) return;
 
     const char *data = (const char *)payload;
     
     // Check if it's a request or response
-    if (strncmp(data, "HTTP/", 5) == 0) {
+    if (payload_len >= 5 && strncmp(data, "HTTP/", 5) == 0) {
         // It's a response
-        parse_http_response(data, payload_len);
+        parse_http_response(ctx, data, payload_len);
     } else {
         // It's a request
-        parse_http_request(data, payload_len);
+        parse_http_request(ctx, data, payload_len);
     }
 }
 
-// Parse HTTP request
-void parse_http_request(const char *data, int len) {
-    if (len <= 0) return;
-    
+// Copies the first line into a NUL-terminated buffer for sscanf; returns its length
+static int copy_first_line(const char *data, int len, char *line, int line_size) {
+    int n = 0;
+    while (n < len && data[n] != '\r' && data[n] != '\n') n++;
+    int copy = n < line_size - 1 ? n : line_size - 1;
+    memcpy(line, data, copy);
+    line[copy] = '\0';
+    return n;
+}
+
+// Emits every "Name: value" header line after the start line; returns the
+// number of security headers seen
+static int parse_http_headers(dissect_ctx_t *ctx, const char *data, int len) {
     const char *end = data + len;
-    const char *line_start = data;
-    
-    // Find end of first line
-    while (data < end && *data != '\r' && *data != '\n') {
-        data++;
-    }
-    
-    // Parse request line: METHOD URI HTTP/VERSION
-    char method[16], uri[512], version[16];
-    if (sscanf(line_start, "%15s %511s %15s", method, uri, version) == 3) {
-        printf("=== HTTP Request ===\n");
-        printf("Method: %s (%s)\n", method, get_http_method_name(method));
-        printf("URI: %s\n", uri);
-        printf("Version: %s\n", version);
-        
-        // Update statistics
-        http_stats.requests++;
-        if (strcmp(method, "GET") == 0) http_stats.get_requests++;
-        if (strcmp(method, "POST") == 0) http_stats.post_requests++;
-        
-        // Check for sensitive data in URL
-        if (strstr(uri, "password") || strstr(uri, "token") || strstr(uri, "key")) {
-            printf("⚠️  WARNING: Sensitive data in URL!\n");
-        }
-    }
+    int security_headers_found = 0;
     
-    // Parse headers
-    printf("Headers:\n");
-    data = line_start;
+    dissect_begin(ctx, "Headers", NULL, 0);
     while (data < end) {
         // Skip to next line
         while (data < end && *data != '\r' && *data != '\n') data++;
@@ -144,97 +132,98 @@ void parse_http_request(const char *data, int len) {
         
         // Extract header name
         char header_name[64];
-        const char *colon = strchr(header_start, ':');
-        if (colon && colon < data) {
+        const char *colon = memchr(header_start, ':', data - header_start);
+        if (colon) {
             int name_len = colon - header_start;
             if (name_len < (int)sizeof(header_name)) {
-                strncpy(header_name, header_start, name_len);
+                memcpy(header_name, header_start, name_len);
                 header_name[name_len] = '\0';
                 
+                const char *value = colon + 1;
+                while (value < data && *value == ' ') value++;
+                
                 // Check if it's a security header
-                if (is_security_header(header_name)) {
-                    printf("  %.*s 🔒\n", (int)(data - header_start), header_start);
-                } else {
-                    printf("  %.*s\n", (int)(data - header_start), header_start);
-                }
+                int secure = is_security_header(header_name);
+                security_headers_found += secure;
+                dissect_field(ctx, header_name, (const u_char *)header_start, (int)(data - header_start),
+                              "%.*s%s", (int)(data - value), value, secure ? " 🔒" : "");
             }
         }
     }
-    printf("====================\n");
+    dissect_end(ctx);
+    return security_headers_found;
 }
 
-// Parse HTTP response
-void parse_http_response(const char *data, int len) {
+// Parse HTTP request
+void parse_http_request(dissect_ctx_t *ctx, const char *data, int len) {
+    http_stats_t *stats = &ctx->state->http;
     if (len <= 0) return;
     
-    const char *end = data + len;
-    const char *line_start = data;
+    char line[600];
+    int line_len = copy_first_line(data, len, line, sizeof(line));
     
-    // Find end of first line
-    while (data < end && *data != '\r' && *data != '\n') {
-        data++;
+    dissect_begin(ctx, "HTTP Request", (const u_char *)data, len);
+    
+    // Parse request line: METHOD URI HTTP/VERSION
+    char method[16], uri[512], version[16];
+    if (sscanf(line, "%15s %511s %15s", method, uri, version) == 3) {
+        const u_char *at = (const u_char *)data;
+        dissect_field(ctx, "Method", at, (int)strlen(method), "%s (%s)", method, get_http_method_name(method));
+        dissect_field(ctx, "URI", at + strlen(method) + 1, (int)strlen(uri), "%s", uri);
+        dissect_field(ctx, "Version", at + line_len - strlen(version), (int)strlen(version), "%s", version);
+        
+        // Update statistics
+        stats->requests++;
+        if (strcmp(method, "GET") == 0) stats->get_requests++;
+        if (strcmp(method, "POST") == 0) stats->post_requests++;
+        
+        // Check for sensitive data in URL
+        if (strstr(uri, "password") || strstr(uri, "token") || strstr(uri, "key")) {
+            dissect_note(ctx, NULL, 0, "⚠️  WARNING: Sensitive data in URL!");
+        }
     }
     
+    parse_http_headers(ctx, data, len);
+    dissect_end(ctx);
+}
+
+// Parse HTTP response
+void parse_http_response(dissect_ctx_t *ctx, const char *data, int len) {
+    http_stats_t *stats = &ctx->state->http;
+    if (len <= 0) return;
+    
+    char line[600];
+    copy_first_line(data, len, line, sizeof(line));
+    
+    dissect_begin(ctx, "HTTP Response", (const u_char *)data, len);
+    
     // Parse response line: HTTP/VERSION STATUS_CODE REASON_PHRASE
     char version[16], reason[128];
     int status_code;
-    if (sscanf(line_start, "%15s %d %127s", version, &status_code, reason) == 3) {
-        printf("=== HTTP Response ===\n");
-        printf("Version: %s\n", version);
-        printf("Status: %d (%s)\n", status_code, get_status_code_description(status_code));
-        printf("Reason: %s\n", reason);
+    if (sscanf(line, "%15s %d %127s", version, &status_code, reason) == 3) {
+        const u_char *at = (const u_char *)data;
+        int version_len = (int)strlen(version);
+        dissect_field(ctx, "Version", at, version_len, "%s", version);
+        dissect_field(ctx, "Status", at + version_len + 1, 3, "%d (%s)", status_code, get_status_code_description(status_code));
+        dissect_field(ctx, "Reason", at + version_len + 5, (int)strlen(reason), "%s", reason);
         
         // Update statistics
-        http_stats.responses++;
-        if (status_code == 200) http_stats.status_200++;
-        if (status_code == 404) http_stats.status_404++;
-        if (status_code >= 500) http_stats.status_500++;
+        stats->responses++;
+        if (status_code == 200) stats->status_200++;
+        if (status_code == 404) stats->status_404++;
+        if (status_code >= 500) stats->status_500++;
         
         // Security warnings
         if (status_code == 301 || status_code == 302) {
-            printf("⚠️  WARNING: HTTP redirect detected!\n");
-        }
-    }
-    
-    // Parse headers
-    printf("Headers:\n");
-    data = line_start;
-    int security_headers_found = 0;
-    while (data < end) {
-        // Skip to next line
-        while (data < end && *data != '\r' && *data != '\n') data++;
-        while (data < end && (*data == '\r' || *data == '\n')) data++;
-        
-        if (data >= end) break;
-        
-        const char *header_start = data;
-        while (data < end && *data != '\r' && *data != '\n') data++;
-        
-        // Extract header name
-        char header_name[64];
-        const char *colon = strchr(header_start, ':');
-        if (colon && colon < data) {
-            int name_len = colon - header_start;
-            if (name_len < (int)sizeof(header_name)) {
-                strncpy(header_name, header_start, name_len);
-                header_name[name_len] = '\0';
-                
-                // Check if it's a security header
-                if (is_security_header(header_name)) {
-                    printf("  %.*s 🔒\n", (int)(data - header_start), header_start);
-                    security_headers_found++;
-                } else {
-                    printf("  %.*s\n", (int)(data - header_start), header_start);
-                }
-            }
+            dissect_note(ctx, NULL, 0, "⚠️  WARNING: HTTP redirect detected!");
         }
     }
     
     // Check for missing security headers
-    if (security_headers_found == 0) {
-        printf("⚠️  WARNING: No security headers found!\n");
-        http_stats.security_headers_missing++;
+    if (parse_http_headers(ctx, data, len) == 0) {
+        dissect_note(ctx, NULL, 0, "⚠️  WARNING: No security headers found!");
+        stats->security_headers_missing++;
     }
     
-    printf("=====================\n");
+    dissect_end(ctx);
 }
@@ -3,14 +3,29 @@
 
 #include <pcap.h>
 #include <stdint.h>
+#include "../dissect.h"
+
+// HTTP traffic statistics
+typedef struct {
+    uint64_t requests;
+    uint64_t responses;
+    uint64_t get_requests;
+    uint64_t post_requests;
+    uint64_t status_200;
+    uint64_t status_404;
+    uint64_t status_500;
+    uint64_t security_headers_missing;
+} http_stats_t;
 
 // Function declarations
 void parse_http(const u_char *payload, int payload_len);
-void parse_http_request(const char *data, int len);
-void parse_http_response(const char *data, int len);
+void dissect_http(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
+void parse_http_request(dissect_ctx_t *ctx, const char *data, int len);
+void parse_http_response(dissect_ctx_t *ctx, const char *data, int len);
 const char* get_http_method_name(const char *method);
 const char* get_status_code_description(int status_code);
 int is_security_header(const char *header_name);
-void print_http_statistics(void);
+void print_http_statistics(const http_stats_t *stats);
+void merge_http_stats(http_stats_t *into, const http_stats_t *from);
 
 #endif // HTTP_H
@@ -2,22 +2,12 @@
 #include <stdint.h>
 #include <string.h>
 #include <arpa/inet.h>
-#include <time.h>
 #include "https.h"
+#include "../dissect_state.h"
 
 // TLS record types
 #define TLS_HANDSHAKE 22
 
-// Statistics tracking
-static struct {
-    int client_hellos;
-    int server_hellos;
-    int weak_ciphers;
-    int weak_versions;
-    int tls_versions[10];
-    time_t start_time;
-} tls_stats = {0};
-
 // Get TLS version name
 const char* get_tls_version_name(uint16_t version) {
     switch (version) {
@@ -102,20 +92,11 @@ int is_weak_cipher_suite(uint16_t cipher_suite) {
     }
 }
 
-// Helper to print hex
-__attribute__((unused))
-static void print_hex(const u_char *data, int len) {
-    for (int i = 0; i < len; i++) {
-        printf("%02x ", data[i]);
-        if ((i + 1) % 16 == 0) printf("\n");
-    }
-    if (len % 16 != 0) printf("\n");
-}
-
 // Parse TLS ClientHello to extract version, cipher suites, and SNI (if present)
-void parse_tls_client_hello(const u_char *payload, int payload_len) {
+void parse_tls_client_hello(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
+    tls_stats_t *stats = &ctx->state->tls;
     if (payload_len < 5) {
-        printf("TLS packet too short\n");
+        dissect_note(ctx, payload, payload_len, "TLS packet too short");
         return;
     }
 
@@ -125,12 +106,12 @@ void parse_tls_client_hello(const u_char *payload, int payload_len) {
     uint16_t record_len = ntohs(*(uint16_t *)(payload + 3));
 
     if (content_type != TLS_HANDSHAKE) {
-        printf("Not a TLS handshake record\n");
+        dissect_note(ctx, payload, 1, "Not a TLS handshake record");
         return;
     }
 
     if (record_len + 5 > payload_len) {
-        printf("Incomplete TLS record\n");
+        dissect_note(ctx, payload + 3, 2, "Incomplete TLS record");
         return;
     }
 
@@ -139,7 +120,7 @@ void parse_tls_client_hello(const u_char *payload, int payload_len) {
     int handshake_len = record_len;
 
     if (handshake_len < 4) {
-        printf("Handshake message too short\n");
+        dissect_note(ctx, handshake, handshake_len, "Handshake message too short");
         return;
     }
 
@@ -148,69 +129,70 @@ void parse_tls_client_hello(const u_char *payload, int payload_len) {
     uint32_t hs_len __attribute__((unused)) = (handshake[1] << 16) | (handshake[2] << 8) | handshake[3];
 
     if (handshake_type != 1) {
-        printf("Not a ClientHello handshake message\n");
+        dissect_note(ctx, handshake, 1, "Not a ClientHello handshake message");
         return;
     }
 
-    printf("=== TLS ClientHello ===\n");
-    printf("TLS Version: 0x%04x (%s)\n", version, get_tls_version_name(version));
+    dissect_begin(ctx, "TLS ClientHello", handshake, handshake_len);
+    dissect_field(ctx, "TLS Version", payload + 1, 2, "0x%04x (%s)", version, get_tls_version_name(version));
     if (is_weak_tls_version(version)) {
-        printf("⚠️  WARNING: Weak TLS version detected!\n");
-        tls_stats.weak_versions++;
+        dissect_note(ctx, payload + 1, 2, "⚠️  WARNING: Weak TLS version detected!");
+        stats->weak_versions++;
     }
 
     // Skip past handshake header (4 bytes)
     int pos = 4;
 
-    if (pos + 2 > handshake_len) return;
+    if (pos + 2 > handshake_len) goto done;
     uint16_t client_version = ntohs(*(uint16_t *)(handshake + pos));
+    dissect_field(ctx, "Client Version", handshake + pos, 2, "0x%04x (%s)", client_version, get_tls_version_name(client_version));
     pos += 2;
-    printf("Client Version: 0x%04x (%s)\n", client_version, get_tls_version_name(client_version));
-    tls_stats.client_hellos++;
+    stats->client_hellos++;
 
     // Skip Random (32 bytes)
     pos += 32;
 
     // Session ID
-    if (pos + 1 > handshake_len) return;
+    if (pos + 1 > handshake_len) goto done;
     uint8_t session_id_len = handshake[pos];
     pos += 1 + session_id_len;
 
-    if (pos + 2 > handshake_len) return;
+    if (pos + 2 > handshake_len) goto done;
 
     // Cipher Suites
     uint16_t cipher_suites_len = ntohs(*(uint16_t *)(handshake + pos));
     pos += 2;
 
-    if (pos + cipher_suites_len > handshake_len) return;
+    if (pos + cipher_suites_len > handshake_len) goto done;
 
-    printf("Cipher Suites Offered (%d bytes):\n", cipher_suites_len);
-    for (int i = 0; i < cipher_suites_len; i += 2) {
+    char title[48];
+    snprintf(title, sizeof(title), "Cipher Suites Offered (%d bytes)", cipher_suites_len);
+    dissect_begin(ctx, title, handshake + pos, cipher_suites_len);
+    for (int i = 0; i + 1 < cipher_suites_len; i += 2) {
         uint16_t cs = ntohs(*(uint16_t *)(handshake + pos + i));
-        const char* cs_name = get_cipher_suite_name(cs);
-        printf("  0x%04x - %s", cs, cs_name);
-        if (is_weak_cipher_suite(cs)) {
-            printf(" ⚠️  WEAK");
-            tls_stats.weak_ciphers++;
+        int weak = is_weak_cipher_suite(cs);
+        dissect_note(ctx, handshake + pos + i, 2, "0x%04x - %s%s", cs, get_cipher_suite_name(cs), weak ? " ⚠️  WEAK" : "");
+        if (weak) {
+            stats->weak_ciphers++;
         }
-        printf("\n");
     }
+    dissect_end(ctx);
     pos += cipher_suites_len;
 
     // Compression Methods
-    if (pos + 1 > handshake_len) return;
+    if (pos + 1 > handshake_len) goto done;
     uint8_t comp_methods_len = handshake[pos];
     pos += 1 + comp_methods_len;
 
     // Extensions
-    if (pos + 2 > handshake_len) return;
+    if (pos + 2 > handshake_len) goto done;
     uint16_t ext_len = ntohs(*(uint16_t *)(handshake + pos));
     pos += 2;
 
     int ext_end = pos + ext_len;
-    if (ext_end > handshake_len) return;
+    if (ext_end > handshake_len) goto done;
 
-    printf("Extensions:\n");
+    dissect_begin(ctx, "Extensions", handshake + pos, ext_len);
 
     while (pos + 4 <= ext_end) {
         uint16_t ext_type = ntohs(*(uint16_t *)(handshake + pos));
@@ -235,27 +217,27 @@ void parse_tls_client_hello(const u_char *payload, int payload_len) {
                 if (sni_pos + name_len > pos + ext_size) break;
 
                 if (name_type == 0) { // host_name
-                    char server_name[256];
-                    if (name_len >= sizeof(server_name)) name_len = sizeof(server_name) - 1;
-                    memcpy(server_name, handshake + sni_pos, name_len);
-                    server_name[name_len] = '\0';
-                    printf("  SNI (Server Name): %s\n", server_name);
+                    dissect_field(ctx, "SNI (Server Name)", handshake + sni_pos, name_len, "%.*s",
+                                  name_len < 255 ? name_len : 255, (const char *)handshake + sni_pos);
                 }
                 sni_pos += name_len;
             }
         } else {
-            printf("  Extension type: 0x%04x, length %d\n", ext_type, ext_size);
+            dissect_note(ctx, handshake + pos - 4, ext_size + 4, "Extension type: 0x%04x, length %d", ext_type, ext_size);
         }
 
         pos += ext_size;
     }
-    printf("========================\n");
+    dissect_end(ctx);
+done:
+    dissect_end(ctx);
 }
 
 // Parse TLS ServerHello message
-void parse_tls_server_hello(const u_char *payload, int payload_len) {
+void parse_tls_server_hello(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
+    tls_stats_t *stats = &ctx->state->tls;
     if (payload_len < 9) {
-        printf("TLS ServerHello packet too short\n");
+        dissect_note(ctx, payload, payload_len, "TLS ServerHello packet too short");
         return;
     }
     
@@ -264,7 +246,7 @@ void parse_tls_server_hello(const u_char *payload, int payload_len) {
     int handshake_len = payload_len - 5;
     
     if (handshake_len < 4) {
-        printf("Handshake message too short\n");
+        dissect_note(ctx, handshake, handshake_len, "Handshake message too short");
         return;
     }
     
@@ -273,17 +255,19 @@ void parse_tls_server_hello(const u_char *payload, int payload_len) {
     int server_hello_len = handshake_len - 4;
     
     if (server_hello_len < 38) { // Minimum ServerHello size
-        printf("ServerHello message too short\n");
+        dissect_note(ctx, server_hello, server_hello_len, "ServerHello message too short");
         return;
     }
     
+    dissect_begin(ctx, "TLS ServerHello", handshake, handshake_len);
+    
     // Parse ServerHello
     uint16_t version = ntohs(*(uint16_t *)server_hello);
-    printf("  TLS Version: %s (0x%04x)\n", get_tls_version_name(version), version);
+    dissect_field(ctx, "TLS Version", server_hello, 2, "%s (0x%04x)", get_tls_version_name(version), version);
     
     if (is_weak_tls_version(version)) {
-        printf("  WARNING: Weak TLS version detected!\n");
-        tls_stats.weak_versions++;
+        dissect_note(ctx, server_hello, 2, "WARNING: Weak TLS version detected!");
+        stats->weak_versions++;
     }
     
     // Skip random (32 bytes) and session ID length (1 byte)
@@ -295,12 +279,12 @@ void parse_tls_server_hello(const u_char *payload, int payload_len) {
     // Parse cipher suite (2 bytes)
     if (pos + 2 <= server_hello_len) {
         uint16_t cipher_suite = ntohs(*(uint16_t *)(server_hello + pos));
-        printf("  Selected Cipher Suite: %s (0x%04x)\n", 
-               get_cipher_suite_name(cipher_suite), cipher_suite);
+        dissect_field(ctx, "Selected Cipher Suite", server_hello + pos, 2, "%s (0x%04x)", 
+                      get_cipher_suite_name(cipher_suite), cipher_suite);
         
         if (is_weak_cipher_suite(cipher_suite)) {
-            printf("  WARNING: Weak cipher suite selected!\n");
-            tls_stats.weak_ciphers++;
+            dissect_note(ctx, server_hello + pos, 2, "WARNING: Weak cipher suite selected!");
+            stats->weak_ciphers++;
         }
         pos += 2;
     }
@@ -308,18 +292,24 @@ void parse_tls_server_hello(const u_char *payload, int payload_len) {
     // Parse compression method (1 byte)
     if (pos + 1 <= server_hello_len) {
         uint8_t compression = server_hello[pos];
-        printf("  Compression Method: %d\n", compression);
+        dissect_field(ctx, "Compression Method", server_hello + pos, 1, "%d", compression);
         pos += 1;
     }
     
-    tls_stats.server_hellos++;
-    printf("========================\n");
+    stats->server_hellos++;
+    dissect_end(ctx);
 }
 
-// Parse TLS handshake messages
 void parse_tls_handshake(const u_char *payload, int payload_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_tls_handshake(&ctx, payload, payload_len);
+}
+
+// Parse TLS handshake messages
+void dissect_tls_handshake(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
     if (payload_len < 5) {
-        printf("TLS packet too short for handshake\n");
+        dissect_note(ctx, payload, payload_len, "TLS packet too short for handshake");
         return;
     }
     
@@ -328,50 +318,56 @@ void parse_tls_handshake(const u_char *payload, int payload_len) {
     uint16_t version = ntohs(*(uint16_t *)(payload + 1));
     uint16_t length = ntohs(*(uint16_t *)(payload + 3));
     
-    printf("TLS Record - Type: 0x%02x, Version: %s, Length: %d\n", 
-           content_type, get_tls_version_name(version), length);
+    dissect_field(ctx, "TLS Record", payload, 5, "Type 0x%02x, Version %s, Length %d", 
+                  content_type, get_tls_version_name(version), length);
     
     if (content_type == TLS_HANDSHAKE && payload_len >= 9) {
         // Handshake message: type(1) + length(3) + data
         uint8_t handshake_type = payload[5];
+        const u_char *at = payload + 5;
         
         switch (handshake_type) {
             case 1: // ClientHello
-                printf("TLS ClientHello detected\n");
-                parse_tls_client_hello(payload, payload_len);
+                parse_tls_client_hello(ctx, payload, payload_len);
                 break;
             case 2: // ServerHello
-                printf("TLS ServerHello detected\n");
-                parse_tls_server_hello(payload, payload_len);
+                parse_tls_server_hello(ctx, payload, payload_len);
                 break;
             case 11: // Certificate
-                printf("TLS Certificate message\n");
+                dissect_field(ctx, "Handshake", at, 1, "Certificate");
                 break;
             case 12: // ServerKeyExchange
-                printf("TLS ServerKeyExchange message\n");
+                dissect_field(ctx, "Handshake", at, 1, "ServerKeyExchange");
                 break;
             case 14: // ServerHelloDone
-                printf("TLS ServerHelloDone message\n");
+                dissect_field(ctx, "Handshake", at, 1, "ServerHelloDone");
                 break;
             case 16: // ClientKeyExchange
-                printf("TLS ClientKeyExchange message\n");
+                dissect_field(ctx, "Handshake", at, 1, "ClientKeyExchange");
                 break;
             case 20: // Finished
-                printf("TLS Finished message\n");
+                dissect_field(ctx, "Handshake", at, 1, "Finished");
                 break;
             default:
-                printf("TLS Handshake message type: %d\n", handshake_type);
+                dissect_field(ctx, "Handshake", at, 1, "Type %d", handshake_type);
                 break;
         }
     }
 }
 
 // Print TLS statistics
-void print_tls_statistics(void) {
+void print_tls_statistics(const tls_stats_t *stats) {
     printf("\n=== TLS Statistics ===\n");
-    printf("Client Hellos: %d\n", tls_stats.client_hellos);
-    printf("Server Hellos: %d\n", tls_stats.server_hellos);
-    printf("Weak Ciphers Detected: %d\n", tls_stats.weak_ciphers);
-    printf("Weak TLS Versions: %d\n", tls_stats.weak_versions);
+    printf("Client Hellos: %lu\n", stats->client_hellos);
+    printf("Server Hellos: %lu\n", stats->server_hellos);
+    printf("Weak Ciphers Detected: %lu\n", stats->weak_ciphers);
+    printf("Weak TLS Versions: %lu\n", stats->weak_versions);
     printf("=====================\n");
 }
+
+void merge_tls_stats(tls_stats_t *into, const tls_stats_t *from) {
+    into->client_hellos += from->client_hellos;
+    into->server_hellos += from->server_hellos;
+    into->weak_ciphers += from->weak_ciphers;
+    into->weak_versions += from->weak_versions;
+}
@@ -3,15 +3,26 @@
 
 #include <pcap.h>
 #include <stdint.h>
+#include "../dissect.h"
+
+// TLS handshake statistics
+typedef struct {
+    uint64_t client_hellos;
+    uint64_t server_hellos;
+    uint64_t weak_ciphers;
+    uint64_t weak_versions;
+} tls_stats_t;
 
 // Function declarations
-void parse_tls_client_hello(const u_char *payload, int payload_len);
-void parse_tls_server_hello(const u_char *payload, int payload_len);
+void parse_tls_client_hello(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
+void parse_tls_server_hello(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
 void parse_tls_handshake(const u_char *payload, int payload_len);
+void dissect_tls_handshake(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
 const char* get_cipher_suite_name(uint16_t cipher_suite);
 const char* get_tls_version_name(uint16_t version);
 int is_weak_cipher_suite(uint16_t cipher_suite);
 int is_weak_tls_version(uint16_t version);
-void print_tls_statistics(void);
+void print_tls_statistics(const tls_stats_t *stats);
+void merge_tls_stats(tls_stats_t *into, const tls_stats_t *from);
 
 #endif
\ No newline at end of file
@@ -2,48 +2,59 @@
 #include <string.h>
 #include "imap.h"
 
+// The payload is not NUL-terminated, so search it by length
+static int payload_contains(const u_char *payload, int payload_len, const char *word) {
+    int word_len = (int)strlen(word);
+    for (int i = 0; i + word_len <= payload_len; i++) {
+        if (memcmp(payload + i, word, word_len) == 0)
+            return 1;
+    }
+    return 0;
+}
+
 void parse_imap(const u_char *payload, int payload_len, int src_port, int dst_port) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_imap(&ctx, payload, payload_len, src_port, dst_port);
+}
+
+void dissect_imap(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     if (src_port != 143 && dst_port != 143) return;
 
-    printf("=== IMAP Packet ===\n");
+    dissect_begin(ctx, "IMAP Packet", payload, payload_len);
 
     if (dst_port == 143)
-        printf("Client -> Server\n");
+        dissect_field(ctx, "Direction", NULL, 0, "Client -> Server");
     else
-        printf("Server -> Client\n");
-
-    printf("Data: ");
-    for (int i = 0; i < payload_len && i < 80; i++) {
-        if (payload[i] >= 32 && payload[i] <= 126)
-            putchar(payload[i]);
-        else if (payload[i] == '\r' || payload[i] == '\n')
-            putchar(payload[i]);
-        else
-            putchar('.');
-    }
-    printf("\n");
+        dissect_field(ctx, "Direction", NULL, 0, "Server -> Client");
+
+    int preview_len = payload_len < 80 ? payload_len : 80;
+    dissect_buf_t preview;
+    dissect_buf_init(&preview);
+    dissect_buf_ascii(&preview, payload, preview_len);
+    dissect_field(ctx, "Data", payload, payload_len, "%s", preview.text);
 
     if (dst_port == 143) {
         if (payload_len > 5) {
-            if (strstr((const char *)payload, "LOGIN"))
-                printf("Command: LOGIN\n");
-            else if (strstr((const char *)payload, "SELECT"))
-                printf("Command: SELECT\n");
-            else if (strstr((const char *)payload, "FETCH"))
-                printf("Command: FETCH\n");
-            else if (strstr((const char *)payload, "LOGOUT"))
-                printf("Command: LOGOUT\n");
+            if (payload_contains(payload, payload_len, "LOGIN"))
+                dissect_field(ctx, "Command", NULL, 0, "LOGIN");
+            else if (payload_contains(payload, payload_len, "SELECT"))
+                dissect_field(ctx, "Command", NULL, 0, "SELECT");
+            else if (payload_contains(payload, payload_len, "FETCH"))
+                dissect_field(ctx, "Command", NULL, 0, "FETCH");
+            else if (payload_contains(payload, payload_len, "LOGOUT"))
+                dissect_field(ctx, "Command", NULL, 0, "LOGOUT");
         }
     }
 
     if (src_port == 143) {
-        if (strstr((const char *)payload, "OK"))
-            printf("Response: OK\n");
-        else if (strstr((const char *)payload, "NO"))
-            printf("Response: NO\n");
-        else if (strstr((const char *)payload, "BAD"))
-            printf("Response: BAD\n");
+        if (payload_contains(payload, payload_len, "OK"))
+            dissect_field(ctx, "Response", NULL, 0, "OK");
+        else if (payload_contains(payload, payload_len, "NO"))
+            dissect_field(ctx, "Response", NULL, 0, "NO");
+        else if (payload_contains(payload, payload_len, "BAD"))
+            dissect_field(ctx, "Response", NULL, 0, "BAD");
     }
 
-    printf("===================\n");
+    dissect_end(ctx);
 }
@@ -2,8 +2,10 @@
 #define IMAP_H
 
 #include <pcap.h>  // for u_char
+#include "../dissect.h"
 
 // Parse IMAP packet
 void parse_imap(const u_char *payload, int payload_len, int src_port, int dst_port);
+void dissect_imap(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
 
 #endif // IMAP_H
@@ -3,7 +3,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
 #include <netinet/ip.h>
@@ -11,9 +10,7 @@
 #include <netinet/udp.h>
 #include <netinet/ip_icmp.h>
 #include "ipv4.h"
-
-// Global statistics
-static ipv4_stats_t g_stats = {0};
+#include "../dissect_state.h"
 
 // Protocol name mappings
 const char* get_protocol_name(uint8_t protocol) {
@@ -31,14 +28,13 @@ const char* get_protocol_name(uint8_t protocol) {
 }
 
 // Type of Service descriptions
-const char* get_tos_description(uint8_t tos) {
+const char* get_tos_description(uint8_t tos, char *desc, size_t desc_len) {
     uint8_t precedence = (tos >> 5) & 0x07;
     uint8_t delay = (tos >> 4) & 0x01;
     uint8_t throughput = (tos >> 3) & 0x01;
     uint8_t reliability = (tos >> 2) & 0x01;
     
-    static char desc[128];
-    snprintf(desc, sizeof(desc), "Precedence:%d %s%s%s", 
+    snprintf(desc, desc_len, "Precedence:%d %s%s%s", 
              precedence,
              delay ? "Low-Delay " : "",
              throughput ? "High-Throughput " : "",
@@ -61,112 +57,129 @@ int is_multicast_ip(uint32_t ip) {
     return (first >= 224 && first <= 239);
 }
 
-void track_ip_addresses(uint32_t src_ip, uint32_t dst_ip) {
-    // Simple unique IP tracking (limited to 256 each)
-    int found_src = 0, found_dst = 0;
-    
-    for (int i = 0; i < g_stats.src_ip_count && i < 256; i++) {
-        if (g_stats.unique_src_ips[i] == src_ip) {
-            found_src = 1;
-            break;
+static void addr_set_insert(ipv4_addr_set_t *set, uint32_t ip) {
+    if (ip == 0) {
+        if (!set->has_zero) {
+            set->has_zero = 1;
+            set->count++;
         }
+        return;
     }
     
-    if (!found_src && g_stats.src_ip_count < 256) {
-        g_stats.unique_src_ips[g_stats.src_ip_count++] = src_ip;
+    // Fibonacci hashing spreads the mostly-sequential addresses of a subnet
+    uint32_t slot = (ip * 2654435761u) & (IPV4_ADDR_SET_SLOTS - 1);
+    while (set->slots[slot] != 0) {
+        if (set->slots[slot] == ip) return;
+        slot = (slot + 1) & (IPV4_ADDR_SET_SLOTS - 1);
     }
-    
-    for (int i = 0; i < g_stats.dst_ip_count && i < 256; i++) {
-        if (g_stats.unique_dst_ips[i] == dst_ip) {
-            found_dst = 1;
-            break;
-        }
+    if (set->count < IPV4_ADDR_SET_SLOTS * 3 / 4) {
+        set->slots[slot] = ip;
+        set->count++;
     }
-    
-    if (!found_dst && g_stats.dst_ip_count < 256) {
-        g_stats.unique_dst_ips[g_stats.dst_ip_count++] = dst_ip;
+}
+
+static void addr_set_merge(ipv4_addr_set_t *into, const ipv4_addr_set_t *from) {
+    if (from->has_zero) addr_set_insert(into, 0);
+    for (int i = 0; i < IPV4_ADDR_SET_SLOTS; i++) {
+        if (from->slots[i] != 0) addr_set_insert(into, from->slots[i]);
     }
 }
 
-void analyze_ipv4_flags(uint16_t flags_fragment) {
+void track_ip_addresses(ipv4_stats_t *stats, uint32_t src_ip, uint32_t dst_ip) {
+    addr_set_insert(&stats->src_ips, src_ip);
+    addr_set_insert(&stats->dst_ips, dst_ip);
+}
+
+void analyze_ipv4_flags(dissect_ctx_t *ctx, const u_char *at, uint16_t flags_fragment) {
+    ipv4_stats_t *stats = &ctx->state->ipv4;
     uint16_t flags = (flags_fragment >> 13) & 0x07;
     uint16_t fragment_offset = flags_fragment & 0x1FFF;
     
-    printf("  Flags: ");
-    if (flags & 0x02) printf("DF(Don't Fragment) ");
-    if (flags & 0x01) printf("MF(More Fragments) ");
-    if (flags == 0) printf("None ");
-    printf("\n");
+    dissect_buf_t text;
+    dissect_buf_init(&text);
+    if (flags & 0x02) dissect_buf_printf(&text, "DF(Don't Fragment) ");
+    if (flags & 0x01) dissect_buf_printf(&text, "MF(More Fragments) ");
+    if (flags == 0) dissect_buf_printf(&text, "None ");
+    dissect_field(ctx, "Flags", at, 1, "%s", text.text);
     
     if (fragment_offset > 0 || (flags & 0x01)) {
-        printf("  Fragment Offset: %u (bytes: %u)\n", fragment_offset, fragment_offset * 8);
-        g_stats.fragmented_packets++;
+        dissect_field(ctx, "Fragment Offset", at, 2, "%u (bytes: %u)", fragment_offset, fragment_offset * 8);
+        stats->fragmented_packets++;
     }
 }
 
-void analyze_ipv4_options(const u_char *options, int options_len) {
+void analyze_ipv4_options(dissect_ctx_t *ctx, const u_char *options, int options_len) {
+    ipv4_stats_t *stats = &ctx->state->ipv4;
     if (options_len == 0) return;
     
-    printf("  Options (%d bytes): ", options_len);
-    for (int i = 0; i < options_len && i < 16; i++) {
-        printf("%02x ", options[i]);
-    }
-    if (options_len > 16) printf("...");
-    printf("\n");
+    char name[32];
+    dissect_buf_t hex;
+    snprintf(name, sizeof(name), "Options (%d bytes)", options_len);
+    dissect_buf_init(&hex);
+    dissect_buf_hex(&hex, options, options_len < 16 ? options_len : 16);
+    if (options_len > 16) dissect_buf_printf(&hex, "...");
+    dissect_field(ctx, name, options, options_len, "%s", hex.text);
     
-    g_stats.options_packets++;
+    stats->options_packets++;
 }
 
-void analyze_ipv4_header(const ipv4_packet_info_t *ip_info) {
+static const char *address_note(uint32_t ip) {
+    if (is_private_ip(ip)) return is_multicast_ip(ip) ? " (Private) (Multicast)" : " (Private)";
+    return is_multicast_ip(ip) ? " (Multicast)" : "";
+}
+
+void analyze_ipv4_header(dissect_ctx_t *ctx, const ipv4_packet_info_t *ip_info) {
+    const u_char *hdr = ip_info->header;
     char src_ip_str[INET_ADDRSTRLEN], dst_ip_str[INET_ADDRSTRLEN];
+    char tos_desc[128];
     struct in_addr src_addr = {.s_addr = ip_info->src_ip};
     struct in_addr dst_addr = {.s_addr = ip_info->dst_ip};
     
     inet_ntop(AF_INET, &src_addr, src_ip_str, INET_ADDRSTRLEN);
     inet_ntop(AF_INET, &dst_addr, dst_ip_str, INET_ADDRSTRLEN);
     
-    printf("Version: %u\n", ip_info->version);
-    printf("Header Length: %u bytes\n", ip_info->header_length);
-    printf("Type of Service: 0x%02x (%s)\n", ip_info->tos, get_tos_description(ip_info->tos));
-    printf("Total Length: %u bytes\n", ip_info->total_length);
-    printf("Identification: 0x%04x (%u)\n", ip_info->identification, ip_info->identification);
-    
-    analyze_ipv4_flags(ip_info->flags_fragment);
+    dissect_field(ctx, "Version", hdr, 1, "%u", ip_info->version);
+    dissect_field(ctx, "Header Length", hdr, 1, "%u bytes", ip_info->header_length);
+    dissect_field(ctx, "Type of Service", hdr + 1, 1, "0x%02x (%s)", ip_info->tos,
+                  get_tos_description(ip_info->tos, tos_desc, sizeof(tos_desc)));
+    dissect_field(ctx, "Total Length", hdr + 2, 2, "%u bytes", ip_info->total_length);
+    dissect_field(ctx, "Identification", hdr + 4, 2, "0x%04x (%u)", ip_info->identification, ip_info->identification);
     
-    printf("TTL: %u\n", ip_info->ttl);
-    printf("Protocol: %u (%s)\n", ip_info->protocol, get_protocol_name(ip_info->protocol));
-    printf("Header Checksum: 0x%04x\n", ip_info->checksum);
+    analyze_ipv4_flags(ctx, hdr + 6, ip_info->flags_fragment);
     
-    printf("Source IP: %s", src_ip_str);
-    if (is_private_ip(ip_info->src_ip)) printf(" (Private)");
-    if (is_multicast_ip(ip_info->src_ip)) printf(" (Multicast)");
-    printf("\n");
+    dissect_field(ctx, "TTL", hdr + 8, 1, "%u", ip_info->ttl);
+    dissect_field(ctx, "Protocol", hdr + 9, 1, "%u (%s)", ip_info->protocol, get_protocol_name(ip_info->protocol));
+    dissect_field(ctx, "Header Checksum", hdr + 10, 2, "0x%04x", ip_info->checksum);
+    dissect_field(ctx, "Source IP", hdr + 12, 4, "%s%s", src_ip_str, address_note(ip_info->src_ip));
+    dissect_field(ctx, "Destination IP", hdr + 16, 4, "%s%s", dst_ip_str, address_note(ip_info->dst_ip));
     
-    printf("Destination IP: %s", dst_ip_str);
-    if (is_private_ip(ip_info->dst_ip)) printf(" (Private)");
-    if (is_multicast_ip(ip_info->dst_ip)) printf(" (Multicast)");
-    printf("\n");
-    
-    analyze_ipv4_options(ip_info->options, ip_info->options_len);
+    analyze_ipv4_options(ctx, ip_info->options, ip_info->options_len);
     
     // Payload analysis
     if (ip_info->payload_len > 0) {
-        printf("Payload: %d bytes (%s)\n", ip_info->payload_len, get_protocol_name(ip_info->protocol));
+        dissect_field(ctx, "Payload", ip_info->payload, ip_info->payload_len, "%d bytes (%s)",
+                      ip_info->payload_len, get_protocol_name(ip_info->protocol));
         
         // Show first few bytes of payload for analysis
-        printf("  First 16 bytes: ");
         int show_bytes = (ip_info->payload_len > 16) ? 16 : ip_info->payload_len;
-        for (int i = 0; i < show_bytes; i++) {
-            printf("%02x ", ip_info->payload[i]);
-        }
-        if (ip_info->payload_len > 16) printf("...");
-        printf("\n");
+        dissect_buf_t hex;
+        dissect_buf_init(&hex);
+        dissect_buf_hex(&hex, ip_info->payload, show_bytes);
+        if (ip_info->payload_len > 16) dissect_buf_printf(&hex, "...");
+        dissect_field(ctx, "First 16 bytes", ip_info->payload, show_bytes, "%s", hex.text);
     }
 }
 
 void parse_ipv4(const u_char *payload, int payload_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_ipv4(&ctx, payload, payload_len);
+}
+
+void dissect_ipv4(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
+    ipv4_stats_t *stats = &ctx->state->ipv4;
     if (payload_len < (int)sizeof(struct ip)) {
-        printf("Invalid IPv4 packet: too short (%d bytes)\n", payload_len);
+        dissect_note(ctx, payload, payload_len, "Invalid IPv4 packet: too short (%d bytes)", payload_len);
         return;
     }
 
@@ -174,12 +187,13 @@ void parse_ipv4(const u_char *payload, int payload_len) {
     
     // Validate IPv4 version
     if (ip_hdr->ip_v != 4) {
-        printf("Not an IPv4 packet (version: %d)\n", ip_hdr->ip_v);
+        dissect_note(ctx, payload, 1, "Not an IPv4 packet (version: %d)", ip_hdr->ip_v);
         return;
     }
     
     // Extract packet information
     ipv4_packet_info_t ip_info = {
+        .header = payload,
         .version = ip_hdr->ip_v,
         .header_length = ip_hdr->ip_hl * 4,
         .tos = ip_hdr->ip_tos,
@@ -195,7 +209,7 @@ void parse_ipv4(const u_char *payload, int payload_len) {
     
     // Validate header length
     if (ip_info.header_length < 20 || ip_info.header_length > payload_len) {
-        printf("Invalid IPv4 header length: %u\n", ip_info.header_length);
+        dissect_note(ctx, payload, 1, "Invalid IPv4 header length: %u", ip_info.header_length);
         return;
     }
     
@@ -218,53 +232,63 @@ void parse_ipv4(const u_char *payload, int payload_len) {
     }
     
     // Update statistics
-    g_stats.total_packets++;
-    g_stats.total_bytes += ip_info.total_length;
+    stats->total_packets++;
+    stats->total_bytes += ip_info.total_length;
     
     switch (ip_info.protocol) {
-        case IPPROTO_TCP: g_stats.tcp_packets++; break;
-        case IPPROTO_UDP: g_stats.udp_packets++; break;
-        case IPPROTO_ICMP: g_stats.icmp_packets++; break;
-        default: g_stats.other_packets++; break;
+        case IPPROTO_TCP: stats->tcp_packets++; break;
+        case IPPROTO_UDP: stats->udp_packets++; break;
+        case IPPROTO_ICMP: stats->icmp_packets++; break;
+        default: stats->other_packets++; break;
     }
     
-    track_ip_addresses(ip_info.src_ip, ip_info.dst_ip);
-    
-    // Print timestamp
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    printf("\n[%02d:%02d:%02d] ", tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
+    track_ip_addresses(stats, ip_info.src_ip, ip_info.dst_ip);
     
-    printf("=== IPv4 Packet #%lu ===\n", g_stats.total_packets);
+    char title[48];
+    snprintf(title, sizeof(title), "IPv4 Packet #%lu", stats->total_packets);
+    dissect_begin(ctx, title, payload, ip_info.header_length);
     
-    analyze_ipv4_header(&ip_info);
+    analyze_ipv4_header(ctx, &ip_info);
     
-    printf("==========================\n");
+    dissect_end(ctx);
 }
 
-void print_ipv4_stats(void) {
+void print_ipv4_stats(const ipv4_stats_t *stats) {
     printf("\n--- IPv4 Traffic Statistics ---\n");
-    printf("Total Packets: %lu\n", g_stats.total_packets);
-    printf("Total Bytes: %lu\n", g_stats.total_bytes);
-    printf("TCP Packets: %lu (%.1f%%)\n", g_stats.tcp_packets,
-           g_stats.total_packets ? (g_stats.tcp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("UDP Packets: %lu (%.1f%%)\n", g_stats.udp_packets,
-           g_stats.total_packets ? (g_stats.udp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("ICMP Packets: %lu (%.1f%%)\n", g_stats.icmp_packets,
-           g_stats.total_packets ? (g_stats.icmp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("Other Packets: %lu (%.1f%%)\n", g_stats.other_packets,
-           g_stats.total_packets ? (g_stats.other_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("Fragmented Packets: %lu\n", g_stats.fragmented_packets);
-    printf("Packets with Options: %lu\n", g_stats.options_packets);
-    printf("Unique Source IPs: %d\n", g_stats.src_ip_count);
-    printf("Unique Destination IPs: %d\n", g_stats.dst_ip_count);
+    printf("Total Packets: %lu\n", stats->total_packets);
+    printf("Total Bytes: %lu\n", stats->total_bytes);
+    printf("TCP Packets: %lu (%.1f%%)\n", stats->tcp_packets,
+           stats->total_packets ? (stats->tcp_packets * 100.0 / stats->total_packets) : 0);
+    printf("UDP Packets: %lu (%.1f%%)\n", stats->udp_packets,
+           stats->total_packets ? (stats->udp_packets * 100.0 / stats->total_packets) : 0);
+    printf("ICMP Packets: %lu (%.1f%%)\n", stats->icmp_packets,
+           stats->total_packets ? (stats->icmp_packets * 100.0 / stats->total_packets) : 0);
+    printf("Other Packets: %lu (%.1f%%)\n", stats->other_packets,
+           stats->total_packets ? (stats->other_packets * 100.0 / stats->total_packets) : 0);
+    printf("Fragmented Packets: %lu\n", stats->fragmented_packets);
+    printf("Packets with Options: %lu\n", stats->options_packets);
+    printf("Unique Source IPs: %d\n", stats->src_ips.count);
+    printf("Unique Destination IPs: %d\n", stats->dst_ips.count);
     printf("Average Packet Size: %.1f bytes\n",
-           g_stats.total_packets ? (g_stats.total_bytes / (double)g_stats.total_packets) : 0);
+           stats->total_packets ? (stats->total_bytes / (double)stats->total_packets) : 0);
     printf("------------------------------\n\n");
 }
 
-void reset_ipv4_stats(void) {
-    memset(&g_stats, 0, sizeof(g_stats));
+void reset_ipv4_stats(ipv4_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void merge_ipv4_stats(ipv4_stats_t *into, const ipv4_stats_t *from) {
+    into->total_packets += from->total_packets;
+    into->total_bytes += from->total_bytes;
+    into->tcp_packets += from->tcp_packets;
+    into->udp_packets += from->udp_packets;
+    into->icmp_packets += from->icmp_packets;
+    into->other_packets += from->other_packets;
+    into->fragmented_packets += from->fragmented_packets;
+    into->options_packets += from->options_packets;
+    addr_set_merge(&into->src_ips, &from->src_ips);
+    addr_set_merge(&into->dst_ips, &from->dst_ips);
 }
 #ifdef IPV4_STANDALONE
 #include <pcap.h>
@@ -332,7 +356,7 @@ int main() {
     printf("Listening for IPv4 packets...\n");
     
     // Initialize stats
-    reset_ipv4_stats();
+    reset_ipv4_stats(&dissect_default_state()->ipv4);
     
     // Start packet capture loop (Ctrl+C to stop)
     pcap_loop(g_handle, 0, packet_handler, NULL);
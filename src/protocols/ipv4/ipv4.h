@@ -11,9 +11,11 @@
 #include <sys/types.h>
 #include <pcap.h>
 #include <netinet/ip.h>
+#include "../dissect.h"
 
 // IPv4 packet analysis structure
 typedef struct {
+    const u_char *header;
     uint8_t version;
     uint8_t header_length;
     uint8_t tos;
@@ -31,6 +33,16 @@ typedef struct {
     int payload_len;
 } ipv4_packet_info_t;
 
+// Distinct addresses seen, open addressing with linear probing. Stops
+// growing at 3/4 load, so counts saturate instead of degrading lookups.
+#define IPV4_ADDR_SET_SLOTS 1024
+
+typedef struct {
+    uint32_t slots[IPV4_ADDR_SET_SLOTS];  // 0 marks a free slot
+    int count;
+    int has_zero;                         // 0.0.0.0 cannot live in a slot
+} ipv4_addr_set_t;
+
 // IPv4 traffic statistics
 typedef struct {
     uint64_t total_packets;
@@ -41,22 +53,22 @@ typedef struct {
     uint64_t other_packets;
     uint64_t fragmented_packets;
     uint64_t options_packets;
-    uint32_t unique_src_ips[256];  // Simple tracking
-    uint32_t unique_dst_ips[256];
-    int src_ip_count;
-    int dst_ip_count;
+    ipv4_addr_set_t src_ips;
+    ipv4_addr_set_t dst_ips;
 } ipv4_stats_t;
 
 // Function declarations
 void parse_ipv4(const u_char *payload, int payload_len);
-void analyze_ipv4_header(const ipv4_packet_info_t *ip_info);
-void analyze_ipv4_flags(uint16_t flags_fragment);
-void analyze_ipv4_options(const u_char *options, int options_len);
-void print_ipv4_stats(void);
-void reset_ipv4_stats(void);
+void dissect_ipv4(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
+void analyze_ipv4_header(dissect_ctx_t *ctx, const ipv4_packet_info_t *ip_info);
+void analyze_ipv4_flags(dissect_ctx_t *ctx, const u_char *at, uint16_t flags_fragment);
+void analyze_ipv4_options(dissect_ctx_t *ctx, const u_char *options, int options_len);
+void print_ipv4_stats(const ipv4_stats_t *stats);
+void reset_ipv4_stats(ipv4_stats_t *stats);
+void merge_ipv4_stats(ipv4_stats_t *into, const ipv4_stats_t *from);
 const char* get_protocol_name(uint8_t protocol);
-const char* get_tos_description(uint8_t tos);
-void track_ip_addresses(uint32_t src_ip, uint32_t dst_ip);
+const char* get_tos_description(uint8_t tos, char *desc, size_t desc_len);
+void track_ip_addresses(ipv4_stats_t *stats, uint32_t src_ip, uint32_t dst_ip);
 int is_private_ip(uint32_t ip);
 int is_multicast_ip(uint32_t ip);
 
@@ -3,7 +3,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
 #include <netinet/ip6.h>
@@ -11,9 +10,7 @@
 #include <netinet/udp.h>
 #include <netinet/icmp6.h>
 #include "ipv6.h"
-
-// Global statistics
-static ipv6_stats_t g_stats = {0};
+#include "../dissect_state.h"
 
 // IPv6 next header protocol names
 const char* get_ipv6_next_header_name(uint8_t next_header) {
@@ -46,97 +43,104 @@ int is_ipv6_loopback(const struct in6_addr *addr) {
     return memcmp(addr, &loopback, sizeof(struct in6_addr)) == 0;
 }
 
-void analyze_traffic_class(uint8_t traffic_class) {
+void analyze_traffic_class(dissect_ctx_t *ctx, const u_char *at, uint8_t traffic_class) {
     uint8_t dscp = (traffic_class >> 2) & 0x3F;
     uint8_t ecn = traffic_class & 0x03;
     
-    printf("  DSCP: 0x%02x (%u)", dscp, dscp);
-    if (dscp == 0) printf(" (Best Effort)");
-    else if (dscp == 46) printf(" (Expedited Forwarding)");
-    else if (dscp >= 34 && dscp <= 38) printf(" (Assured Forwarding)");
-    printf("\n");
+    const char *dscp_note = "";
+    if (dscp == 0) dscp_note = " (Best Effort)";
+    else if (dscp == 46) dscp_note = " (Expedited Forwarding)";
+    else if (dscp >= 34 && dscp <= 38) dscp_note = " (Assured Forwarding)";
+    dissect_field(ctx, "DSCP", at, 2, "0x%02x (%u)%s", dscp, dscp, dscp_note);
     
-    printf("  ECN: 0x%01x", ecn);
+    const char *ecn_note = "";
     switch (ecn) {
-        case 0: printf(" (Not ECT)"); break;
-        case 1: printf(" (ECT(1))"); break;
-        case 2: printf(" (ECT(0))"); break;
-        case 3: printf(" (CE - Congestion Experienced)"); break;
+        case 0: ecn_note = " (Not ECT)"; break;
+        case 1: ecn_note = " (ECT(1))"; break;
+        case 2: ecn_note = " (ECT(0))"; break;
+        case 3: ecn_note = " (CE - Congestion Experienced)"; break;
     }
-    printf("\n");
+    dissect_field(ctx, "ECN", at + 1, 1, "0x%01x%s", ecn, ecn_note);
+}
+
+static const char *address_note(const struct in6_addr *addr) {
+    if (is_ipv6_loopback(addr)) return " (Loopback)";
+    if (is_ipv6_link_local(addr)) return " (Link-Local)";
+    if (is_ipv6_multicast(addr)) return " (Multicast)";
+    return "";
 }
 
-void analyze_ipv6_addresses(const struct in6_addr *src, const struct in6_addr *dst) {
+void analyze_ipv6_addresses(dissect_ctx_t *ctx, const u_char *at, const struct in6_addr *src, const struct in6_addr *dst) {
+    ipv6_stats_t *stats = &ctx->state->ipv6;
     char src_str[INET6_ADDRSTRLEN], dst_str[INET6_ADDRSTRLEN];
     
     inet_ntop(AF_INET6, src, src_str, INET6_ADDRSTRLEN);
     inet_ntop(AF_INET6, dst, dst_str, INET6_ADDRSTRLEN);
     
-    printf("Source IPv6: %s", src_str);
-    if (is_ipv6_loopback(src)) printf(" (Loopback)");
-    else if (is_ipv6_link_local(src)) printf(" (Link-Local)");
-    else if (is_ipv6_multicast(src)) printf(" (Multicast)");
-    printf("\n");
-    
-    printf("Destination IPv6: %s", dst_str);
-    if (is_ipv6_loopback(dst)) printf(" (Loopback)");
-    else if (is_ipv6_link_local(dst)) printf(" (Link-Local)");
-    else if (is_ipv6_multicast(dst)) printf(" (Multicast)");
-    printf("\n");
+    dissect_field(ctx, "Source IPv6", at, 16, "%s%s", src_str, address_note(src));
+    dissect_field(ctx, "Destination IPv6", at ? at + 16 : NULL, 16, "%s%s", dst_str, address_note(dst));
     
     // Update statistics
     if (is_ipv6_multicast(src) || is_ipv6_multicast(dst)) {
-        g_stats.multicast_packets++;
+        stats->multicast_packets++;
     }
     if (is_ipv6_link_local(src) || is_ipv6_link_local(dst)) {
-        g_stats.link_local_packets++;
+        stats->link_local_packets++;
     }
 }
 
-void analyze_ipv6_header(const ipv6_packet_info_t *ip6_info) {
-    printf("Version: %u\n", ip6_info->version);
-    printf("Traffic Class: 0x%02x\n", ip6_info->traffic_class);
-    analyze_traffic_class(ip6_info->traffic_class);
-    printf("Flow Label: 0x%05x (%u)\n", ip6_info->flow_label, ip6_info->flow_label);
-    printf("Payload Length: %u bytes\n", ip6_info->payload_length);
-    printf("Next Header: %u (%s)\n", ip6_info->next_header, 
-           get_ipv6_next_header_name(ip6_info->next_header));
-    printf("Hop Limit: %u\n", ip6_info->hop_limit);
-    
-    analyze_ipv6_addresses(&ip6_info->src_addr, &ip6_info->dst_addr);
+void analyze_ipv6_header(dissect_ctx_t *ctx, const ipv6_packet_info_t *ip6_info) {
+    ipv6_stats_t *stats = &ctx->state->ipv6;
+    const u_char *hdr = ip6_info->header;
+    dissect_field(ctx, "Version", hdr, 1, "%u", ip6_info->version);
+    dissect_field(ctx, "Traffic Class", hdr, 2, "0x%02x", ip6_info->traffic_class);
+    analyze_traffic_class(ctx, hdr, ip6_info->traffic_class);
+    dissect_field(ctx, "Flow Label", hdr + 1, 3, "0x%05x (%u)", ip6_info->flow_label, ip6_info->flow_label);
+    dissect_field(ctx, "Payload Length", hdr + 4, 2, "%u bytes", ip6_info->payload_length);
+    dissect_field(ctx, "Next Header", hdr + 6, 1, "%u (%s)", ip6_info->next_header, 
+                  get_ipv6_next_header_name(ip6_info->next_header));
+    dissect_field(ctx, "Hop Limit", hdr + 7, 1, "%u", ip6_info->hop_limit);
+    
+    analyze_ipv6_addresses(ctx, hdr + 8, &ip6_info->src_addr, &ip6_info->dst_addr);
     
     // Extension headers analysis
     if (ip6_info->extension_headers_len > 0) {
-        printf("Extension Headers: %d bytes\n", ip6_info->extension_headers_len);
-        printf("  First 16 bytes: ");
         int show_bytes = (ip6_info->extension_headers_len > 16) ? 16 : ip6_info->extension_headers_len;
-        for (int i = 0; i < show_bytes; i++) {
-            printf("%02x ", ip6_info->extension_headers[i]);
-        }
-        if (ip6_info->extension_headers_len > 16) printf("...");
-        printf("\n");
-        g_stats.extension_header_packets++;
+        dissect_buf_t hex;
+        dissect_buf_init(&hex);
+        dissect_buf_hex(&hex, ip6_info->extension_headers, show_bytes);
+        if (ip6_info->extension_headers_len > 16) dissect_buf_printf(&hex, "...");
+        dissect_field(ctx, "Extension Headers", ip6_info->extension_headers, ip6_info->extension_headers_len,
+                      "%d bytes", ip6_info->extension_headers_len);
+        dissect_field(ctx, "First 16 bytes", ip6_info->extension_headers, show_bytes, "%s", hex.text);
+        stats->extension_header_packets++;
     }
     
     // Payload analysis
     if (ip6_info->payload_len > 0) {
-        printf("Payload: %d bytes (%s)\n", ip6_info->payload_len, 
-               get_ipv6_next_header_name(ip6_info->next_header));
+        dissect_field(ctx, "Payload", ip6_info->payload, ip6_info->payload_len, "%d bytes (%s)",
+                      ip6_info->payload_len, get_ipv6_next_header_name(ip6_info->next_header));
         
         // Show first few bytes of payload
-        printf("  First 16 bytes: ");
         int show_bytes = (ip6_info->payload_len > 16) ? 16 : ip6_info->payload_len;
-        for (int i = 0; i < show_bytes; i++) {
-            printf("%02x ", ip6_info->payload[i]);
-        }
-        if (ip6_info->payload_len > 16) printf("...");
-        printf("\n");
+        dissect_buf_t hex;
+        dissect_buf_init(&hex);
+        dissect_buf_hex(&hex, ip6_info->payload, show_bytes);
+        if (ip6_info->payload_len > 16) dissect_buf_printf(&hex, "...");
+        dissect_field(ctx, "First 16 bytes", ip6_info->payload, show_bytes, "%s", hex.text);
     }
 }
 
 void parse_ipv6(const u_char *payload, int payload_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_ipv6(&ctx, payload, payload_len);
+}
+
+void dissect_ipv6(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
+    ipv6_stats_t *stats = &ctx->state->ipv6;
     if (payload_len < (int)sizeof(struct ip6_hdr)) {
-        printf("Invalid IPv6 packet: too short (%d bytes)\n", payload_len);
+        dissect_note(ctx, payload, payload_len, "Invalid IPv6 packet: too short (%d bytes)", payload_len);
         return;
     }
 
@@ -148,12 +152,13 @@ void parse_ipv6(const u_char *payload, int payload_len) {
     
     // Validate IPv6 version
     if (version != 6) {
-        printf("Not an IPv6 packet (version: %d)\n", version);
+        dissect_note(ctx, payload, 1, "Not an IPv6 packet (version: %d)", version);
         return;
     }
     
     // Extract packet information
     ipv6_packet_info_t ip6_info = {
+        .header = payload,
         .version = version,
         .traffic_class = (ver_tc_fl >> 20) & 0xFF,
         .flow_label = ver_tc_fl & 0xFFFFF,
@@ -192,52 +197,62 @@ void parse_ipv6(const u_char *payload, int payload_len) {
     }
     
     // Update statistics
-    g_stats.total_packets++;
-    g_stats.total_bytes += payload_len;
+    stats->total_packets++;
+    stats->total_bytes += payload_len;
     
     switch (ip6_info.next_header) {
-        case IPPROTO_TCP: g_stats.tcp_packets++; break;
-        case IPPROTO_UDP: g_stats.udp_packets++; break;
-        case IPPROTO_ICMPV6: g_stats.icmpv6_packets++; break;
-        case IPPROTO_FRAGMENT: g_stats.fragmented_packets++; break;
-        default: g_stats.other_packets++; break;
+        case IPPROTO_TCP: stats->tcp_packets++; break;
+        case IPPROTO_UDP: stats->udp_packets++; break;
+        case IPPROTO_ICMPV6: stats->icmpv6_packets++; break;
+        case IPPROTO_FRAGMENT: stats->fragmented_packets++; break;
+        default: stats->other_packets++; break;
     }
     
-    // Print timestamp
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    printf("\n[%02d:%02d:%02d] ", tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
-    
-    printf("=== IPv6 Packet #%lu ===\n", g_stats.total_packets);
+    char title[48];
+    snprintf(title, sizeof(title), "IPv6 Packet #%lu", stats->total_packets);
+    dissect_begin(ctx, title, payload, ipv6_header_len);
     
-    analyze_ipv6_header(&ip6_info);
+    analyze_ipv6_header(ctx, &ip6_info);
     
-    printf("==========================\n");
+    dissect_end(ctx);
 }
 
-void print_ipv6_stats(void) {
+void print_ipv6_stats(const ipv6_stats_t *stats) {
     printf("\n--- IPv6 Traffic Statistics ---\n");
-    printf("Total Packets: %lu\n", g_stats.total_packets);
-    printf("Total Bytes: %lu\n", g_stats.total_bytes);
-    printf("TCP Packets: %lu (%.1f%%)\n", g_stats.tcp_packets,
-           g_stats.total_packets ? (g_stats.tcp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("UDP Packets: %lu (%.1f%%)\n", g_stats.udp_packets,
-           g_stats.total_packets ? (g_stats.udp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("ICMPv6 Packets: %lu (%.1f%%)\n", g_stats.icmpv6_packets,
-           g_stats.total_packets ? (g_stats.icmpv6_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("Other Packets: %lu (%.1f%%)\n", g_stats.other_packets,
-           g_stats.total_packets ? (g_stats.other_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("Extension Header Packets: %lu\n", g_stats.extension_header_packets);
-    printf("Fragmented Packets: %lu\n", g_stats.fragmented_packets);
-    printf("Multicast Packets: %lu\n", g_stats.multicast_packets);
-    printf("Link-Local Packets: %lu\n", g_stats.link_local_packets);
+    printf("Total Packets: %lu\n", stats->total_packets);
+    printf("Total Bytes: %lu\n", stats->total_bytes);
+    printf("TCP Packets: %lu (%.1f%%)\n", stats->tcp_packets,
+           stats->total_packets ? (stats->tcp_packets * 100.0 / stats->total_packets) : 0);
+    printf("UDP Packets: %lu (%.1f%%)\n", stats->udp_packets,
+           stats->total_packets ? (stats->udp_packets * 100.0 / stats->total_packets) : 0);
+    printf("ICMPv6 Packets: %lu (%.1f%%)\n", stats->icmpv6_packets,
+           stats->total_packets ? (stats->icmpv6_packets * 100.0 / stats->total_packets) : 0);
+    printf("Other Packets: %lu (%.1f%%)\n", stats->other_packets,
+           stats->total_packets ? (stats->other_packets * 100.0 / stats->total_packets) : 0);
+    printf("Extension Header Packets: %lu\n", stats->extension_header_packets);
+    printf("Fragmented Packets: %lu\n", stats->fragmented_packets);
+    printf("Multicast Packets: %lu\n", stats->multicast_packets);
+    printf("Link-Local Packets: %lu\n", stats->link_local_packets);
     printf("Average Packet Size: %.1f bytes\n",
-           g_stats.total_packets ? (g_stats.total_bytes / (double)g_stats.total_packets) : 0);
+           stats->total_packets ? (stats->total_bytes / (double)stats->total_packets) : 0);
     printf("------------------------------\n\n");
 }
 
-void reset_ipv6_stats(void) {
-    memset(&g_stats, 0, sizeof(g_stats));
+void reset_ipv6_stats(ipv6_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void merge_ipv6_stats(ipv6_stats_t *into, const ipv6_stats_t *from) {
+    into->total_packets += from->total_packets;
+    into->total_bytes += from->total_bytes;
+    into->tcp_packets += from->tcp_packets;
+    into->udp_packets += from->udp_packets;
+    into->icmpv6_packets += from->icmpv6_packets;
+    into->other_packets += from->other_packets;
+    into->extension_header_packets += from->extension_header_packets;
+    into->fragmented_packets += from->fragmented_packets;
+    into->multicast_packets += from->multicast_packets;
+    into->link_local_packets += from->link_local_packets;
 }
 #ifdef IPV6_STANDALONE
 #include <pcap.h>
@@ -305,7 +320,7 @@ int main() {
     printf("Listening for IPv6 packets...\n");
     
     // Initialize stats
-    reset_ipv6_stats();
+    reset_ipv6_stats(&dissect_default_state()->ipv6);
     
     // Start packet capture loop (Ctrl+C to stop)
     pcap_loop(g_handle, 0, packet_handler, NULL);
@@ -11,9 +11,11 @@
 #include <sys/types.h>
 #include <pcap.h>
 #include <netinet/ip6.h>
+#include "../dissect.h"
 
 // IPv6 packet analysis structure
 typedef struct {
+    const u_char *header;
     uint8_t version;
     uint8_t traffic_class;
     uint32_t flow_label;
@@ -44,14 +46,16 @@ typedef struct {
 
 // Function declarations
 void parse_ipv6(const u_char *payload, int payload_len);
-void analyze_ipv6_header(const ipv6_packet_info_t *ip6_info);
-void analyze_ipv6_addresses(const struct in6_addr *src, const struct in6_addr *dst);
-void analyze_traffic_class(uint8_t traffic_class);
+void dissect_ipv6(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
+void analyze_ipv6_header(dissect_ctx_t *ctx, const ipv6_packet_info_t *ip6_info);
+void analyze_ipv6_addresses(dissect_ctx_t *ctx, const u_char *at, const struct in6_addr *src, const struct in6_addr *dst);
+void analyze_traffic_class(dissect_ctx_t *ctx, const u_char *at, uint8_t traffic_class);
 const char* get_ipv6_next_header_name(uint8_t next_header);
 int is_ipv6_multicast(const struct in6_addr *addr);
 int is_ipv6_link_local(const struct in6_addr *addr);
 int is_ipv6_loopback(const struct in6_addr *addr);
-void print_ipv6_stats(void);
-void reset_ipv6_stats(void);
+void print_ipv6_stats(const ipv6_stats_t *stats);
+void reset_ipv6_stats(ipv6_stats_t *stats);
+void merge_ipv6_stats(ipv6_stats_t *into, const ipv6_stats_t *from);
 
 #endif // IPV6_H
@@ -0,0 +1,158 @@
+#include "port_registry.h"
+
+#include <stddef.h>
+#include <strings.h>
+
+#define L4_TCP 6
+#define L4_UDP 17
+
+// Well-known ports, one byte per port so classification is a single load
+static uint8_t tcp_ports[65536] = {
+    [20] = PORT_APP_FTP, [21] = PORT_APP_FTP,
+    [22] = PORT_APP_SSH,
+    [23] = PORT_APP_TELNET,
+    [25] = PORT_APP_SMTP, [465] = PORT_APP_SMTP, [587] = PORT_APP_SMTP,
+    [53] = PORT_APP_DNS,
+    [80] = PORT_APP_HTTP,
+    [110] = PORT_APP_POP3, [995] = PORT_APP_POP3,
+    [139] = PORT_APP_NETBIOS,
+    [143] = PORT_APP_IMAP, [993] = PORT_APP_IMAP,
+    [443] = PORT_APP_HTTPS,
+    [5060] = PORT_APP_SIP, [5061] = PORT_APP_SIP,
+};
+
+static uint8_t udp_ports[65536] = {
+    [53] = PORT_APP_DNS,
+    [67] = PORT_APP_DHCP, [68] = PORT_APP_DHCP,
+    [69] = PORT_APP_TFTP,
+    [80] = PORT_APP_QUIC, [443] = PORT_APP_QUIC,
+    [123] = PORT_APP_NTP,
+    [137] = PORT_APP_NETBIOS, [138] = PORT_APP_NETBIOS,
+    [161] = PORT_APP_SNMP, [162] = PORT_APP_SNMP,
+    [5060] = PORT_APP_SIP, [5061] = PORT_APP_SIP,
+};
+
+static const char *const app_names[PORT_APP_COUNT] = {
+    [PORT_APP_HTTP] = "HTTP",
+    [PORT_APP_HTTPS] = "HTTPS",
+    [PORT_APP_SSH] = "SSH",
+    [PORT_APP_FTP] = "FTP",
+    [PORT_APP_SMTP] = "SMTP",
+    [PORT_APP_DNS] = "DNS",
+    [PORT_APP_DHCP] = "DHCP",
+    [PORT_APP_NTP] = "NTP",
+    [PORT_APP_QUIC] = "QUIC",
+    [PORT_APP_IMAP] = "IMAP",
+    [PORT_APP_POP3] = "POP3",
+    [PORT_APP_TELNET] = "Telnet",
+    [PORT_APP_SNMP] = "SNMP",
+    [PORT_APP_TFTP] = "TFTP",
+    [PORT_APP_NETBIOS] = "NetBIOS",
+    [PORT_APP_SIP] = "SIP",
+};
+
+// What each overridden port mapped to before, so overrides can be undone
+typedef struct {
+    uint8_t l4_proto;
+    uint16_t port;
+    uint8_t original;
+} port_override_t;
+
+static port_override_t overrides[PORT_REGISTRY_MAX_OVERRIDES];
+static int override_count = 0;
+
+static uint8_t *table_for(uint8_t l4_proto) {
+    switch (l4_proto) {
+    case L4_TCP: return tcp_ports;
+    case L4_UDP: return udp_ports;
+    default: return NULL;
+    }
+}
+
+// Relaxed atomics compile to plain byte loads/stores but keep a decode-as
+// change racing with a dissecting thread well defined
+static uint8_t load_entry(const uint8_t *table, uint16_t port) {
+    return __atomic_load_n(&table[port], __ATOMIC_RELAXED);
+}
+
+static void store_entry(uint8_t *table, uint16_t port, uint8_t app) {
+    __atomic_store_n(&table[port], app, __ATOMIC_RELAXED);
+}
+
+static int find_override(uint8_t l4_proto, uint16_t port) {
+    for (int i = 0; i < override_count; i++) {
+        if (overrides[i].l4_proto == l4_proto && overrides[i].port == port) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint8_t port_registry_lookup(uint8_t l4_proto, uint16_t port) {
+    const uint8_t *table = table_for(l4_proto);
+    return table ? load_entry(table, port) : PORT_APP_NONE;
+}
+
+uint8_t port_registry_classify(uint8_t l4_proto, uint16_t src_port, uint16_t dst_port) {
+    const uint8_t *table = table_for(l4_proto);
+    if (!table) {
+        return PORT_APP_NONE;
+    }
+    uint16_t low = src_port < dst_port ? src_port : dst_port;
+    uint16_t high = src_port < dst_port ? dst_port : src_port;
+    uint8_t app = load_entry(table, low);
+    return app != PORT_APP_NONE ? app : load_entry(table, high);
+}
+
+int port_registry_decode_as(uint8_t l4_proto, uint16_t port, uint8_t app) {
+    uint8_t *table = table_for(l4_proto);
+    if (!table || app >= PORT_APP_COUNT) {
+        return -1;
+    }
+    if (find_override(l4_proto, port) < 0) {
+        if (override_count == PORT_REGISTRY_MAX_OVERRIDES) {
+            return -1;
+        }
+        overrides[override_count].l4_proto = l4_proto;
+        overrides[override_count].port = port;
+        overrides[override_count].original = load_entry(table, port);
+        override_count++;
+    }
+    store_entry(table, port, app);
+    return 0;
+}
+
+void port_registry_clear_decode_as(uint8_t l4_proto, uint16_t port) {
+    int index = find_override(l4_proto, port);
+    if (index < 0) {
+        return;
+    }
+    store_entry(table_for(l4_proto), port, overrides[index].original);
+    overrides[index] = overrides[--override_count];
+}
+
+void port_registry_clear_all(void) {
+    while (override_count > 0) {
+        const port_override_t *last = &overrides[override_count - 1];
+        port_registry_clear_decode_as(last->l4_proto, last->port);
+    }
+}
+
+const char *port_registry_app_name(uint8_t app) {
+    return app < PORT_APP_COUNT ? app_names[app] : NULL;
+}
+
+int port_registry_app_from_name(const char *name) {
+    if (!name) {
+        return -1;
+    }
+    if (strcasecmp(name, "none") == 0) {
+        return PORT_APP_NONE;
+    }
+    for (int app = PORT_APP_NONE + 1; app < PORT_APP_COUNT; app++) {
+        if (strcasecmp(name, app_names[app]) == 0) {
+            return app;
+        }
+    }
+    return -1;
+}
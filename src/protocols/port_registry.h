@@ -0,0 +1,56 @@
+#ifndef PORT_REGISTRY_H
+#define PORT_REGISTRY_H
+
+#include <stdint.h>
+
+// Application protocols a transport port can be dispatched to. The packet
+// table, the dissection tree and the display filters all classify through
+// this one registry, so they always agree on what a packet is.
+#define PORT_APP_NONE    0
+#define PORT_APP_HTTP    1
+#define PORT_APP_HTTPS   2
+#define PORT_APP_SSH     3
+#define PORT_APP_FTP     4
+#define PORT_APP_SMTP    5
+#define PORT_APP_DNS     6
+#define PORT_APP_DHCP    7
+#define PORT_APP_NTP     8
+#define PORT_APP_QUIC    9
+#define PORT_APP_IMAP    10
+#define PORT_APP_POP3    11
+#define PORT_APP_TELNET  12
+#define PORT_APP_SNMP    13
+#define PORT_APP_TFTP    14
+#define PORT_APP_NETBIOS 15
+#define PORT_APP_SIP     16
+#define PORT_APP_COUNT   17
+
+// Most decode-as overrides kept at once
+#define PORT_REGISTRY_MAX_OVERRIDES 256
+
+// l4_proto is the IP protocol number; only TCP (6) and UDP (17) have
+// tables, everything else maps to PORT_APP_NONE. Lookups are a plain
+// indexed load and safe from any thread; a decode-as change made while
+// other threads dissect is seen by each packet either before or after.
+uint8_t port_registry_lookup(uint8_t l4_proto, uint16_t port);
+
+// Application protocol of a flow: the lower port is taken as the server
+// side and wins when both ports are registered
+uint8_t port_registry_classify(uint8_t l4_proto, uint16_t src_port, uint16_t dst_port);
+
+// Decode-as: dissect port as app (PORT_APP_NONE turns dispatch off for
+// it). Returns 0, or -1 for an unknown protocol/app or a full override list.
+int port_registry_decode_as(uint8_t l4_proto, uint16_t port, uint8_t app);
+
+// Drops the override on port, or every override, restoring the built-in map
+void port_registry_clear_decode_as(uint8_t l4_proto, uint16_t port);
+void port_registry_clear_all(void);
+
+// Short display name, NULL for PORT_APP_NONE and unknown values
+const char *port_registry_app_name(uint8_t app);
+
+// Case-insensitive inverse of port_registry_app_name(), "none" included;
+// -1 when the name is unknown
+int port_registry_app_from_name(const char *name);
+
+#endif // PORT_REGISTRY_H
@@ -6,6 +6,12 @@
 
 // Main QUIC parser function
 void parse_quic(const u_char *payload, int payload_len, int src_port, int dst_port) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_quic(&ctx, payload, payload_len, src_port, dst_port);
+}
+
+void dissect_quic(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     if (payload_len <= 0) return;
     
     // Only check content-based detection for QUIC
@@ -13,54 +19,60 @@ void parse_quic(const u_char *payload, int payload_len, int src_port, int dst_po
         return;
     }
 
-    printf("=== QUIC Packet ===\n");
-    printf("Ports: %d -> %d\n", src_port, dst_port);
-    printf("Length: %d bytes\n", payload_len);
-
-    if (payload_len < 1) {
-        printf("Error: Packet too short\n");
-        printf("===================\n");
-        return;
-    }
+    dissect_begin(ctx, "QUIC Packet", payload, payload_len);
+    dissect_field(ctx, "Ports", NULL, 0, "%d -> %d", src_port, dst_port);
+    dissect_field(ctx, "Length", payload, payload_len, "%d bytes", payload_len);
 
     uint8_t first_byte = payload[0];
     int is_long_header = first_byte & 0x80;
 
     if (is_long_header) {
-        parse_quic_long_header(payload, payload_len, first_byte);
+        parse_quic_long_header(ctx, payload, payload_len, first_byte);
     } else {
-        parse_quic_short_header(payload, payload_len, first_byte);
+        parse_quic_short_header(ctx, payload, payload_len, first_byte);
     }
 
-    printf("===================\n");
+    dissect_end(ctx);
+}
+
+static void dissect_hex_field(dissect_ctx_t *ctx, const char *name, const u_char *data, int len, int max_bytes) {
+    int shown = len < max_bytes ? len : max_bytes;
+    dissect_buf_t hex;
+    dissect_buf_init(&hex);
+    for (int i = 0; i < shown; i++) {
+        dissect_buf_printf(&hex, "%02x", data[i]);
+    }
+    if (len > max_bytes) dissect_buf_printf(&hex, "...");
+    dissect_field(ctx, name, data, len, "%s", hex.text);
 }
 
 // Parse QUIC long header packets
-void parse_quic_long_header(const u_char *data, int len, uint8_t first_byte) {
+void parse_quic_long_header(dissect_ctx_t *ctx, const u_char *data, int len, uint8_t first_byte) {
     const u_char *ptr = data + 1;
     const u_char *end = data + len;
 
-    printf("Header Type: Long Header\n");
+    dissect_field(ctx, "Header Type", data, 1, "Long Header");
 
     // Extract packet type
     uint8_t packet_type = (first_byte & 0x30) >> 4;
-    printf("Packet Type: %s\n", get_quic_packet_type_name(packet_type));
+    dissect_field(ctx, "Packet Type", data, 1, "%s", get_quic_packet_type_name(packet_type));
 
     // Version (4 bytes)
     if (ptr + 4 > end) return;
     uint32_t version = ntohl(*(uint32_t*)ptr);
-    printf("Version: 0x%08x (%s)\n", version, get_quic_version_name(version));
+    dissect_field(ctx, "Version", ptr, 4, "0x%08x (%s)", version, get_quic_version_name(version));
     ptr += 4;
 
     // Version negotiation packet
     if (version == QUIC_VERSION_NEGOTIATION) {
-        printf("Version Negotiation Packet\n");
-        printf("Supported Versions:\n");
+        dissect_note(ctx, NULL, 0, "Version Negotiation Packet");
+        dissect_begin(ctx, "Supported Versions", ptr, (int)(end - ptr));
         while (ptr + 4 <= end) {
             uint32_t supported_version = ntohl(*(uint32_t*)ptr);
-            printf("  0x%08x (%s)\n", supported_version, get_quic_version_name(supported_version));
+            dissect_note(ctx, ptr, 4, "0x%08x (%s)", supported_version, get_quic_version_name(supported_version));
             ptr += 4;
         }
+        dissect_end(ctx);
         return;
     }
 
@@ -68,14 +80,14 @@ void parse_quic_long_header(const u_char *data, int len, uint8_t first_byte) {
     if (ptr >= end) return;
     uint8_t dcid_len = *ptr++;
     if (dcid_len > QUIC_MAX_CID_LENGTH || ptr + dcid_len > end) return;
-    print_quic_connection_id(ptr, dcid_len, "Destination Connection ID");
+    print_quic_connection_id(ctx, ptr, dcid_len, "Destination Connection ID");
     ptr += dcid_len;
 
     // Source Connection ID
     if (ptr >= end) return;
     uint8_t scid_len = *ptr++;
     if (scid_len > QUIC_MAX_CID_LENGTH || ptr + scid_len > end) return;
-    print_quic_connection_id(ptr, scid_len, "Source Connection ID");
+    print_quic_connection_id(ctx, ptr, scid_len, "Source Connection ID");
     ptr += scid_len;
 
     // Type-specific fields
@@ -84,28 +96,17 @@ void parse_quic_long_header(const u_char *data, int len, uint8_t first_byte) {
         uint64_t token_len;
         int token_len_bytes = read_quic_varint(ptr, end - ptr, &token_len);
         if (token_len_bytes < 0) return;
+        dissect_field(ctx, "Token Length", ptr, token_len_bytes, "%llu", (unsigned long long)token_len);
         ptr += token_len_bytes;
 
-        printf("Token Length: %llu\n", (unsigned long long)token_len);
         if (token_len > 0) {
-            if (ptr + token_len > end) return;
-            printf("Token: ");
-            int preview_len = (token_len < 16) ? token_len : 16;
-            for (int i = 0; i < preview_len; i++) {
-                printf("%02x", ptr[i]);
-            }
-            if (token_len > 16) printf("...");
-            printf("\n");
+            if (token_len > (uint64_t)(end - ptr)) return;
+            dissect_hex_field(ctx, "Token", ptr, (int)token_len, 16);
             ptr += token_len;
         }
     } else if (packet_type == QUIC_PACKET_RETRY) {
-        printf("Retry Token: ");
         int remaining = end - ptr;
-        if (remaining > 16) remaining = 16;
-        for (int i = 0; i < remaining; i++) {
-            printf("%02x", ptr[i]);
-        }
-        printf("\n");
+        dissect_hex_field(ctx, "Retry Token", ptr, remaining < 16 ? remaining : 16, 16);
         return;
     }
 
@@ -113,82 +114,73 @@ void parse_quic_long_header(const u_char *data, int len, uint8_t first_byte) {
     uint64_t length;
     int length_bytes = read_quic_varint(ptr, end - ptr, &length);
     if (length_bytes < 0) return;
+    dissect_field(ctx, "Payload Length", ptr, length_bytes, "%llu", (unsigned long long)length);
     ptr += length_bytes;
-    printf("Payload Length: %llu\n", (unsigned long long)length);
 
     // Packet Number
     int pn_length = (first_byte & 0x03) + 1;
     if (ptr + pn_length > end) return;
-    printf("Packet Number Length: %d bytes\n", pn_length);
-    printf("Packet Number: ");
-    for (int i = 0; i < pn_length; i++) {
-        printf("%02x", ptr[i]);
-    }
-    printf("\n");
+    dissect_field(ctx, "Packet Number Length", data, 1, "%d bytes", pn_length);
+    dissect_hex_field(ctx, "Packet Number", ptr, pn_length, pn_length);
     ptr += pn_length;
 
     // Payload analysis
     int payload_remaining = end - ptr;
-    printf("Payload: %d bytes ", payload_remaining);
 
     if (packet_type == QUIC_PACKET_INITIAL || packet_type == QUIC_PACKET_HANDSHAKE) {
-        printf("(TLS handshake data)\n");
+        dissect_field(ctx, "Payload", ptr, payload_remaining, "%d bytes (TLS handshake data)", payload_remaining);
         
         // Try to detect TLS handshake messages
         if (payload_remaining > 4) {
             if (ptr[0] == 0x01 && ptr[1] == 0x00) {
-                printf("Detected: TLS Client Hello\n");
+                dissect_field(ctx, "Detected", ptr, 2, "TLS Client Hello");
             } else if (ptr[0] == 0x02 && ptr[1] == 0x00) {
-                printf("Detected: TLS Server Hello\n");
+                dissect_field(ctx, "Detected", ptr, 2, "TLS Server Hello");
             } else if (ptr[0] == 0x0b && ptr[1] == 0x00) {
-                printf("Detected: TLS Certificate\n");
+                dissect_field(ctx, "Detected", ptr, 2, "TLS Certificate");
             }
         }
     } else {
-        printf("(encrypted application data)\n");
+        dissect_field(ctx, "Payload", ptr, payload_remaining, "%d bytes (encrypted application data)", payload_remaining);
     }
 
     // Security analysis
     if (version == QUIC_VERSION_1) {
-        printf("Security: ✓ QUIC v1 (RFC 9000) - Latest stable\n");
+        dissect_field(ctx, "Security", data + 1, 4, "✓ QUIC v1 (RFC 9000) - Latest stable");
     } else if (version == QUIC_VERSION_NEGOTIATION) {
-        printf("Security: ⚠ Version negotiation in progress\n");
+        dissect_field(ctx, "Security", data + 1, 4, "⚠ Version negotiation in progress");
     } else if ((version & 0xFF000000) == 0xFF000000) {
-        printf("Security: ⚠ Draft version - may have issues\n");
+        dissect_field(ctx, "Security", data + 1, 4, "⚠ Draft version - may have issues");
     }
 }
 
 // Parse QUIC short header packets
-void parse_quic_short_header(const u_char *data, int len, uint8_t first_byte) {
+void parse_quic_short_header(dissect_ctx_t *ctx, const u_char *data, int len, uint8_t first_byte) {
     const u_char *ptr = data + 1;
     const u_char *end = data + len;
 
-    printf("Header Type: Short Header (1-RTT)\n");
+    dissect_field(ctx, "Header Type", data, 1, "Short Header (1-RTT)");
 
     // Key phase bit
     int key_phase = (first_byte & 0x04) ? 1 : 0;
-    printf("Key Phase: %d\n", key_phase);
+    dissect_field(ctx, "Key Phase", data, 1, "%d", key_phase);
 
     // Spin bit (for RTT measurement)
     int spin_bit = (first_byte & 0x20) ? 1 : 0;
-    printf("Spin Bit: %d\n", spin_bit);
+    dissect_field(ctx, "Spin Bit", data, 1, "%d", spin_bit);
 
     // Packet Number
     int pn_length = (first_byte & 0x03) + 1;
-    printf("Packet Number Length: %d bytes\n", pn_length);
+    dissect_field(ctx, "Packet Number Length", data, 1, "%d bytes", pn_length);
     
     if (ptr + pn_length > end) return;
-    printf("Packet Number: ");
-    for (int i = 0; i < pn_length; i++) {
-        printf("%02x", ptr[i]);
-    }
-    printf("\n");
+    dissect_hex_field(ctx, "Packet Number", ptr, pn_length, pn_length);
     ptr += pn_length;
 
     // Encrypted payload
     int payload_len = end - ptr;
-    printf("Encrypted Payload: %d bytes\n", payload_len);
-    printf("Status: Application data (encrypted)\n");
+    dissect_field(ctx, "Encrypted Payload", ptr, payload_len, "%d bytes", payload_len);
+    dissect_field(ctx, "Status", NULL, 0, "Application data (encrypted)");
 }
 
 // Read QUIC variable-length integer
@@ -243,16 +235,14 @@ const char* get_quic_version_name(uint32_t version) {
 }
 
 // Print QUIC connection ID
-void print_quic_connection_id(const uint8_t *cid, int len, const char *label) {
-    printf("%s (%d bytes): ", label, len);
+void print_quic_connection_id(dissect_ctx_t *ctx, const uint8_t *cid, int len, const char *label) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s (%d bytes)", label, len);
     if (len == 0) {
-        printf("(empty)");
+        dissect_field(ctx, name, NULL, 0, "(empty)");
     } else {
-        for (int i = 0; i < len; i++) {
-            printf("%02x", cid[i]);
-        }
+        dissect_hex_field(ctx, name, cid, len, len);
     }
-    printf("\n");
 }
 
 // Strict QUIC packet detection
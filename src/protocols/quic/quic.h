@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <pcap.h>
+#include "../dissect.h"
 
 // QUIC Protocol Constants
 #define QUIC_PORT 443
@@ -22,12 +23,13 @@
 
 // Function declarations
 void parse_quic(const u_char *payload, int payload_len, int src_port, int dst_port);
-void parse_quic_long_header(const u_char *data, int len, uint8_t first_byte);
-void parse_quic_short_header(const u_char *data, int len, uint8_t first_byte);
+void dissect_quic(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
+void parse_quic_long_header(dissect_ctx_t *ctx, const u_char *data, int len, uint8_t first_byte);
+void parse_quic_short_header(dissect_ctx_t *ctx, const u_char *data, int len, uint8_t first_byte);
 int read_quic_varint(const u_char *data, int len, uint64_t *value_out);
 const char* get_quic_packet_type_name(uint8_t packet_type);
 const char* get_quic_version_name(uint32_t version);
-void print_quic_connection_id(const uint8_t *cid, int len, const char *label);
+void print_quic_connection_id(dissect_ctx_t *ctx, const uint8_t *cid, int len, const char *label);
 int is_quic_traffic(int src_port, int dst_port);
 int detect_quic_packet(const u_char *payload, int payload_len);
 
@@ -25,45 +25,53 @@ static int starts_with_ci(const char *line, const char *prefix) {
     return 1;
 }
 
-static void print_server_reply(const char *line, int *in_multiline_code) {
+static void print_server_reply(dissect_ctx_t *ctx, const u_char *at, const char *line, int *in_multiline_code) {
+    int line_len = (int)strlen(line);
     // Format: CODE[ -]TEXT, e.g., 250-... or 250 ...
     if (isdigit((unsigned char)line[0]) && isdigit((unsigned char)line[1]) && isdigit((unsigned char)line[2])) {
         int code = (line[0]-'0')*100 + (line[1]-'0')*10 + (line[2]-'0');
         char sep = line[3];
         const char *text = line + (sep == ' ' || sep == '-' ? 4 : 3);
-        printf("Reply %d%c %s\n", code, sep, text);
+        dissect_field(ctx, "Reply", at, line_len, "%d%c %s", code, sep, text);
         if (sep == '-') *in_multiline_code = code; else *in_multiline_code = 0;
     } else if (*in_multiline_code) {
-        printf("Reply %d- %s\n", *in_multiline_code, line);
+        dissect_field(ctx, "Reply", at, line_len, "%d- %s", *in_multiline_code, line);
     } else {
-        printf("Reply %s\n", line);
+        dissect_field(ctx, "Reply", at, line_len, "%s", line);
     }
 }
 
-static void redact_and_print_client_line(const char *line) {
+static void redact_and_print_client_line(dissect_ctx_t *ctx, const u_char *at, const char *line) {
+    int line_len = (int)strlen(line);
     if (starts_with_ci(line, "AUTH ")) {
         // Print mechanism but redact rest
         const char *mech = line + 5;
-        printf("AUTH %.*s <redacted>\n", (int)strcspn(mech, " \r\n"), mech);
+        dissect_field(ctx, "Command", at, line_len, "AUTH %.*s <redacted>", (int)strcspn(mech, " \r\n"), mech);
         return;
     }
     if (starts_with_ci(line, "PASS ") || starts_with_ci(line, "LOGIN ")) {
-        printf("<redacted sensitive>\n");
+        dissect_field(ctx, "Command", at, line_len, "<redacted sensitive>");
         return;
     }
-    printf("%s\n", line);
+    dissect_field(ctx, "Command", at, line_len, "%s", line);
 }
 
 // Parse SMTP control messages
 void parse_smtp(const u_char *payload, int payload_len, int src_port, int dst_port) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_smtp(&ctx, payload, payload_len, src_port, dst_port);
+}
+
+void dissect_smtp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     // Typical SMTP ports: 25 (standard), 587 (submission), 465 (implicit TLS)
     if (src_port != 25 && dst_port != 25 && src_port != 587 && dst_port != 587 && src_port != 465 && dst_port != 465) return;
 
     if (!is_printable_ascii(payload, payload_len)) return;
 
     int server_to_client = (src_port == 25 || src_port == 587 || src_port == 465);
-    printf("=== SMTP Packet ===\n");
-    printf(server_to_client ? "Server -> Client:\n" : "Client -> Server:\n");
+    dissect_begin(ctx, "SMTP Packet", payload, payload_len);
+    dissect_field(ctx, "Direction", NULL, 0, "%s", server_to_client ? "Server -> Client" : "Client -> Server");
 
     char buffer[2049];
     int copy_len = (payload_len < 2048) ? payload_len : 2048;
@@ -74,30 +82,32 @@ void parse_smtp(const u_char *payload, int payload_len, int src_port, int dst_po
     char *saveptr = NULL;
     char *line = strtok_r(buffer, "\r\n", &saveptr);
     while (line) {
+        const u_char *at = payload + (line - buffer);
+        int line_len = (int)strlen(line);
         if (server_to_client) {
-            print_server_reply(line, &in_multiline_code);
+            print_server_reply(ctx, at, line, &in_multiline_code);
         } else {
             // Parse key client commands for quick insights
             if (starts_with_ci(line, "EHLO ") || starts_with_ci(line, "HELO ")) {
-                printf("%s\n", line);
+                dissect_field(ctx, "Command", at, line_len, "%s", line);
             } else if (starts_with_ci(line, "MAIL FROM:")) {
-                printf("MAIL FROM: %s\n", line + 10);
+                dissect_field(ctx, "MAIL FROM", at, line_len, "%s", line + 10);
             } else if (starts_with_ci(line, "RCPT TO:")) {
-                printf("RCPT TO: %s\n", line + 8);
+                dissect_field(ctx, "RCPT TO", at, line_len, "%s", line + 8);
             } else if (starts_with_ci(line, "STARTTLS")) {
-                printf("STARTTLS\n");
+                dissect_field(ctx, "Command", at, line_len, "STARTTLS");
             } else if (starts_with_ci(line, "DATA")) {
-                printf("DATA (message body follows)\n");
+                dissect_field(ctx, "Command", at, line_len, "DATA (message body follows)");
             } else if (starts_with_ci(line, "QUIT")) {
-                printf("QUIT\n");
+                dissect_field(ctx, "Command", at, line_len, "QUIT");
             } else {
-                redact_and_print_client_line(line);
+                redact_and_print_client_line(ctx, at, line);
             }
         }
         line = strtok_r(NULL, "\r\n", &saveptr);
     }
 
-    printf("===================\n");
+    dissect_end(ctx);
 }
 
 #ifdef SMTP_STANDALONE
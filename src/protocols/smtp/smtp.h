@@ -3,8 +3,10 @@
 
 #include <stdint.h>
 #include <pcap.h>  // for u_char
+#include "../dissect.h"
 
 // Parse SMTP traffic
 void parse_smtp(const u_char *payload, int payload_len, int src_port, int dst_port);
+void dissect_smtp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
 
 #endif // SMTP_H
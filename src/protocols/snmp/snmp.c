@@ -6,20 +6,26 @@
 
 // Main SNMP parser function
 void parse_snmp(const u_char *payload, int payload_len, int src_port, int dst_port) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_snmp(&ctx, payload, payload_len, src_port, dst_port);
+}
+
+void dissect_snmp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     if (!is_snmp_traffic(src_port, dst_port)) return;
     if (payload_len < 10) return; // Minimum SNMP message size
 
-    printf("=== SNMP Packet ===\n");
-    printf("Ports: %d -> %d\n", src_port, dst_port);
-    printf("Length: %d bytes\n", payload_len);
+    dissect_begin(ctx, "SNMP Packet", payload, payload_len);
+    dissect_field(ctx, "Ports", NULL, 0, "%d -> %d", src_port, dst_port);
+    dissect_field(ctx, "Length", payload, payload_len, "%d bytes", payload_len);
 
     // Determine direction and type
     if (dst_port == SNMP_PORT) {
-        printf("Direction: Client -> SNMP Agent (Request)\n");
+        dissect_field(ctx, "Direction", NULL, 0, "Client -> SNMP Agent (Request)");
     } else if (src_port == SNMP_PORT) {
-        printf("Direction: SNMP Agent -> Client (Response)\n");
+        dissect_field(ctx, "Direction", NULL, 0, "SNMP Agent -> Client (Response)");
     } else if (src_port == SNMP_TRAP_PORT || dst_port == SNMP_TRAP_PORT) {
-        printf("Direction: SNMP Trap/Inform\n");
+        dissect_field(ctx, "Direction", NULL, 0, "SNMP Trap/Inform");
     }
 
     // Parse SNMP message
@@ -27,37 +33,37 @@ void parse_snmp(const u_char *payload, int payload_len, int src_port, int dst_po
     memset(&msg, 0, sizeof(msg));
     
     if (parse_snmp_message(payload, payload_len, &msg)) {
-        printf("Version: %s\n", get_snmp_version_name(msg.version));
+        dissect_field(ctx, "Version", NULL, 0, "%s", get_snmp_version_name(msg.version));
         
         if (msg.version != SNMP_VERSION_3) {
-            printf("Community: %s\n", msg.community);
+            dissect_field(ctx, "Community", NULL, 0, "%s", msg.community);
         }
         
-        printf("PDU Type: %s\n", get_snmp_pdu_type_name(msg.pdu_type));
-        printf("Request ID: %u\n", msg.request_id);
+        dissect_field(ctx, "PDU Type", NULL, 0, "%s", get_snmp_pdu_type_name(msg.pdu_type));
+        dissect_field(ctx, "Request ID", NULL, 0, "%u", msg.request_id);
         
         if (msg.error_status != SNMP_ERROR_NO_ERROR) {
-            printf("Error Status: %s (%u)\n", get_snmp_error_name(msg.error_status), msg.error_status);
-            printf("Error Index: %u\n", msg.error_index);
+            dissect_field(ctx, "Error Status", NULL, 0, "%s (%u)", get_snmp_error_name(msg.error_status), msg.error_status);
+            dissect_field(ctx, "Error Index", NULL, 0, "%u", msg.error_index);
         } else {
-            printf("Error Status: No Error\n");
+            dissect_field(ctx, "Error Status", NULL, 0, "No Error");
         }
         
-        printf("Variable Bindings: %d\n", msg.varbind_count);
+        dissect_field(ctx, "Variable Bindings", NULL, 0, "%d", msg.varbind_count);
         
         // Security analysis
-        analyze_snmp_security(&msg);
+        analyze_snmp_security(ctx, &msg);
     } else {
-        printf("Status: Failed to parse SNMP message\n");
-        printf("Raw Data: ");
-        for (int i = 0; i < (payload_len < 32 ? payload_len : 32); i++) {
-            printf("%02x ", payload[i]);
-        }
-        if (payload_len > 32) printf("...");
-        printf("\n");
+        int raw_len = payload_len < 32 ? payload_len : 32;
+        dissect_buf_t raw;
+        dissect_buf_init(&raw);
+        dissect_buf_hex(&raw, payload, raw_len);
+        if (payload_len > 32) dissect_buf_printf(&raw, "...");
+        dissect_field(ctx, "Status", NULL, 0, "Failed to parse SNMP message");
+        dissect_field(ctx, "Raw Data", payload, raw_len, "%s", raw.text);
     }
 
-    printf("===================\n");
+    dissect_end(ctx);
 }
 
 // Parse complete SNMP message
@@ -241,9 +247,9 @@ int parse_snmp_pdu(const u_char *data, int len, snmp_message_t *msg) {
         msg->varbind_count = 0;
         // Count variable bindings (simplified)
         const u_char *vb_ptr = ptr + 2;
-        int vb_remaining = ptr[1];
+        int vb_remaining = ptr[1] < remaining - 2 ? ptr[1] : remaining - 2;
         
-        while (vb_remaining > 0 && msg->varbind_count < 10) {
+        while (vb_remaining >= 2 && msg->varbind_count < 10) {
             if (vb_ptr[0] == ASN1_SEQUENCE) {
                 msg->varbind_count++;
                 int vb_len = vb_ptr[1];
@@ -343,41 +349,43 @@ const char* resolve_oid_name(const char *oid) {
 }
 
 // Analyze SNMP security
-void analyze_snmp_security(const snmp_message_t *msg) {
-    printf("Security Analysis:\n");
+void analyze_snmp_security(dissect_ctx_t *ctx, const snmp_message_t *msg) {
+    dissect_begin(ctx, "Security Analysis", NULL, 0);
     
     switch (msg->version) {
         case SNMP_VERSION_1:
-            printf("  ⚠ SNMPv1 - No encryption, plaintext community\n");
+            dissect_note(ctx, NULL, 0, "⚠ SNMPv1 - No encryption, plaintext community");
             if (strcmp(msg->community, "public") == 0) {
-                printf("  ⚠ Using default 'public' community - SECURITY RISK\n");
+                dissect_note(ctx, NULL, 0, "⚠ Using default 'public' community - SECURITY RISK");
             } else if (strcmp(msg->community, "private") == 0) {
-                printf("  ⚠ Using default 'private' community - SECURITY RISK\n");
+                dissect_note(ctx, NULL, 0, "⚠ Using default 'private' community - SECURITY RISK");
             }
             break;
             
         case SNMP_VERSION_2C:
-            printf("  ⚠ SNMPv2c - No encryption, plaintext community\n");
+            dissect_note(ctx, NULL, 0, "⚠ SNMPv2c - No encryption, plaintext community");
             if (strcmp(msg->community, "public") == 0) {
-                printf("  ⚠ Using default 'public' community - SECURITY RISK\n");
+                dissect_note(ctx, NULL, 0, "⚠ Using default 'public' community - SECURITY RISK");
             } else if (strcmp(msg->community, "private") == 0) {
-                printf("  ⚠ Using default 'private' community - SECURITY RISK\n");
+                dissect_note(ctx, NULL, 0, "⚠ Using default 'private' community - SECURITY RISK");
             }
             break;
             
         case SNMP_VERSION_3:
-            printf("  ✓ SNMPv3 - Supports authentication and encryption\n");
+            dissect_note(ctx, NULL, 0, "✓ SNMPv3 - Supports authentication and encryption");
             break;
             
         default:
-            printf("  ⚠ Unknown SNMP version\n");
+            dissect_note(ctx, NULL, 0, "⚠ Unknown SNMP version");
             break;
     }
     
     // Check for write operations
     if (msg->pdu_type == SNMP_PDU_SET_REQUEST) {
-        printf("  ⚠ SET operation detected - potential configuration change\n");
+        dissect_note(ctx, NULL, 0, "⚠ SET operation detected - potential configuration change");
     }
+
+    dissect_end(ctx);
 }
 
 // Check if traffic is SNMP
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <pcap.h>  // for u_char
+#include "../dissect.h"
 
 // SNMP Protocol Constants
 #define SNMP_PORT 161
@@ -85,6 +86,7 @@ typedef struct {
 
 // Function declarations
 void parse_snmp(const u_char *payload, int payload_len, int src_port, int dst_port);
+void dissect_snmp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
 int parse_snmp_message(const u_char *data, int len, snmp_message_t *msg);
 int parse_asn1_length(const u_char *data, int len, int *length_bytes);
 int parse_asn1_integer(const u_char *data, int len, int32_t *value);
@@ -97,7 +99,7 @@ const char* get_snmp_pdu_type_name(uint8_t pdu_type);
 const char* get_snmp_error_name(uint32_t error_code);
 const char* get_asn1_type_name(uint8_t type);
 const char* resolve_oid_name(const char *oid);
-void analyze_snmp_security(const snmp_message_t *msg);
+void analyze_snmp_security(dissect_ctx_t *ctx, const snmp_message_t *msg);
 int is_snmp_traffic(int src_port, int dst_port);
 
 #endif // SNMP_H
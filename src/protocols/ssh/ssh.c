@@ -1,35 +1,38 @@
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include <arpa/inet.h>
 #include "ssh.h"
 
-// Global connection tracking (simplified for demo)
-static ssh_connection_t ssh_connections[100] __attribute__((unused));
-static int connection_count __attribute__((unused)) = 0;
-
 // Main SSH parser function
 void parse_ssh(const u_char *payload, int payload_len, int src_port, int dst_port) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_ssh(&ctx, payload, payload_len, src_port, dst_port);
+}
+
+void dissect_ssh(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     if (src_port != SSH_PORT && dst_port != SSH_PORT) return;
     if (payload_len < 4) return;
 
-    printf("=== SSH Packet ===\n");
-    printf("Ports: %d -> %d\n", src_port, dst_port);
-    printf("Length: %d bytes\n", payload_len);
+    dissect_begin(ctx, "SSH Packet", payload, payload_len);
+    dissect_field(ctx, "Ports", NULL, 0, "%d -> %d", src_port, dst_port);
+    dissect_field(ctx, "Length", payload, payload_len, "%d bytes", payload_len);
 
     // Check if this is version exchange (plaintext)
     if (payload_len > 4 && memcmp(payload, "SSH-", 4) == 0) {
-        parse_ssh_version_exchange(payload, payload_len, src_port, dst_port);
+        parse_ssh_version_exchange(ctx, payload, payload_len, src_port, dst_port);
     } else if (payload_len >= SSH_PACKET_MIN_SIZE) {
         // Binary SSH packet (encrypted or key exchange)
-        parse_ssh_binary_packet(payload, payload_len, src_port, dst_port);
+        parse_ssh_binary_packet(ctx, payload, payload_len, src_port, dst_port);
     }
 
-    printf("==================\n");
+    dissect_end(ctx);
 }
 
 // Parse SSH version exchange
-void parse_ssh_version_exchange(const u_char *payload, int payload_len, int src_port, int dst_port) {
+void parse_ssh_version_exchange(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     (void)dst_port; // Suppress unused parameter warning
     char version_string[SSH_VERSION_EXCHANGE_MAX + 1];
     int copy_len = (payload_len < SSH_VERSION_EXCHANGE_MAX) ? payload_len : SSH_VERSION_EXCHANGE_MAX;
@@ -47,37 +50,37 @@ void parse_ssh_version_exchange(const u_char *payload, int payload_len, int src_
     memcpy(version_string, payload, line_end);
     version_string[line_end] = '\0';
 
-    printf("Type: Version Exchange\n");
-    printf("Direction: %s\n", (src_port == SSH_PORT) ? "Server -> Client" : "Client -> Server");
-    printf("Version String: %s\n", version_string);
+    dissect_field(ctx, "Type", NULL, 0, "Version Exchange");
+    dissect_field(ctx, "Direction", NULL, 0, "%s", (src_port == SSH_PORT) ? "Server -> Client" : "Client -> Server");
+    dissect_field(ctx, "Version String", payload, line_end, "%s", version_string);
 
     // Parse version components
     if (strncmp(version_string, "SSH-2.0-", 8) == 0) {
-        printf("Protocol Version: 2.0\n");
-        printf("Software: %s\n", version_string + 8);
+        dissect_field(ctx, "Protocol Version", payload, 8, "2.0");
+        dissect_field(ctx, "Software", payload + 8, line_end - 8, "%s", version_string + 8);
     } else if (strncmp(version_string, "SSH-1.99-", 9) == 0) {
-        printf("Protocol Version: 1.99 (compatible with 2.0)\n");
-        printf("Software: %s\n", version_string + 9);
+        dissect_field(ctx, "Protocol Version", payload, 9, "1.99 (compatible with 2.0)");
+        dissect_field(ctx, "Software", payload + 9, line_end - 9, "%s", version_string + 9);
     } else if (strncmp(version_string, "SSH-1.5-", 8) == 0) {
-        printf("Protocol Version: 1.5 (deprecated)\n");
-        printf("Software: %s\n", version_string + 8);
-        printf("WARNING: SSH 1.5 has known security vulnerabilities\n");
+        dissect_field(ctx, "Protocol Version", payload, 8, "1.5 (deprecated)");
+        dissect_field(ctx, "Software", payload + 8, line_end - 8, "%s", version_string + 8);
+        dissect_note(ctx, payload, 8, "WARNING: SSH 1.5 has known security vulnerabilities");
     }
 
     // Detect common SSH implementations
     if (strstr(version_string, "OpenSSH")) {
-        printf("Implementation: OpenSSH\n");
+        dissect_field(ctx, "Implementation", NULL, 0, "OpenSSH");
     } else if (strstr(version_string, "libssh")) {
-        printf("Implementation: libssh\n");
+        dissect_field(ctx, "Implementation", NULL, 0, "libssh");
     } else if (strstr(version_string, "PuTTY")) {
-        printf("Implementation: PuTTY\n");
+        dissect_field(ctx, "Implementation", NULL, 0, "PuTTY");
     } else if (strstr(version_string, "Cisco")) {
-        printf("Implementation: Cisco SSH\n");
+        dissect_field(ctx, "Implementation", NULL, 0, "Cisco SSH");
     }
 }
 
 // Parse SSH binary packet
-void parse_ssh_binary_packet(const u_char *payload, int payload_len, int src_port, int dst_port) {
+void parse_ssh_binary_packet(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port) {
     (void)dst_port; // Suppress unused parameter warning
     // SSH binary packet format:
     // uint32 packet_length
@@ -90,50 +93,50 @@ void parse_ssh_binary_packet(const u_char *payload, int payload_len, int src_por
     uint32_t packet_length = ntohl(*(uint32_t*)payload);
     uint8_t padding_length = payload[4];
 
-    printf("Type: Binary Packet\n");
-    printf("Direction: %s\n", (src_port == SSH_PORT) ? "Server -> Client" : "Client -> Server");
-    printf("Packet Length: %u\n", packet_length);
-    printf("Padding Length: %u\n", padding_length);
+    dissect_field(ctx, "Type", NULL, 0, "Binary Packet");
+    dissect_field(ctx, "Direction", NULL, 0, "%s", (src_port == SSH_PORT) ? "Server -> Client" : "Client -> Server");
+    dissect_field(ctx, "Packet Length", payload, 4, "%u", packet_length);
+    dissect_field(ctx, "Padding Length", payload + 4, 1, "%u", padding_length);
 
     // Calculate payload length
     int ssh_payload_len = packet_length - padding_length - 1;
     if (ssh_payload_len <= 0 || ssh_payload_len > payload_len - 5) {
-        printf("Status: Encrypted/Invalid packet structure\n");
+        dissect_field(ctx, "Status", NULL, 0, "Encrypted/Invalid packet structure");
         return;
     }
 
     // Get message type (first byte of payload)
     uint8_t msg_type = payload[5];
-    printf("Message Type: %u (%s)\n", msg_type, get_ssh_message_type_name(msg_type));
+    dissect_field(ctx, "Message Type", payload + 5, 1, "%u (%s)", msg_type, get_ssh_message_type_name(msg_type));
 
     // Parse specific message types
     switch (msg_type) {
         case SSH_MSG_KEXINIT:
-            parse_ssh_kexinit(payload + 5, ssh_payload_len);
+            parse_ssh_kexinit(ctx, payload + 5, ssh_payload_len);
             break;
         case SSH_MSG_USERAUTH_REQUEST:
         case SSH_MSG_USERAUTH_FAILURE:
         case SSH_MSG_USERAUTH_SUCCESS:
-            parse_ssh_userauth(payload + 5, ssh_payload_len, msg_type);
+            parse_ssh_userauth(ctx, payload + 5, ssh_payload_len, msg_type);
             break;
         case SSH_MSG_CHANNEL_DATA:
         case SSH_MSG_CHANNEL_EXTENDED_DATA:
-            parse_ssh_channel_data(payload + 5, ssh_payload_len);
+            parse_ssh_channel_data(ctx, payload + 5, ssh_payload_len);
             break;
         case SSH_MSG_DISCONNECT:
             if (ssh_payload_len >= 5) {
                 uint32_t reason = ntohl(*(uint32_t*)(payload + 6));
-                printf("Disconnect Reason: %u (%s)\n", reason, get_ssh_disconnect_reason(reason));
+                dissect_field(ctx, "Disconnect Reason", payload + 6, 4, "%u (%s)", reason, get_ssh_disconnect_reason(reason));
             }
             break;
     }
 }
 
 // Parse SSH KEXINIT message
-void parse_ssh_kexinit(const u_char *payload, int payload_len) {
+void parse_ssh_kexinit(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
     if (payload_len < 17) return; // Minimum KEXINIT size
 
-    printf("Key Exchange Initialization:\n");
+    dissect_begin(ctx, "Key Exchange Initialization", payload, payload_len);
     
     // Skip message type (1 byte) and random bytes (16 bytes)
     const u_char *data = payload + 17;
@@ -152,75 +155,63 @@ void parse_ssh_kexinit(const u_char *payload, int payload_len) {
         remaining -= 4;
 
         if (list_len > 0 && list_len <= (uint32_t)remaining) {
-            print_ssh_algorithms(data, list_len, algorithm_types[i]);
+            print_ssh_algorithms(ctx, data, list_len, algorithm_types[i]);
             data += list_len;
             remaining -= list_len;
         }
     }
+
+    dissect_end(ctx);
+}
+
+// Copies an SSH string of at most max_len bytes; 0 if it does not fit
+static int read_ssh_string(const u_char **data, int *remaining, char *out, uint32_t max_len, const u_char **value_at) {
+    if (*remaining < 4) return 0;
+    uint32_t len = ntohl(*(uint32_t*)*data);
+    *data += 4;
+    *remaining -= 4;
+
+    if (len == 0 || len > (uint32_t)*remaining || len >= max_len) return 0;
+    memcpy(out, *data, len);
+    out[len] = '\0';
+    *value_at = *data;
+    *data += len;
+    *remaining -= len;
+    return (int)len;
 }
 
 // Parse SSH authentication messages
-void parse_ssh_userauth(const u_char *payload, int payload_len, uint8_t msg_type) {
+void parse_ssh_userauth(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint8_t msg_type) {
     if (payload_len < 2) return;
 
     switch (msg_type) {
         case SSH_MSG_USERAUTH_REQUEST:
-            printf("Authentication Request:\n");
+            dissect_begin(ctx, "Authentication Request", payload, payload_len);
             // Parse username, service, method
             if (payload_len > 5) {
                 const u_char *data = payload + 1;
                 int remaining = payload_len - 1;
-                
-                // Username length and value
-                if (remaining >= 4) {
-                    uint32_t username_len = ntohl(*(uint32_t*)data);
-                    data += 4;
-                    remaining -= 4;
-                    
-                    if (username_len > 0 && username_len <= (uint32_t)remaining && username_len < 64) {
-                        char username[65];
-                        memcpy(username, data, username_len);
-                        username[username_len] = '\0';
-                        printf("  Username: %s\n", username);
-                        data += username_len;
-                        remaining -= username_len;
-                    }
+                const u_char *at;
+                char username[65];
+                char service[33];
+                char method[33];
+                int n;
+
+                if ((n = read_ssh_string(&data, &remaining, username, 64, &at)) > 0) {
+                    dissect_field(ctx, "Username", at, n, "%s", username);
                 }
-                
-                // Service name
-                if (remaining >= 4) {
-                    uint32_t service_len = ntohl(*(uint32_t*)data);
-                    data += 4;
-                    remaining -= 4;
-                    
-                    if (service_len > 0 && service_len <= (uint32_t)remaining && service_len < 32) {
-                        char service[33];
-                        memcpy(service, data, service_len);
-                        service[service_len] = '\0';
-                        printf("  Service: %s\n", service);
-                        data += service_len;
-                        remaining -= service_len;
-                    }
+                if ((n = read_ssh_string(&data, &remaining, service, 32, &at)) > 0) {
+                    dissect_field(ctx, "Service", at, n, "%s", service);
                 }
-                
-                // Authentication method
-                if (remaining >= 4) {
-                    uint32_t method_len = ntohl(*(uint32_t*)data);
-                    data += 4;
-                    remaining -= 4;
-                    
-                    if (method_len > 0 && method_len <= (uint32_t)remaining && method_len < 32) {
-                        char method[33];
-                        memcpy(method, data, method_len);
-                        method[method_len] = '\0';
-                        printf("  Method: %s\n", method);
-                    }
+                if ((n = read_ssh_string(&data, &remaining, method, 32, &at)) > 0) {
+                    dissect_field(ctx, "Method", at, n, "%s", method);
                 }
             }
+            dissect_end(ctx);
             break;
             
         case SSH_MSG_USERAUTH_FAILURE:
-            printf("Authentication Failed\n");
+            dissect_begin(ctx, "Authentication Failed", payload, payload_len);
             if (payload_len > 5) {
                 const u_char *data = payload + 1;
                 uint32_t methods_len = ntohl(*(uint32_t*)data);
@@ -229,42 +220,39 @@ void parse_ssh_userauth(const u_char *payload, int payload_len, uint8_t msg_type
                     int copy_len = (methods_len < 255) ? methods_len : 255;
                     memcpy(methods, data + 4, copy_len);
                     methods[copy_len] = '\0';
-                    printf("  Available Methods: %s\n", methods);
+                    dissect_field(ctx, "Available Methods", data + 4, copy_len, "%s", methods);
                 }
             }
+            dissect_end(ctx);
             break;
             
         case SSH_MSG_USERAUTH_SUCCESS:
-            printf("Authentication Successful\n");
+            dissect_note(ctx, payload, 1, "Authentication Successful");
             break;
     }
 }
 
 // Parse SSH channel data
-void parse_ssh_channel_data(const u_char *payload, int payload_len) {
+void parse_ssh_channel_data(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
     if (payload_len < 9) return;
 
     uint32_t channel = ntohl(*(uint32_t*)(payload + 1));
     uint32_t data_len = ntohl(*(uint32_t*)(payload + 5));
 
-    printf("Channel Data:\n");
-    printf("  Channel: %u\n", channel);
-    printf("  Data Length: %u bytes\n", data_len);
+    dissect_begin(ctx, "Channel Data", payload, payload_len);
+    dissect_field(ctx, "Channel", payload + 1, 4, "%u", channel);
+    dissect_field(ctx, "Data Length", payload + 5, 4, "%u bytes", data_len);
 
     if (data_len > 0 && data_len <= (uint32_t)(payload_len - 9)) {
-        printf("  Data Preview: ");
         int preview_len = (data_len < 32) ? data_len : 32;
-        for (int i = 0; i < preview_len; i++) {
-            char c = payload[9 + i];
-            if (c >= 32 && c <= 126) {
-                printf("%c", c);
-            } else {
-                printf(".");
-            }
-        }
-        if (data_len > 32) printf("...");
-        printf("\n");
+        dissect_buf_t preview;
+        dissect_buf_init(&preview);
+        dissect_buf_ascii(&preview, payload + 9, preview_len);
+        if (data_len > 32) dissect_buf_printf(&preview, "...");
+        dissect_field(ctx, "Data Preview", payload + 9, data_len, "%s", preview.text);
     }
+
+    dissect_end(ctx);
 }
 
 // Get SSH message type name
@@ -325,7 +313,7 @@ const char* get_ssh_disconnect_reason(uint32_t reason_code) {
 }
 
 // Print SSH algorithm lists
-void print_ssh_algorithms(const u_char *data, int len, const char *type) {
+void print_ssh_algorithms(dissect_ctx_t *ctx, const u_char *data, int len, const char *type) {
     if (len <= 0) return;
     
     char algorithms[512];
@@ -333,7 +321,7 @@ void print_ssh_algorithms(const u_char *data, int len, const char *type) {
     memcpy(algorithms, data, copy_len);
     algorithms[copy_len] = '\0';
     
-    printf("  %s: %s\n", type, algorithms);
+    dissect_field(ctx, type, data, len, "%s", algorithms);
 }
 
 // Redact sensitive SSH data
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <pcap.h>  // for u_char
+#include "../dissect.h"
 
 // SSH Protocol Constants
 #define SSH_PORT 22
@@ -65,14 +66,15 @@ typedef struct {
 
 // Function declarations
 void parse_ssh(const u_char *payload, int payload_len, int src_port, int dst_port);
-void parse_ssh_version_exchange(const u_char *payload, int payload_len, int src_port, int dst_port);
-void parse_ssh_binary_packet(const u_char *payload, int payload_len, int src_port, int dst_port);
-void parse_ssh_kexinit(const u_char *payload, int payload_len);
-void parse_ssh_userauth(const u_char *payload, int payload_len, uint8_t msg_type);
-void parse_ssh_channel_data(const u_char *payload, int payload_len);
+void dissect_ssh(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
+void parse_ssh_version_exchange(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
+void parse_ssh_binary_packet(dissect_ctx_t *ctx, const u_char *payload, int payload_len, int src_port, int dst_port);
+void parse_ssh_kexinit(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
+void parse_ssh_userauth(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint8_t msg_type);
+void parse_ssh_channel_data(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
 const char* get_ssh_message_type_name(uint8_t msg_type);
 const char* get_ssh_disconnect_reason(uint32_t reason_code);
-void print_ssh_algorithms(const u_char *data, int len, const char *type);
+void print_ssh_algorithms(dissect_ctx_t *ctx, const u_char *data, int len, const char *type);
 void redact_sensitive_ssh_data(char *data, int len);
 
 #endif // SSH_H
\ No newline at end of file
@@ -4,10 +4,8 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include "tcp.h"
-
-// Global connection tracking (simplified for demo)
-static tcp_connection_t tcp_connections[100] __attribute__((unused));
-static int connection_count __attribute__((unused)) = 0;
+#include "../dissect_state.h"
+#include "../app_heuristics.h"
 
 // Main TCP parser function
 void parse_tcp(const u_char *payload, int payload_len) {
@@ -16,10 +14,17 @@ void parse_tcp(const u_char *payload, int payload_len) {
 
 // TCP parser with IP context
 void parse_tcp_with_context(const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_tcp(&ctx, payload, payload_len, src_ip, dst_ip, 0);
+}
+
+void dissect_tcp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip,
+                 uint64_t flow_key) {
     if (payload_len < TCP_MIN_HEADER_SIZE) {
-        printf("=== TCP Segment ===\n");
-        printf("Error: Packet too short (%d bytes, minimum %d)\n", payload_len, TCP_MIN_HEADER_SIZE);
-        printf("===================\n");
+        dissect_begin(ctx, "TCP Segment", payload, payload_len);
+        dissect_field(ctx, "Error", payload, payload_len, "Packet too short (%d bytes, minimum %d)", payload_len, TCP_MIN_HEADER_SIZE);
+        dissect_end(ctx);
         return;
     }
 
@@ -27,92 +32,102 @@ void parse_tcp_with_context(const u_char *payload, int payload_len, uint32_t src
     int header_len = tcp_hdr->doff * 4;
     
     if (header_len < TCP_MIN_HEADER_SIZE || header_len > payload_len) {
-        printf("=== TCP Segment ===\n");
-        printf("Error: Invalid header length (%d bytes)\n", header_len);
-        printf("===================\n");
+        dissect_begin(ctx, "TCP Segment", payload, payload_len);
+        dissect_field(ctx, "Error", payload + 12, 1, "Invalid header length (%d bytes)", header_len);
+        dissect_end(ctx);
         return;
     }
 
-    printf("=== TCP Segment ===\n");
+    dissect_begin(ctx, "TCP Segment", payload, payload_len);
     
     // Basic header information
     uint16_t src_port = ntohs(tcp_hdr->source);
     uint16_t dst_port = ntohs(tcp_hdr->dest);
     
-    printf("Ports: %u -> %u\n", src_port, dst_port);
+    dissect_field(ctx, "Ports", payload, 4, "%u -> %u", src_port, dst_port);
     
     if (src_ip && dst_ip) {
-        struct in_addr src_addr = {src_ip};
-        struct in_addr dst_addr = {dst_ip};
-        printf("Addresses: %s:%u -> %s:%u\n", 
-               inet_ntoa(src_addr), src_port,
-               inet_ntoa(dst_addr), dst_port);
-    }
-    
-    // Detect application protocol
-    const char* app_protocol = detect_application_protocol(src_port, dst_port, 
-                                                          payload + header_len, 
-                                                          payload_len - header_len);
+        char src_text[INET_ADDRSTRLEN];
+        char dst_text[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &src_ip, src_text, sizeof(src_text));
+        inet_ntop(AF_INET, &dst_ip, dst_text, sizeof(dst_text));
+        dissect_field(ctx, "Addresses", NULL, 0, "%s:%u -> %s:%u", src_text, src_port, dst_text, dst_port);
+    }
+    
+    // Detect application protocol; the flow's cached verdict keeps this in
+    // line with the application layer below it
+    int app_len = payload_len - header_len;
+    if (flow_key == 0) {
+        flow_key = app_flow_key(IPPROTO_TCP, &src_ip, &dst_ip, sizeof(src_ip), src_port, dst_port);
+    }
+    const char* app_protocol = port_registry_app_name(
+        app_flow_classify(app_flow_shared_cache(), flow_key, IPPROTO_TCP, src_port, dst_port,
+                          payload + header_len, app_len > 0 ? (size_t)app_len : 0));
     if (app_protocol) {
-        printf("Application Protocol: %s\n", app_protocol);
+        dissect_field(ctx, "Application Protocol", NULL, 0, "%s", app_protocol);
     }
     
     // Parse TCP header
-    parse_tcp_header(tcp_hdr, header_len);
+    parse_tcp_header(ctx, tcp_hdr, header_len);
     
     // Parse TCP options if present
     if (header_len > TCP_MIN_HEADER_SIZE) {
-        parse_tcp_options(payload + TCP_MIN_HEADER_SIZE, header_len - TCP_MIN_HEADER_SIZE);
+        parse_tcp_options(ctx, payload + TCP_MIN_HEADER_SIZE, header_len - TCP_MIN_HEADER_SIZE);
     }
     
     // Analyze flags
-    analyze_tcp_flags(tcp_hdr->th_flags);
+    analyze_tcp_flags(ctx, tcp_hdr->th_flags);
     
     // Performance analysis
-    analyze_tcp_performance(tcp_hdr, payload_len - header_len);
+    analyze_tcp_performance(ctx, tcp_hdr, payload_len - header_len);
     
     // Security analysis
-    analyze_tcp_security(tcp_hdr, src_port, dst_port);
+    analyze_tcp_security(ctx, tcp_hdr, src_port, dst_port);
     
     // Parse payload if present
     int payload_data_len = payload_len - header_len;
     if (payload_data_len > 0) {
-        parse_tcp_payload(payload + header_len, payload_data_len, src_port, dst_port);
+        parse_tcp_payload(ctx, payload + header_len, payload_data_len, src_port, dst_port);
     }
     
-    printf("===================\n");
+    dissect_end(ctx);
 }
 
 // Parse TCP header details
-void parse_tcp_header(const struct tcphdr *tcp_hdr, int header_len) {
-    printf("TCP Header:\n");
-    printf("  Sequence Number: %u (0x%08x)\n", ntohl(tcp_hdr->seq), ntohl(tcp_hdr->seq));
-    printf("  Acknowledgment Number: %u (0x%08x)\n", ntohl(tcp_hdr->ack_seq), ntohl(tcp_hdr->ack_seq));
-    printf("  Header Length: %d bytes (%d words)\n", header_len, tcp_hdr->doff);
-    printf("  Flags: %s (0x%02x)\n", get_tcp_flag_string(tcp_hdr->th_flags), tcp_hdr->th_flags);
-    printf("  Window Size: %u bytes\n", ntohs(tcp_hdr->window));
-    printf("  Checksum: 0x%04x\n", ntohs(tcp_hdr->check));
+void parse_tcp_header(dissect_ctx_t *ctx, const struct tcphdr *tcp_hdr, int header_len) {
+    const u_char *raw = (const u_char *)tcp_hdr;
+    dissect_begin(ctx, "TCP Header", raw, header_len);
+    dissect_field(ctx, "Sequence Number", raw + 4, 4, "%u (0x%08x)", ntohl(tcp_hdr->seq), ntohl(tcp_hdr->seq));
+    dissect_field(ctx, "Acknowledgment Number", raw + 8, 4, "%u (0x%08x)", ntohl(tcp_hdr->ack_seq), ntohl(tcp_hdr->ack_seq));
+    dissect_field(ctx, "Header Length", raw + 12, 1, "%d bytes (%d words)", header_len, tcp_hdr->doff);
+    char flag_str[TCP_FLAG_STR_LEN];
+    dissect_field(ctx, "Flags", raw + 13, 1, "%s (0x%02x)", get_tcp_flag_string(tcp_hdr->th_flags, flag_str), tcp_hdr->th_flags);
+    dissect_field(ctx, "Window Size", raw + 14, 2, "%u bytes", ntohs(tcp_hdr->window));
+    dissect_field(ctx, "Checksum", raw + 16, 2, "0x%04x", ntohs(tcp_hdr->check));
     
     if (tcp_hdr->urg) {
-        printf("  Urgent Pointer: %u\n", ntohs(tcp_hdr->urg_ptr));
+        dissect_field(ctx, "Urgent Pointer", raw + 18, 2, "%u", ntohs(tcp_hdr->urg_ptr));
     }
+    dissect_end(ctx);
 }
 
 // Parse TCP options
-void parse_tcp_options(const u_char *options, int options_len) {
-    printf("TCP Options (%d bytes):\n", options_len);
+void parse_tcp_options(dissect_ctx_t *ctx, const u_char *options, int options_len) {
+    char title[32];
+    snprintf(title, sizeof(title), "TCP Options (%d bytes)", options_len);
+    dissect_begin(ctx, title, options, options_len);
     
     int i = 0;
     while (i < options_len) {
         uint8_t kind = options[i];
         
         if (kind == TCP_OPT_EOL) {
-            printf("  End of Option List\n");
+            dissect_note(ctx, options + i, 1, "End of Option List");
             break;
         }
         
         if (kind == TCP_OPT_NOP) {
-            printf("  No Operation\n");
+            dissect_note(ctx, options + i, 1, "No Operation");
             i++;
             continue;
         }
@@ -121,61 +136,64 @@ void parse_tcp_options(const u_char *options, int options_len) {
         
         uint8_t length = options[i + 1];
         if (length < 2 || i + length > options_len) {
-            printf("  Invalid option length\n");
+            dissect_note(ctx, options + i, options_len - i, "Invalid option length");
             break;
         }
         
-        printf("  %s: ", get_tcp_option_name(kind));
+        const char *name = get_tcp_option_name(kind);
+        const u_char *option = options + i;
         
         switch (kind) {
             case TCP_OPT_MSS:
                 if (length == 4) {
-                    uint16_t mss = ntohs(*(uint16_t*)(options + i + 2));
-                    printf("MSS = %u bytes\n", mss);
+                    uint16_t mss = ntohs(*(uint16_t*)(option + 2));
+                    dissect_field(ctx, name, option, length, "MSS = %u bytes", mss);
                 } else {
-                    printf("Invalid MSS option\n");
+                    dissect_field(ctx, name, option, length, "Invalid MSS option");
                 }
                 break;
                 
             case TCP_OPT_WINDOW_SCALE:
                 if (length == 3) {
-                    uint8_t scale = options[i + 2];
-                    printf("Window Scale = %u (multiplier: %u)\n", scale, 1 << scale);
+                    uint8_t scale = option[2];
+                    dissect_field(ctx, name, option, length, "Window Scale = %u (multiplier: %u)", scale, 1u << scale);
                 } else {
-                    printf("Invalid Window Scale option\n");
+                    dissect_field(ctx, name, option, length, "Invalid Window Scale option");
                 }
                 break;
                 
             case TCP_OPT_SACK_PERMITTED:
-                printf("SACK Permitted\n");
+                dissect_field(ctx, name, option, length, "SACK Permitted");
                 break;
                 
             case TCP_OPT_TIMESTAMP:
                 if (length == 10) {
-                    uint32_t ts_val = ntohl(*(uint32_t*)(options + i + 2));
-                    uint32_t ts_ecr = ntohl(*(uint32_t*)(options + i + 6));
-                    printf("TSval = %u, TSecr = %u\n", ts_val, ts_ecr);
+                    uint32_t ts_val = ntohl(*(uint32_t*)(option + 2));
+                    uint32_t ts_ecr = ntohl(*(uint32_t*)(option + 6));
+                    dissect_field(ctx, name, option, length, "TSval = %u, TSecr = %u", ts_val, ts_ecr);
                 } else {
-                    printf("Invalid Timestamp option\n");
+                    dissect_field(ctx, name, option, length, "Invalid Timestamp option");
                 }
                 break;
                 
             default:
-                printf("Unknown option (kind=%u, length=%u)\n", kind, length);
+                dissect_field(ctx, name, option, length, "Unknown option (kind=%u, length=%u)", kind, length);
                 break;
         }
         
         i += length;
     }
+    dissect_end(ctx);
 }
 
 // Parse TCP payload
-void parse_tcp_payload(const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port) {
-    printf("Payload: %d bytes\n", payload_len);
+void parse_tcp_payload(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port) {
+    dissect_field(ctx, "Payload", payload, payload_len, "%d bytes", payload_len);
     
     if (payload_len > 0) {
-        printf("  Data Preview: ");
         int preview_len = (payload_len < 32) ? payload_len : 32;
+        dissect_buf_t preview;
+        dissect_buf_init(&preview);
         
         // Try to show printable characters
         int printable_count = 0;
@@ -187,153 +205,146 @@ void parse_tcp_payload(const u_char *payload, int payload_len, uint16_t src_port
         
         if (printable_count > preview_len / 2) {
             // Mostly printable - show as text
-            for (int i = 0; i < preview_len; i++) {
-                char c = payload[i];
-                if (c >= 32 && c <= 126) {
-                    printf("%c", c);
-                } else {
-                    printf(".");
-                }
-            }
+            dissect_buf_ascii(&preview, payload, preview_len);
         } else {
             // Mostly binary - show as hex
-            for (int i = 0; i < preview_len; i++) {
-                printf("%02x ", payload[i]);
-            }
+            dissect_buf_hex(&preview, payload, preview_len);
         }
         
-        if (payload_len > 32) printf("...");
-        printf("\n");
+        if (payload_len > 32) dissect_buf_printf(&preview, "...");
+        dissect_field(ctx, "Data Preview", payload, preview_len, "%s", preview.text);
         
         // Protocol-specific analysis
         if (src_port == 80 || dst_port == 80) {
             if (strncmp((char*)payload, "GET ", 4) == 0 || 
                 strncmp((char*)payload, "POST ", 5) == 0 ||
                 strncmp((char*)payload, "HTTP/", 5) == 0) {
-                printf("  HTTP Traffic Detected\n");
+                dissect_note(ctx, NULL, 0, "HTTP Traffic Detected");
             }
         } else if (src_port == 443 || dst_port == 443) {
             if (payload[0] == 0x16 && payload[1] == 0x03) {
-                printf("  TLS/SSL Handshake Detected\n");
+                dissect_note(ctx, payload, 2, "TLS/SSL Handshake Detected");
             }
         } else if (src_port == 22 || dst_port == 22) {
             if (strncmp((char*)payload, "SSH-", 4) == 0) {
-                printf("  SSH Protocol Version Exchange\n");
+                dissect_note(ctx, payload, 4, "SSH Protocol Version Exchange");
             }
         }
     }
 }
 
 // Analyze TCP flags
-void analyze_tcp_flags(uint8_t flags) {
-    printf("Flag Analysis:\n");
+void analyze_tcp_flags(dissect_ctx_t *ctx, uint8_t flags) {
+    dissect_begin(ctx, "Flag Analysis", NULL, 0);
     
     if (flags & TCP_FLAG_SYN) {
         if (flags & TCP_FLAG_ACK) {
-            printf("  SYN+ACK: Connection establishment response\n");
+            dissect_field(ctx, "SYN+ACK", NULL, 0, "Connection establishment response");
         } else {
-            printf("  SYN: Connection establishment request\n");
+            dissect_field(ctx, "SYN", NULL, 0, "Connection establishment request");
         }
     }
     
     if (flags & TCP_FLAG_FIN) {
-        printf("  FIN: Connection termination\n");
+        dissect_field(ctx, "FIN", NULL, 0, "Connection termination");
     }
     
     if (flags & TCP_FLAG_RST) {
-        printf("  RST: Connection reset (abrupt termination)\n");
+        dissect_field(ctx, "RST", NULL, 0, "Connection reset (abrupt termination)");
     }
     
     if (flags & TCP_FLAG_PSH) {
-        printf("  PSH: Push data to application immediately\n");
+        dissect_field(ctx, "PSH", NULL, 0, "Push data to application immediately");
     }
     
     if (flags & TCP_FLAG_URG) {
-        printf("  URG: Urgent data present\n");
+        dissect_field(ctx, "URG", NULL, 0, "Urgent data present");
     }
     
     if (flags & TCP_FLAG_ECE) {
-        printf("  ECE: ECN Echo (congestion notification)\n");
+        dissect_field(ctx, "ECE", NULL, 0, "ECN Echo (congestion notification)");
     }
     
     if (flags & TCP_FLAG_CWR) {
-        printf("  CWR: Congestion Window Reduced\n");
+        dissect_field(ctx, "CWR", NULL, 0, "Congestion Window Reduced");
     }
     
     // Determine connection state
     tcp_state_t state = determine_tcp_state(flags, 0);
-    printf("  Connection State: %s\n", get_tcp_state_name(state));
+    dissect_field(ctx, "Connection State", NULL, 0, "%s", get_tcp_state_name(state));
+    dissect_end(ctx);
 }
 
 // Analyze TCP performance
-void analyze_tcp_performance(const struct tcphdr *tcp_hdr, int payload_len) {
-    printf("Performance Analysis:\n");
+void analyze_tcp_performance(dissect_ctx_t *ctx, const struct tcphdr *tcp_hdr, int payload_len) {
+    dissect_begin(ctx, "Performance Analysis", NULL, 0);
     
     uint16_t window = ntohs(tcp_hdr->window);
-    printf("  Window Size: %u bytes", window);
-    
+    const char *window_note = "";
     if (window == 0) {
-        printf(" (ZERO WINDOW - receiver buffer full!)");
+        window_note = " (ZERO WINDOW - receiver buffer full!)";
     } else if (window < 1024) {
-        printf(" (small window - potential performance issue)");
+        window_note = " (small window - potential performance issue)";
     } else if (window >= 65535) {
-        printf(" (maximum window - good performance)");
+        window_note = " (maximum window - good performance)";
     }
-    printf("\n");
+    dissect_field(ctx, "Window Size", (const u_char *)tcp_hdr + 14, 2, "%u bytes%s", window, window_note);
     
     if (payload_len > 0) {
-        printf("  Payload Size: %d bytes", payload_len);
+        const char *size_note = "";
         if (payload_len == 1) {
-            printf(" (possible keep-alive or interactive traffic)");
+            size_note = " (possible keep-alive or interactive traffic)";
         } else if (payload_len >= 1460) {
-            printf(" (full-sized segment - good efficiency)");
+            size_note = " (full-sized segment - good efficiency)";
         }
-        printf("\n");
+        dissect_field(ctx, "Payload Size", NULL, 0, "%d bytes%s", payload_len, size_note);
     }
     
     // Check for potential issues
     if ((tcp_hdr->th_flags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == TCP_FLAG_SYN && payload_len > 0) {
-        printf("  ⚠ Data in SYN packet (unusual)\n");
+        dissect_note(ctx, NULL, 0, "⚠ Data in SYN packet (unusual)");
     }
+    dissect_end(ctx);
 }
 
 // Analyze TCP security
-void analyze_tcp_security(const struct tcphdr *tcp_hdr, uint16_t src_port, uint16_t dst_port) {
-    printf("Security Analysis:\n");
+void analyze_tcp_security(dissect_ctx_t *ctx, const struct tcphdr *tcp_hdr, uint16_t src_port, uint16_t dst_port) {
+    const u_char *raw = (const u_char *)tcp_hdr;
+    dissect_begin(ctx, "Security Analysis", NULL, 0);
     
     // Check for common vulnerable ports
     if (src_port == 23 || dst_port == 23) {
-        printf("  ⚠ Telnet (port 23) - unencrypted protocol\n");
+        dissect_note(ctx, raw, 4, "⚠ Telnet (port 23) - unencrypted protocol");
     } else if (src_port == 21 || dst_port == 21) {
-        printf("  ⚠ FTP (port 21) - unencrypted control channel\n");
+        dissect_note(ctx, raw, 4, "⚠ FTP (port 21) - unencrypted control channel");
     } else if (src_port == 80 || dst_port == 80) {
-        printf("  ⚠ HTTP (port 80) - unencrypted web traffic\n");
+        dissect_note(ctx, raw, 4, "⚠ HTTP (port 80) - unencrypted web traffic");
     } else if (src_port == 443 || dst_port == 443) {
-        printf("  ✓ HTTPS (port 443) - encrypted web traffic\n");
+        dissect_note(ctx, raw, 4, "✓ HTTPS (port 443) - encrypted web traffic");
     } else if (src_port == 22 || dst_port == 22) {
-        printf("  ✓ SSH (port 22) - encrypted remote access\n");
+        dissect_note(ctx, raw, 4, "✓ SSH (port 22) - encrypted remote access");
     }
     
     // Check for suspicious flags
     if (tcp_hdr->th_flags == 0) {
-        printf("  ⚠ NULL scan detected (all flags clear)\n");
+        dissect_note(ctx, raw + 13, 1, "⚠ NULL scan detected (all flags clear)");
     } else if ((tcp_hdr->th_flags & (TCP_FLAG_FIN | TCP_FLAG_URG | TCP_FLAG_PSH)) == 
                (TCP_FLAG_FIN | TCP_FLAG_URG | TCP_FLAG_PSH)) {
-        printf("  ⚠ XMAS scan detected (FIN+URG+PSH flags)\n");
+        dissect_note(ctx, raw + 13, 1, "⚠ XMAS scan detected (FIN+URG+PSH flags)");
     } else if (tcp_hdr->th_flags & TCP_FLAG_RST && tcp_hdr->th_flags & TCP_FLAG_SYN) {
-        printf("  ⚠ Unusual flag combination (RST+SYN)\n");
+        dissect_note(ctx, raw + 13, 1, "⚠ Unusual flag combination (RST+SYN)");
     }
     
     // Check sequence numbers
     uint32_t seq = ntohl(tcp_hdr->seq);
     if (seq == 0 && !(tcp_hdr->th_flags & TCP_FLAG_SYN)) {
-        printf("  ⚠ Zero sequence number without SYN flag\n");
+        dissect_note(ctx, raw + 4, 4, "⚠ Zero sequence number without SYN flag");
     }
+    dissect_end(ctx);
 }
 
 // Get TCP flag string representation
-const char* get_tcp_flag_string(uint8_t flags) {
-    static char flag_str[64];
+const char* get_tcp_flag_string(uint8_t flags, char *flag_str) {
     flag_str[0] = '\0';
     
     if (flags & TCP_FLAG_CWR) strcat(flag_str, "CWR ");
@@ -388,35 +399,13 @@ const char* get_tcp_option_name(uint8_t option_kind) {
 
 // Detect application protocol
 const char* detect_application_protocol(uint16_t src_port, uint16_t dst_port, const u_char *payload, int len) {
-    // Check well-known ports first
-    if (src_port == 80 || dst_port == 80) return "HTTP";
-    if (src_port == 443 || dst_port == 443) return "HTTPS/TLS";
-    if (src_port == 22 || dst_port == 22) return "SSH";
-    if (src_port == 21 || dst_port == 21) return "FTP";
-    if (src_port == 23 || dst_port == 23) return "Telnet";
-    if (src_port == 25 || dst_port == 25) return "SMTP";
-    if (src_port == 53 || dst_port == 53) return "DNS";
-    if (src_port == 110 || dst_port == 110) return "POP3";
-    if (src_port == 143 || dst_port == 143) return "IMAP";
-    if (src_port == 993 || dst_port == 993) return "IMAPS";
-    if (src_port == 995 || dst_port == 995) return "POP3S";
-    
-    // Try to detect by payload content
-    if (len > 4) {
-        if (strncmp((char*)payload, "GET ", 4) == 0 || 
-            strncmp((char*)payload, "POST ", 5) == 0 ||
-            strncmp((char*)payload, "HTTP/", 5) == 0) {
-            return "HTTP";
-        }
-        if (strncmp((char*)payload, "SSH-", 4) == 0) {
-            return "SSH";
-        }
-        if (payload[0] == 0x16 && payload[1] == 0x03) {
-            return "TLS/SSL";
-        }
-    }
+    // Registered ports first, the same map every other classifier uses
+    const char *name = port_registry_app_name(port_registry_classify(IPPROTO_TCP, src_port, dst_port));
+    if (name) return name;
     
-    return NULL;
+    // Then the payload signatures
+    if (len <= 0) return NULL;
+    return port_registry_app_name(app_heuristics_match(IPPROTO_TCP, payload, (size_t)len));
 }
 
 // Determine TCP connection state
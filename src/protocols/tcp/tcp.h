@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <pcap.h>
 #include <netinet/tcp.h>
+#include "../dissect.h"
 
 // TCP Protocol Constants
 #define TCP_MIN_HEADER_SIZE 20
@@ -21,6 +22,9 @@
 #define TCP_FLAG_ECE 0x40
 #define TCP_FLAG_CWR 0x80
 
+// Buffer size for get_tcp_flag_string(): all eight names plus separators
+#define TCP_FLAG_STR_LEN 40
+
 // TCP Options
 #define TCP_OPT_EOL 0
 #define TCP_OPT_NOP 1
@@ -73,13 +77,18 @@ typedef struct {
 // Function declarations
 void parse_tcp(const u_char *payload, int payload_len);
 void parse_tcp_with_context(const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip);
-void parse_tcp_header(const struct tcphdr *tcp_hdr, int header_len);
-void parse_tcp_options(const u_char *options, int options_len);
-void parse_tcp_payload(const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port);
-void analyze_tcp_flags(uint8_t flags);
-void analyze_tcp_performance(const struct tcphdr *tcp_hdr, int payload_len);
-void analyze_tcp_security(const struct tcphdr *tcp_hdr, uint16_t src_port, uint16_t dst_port);
-const char* get_tcp_flag_string(uint8_t flags);
+// src_ip/dst_ip are IPv4 addresses to show, 0 when unknown or IPv6.
+// flow_key is app_flow_key() of the segment's flow, 0 to key it on
+// src_ip/dst_ip.
+void dissect_tcp(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint32_t src_ip, uint32_t dst_ip,
+                 uint64_t flow_key);
+void parse_tcp_header(dissect_ctx_t *ctx, const struct tcphdr *tcp_hdr, int header_len);
+void parse_tcp_options(dissect_ctx_t *ctx, const u_char *options, int options_len);
+void parse_tcp_payload(dissect_ctx_t *ctx, const u_char *payload, int payload_len, uint16_t src_port, uint16_t dst_port);
+void analyze_tcp_flags(dissect_ctx_t *ctx, uint8_t flags);
+void analyze_tcp_performance(dissect_ctx_t *ctx, const struct tcphdr *tcp_hdr, int payload_len);
+void analyze_tcp_security(dissect_ctx_t *ctx, const struct tcphdr *tcp_hdr, uint16_t src_port, uint16_t dst_port);
+const char* get_tcp_flag_string(uint8_t flags, char *flag_str);
 const char* get_tcp_state_name(tcp_state_t state);
 const char* get_tcp_option_name(uint8_t option_kind);
 const char* detect_application_protocol(uint16_t src_port, uint16_t dst_port, const u_char *payload, int len);
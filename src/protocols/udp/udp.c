@@ -4,14 +4,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <time.h>
 #include <sys/types.h>
 #include <netinet/udp.h>
 #include <arpa/inet.h>
 #include "udp.h"
-
-// Global statistics
-static udp_stats_t g_stats = {0};
+#include "../dissect_state.h"
 
 // Well-known port mappings
 typedef struct {
@@ -45,28 +42,25 @@ int is_printable_data(const u_char *data, int len) {
     return (printable_count * 100 / (len > 100 ? 100 : len)) > 70;
 }
 
-void print_hex_dump(const u_char *data, int len, int max_bytes) {
+void print_hex_dump(dissect_ctx_t *ctx, const u_char *data, int len, int max_bytes) {
     int bytes_to_print = (len > max_bytes) ? max_bytes : len;
-    
-    printf("Data (hex): ");
-    for (int i = 0; i < bytes_to_print; i++) {
-        printf("%02x ", data[i]);
-        if ((i + 1) % 16 == 0) printf("\n            ");
-    }
-    if (len > max_bytes) printf("... (%d more bytes)", len - max_bytes);
-    printf("\n");
+    dissect_buf_t hex;
+    dissect_buf_init(&hex);
+    dissect_buf_hex(&hex, data, bytes_to_print);
+    if (len > max_bytes) dissect_buf_printf(&hex, "... (%d more bytes)", len - max_bytes);
+    dissect_field(ctx, "Data (hex)", data, bytes_to_print, "%s", hex.text);
     
     if (is_printable_data(data, bytes_to_print)) {
-        printf("Data (ascii): ");
-        for (int i = 0; i < bytes_to_print; i++) {
-            printf("%c", isprint(data[i]) ? data[i] : '.');
-        }
-        if (len > max_bytes) printf("...");
-        printf("\n");
+        dissect_buf_t ascii;
+        dissect_buf_init(&ascii);
+        dissect_buf_ascii(&ascii, data, bytes_to_print);
+        if (len > max_bytes) dissect_buf_printf(&ascii, "...");
+        dissect_field(ctx, "Data (ascii)", data, bytes_to_print, "%s", ascii.text);
     }
 }
 
-void parse_dns_packet(const u_char *data, int len, uint16_t src_port, uint16_t dst_port) {
+void parse_dns_packet(dissect_ctx_t *ctx, const u_char *data, int len, uint16_t src_port, uint16_t dst_port) {
+    udp_stats_t *stats = &ctx->state->udp;
     (void)src_port; // Suppress unused parameter warning
     (void)dst_port; // Suppress unused parameter warning
     if (len < 12) return; // Minimum DNS header size
@@ -80,15 +74,17 @@ void parse_dns_packet(const u_char *data, int len, uint16_t src_port, uint16_t d
     int opcode = (flags >> 11) & 0x0F;
     int rcode = flags & 0x0F;
     
-    printf("  DNS %s (ID: 0x%04x)\n", is_response ? "Response" : "Query", transaction_id);
-    printf("  Questions: %u, Answers: %u, Opcode: %d", questions, answers, opcode);
-    if (is_response) printf(", RCode: %d", rcode);
-    printf("\n");
+    dissect_field(ctx, is_response ? "DNS Response" : "DNS Query", data, 2, "ID 0x%04x", transaction_id);
+    dissect_field(ctx, "Questions", data + 4, 2, "%u", questions);
+    dissect_field(ctx, "Answers", data + 6, 2, "%u", answers);
+    dissect_field(ctx, "Opcode", data + 2, 2, "%d", opcode);
+    if (is_response) dissect_field(ctx, "RCode", data + 2, 2, "%d", rcode);
     
-    g_stats.dns_packets++;
+    stats->dns_packets++;
 }
 
-void parse_dhcp_packet(const u_char *data, int len, uint16_t src_port, uint16_t dst_port) {
+void parse_dhcp_packet(dissect_ctx_t *ctx, const u_char *data, int len, uint16_t src_port, uint16_t dst_port) {
+    udp_stats_t *stats = &ctx->state->udp;
     (void)src_port; // Suppress unused parameter warning
     (void)dst_port; // Suppress unused parameter warning
     if (len < 240) return; // Minimum DHCP packet size
@@ -98,8 +94,9 @@ void parse_dhcp_packet(const u_char *data, int len, uint16_t src_port, uint16_t
     uint8_t hlen = data[2];
     uint32_t xid = ntohl(*(uint32_t*)(data + 4));
     
-    printf("  DHCP %s (XID: 0x%08x)\n", (op == 1) ? "Request" : "Reply", xid);
-    printf("  Hardware Type: %u, Hardware Length: %u\n", htype, hlen);
+    dissect_field(ctx, (op == 1) ? "DHCP Request" : "DHCP Reply", data + 4, 4, "XID 0x%08x", xid);
+    dissect_field(ctx, "Hardware Type", data + 1, 1, "%u", htype);
+    dissect_field(ctx, "Hardware Length", data + 2, 1, "%u", hlen);
     
     // Look for DHCP message type in options (simplified)
     if (len > 240) {
@@ -111,17 +108,18 @@ void parse_dhcp_packet(const u_char *data, int len, uint16_t src_port, uint16_t
                 const char *type_names[] = {"", "DISCOVER", "OFFER", "REQUEST", 
                                           "DECLINE", "ACK", "NAK", "RELEASE", "INFORM"};
                 if (msg_type >= 1 && msg_type <= 8) {
-                    printf("  Message Type: %s\n", type_names[msg_type]);
+                    dissect_field(ctx, "Message Type", options + i, 3, "%s", type_names[msg_type]);
                 }
                 break;
             }
         }
     }
     
-    g_stats.dhcp_packets++;
+    stats->dhcp_packets++;
 }
 
-void parse_ntp_packet(const u_char *data, int len, uint16_t src_port, uint16_t dst_port) {
+void parse_ntp_packet(dissect_ctx_t *ctx, const u_char *data, int len, uint16_t src_port, uint16_t dst_port) {
+    udp_stats_t *stats = &ctx->state->udp;
     (void)src_port; // Suppress unused parameter warning
     (void)dst_port; // Suppress unused parameter warning
     if (len < 48) return; // NTP packet is exactly 48 bytes
@@ -137,53 +135,63 @@ void parse_ntp_packet(const u_char *data, int len, uint16_t src_port, uint16_t d
     const char *mode_names[] = {"Reserved", "Symmetric Active", "Symmetric Passive",
                                "Client", "Server", "Broadcast", "Control", "Private"};
     
-    printf("  NTP v%d %s\n", version, (mode < 8) ? mode_names[mode] : "Unknown");
-    printf("  Stratum: %u, Poll: %d, Precision: %d\n", stratum, poll, (int8_t)precision);
+    dissect_field(ctx, "NTP Mode", data, 1, "v%d %s", version, (mode < 8) ? mode_names[mode] : "Unknown");
+    dissect_field(ctx, "Stratum", data + 1, 1, "%u", stratum);
+    dissect_field(ctx, "Poll", data + 2, 1, "%d", poll);
+    dissect_field(ctx, "Precision", data + 3, 1, "%d", (int8_t)precision);
     
-    g_stats.ntp_packets++;
+    stats->ntp_packets++;
 }
 
-void analyze_udp_protocol(const udp_packet_info_t *udp_info) {
+void analyze_udp_protocol(dissect_ctx_t *ctx, const udp_packet_info_t *udp_info) {
+    udp_stats_t *stats = &ctx->state->udp;
     uint16_t src_port = udp_info->src_port;
     uint16_t dst_port = udp_info->dst_port;
     
     // DNS
     if (src_port == 53 || dst_port == 53 || src_port == 5353 || dst_port == 5353) {
-        parse_dns_packet(udp_info->data, udp_info->data_len, src_port, dst_port);
+        parse_dns_packet(ctx, udp_info->data, udp_info->data_len, src_port, dst_port);
         return;
     }
     
     // DHCP
     if ((src_port == 67 && dst_port == 68) || (src_port == 68 && dst_port == 67)) {
-        parse_dhcp_packet(udp_info->data, udp_info->data_len, src_port, dst_port);
+        parse_dhcp_packet(ctx, udp_info->data, udp_info->data_len, src_port, dst_port);
         return;
     }
     
     // NTP
     if (src_port == 123 || dst_port == 123) {
-        parse_ntp_packet(udp_info->data, udp_info->data_len, src_port, dst_port);
+        parse_ntp_packet(ctx, udp_info->data, udp_info->data_len, src_port, dst_port);
         return;
     }
     
     // Generic protocol analysis
-    printf("  Protocol: %s", get_port_service(dst_port));
     if (strcmp(get_port_service(dst_port), "Unknown") == 0 && 
         strcmp(get_port_service(src_port), "Unknown") != 0) {
-        printf(" (%s)", get_port_service(src_port));
+        dissect_field(ctx, "Protocol", NULL, 0, "%s (%s)", get_port_service(dst_port), get_port_service(src_port));
+    } else {
+        dissect_field(ctx, "Protocol", NULL, 0, "%s", get_port_service(dst_port));
     }
-    printf("\n");
     
     if (udp_info->data_len > 0) {
-        printf("  Payload: %d bytes\n", udp_info->data_len);
-        print_hex_dump(udp_info->data, udp_info->data_len, 32);
+        dissect_field(ctx, "Payload", udp_info->data, udp_info->data_len, "%d bytes", udp_info->data_len);
+        print_hex_dump(ctx, udp_info->data, udp_info->data_len, 32);
     }
     
-    g_stats.other_packets++;
+    stats->other_packets++;
 }
 
 void parse_udp(const u_char *payload, int payload_len) {
+    dissect_ctx_t ctx;
+    dissect_ctx_init(&ctx, &dissect_stdout_visitor, NULL, dissect_default_state(), payload, payload_len);
+    dissect_udp(&ctx, payload, payload_len);
+}
+
+void dissect_udp(dissect_ctx_t *ctx, const u_char *payload, int payload_len) {
+    udp_stats_t *stats = &ctx->state->udp;
     if (payload_len < (int)sizeof(struct udphdr)) {
-        printf("Invalid UDP packet: too short (%d bytes)\n", payload_len);
+        dissect_note(ctx, payload, payload_len, "Invalid UDP packet: too short (%d bytes)", payload_len);
         return;
     }
 
@@ -201,51 +209,57 @@ void parse_udp(const u_char *payload, int payload_len) {
     
     // Validate UDP length
     if (udp_info.length < sizeof(struct udphdr) || udp_info.length > payload_len) {
-        printf("Invalid UDP length field: %u (packet size: %d)\n", udp_info.length, payload_len);
+        dissect_note(ctx, payload + 4, 2, "Invalid UDP length field: %u (packet size: %d)", udp_info.length, payload_len);
         return;
     }
     
     // Update statistics
-    g_stats.total_packets++;
-    g_stats.total_bytes += udp_info.length;
-    
-    // Print timestamp
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    printf("\n[%02d:%02d:%02d] ", tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
-    
-    printf("=== UDP Packet #%lu ===\n", g_stats.total_packets);
-    printf("Source Port: %u (%s)\n", udp_info.src_port, get_port_service(udp_info.src_port));
-    printf("Destination Port: %u (%s)\n", udp_info.dst_port, get_port_service(udp_info.dst_port));
-    printf("Length: %u bytes\n", udp_info.length);
-    printf("Checksum: 0x%04x %s\n", udp_info.checksum, 
-           udp_info.checksum == 0 ? "(disabled)" : "");
+    stats->total_packets++;
+    stats->total_bytes += udp_info.length;
+    
+    char title[48];
+    snprintf(title, sizeof(title), "UDP Packet #%lu", stats->total_packets);
+    dissect_begin(ctx, title, payload, udp_info.length);
+    dissect_field(ctx, "Source Port", payload, 2, "%u (%s)", udp_info.src_port, get_port_service(udp_info.src_port));
+    dissect_field(ctx, "Destination Port", payload + 2, 2, "%u (%s)", udp_info.dst_port, get_port_service(udp_info.dst_port));
+    dissect_field(ctx, "Length", payload + 4, 2, "%u bytes", udp_info.length);
+    dissect_field(ctx, "Checksum", payload + 6, 2, "0x%04x %s", udp_info.checksum, 
+                  udp_info.checksum == 0 ? "(disabled)" : "");
     
     // Protocol-specific analysis
-    analyze_udp_protocol(&udp_info);
+    analyze_udp_protocol(ctx, &udp_info);
     
-    printf("========================\n");
+    dissect_end(ctx);
 }
 
-void print_udp_stats(void) {
+void print_udp_stats(const udp_stats_t *stats) {
     printf("\n--- UDP Traffic Statistics ---\n");
-    printf("Total Packets: %lu\n", g_stats.total_packets);
-    printf("Total Bytes: %lu\n", g_stats.total_bytes);
-    printf("DNS Packets: %lu (%.1f%%)\n", g_stats.dns_packets, 
-           g_stats.total_packets ? (g_stats.dns_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("DHCP Packets: %lu (%.1f%%)\n", g_stats.dhcp_packets,
-           g_stats.total_packets ? (g_stats.dhcp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("NTP Packets: %lu (%.1f%%)\n", g_stats.ntp_packets,
-           g_stats.total_packets ? (g_stats.ntp_packets * 100.0 / g_stats.total_packets) : 0);
-    printf("Other Packets: %lu (%.1f%%)\n", g_stats.other_packets,
-           g_stats.total_packets ? (g_stats.other_packets * 100.0 / g_stats.total_packets) : 0);
+    printf("Total Packets: %lu\n", stats->total_packets);
+    printf("Total Bytes: %lu\n", stats->total_bytes);
+    printf("DNS Packets: %lu (%.1f%%)\n", stats->dns_packets, 
+           stats->total_packets ? (stats->dns_packets * 100.0 / stats->total_packets) : 0);
+    printf("DHCP Packets: %lu (%.1f%%)\n", stats->dhcp_packets,
+           stats->total_packets ? (stats->dhcp_packets * 100.0 / stats->total_packets) : 0);
+    printf("NTP Packets: %lu (%.1f%%)\n", stats->ntp_packets,
+           stats->total_packets ? (stats->ntp_packets * 100.0 / stats->total_packets) : 0);
+    printf("Other Packets: %lu (%.1f%%)\n", stats->other_packets,
+           stats->total_packets ? (stats->other_packets * 100.0 / stats->total_packets) : 0);
     printf("Average Packet Size: %.1f bytes\n", 
-           g_stats.total_packets ? (g_stats.total_bytes / (double)g_stats.total_packets) : 0);
+           stats->total_packets ? (stats->total_bytes / (double)stats->total_packets) : 0);
     printf("-----------------------------\n\n");
 }
 
-void reset_udp_stats(void) {
-    memset(&g_stats, 0, sizeof(g_stats));
+void reset_udp_stats(udp_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+void merge_udp_stats(udp_stats_t *into, const udp_stats_t *from) {
+    into->total_packets += from->total_packets;
+    into->total_bytes += from->total_bytes;
+    into->dns_packets += from->dns_packets;
+    into->dhcp_packets += from->dhcp_packets;
+    into->ntp_packets += from->ntp_packets;
+    into->other_packets += from->other_packets;
 }
 
 #ifdef UDP_STANDALONE
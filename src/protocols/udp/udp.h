@@ -11,6 +11,7 @@
 #include <pcap.h>
 #include <stdint.h>
 #include <netinet/udp.h>
+#include "../dissect.h"
 
 // UDP protocol analysis structures
 typedef struct {
@@ -33,16 +34,18 @@ typedef struct {
 
 // Function declarations
 void parse_udp(const u_char *payload, int payload_len);
-void analyze_udp_protocol(const udp_packet_info_t *udp_info);
-void print_udp_stats(void);
-void reset_udp_stats(void);
+void dissect_udp(dissect_ctx_t *ctx, const u_char *payload, int payload_len);
+void analyze_udp_protocol(dissect_ctx_t *ctx, const udp_packet_info_t *udp_info);
+void print_udp_stats(const udp_stats_t *stats);
+void reset_udp_stats(udp_stats_t *stats);
+void merge_udp_stats(udp_stats_t *into, const udp_stats_t *from);
 const char* get_port_service(uint16_t port);
-void print_hex_dump(const u_char *data, int len, int max_bytes);
+void print_hex_dump(dissect_ctx_t *ctx, const u_char *data, int len, int max_bytes);
 int is_printable_data(const u_char *data, int len);
 
 // Protocol-specific parsers
-void parse_dns_packet(const u_char *data, int len, uint16_t src_port, uint16_t dst_port);
-void parse_dhcp_packet(const u_char *data, int len, uint16_t src_port, uint16_t dst_port);
-void parse_ntp_packet(const u_char *data, int len, uint16_t src_port, uint16_t dst_port);
+void parse_dns_packet(dissect_ctx_t *ctx, const u_char *data, int len, uint16_t src_port, uint16_t dst_port);
+void parse_dhcp_packet(dissect_ctx_t *ctx, const u_char *data, int len, uint16_t src_port, uint16_t dst_port);
+void parse_ntp_packet(dissect_ctx_t *ctx, const u_char *data, int len, uint16_t src_port, uint16_t dst_port);
 
 #endif // UDP_H